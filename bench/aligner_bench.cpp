@@ -0,0 +1,155 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/aligner.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
+
+// usage: biosoup_aligner_bench [pairs] [length] [error rate] [band]
+int main(int argc, char** argv) {
+  std::uint32_t num_pairs = argc > 1 ? std::atoi(argv[1]) : 200;
+  std::uint32_t len = argc > 2 ? std::atoi(argv[2]) : 10000;
+  double error_rate = argc > 3 ? std::atof(argv[3]) : 0.1;
+  std::uint32_t band = argc > 4 ? std::atoi(argv[4]) : 512;
+
+  // pairs of reads sampled from the same region, with errors spread evenly
+  // over substitutions, insertions and deletions, half of them on the
+  // reverse strand
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> distribution(0, 1);
+  auto mutate = [&] (const std::string& data) -> std::string {
+    std::string dst;
+    for (const auto& it : data) {
+      double x = distribution(generator);
+      if (x < error_rate / 3) {
+        dst += "ACGT"[generator() & 3];
+      } else if (x < error_rate * 2 / 3) {
+        dst += it;
+        dst += "ACGT"[generator() & 3];
+      } else if (x >= error_rate) {
+        dst += it;
+      }
+    }
+    return dst;
+  };
+  std::vector<std::unique_ptr<biosoup::NucleicAcid>> sequences;
+  std::vector<biosoup::Overlap> overlaps;
+  std::uint64_t num_cells = 0;
+  for (std::uint32_t i = 0; i < num_pairs; ++i) {
+    std::string data(len, 'A');
+    for (auto& it : data) {
+      it = "ACGT"[generator() & 3];
+    }
+    std::string lhs = mutate(data), rhs = mutate(data);
+    sequences.emplace_back(new biosoup::NucleicAcid("lhs", lhs));
+    sequences.emplace_back(new biosoup::NucleicAcid("rhs", rhs));
+    bool strand = i & 1;
+    if (!strand) {
+      sequences[2 * i]->ReverseAndComplement();
+    }
+    overlaps.emplace_back(
+        2 * i, 0, lhs.size(),
+        2 * i + 1, 0, rhs.size(),
+        0,
+        strand);
+    num_cells += static_cast<std::uint64_t>(lhs.size()) * rhs.size();
+  }
+  auto sequence = [&] (std::uint32_t id) -> biosoup::NucleicAcidView {
+    return biosoup::NucleicAcidView(*sequences[id]);
+  };
+
+  biosoup::Timer timer{};
+  std::uint64_t checksum = 0;
+
+  // textbook dynamic programming on inflated strings, as done by hand
+  timer.Start();
+  {
+    std::uint32_t n = std::min<std::uint32_t>(num_pairs, 4);
+    std::uint64_t cells = 0;
+    std::vector<std::uint32_t> column;
+    for (std::uint32_t i = 0; i < n; ++i) {
+      std::string lhs = sequences[2 * i]->InflateData();
+      std::string rhs = sequences[2 * i + 1]->InflateData();
+      column.resize(lhs.size() + 1);
+      for (std::uint32_t k = 0; k <= lhs.size(); ++k) {
+        column[k] = k;
+      }
+      for (std::uint32_t j = 1; j <= rhs.size(); ++j) {
+        std::uint32_t diagonal = column[0];
+        column[0] = j;
+        for (std::uint32_t k = 1; k <= lhs.size(); ++k) {
+          std::uint32_t score = std::min(
+              diagonal + (lhs[k - 1] != rhs[j - 1]),
+              std::min(column[k], column[k - 1]) + 1);
+          diagonal = column[k];
+          column[k] = score;
+        }
+      }
+      checksum += column.back();
+      cells += static_cast<std::uint64_t>(lhs.size()) * rhs.size();
+    }
+    double time = timer.Stop();
+    std::cout << "[biosoup::Aligner] edit distance by hand: "
+              << cells / time / 1e9 << " G cells/s" << std::endl;
+  }
+
+  for (std::uint32_t b : {UINT32_MAX, band}) {
+    biosoup::Aligner aligner{b};
+    const char* name = b == UINT32_MAX ? "full" : "banded";
+
+    timer.Start();
+    for (const auto& it : overlaps) {
+      biosoup::NucleicAcidView l = sequence(it.lhs_id).Slice(it.lhs_begin, it.lhs_end - it.lhs_begin);  // NOLINT
+      if (!it.strand) {
+        l.ReverseAndComplement();
+      }
+      checksum += aligner.EditDistance(l, sequence(it.rhs_id));
+    }
+    double time = timer.Stop();
+    std::cout << "[biosoup::Aligner] edit distance " << name << ": "
+              << num_pairs / time << " pairs/s, "
+              << num_cells / time / 1e9 << " G cells/s" << std::endl;
+
+    timer.Start();
+    std::uint64_t num_edits = 0;
+    for (auto it : overlaps) {
+      num_edits += aligner.Align(sequence(it.lhs_id), sequence(it.rhs_id), &it);  // NOLINT
+    }
+    time = timer.Stop();
+    std::cout << "[biosoup::Aligner] align " << name << ": "
+              << num_pairs / time << " pairs/s, "
+              << num_edits / static_cast<double>(num_pairs) << " edits/pair"
+              << std::endl;
+    checksum += num_edits;
+  }
+
+  std::vector<std::uint32_t> num_threads{1};
+  while (num_threads.back() * 2 <= std::thread::hardware_concurrency()) {
+    num_threads.emplace_back(num_threads.back() * 2);
+  }
+  biosoup::Aligner aligner{band};
+  for (auto it : num_threads) {
+    std::vector<biosoup::Overlap> batch = overlaps;
+    timer.Start();
+    aligner.Align(sequence, &batch, it);
+    double time = timer.Stop();
+    std::cout << "[biosoup::Aligner] align banded, " << it << " thread(s): "
+              << num_pairs / time << " pairs/s" << std::endl;
+    for (const auto& jt : batch) {
+      checksum += jt.score;
+    }
+  }
+
+  std::cout << "[biosoup::Aligner] checksum " << checksum << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,143 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/chainer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
+
+namespace {
+
+using ChainFunction = std::int32_t (*)(
+    const std::int32_t*, const std::int32_t*, const std::int32_t*,
+    std::int32_t, std::int32_t,
+    const biosoup::detail::ChainParameters&,
+    std::int32_t*);
+
+}  // namespace
+
+// usage: biosoup_chainer_bench [pairs] [lookback]
+int main(int argc, char** argv) {
+  std::uint32_t num_pairs = argc > 1 ? std::atoi(argv[1]) : 20000;
+  std::uint32_t lookback = argc > 2 ? std::atoi(argv[2]) : 64;
+
+  // (15, 10)-minimizers of overlapping noisy reads: a seed every 5.5 bases
+  // on average, drifting off the diagonal with indels, and a fifth of seeds
+  // hitting repeats elsewhere
+  std::mt19937 generator(42);
+  std::vector<biosoup::AnchorBatch> batches(num_pairs);
+  std::uint64_t num_anchors = 0;
+  for (std::uint32_t i = 0; i < num_pairs; ++i) {
+    auto& it = batches[i];
+    it.lhs_id = i;
+    it.rhs_id = i + num_pairs;
+    std::uint32_t len = 1000 + generator() % 9000;
+    std::uint32_t lhs_begin = generator() % 5000, rhs_begin = generator() % 5000;  // NOLINT
+    bool strand = generator() & 1;
+    std::int32_t drift = 0;
+    for (std::uint32_t j = generator() % 6; j + 15 < len; j += 1 + generator() % 10) {  // NOLINT
+      drift += static_cast<std::int32_t>(generator() % 3) - 1;
+      std::uint32_t r = std::max<std::int32_t>(0, j + drift);
+      it.anchors.push_back(biosoup::Anchor{
+          lhs_begin + j,
+          strand ? rhs_begin + r : rhs_begin + len + 100 - r,
+          strand});
+      if (generator() % 5 == 0) {
+        it.anchors.push_back(biosoup::Anchor{
+            static_cast<std::uint32_t>(generator() % (len + 5000)),
+            static_cast<std::uint32_t>(generator() % (len + 5000)),
+            (generator() & 1) == 1});
+      }
+    }
+    std::shuffle(it.anchors.begin(), it.anchors.end(), generator);
+    num_anchors += it.anchors.size();
+  }
+  std::cout << "[biosoup::Chainer] " << num_anchors << " anchors of "
+            << num_pairs << " pairs" << std::endl;
+
+  biosoup::Timer timer{};
+  std::uint64_t checksum = 0;
+
+  // the DP alone, over anchors sorted by hand
+  std::vector<std::vector<std::pair<std::int32_t, std::int32_t>>> sorted(num_pairs);  // NOLINT
+  for (std::uint32_t i = 0; i < num_pairs; ++i) {
+    for (const auto& it : batches[i].anchors) {
+      sorted[i].emplace_back(
+          it.strand ? it.rhs_position : INT32_MAX - it.rhs_position,
+          it.lhs_position + (it.strand ? 0 : 1U << 30));
+    }
+    std::sort(sorted[i].begin(), sorted[i].end());
+  }
+  biosoup::detail::ChainParameters parameters{15, 5000, 500, 38};
+  std::vector<std::pair<const char*, ChainFunction>> kernels{
+      {"scalar", biosoup::detail::BestPredecessorScalar}};
+#if defined(BIOSOUP_X86_DISPATCH)
+  if (biosoup::detail::simd_level() >= biosoup::detail::SimdLevel::kSse42) {
+    kernels.emplace_back("sse4.2", biosoup::detail::BestPredecessorSse42);
+  }
+  if (biosoup::detail::simd_level() >= biosoup::detail::SimdLevel::kAvx2) {
+    kernels.emplace_back("avx2", biosoup::detail::BestPredecessorAvx2);
+  }
+#endif
+  for (const auto& kernel : kernels) {
+    std::vector<std::int32_t> q, t, f;
+    std::uint64_t sum = 0;
+    timer.Start();
+    for (const auto& it : sorted) {
+      std::int32_t n = it.size();
+      q.resize(n);
+      t.resize(n);
+      f.resize(n);
+      for (std::int32_t i = 0; i < n; ++i) {
+        t[i] = it[i].first;
+        q[i] = it[i].second;
+      }
+      for (std::int32_t i = 0, lo = 0; i < n; ++i) {
+        while (t[i] - t[lo] > parameters.max_gap) {
+          ++lo;
+        }
+        std::int32_t score = 0;
+        std::int32_t j = kernel.second(
+            q.data(), t.data(), f.data(),
+            std::max<std::int32_t>(lo, i - lookback), i,
+            parameters,
+            &score);
+        f[i] = j != -1 && score > 15 ? score : 15;
+        sum += f[i];
+      }
+    }
+    double time = timer.Stop();
+    std::cout << "[biosoup::Chainer] DP " << kernel.first << ": "
+              << num_anchors / time / 1e6 << " M anchors/s, checksum "
+              << sum << std::endl;
+  }
+
+  biosoup::Chainer chainer{15, 3, 40, 5000, 500, lookback};
+  std::vector<std::uint32_t> num_threads{1};
+  while (num_threads.back() * 2 <= std::thread::hardware_concurrency()) {
+    num_threads.emplace_back(num_threads.back() * 2);
+  }
+  for (auto it : num_threads) {
+    timer.Start();
+    auto overlaps = chainer.Chain(batches, it);
+    double time = timer.Stop();
+    std::cout << "[biosoup::Chainer] chain, " << it << " thread(s): "
+              << num_anchors / time / 1e6 << " M anchors/s, "
+              << overlaps.size() << " overlaps" << std::endl;
+    for (const auto& jt : overlaps) {
+      checksum += jt.score;
+    }
+  }
+
+  std::cout << "[biosoup::Chainer] checksum " << checksum << std::endl;
+
+  return 0;
+}
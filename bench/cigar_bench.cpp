@@ -0,0 +1,107 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/cigar.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+// identity and projection by parsing the text form, as done by consumers
+double ParseIdentity(const std::string& cigar) {
+  std::uint64_t matches = 0, columns = 0, len = 0;
+  for (char c : cigar) {
+    if (c >= '0' && c <= '9') {
+      len = len * 10 + (c - '0');
+      continue;
+    }
+    if (c == 'M' || c == '=') {
+      matches += len;
+    }
+    if (c == 'M' || c == '=' || c == 'X' || c == 'I' || c == 'D') {
+      columns += len;
+    }
+    len = 0;
+  }
+  return columns ? matches / static_cast<double>(columns) : 0;
+}
+
+std::uint32_t ParseLhsToRhs(const std::string& cigar, std::uint32_t pos) {
+  std::uint32_t lhs = 0, rhs = 0, len = 0;
+  for (char c : cigar) {
+    if (c >= '0' && c <= '9') {
+      len = len * 10 + (c - '0');
+      continue;
+    }
+    bool is_lhs = c == 'M' || c == 'I' || c == 'S' || c == '=' || c == 'X';
+    bool is_rhs = c == 'M' || c == 'D' || c == 'N' || c == '=' || c == 'X';
+    if (is_lhs && pos < lhs + len) {
+      return rhs + (is_rhs ? pos - lhs : 0);
+    }
+    lhs += is_lhs ? len : 0;
+    rhs += is_rhs ? len : 0;
+    len = 0;
+  }
+  return rhs;
+}
+
+// usage: biosoup_cigar_bench [alignments] [operations] [queries]
+int main(int argc, char** argv) {
+  std::uint32_t num_alignments = argc > 1 ? std::atoi(argv[1]) : 10000;
+  std::uint32_t num_operations = argc > 2 ? std::atoi(argv[2]) : 2000;
+  std::uint32_t num_queries = argc > 3 ? std::atoi(argv[3]) : 100;
+
+  std::mt19937 generator(42);
+  std::vector<std::string> texts;
+  for (std::uint32_t i = 0; i < num_alignments; ++i) {
+    std::string cigar;
+    for (std::uint32_t j = 0; j < num_operations; ++j) {
+      cigar += std::to_string(j % 2 ? generator() % 3 + 1 : generator() % 50 + 1);  // NOLINT
+      cigar += j % 2 ? "XID"[generator() % 3] : '=';
+    }
+    texts.emplace_back(cigar);
+  }
+
+  biosoup::Timer timer{};
+  double checksum = 0;
+
+  timer.Start();
+  std::vector<biosoup::Cigar> cigars;
+  for (const auto& it : texts) {
+    cigars.emplace_back(it);
+  }
+  double time = timer.Stop();
+  std::cout << "[biosoup::Cigar] encoding: "
+            << num_alignments / time / 1e3 << " K alignments/s" << std::endl;
+
+  timer.Start();
+  for (const auto& it : texts) {
+    checksum += ParseIdentity(it);
+    for (std::uint32_t i = 0; i < num_queries; ++i) {
+      checksum += ParseLhsToRhs(it, i * 997);
+    }
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::Cigar] text parsing: "
+            << num_alignments * (num_queries + 1.) / time / 1e6
+            << " M queries/s" << std::endl;
+
+  timer.Start();
+  for (const auto& it : cigars) {
+    checksum -= it.Identity();
+    for (std::uint32_t i = 0; i < num_queries; ++i) {
+      checksum -= it.LhsToRhs(i * 997);
+    }
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::Cigar] prefix sums: "
+            << num_alignments * (num_queries + 1.) / time / 1e6
+            << " M queries/s" << std::endl;
+
+  std::cout << "[biosoup::Cigar] checksum " << checksum << std::endl;
+
+  return 0;
+}
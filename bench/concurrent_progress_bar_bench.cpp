@@ -0,0 +1,80 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/concurrent_progress_bar.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "biosoup/progress_bar.hpp"
+#include "biosoup/timer.hpp"
+
+// runs f(thread) on num_threads threads, returns elapsed seconds
+template<typename F>
+double Run(std::uint32_t num_threads, F f) {
+  biosoup::Timer timer{};
+  timer.Start();
+  std::vector<std::thread> threads;
+  for (std::uint32_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back(f);
+  }
+  for (auto& it : threads) {
+    it.join();
+  }
+  return timer.Stop();
+}
+
+// usage: biosoup_concurrent_progress_bar_bench [events per thread]
+int main(int argc, char** argv) {
+  std::uint32_t num_events = argc > 1 ? std::atoi(argv[1]) : 10000000;
+
+  std::vector<std::uint32_t> num_threads{1};
+  while (num_threads.back() * 2 <= 4 * std::thread::hardware_concurrency()) {
+    num_threads.emplace_back(num_threads.back() * 2);
+  }
+
+  std::ostringstream os;
+  for (auto it : num_threads) {
+    std::uint64_t total = static_cast<std::uint64_t>(num_events) * it;
+
+    // ProgressBar behind a mutex, as done by hand in tools using biosoup
+    biosoup::ProgressBar pb{static_cast<std::uint32_t>(total), 20};
+    std::mutex mutex;
+    double time = Run(it, [&] () -> void {
+      for (std::uint32_t i = 0; i < num_events; ++i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (++pb) {
+          os << "\r" << pb;
+        }
+      }
+    });
+    std::cout << "[biosoup::ConcurrentProgressBar] ProgressBar with mutex, "
+              << it << " thread(s): " << total / time / 1e6 << " M events/s"
+              << std::endl;
+
+    biosoup::ConcurrentProgressBar cpb{total, 20, &os};
+    time = Run(it, [&] () -> void {
+      for (std::uint32_t i = 0; i < num_events; ++i) {
+        ++cpb;
+        if ((i & 0xFFFF) == 0) {
+          cpb.Render();
+        }
+      }
+    });
+    std::cout << "[biosoup::ConcurrentProgressBar] " << it << " thread(s): "
+              << total / time / 1e6 << " M events/s" << std::endl;
+    if (cpb.event_counter() != total) {
+      std::cout << "[biosoup::ConcurrentProgressBar] error: lost events"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "[biosoup::ConcurrentProgressBar] " << os.str().size()
+            << " bytes drawn" << std::endl;
+
+  return 0;
+}
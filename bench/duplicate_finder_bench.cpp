@@ -0,0 +1,132 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/duplicate_finder.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
+
+// usage: biosoup_duplicate_finder_bench [reads] [length] [threads]
+int main(int argc, char** argv) {
+  std::uint32_t num_reads = argc > 1 ? std::atoi(argv[1]) : 20000000;
+  std::uint32_t read_len = argc > 2 ? std::atoi(argv[2]) : 150;
+  std::uint32_t num_threads = argc > 3 ?
+      std::atoi(argv[3]) : std::thread::hardware_concurrency();
+
+  // reads are generated and added in batches, as they would be parsed
+  std::uint32_t batch_size = 1U << 20;
+  std::uint32_t genome_len = 50000000;
+  std::mt19937 generator(42);
+  std::string genome(genome_len, 'A');
+  for (auto& it : genome) {
+    it = "ACGT"[generator() & 3];
+  }
+
+  biosoup::Timer timer{};
+  double time_by_hand = 0, time_fingerprint = 0, time_finder = 0,
+      time_spilling = 0;
+  std::uint64_t checksum = 0;
+
+  // inflate, pick the smaller strand and hash the string, as done by hand
+  std::vector<std::pair<std::size_t, biosoup::ObjectId>> hashes;
+  biosoup::DuplicateFinder finder{true, 1ULL << 32, ".", num_threads};
+  biosoup::DuplicateFinder spilling{true, 1ULL << 26, ".", num_threads};
+
+  std::uint32_t begin = 0;
+  for (std::uint32_t i = 0; i < num_reads; i += batch_size) {
+    std::vector<std::unique_ptr<biosoup::NucleicAcid>> reads;
+    for (std::uint32_t j = i; j < std::min(i + batch_size, num_reads); ++j) {
+      if (generator() % 10) {  // every 10th read is a copy of the previous one
+        begin = generator() % (genome_len - read_len);
+      }
+      reads.emplace_back(new biosoup::NucleicAcid(
+          "read", genome.substr(begin, read_len)));
+      if (generator() & 1) {
+        reads.back()->ReverseAndComplement();
+      }
+    }
+
+    timer.Start();
+    {
+      std::string data, reverse;
+      for (const auto& it : reads) {
+        it->InflateData(0, -1, &data);
+        reverse.assign(data.rbegin(), data.rend());
+        for (auto& jt : reverse) {
+          jt = jt == 'A' ? 'T' : jt == 'C' ? 'G' : jt == 'G' ? 'C' : 'A';
+        }
+        hashes.emplace_back(
+            std::hash<std::string>()(std::min(data, reverse)), it->id);
+      }
+    }
+    time_by_hand += timer.Stop();
+
+    timer.Start();
+    for (const auto& it : reads) {
+      checksum += biosoup::ComputeCanonicalFingerprint(*it).lo & 1;
+    }
+    time_fingerprint += timer.Stop();
+
+    timer.Start();
+    finder.Add(reads);
+    time_finder += timer.Stop();
+
+    timer.Start();
+    spilling.Add(reads);
+    time_spilling += timer.Stop();
+  }
+
+  timer.Start();
+  std::uint64_t num_groups = 0;
+  {
+    std::sort(hashes.begin(), hashes.end());
+    for (std::size_t i = 0, j; i < hashes.size(); i = j) {
+      for (j = i + 1; j < hashes.size() && hashes[j].first == hashes[i].first;) {  // NOLINT
+        ++j;
+      }
+      num_groups += j - i > 1;
+    }
+    std::vector<std::pair<std::size_t, biosoup::ObjectId>>().swap(hashes);
+  }
+  time_by_hand += timer.Stop();
+  checksum += num_groups;
+  std::cout << "[biosoup::DuplicateFinder] done by hand: "
+            << num_reads / time_by_hand / 1e6 << " M reads/s, "
+            << num_groups << " groups" << std::endl;
+
+  std::cout << "[biosoup::DuplicateFinder] canonical fingerprints: "
+            << num_reads / time_fingerprint / 1e6 << " M reads/s" << std::endl;
+
+  timer.Start();
+  auto groups = finder.Find();
+  time_finder += timer.Stop();
+  checksum += groups.size();
+  std::cout << "[biosoup::DuplicateFinder] in memory: "
+            << num_reads / time_finder / 1e6 << " M reads/s, "
+            << groups.size() << " groups" << std::endl;
+
+  std::size_t num_spills = spilling.num_spills();
+  timer.Start();
+  groups = spilling.Find();
+  time_spilling += timer.Stop();
+  checksum += groups.size();
+  std::cout << "[biosoup::DuplicateFinder] within 64 MiB: "
+            << num_reads / time_spilling / 1e6 << " M reads/s, "
+            << groups.size() << " groups, "
+            << num_spills << " spills" << std::endl;
+
+  std::cout << "[biosoup::DuplicateFinder] checksum " << checksum << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,148 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/hpc_nucleic_acid.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
+
+// usage: biosoup_hpc_nucleic_acid_bench [reads] [length] [queries]
+int main(int argc, char** argv) {
+  std::uint32_t num_reads = argc > 1 ? std::atoi(argv[1]) : 2000;
+  std::uint32_t read_len = argc > 2 ? std::atoi(argv[2]) : 20000;
+  std::uint32_t num_queries = argc > 3 ? std::atoi(argv[3]) : 10000000;
+
+  std::mt19937 generator(42);
+  std::vector<std::unique_ptr<biosoup::NucleicAcid>> reads;
+  for (std::uint32_t i = 0; i < num_reads; ++i) {
+    std::string data;
+    while (data.size() < read_len) {  // geometric run lengths
+      char c = "ACGT"[generator() & 3];
+      if (!data.empty() && c == data.back()) {
+        continue;
+      }
+      std::uint32_t n = 1;
+      while (generator() % 3 == 0) {
+        ++n;
+      }
+      data.append(n, c);
+    }
+    data.resize(read_len);
+    reads.emplace_back(new biosoup::NucleicAcid("read", data));
+  }
+  double num_bases = static_cast<double>(num_reads) * read_len;
+
+  biosoup::Timer timer{};
+  std::uint64_t checksum = 0;
+
+  // inflate, collapse, re-encode and keep raw positions, as done by hand
+  std::vector<std::unique_ptr<biosoup::NucleicAcid>> collapsed;
+  std::vector<std::vector<std::uint32_t>> positions;
+  timer.Start();
+  {
+    std::string data, bases;
+    for (const auto& it : reads) {
+      it->InflateData(0, -1, &data);
+      bases.clear();
+      positions.emplace_back();
+      for (std::uint32_t i = 0; i < data.size(); ++i) {
+        if (i == 0 || data[i] != data[i - 1]) {
+          bases.push_back(data[i]);
+          positions.back().push_back(i);
+        }
+      }
+      positions.back().push_back(data.size());
+      positions.back().shrink_to_fit();
+      collapsed.emplace_back(new biosoup::NucleicAcid(it->name, bases));
+    }
+  }
+  double time = timer.Stop();
+  std::uint64_t num_bytes = 0;
+  for (std::uint32_t i = 0; i < num_reads; ++i) {
+    num_bytes += collapsed[i]->deflated_data.capacity() * 8 +
+        positions[i].capacity() * 4;
+  }
+  std::cout << "[biosoup::HpcNucleicAcid] done by hand: "
+            << num_bases / time / 1e6 << " M bases/s, "
+            << num_bytes * 8. / num_bases << " bits per base" << std::endl;
+
+  std::vector<std::unique_ptr<biosoup::HpcNucleicAcid>> hpc;
+  timer.Start();
+  for (const auto& it : reads) {
+    hpc.emplace_back(new biosoup::HpcNucleicAcid(*it));
+  }
+  time = timer.Stop();
+  num_bytes = 0;
+  for (const auto& it : hpc) {
+    num_bytes += it->deflated_data.capacity() * 8 +
+        (it->raw_len + 63) / 64 * 8 +
+        (it->raw_len / 512 + it->inflated_len / 64 + 2) * 4;
+  }
+  std::cout << "[biosoup::HpcNucleicAcid] from NucleicAcid: "
+            << num_bases / time / 1e6 << " M bases/s, "
+            << num_bytes * 8. / num_bases << " bits per base" << std::endl;
+
+  {
+    std::string data = reads.front()->InflateData();
+    timer.Start();
+    for (std::uint32_t i = 0; i < num_reads; ++i) {
+      biosoup::HpcNucleicAcid h{"read", data};
+      checksum += h.inflated_len;
+    }
+    time = timer.Stop();
+    std::cout << "[biosoup::HpcNucleicAcid] from characters: "
+              << num_bases / time / 1e6 << " M bases/s" << std::endl;
+  }
+
+  std::vector<std::uint32_t> reads_ids(num_queries), hpc_positions(num_queries);
+  std::vector<std::uint32_t> raw_positions(num_queries);
+  for (std::uint32_t i = 0; i < num_queries; ++i) {
+    reads_ids[i] = generator() % num_reads;
+    hpc_positions[i] = generator() % hpc[reads_ids[i]]->inflated_len;
+    raw_positions[i] = generator() % read_len;
+  }
+
+  timer.Start();
+  for (std::uint32_t i = 0; i < num_queries; ++i) {
+    checksum += positions[reads_ids[i]][hpc_positions[i]];
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::HpcNucleicAcid] HPC to raw, by hand: "
+            << num_queries / time / 1e6 << " M queries/s" << std::endl;
+
+  timer.Start();
+  for (std::uint32_t i = 0; i < num_queries; ++i) {
+    checksum += hpc[reads_ids[i]]->RawPosition(hpc_positions[i]);
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::HpcNucleicAcid] HPC to raw: "
+            << num_queries / time / 1e6 << " M queries/s" << std::endl;
+
+  timer.Start();
+  for (std::uint32_t i = 0; i < num_queries; ++i) {
+    const auto& p = positions[reads_ids[i]];
+    checksum += std::upper_bound(p.begin(), p.end(), raw_positions[i]) - p.begin() - 1;  // NOLINT
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::HpcNucleicAcid] raw to HPC, by hand: "
+            << num_queries / time / 1e6 << " M queries/s" << std::endl;
+
+  timer.Start();
+  for (std::uint32_t i = 0; i < num_queries; ++i) {
+    checksum += hpc[reads_ids[i]]->HpcPosition(raw_positions[i]);
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::HpcNucleicAcid] raw to HPC: "
+            << num_queries / time / 1e6 << " M queries/s" << std::endl;
+
+  std::cout << "[biosoup::HpcNucleicAcid] checksum " << checksum << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/kmer.hpp"
+
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
+
+// usage: biosoup_kmer_bench [reads] [length] [k] [w]
+int main(int argc, char** argv) {
+  std::uint32_t num_reads = argc > 1 ? std::atoi(argv[1]) : 1000;
+  std::uint32_t read_len = argc > 2 ? std::atoi(argv[2]) : 20000;
+  std::uint32_t k = argc > 3 ? std::atoi(argv[3]) : 15;
+  std::uint32_t w = argc > 4 ? std::atoi(argv[4]) : 5;
+
+  std::mt19937 generator(42);
+  std::vector<std::unique_ptr<biosoup::NucleicAcid>> reads;
+  std::string data(read_len, 'A');
+  for (std::uint32_t i = 0; i < num_reads; ++i) {
+    for (auto& it : data) {
+      it = "ACGT"[generator() & 3];
+    }
+    reads.emplace_back(new biosoup::NucleicAcid("bench", data));
+  }
+  double num_bases = static_cast<double>(num_reads) * read_len;
+
+  biosoup::Timer timer{};
+  std::vector<biosoup::Kmer> kmers;
+  std::uint64_t checksum = 0;
+
+  timer.Start();
+  for (const auto& it : reads) {
+    kmers.clear();
+    biosoup::detail::CanonicalKmersByCode(*it, k, &kmers);
+    checksum += kmers.back().value;
+  }
+  double time = timer.Stop();
+  std::cout << "[biosoup::Kmer] Code(i) k-mers: "
+            << num_bases / time / 1e6 << " M bases/s" << std::endl;
+
+  timer.Start();
+  for (const auto& it : reads) {
+    kmers.resize(read_len);
+    biosoup::KmerIterator kt{*it, k};
+    kmers.resize(kt.Next(kmers.data(), kmers.size()));
+    checksum += kmers.back().value;
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::Kmer] KmerIterator: "
+            << num_bases / time / 1e6 << " M bases/s" << std::endl;
+
+  // minimizers on top of per-base extraction, as done before KmerIterator
+  std::uint64_t num_minimizers = 0;
+  timer.Start();
+  for (const auto& it : reads) {
+    kmers.clear();
+    biosoup::detail::CanonicalKmersByCode(*it, k, &kmers);
+    std::deque<std::pair<std::uint64_t, std::uint32_t>> window;
+    std::uint32_t last = -1;
+    for (std::uint32_t i = 0; i < kmers.size(); ++i) {
+      std::uint64_t hash = biosoup::HashKmer(kmers[i].value, biosoup::KmerMask(k));  // NOLINT
+      while (!window.empty() && window.back().first > hash) {
+        window.pop_back();
+      }
+      window.emplace_back(hash, i);
+      if (i - window.front().second >= w) {
+        window.pop_front();
+      }
+      if (i + 1 >= w && window.front().second != last) {
+        last = window.front().second;
+        ++num_minimizers;
+      }
+    }
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::Kmer] Code(i) minimizers: "
+            << num_bases / time / 1e6 << " M bases/s, "
+            << num_minimizers << " minimizers" << std::endl;
+
+  num_minimizers = 0;
+  timer.Start();
+  for (const auto& it : reads) {
+    kmers.clear();
+    biosoup::Minimize(*it, k, w, &kmers);
+    num_minimizers += kmers.size();
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::Kmer] Minimize: "
+            << num_bases / time / 1e6 << " M bases/s, "
+            << num_minimizers << " minimizers" << std::endl;
+
+  std::cout << "[biosoup::Kmer] checksum " << checksum << std::endl;
+
+  return 0;
+}
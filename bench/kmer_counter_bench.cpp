@@ -0,0 +1,104 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/kmer_counter.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
+
+// usage: biosoup_kmer_counter_bench [genome length] [coverage] [k]
+int main(int argc, char** argv) {
+  std::uint32_t genome_len = argc > 1 ? std::atoi(argv[1]) : 2000000;
+  std::uint32_t coverage = argc > 2 ? std::atoi(argv[2]) : 10;
+  std::uint32_t k = argc > 3 ? std::atoi(argv[3]) : 21;
+
+  std::mt19937 generator(42);
+  std::string genome(genome_len, 'A');
+  for (auto& it : genome) {
+    it = "ACGT"[generator() & 3];
+  }
+  std::vector<std::unique_ptr<biosoup::NucleicAcid>> reads;
+  std::uint64_t num_bases = 0;
+  while (num_bases < static_cast<std::uint64_t>(genome_len) * coverage) {
+    std::uint32_t len = 5000 + generator() % 10000;
+    std::string data = genome.substr(generator() % (genome_len - len), len);
+    for (std::uint32_t i = 0; i < len / 100; ++i) {  // 1% substitutions
+      data[generator() % len] = "ACGT"[generator() & 3];
+    }
+    reads.emplace_back(new biosoup::NucleicAcid("read", data));
+    num_bases += len;
+  }
+
+  biosoup::Timer timer{};
+  std::uint64_t checksum = 0;
+
+  // std::unordered_map filled through Code(i), as done by hand
+  timer.Start();
+  {
+    std::unordered_map<std::uint64_t, std::uint32_t> counts;
+    std::vector<biosoup::Kmer> kmers;
+    for (const auto& it : reads) {
+      kmers.clear();
+      biosoup::detail::CanonicalKmersByCode(*it, k, &kmers);
+      for (const auto& jt : kmers) {
+        ++counts[jt.value];
+      }
+    }
+    std::vector<std::uint64_t> histogram(1);
+    for (const auto& it : counts) {
+      if (histogram.size() <= it.second) {
+        histogram.resize(it.second + 1, 0);
+      }
+      ++histogram[it.second];
+    }
+    checksum += histogram[1];
+  }
+  double time = timer.Stop();
+  std::cout << "[biosoup::KmerCounter] std::unordered_map: "
+            << num_bases / time / 1e6 << " M bases/s" << std::endl;
+
+  std::vector<std::uint32_t> num_threads{1};
+  while (num_threads.back() * 2 <= std::thread::hardware_concurrency()) {
+    num_threads.emplace_back(num_threads.back() * 2);
+  }
+  for (auto it : num_threads) {
+    timer.Start();
+    biosoup::KmerCounter c{k, 1ULL << 32, ".", it};
+    c.Add(reads);
+    c.Count(2);
+    checksum += c.histogram()[1];
+    time = timer.Stop();
+    std::cout << "[biosoup::KmerCounter] " << it << " thread(s): "
+              << num_bases / time / 1e6 << " M bases/s, "
+              << c.num_counted_kmers() << " k-mers occurring at least twice"
+              << std::endl;
+  }
+
+  for (std::uint64_t memory_limit : {1ULL << 26, 1ULL << 24}) {
+    timer.Start();
+    biosoup::KmerCounter c{
+        k, memory_limit, ".", std::thread::hardware_concurrency()};
+    c.Add(reads);
+    std::size_t num_runs = c.num_runs();
+    c.Count(2);
+    checksum += c.histogram()[1];
+    time = timer.Stop();
+    std::cout << "[biosoup::KmerCounter] memory limit "
+              << (memory_limit >> 20) << " MiB: "
+              << num_bases / time / 1e6 << " M bases/s, "
+              << num_runs << " runs" << std::endl;
+  }
+
+  std::cout << "[biosoup::KmerCounter] checksum " << checksum << std::endl;
+
+  return 0;
+}
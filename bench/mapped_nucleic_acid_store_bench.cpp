@@ -0,0 +1,82 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/mapped_nucleic_acid_store.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
+
+// usage: biosoup_mapped_nucleic_acid_store_bench [prefix] [reads] [length]
+int main(int argc, char** argv) {
+  std::string prefix = argc > 1 ? argv[1] : "biosoup_bench";
+  std::uint32_t num_reads = argc > 2 ? std::atoi(argv[2]) : 100000;
+  std::uint32_t read_len = argc > 3 ? std::atoi(argv[3]) : 5000;
+
+  std::string fastq_path = prefix + ".fastq";
+  std::string binary_path = prefix + ".bin";
+  {
+    std::mt19937 generator(42);
+    std::ofstream os(fastq_path);
+    std::string data(read_len, 'A'), quality(read_len, '!');
+    for (std::uint32_t i = 0; i < num_reads; ++i) {
+      for (std::uint32_t j = 0; j < read_len; ++j) {
+        data[j] = "ACGT"[generator() & 3];
+        quality[j] = '!' + generator() % 40;
+      }
+      os << "@read" << i << "\n" << data << "\n+\n" << quality << "\n";
+    }
+  }
+
+  biosoup::Timer timer{};
+  timer.Start();
+  biosoup::NucleicAcidStore store{};
+  {
+    std::ifstream is(fastq_path);
+    std::string name, data, separator, quality;
+    while (std::getline(is, name) && std::getline(is, data) &&
+           std::getline(is, separator) && std::getline(is, quality)) {
+      store.Append(
+          name.c_str() + 1, name.size() - 1,
+          data.c_str(), data.size(),
+          quality.c_str(), quality.size());
+    }
+  }
+  double parse_time = timer.Stop();
+
+  timer.Start();
+  biosoup::MappedNucleicAcidStore::Write(binary_path, store);
+  double write_time = timer.Stop();
+
+  timer.Start();
+  biosoup::MappedNucleicAcidStore mapped{binary_path};
+  double map_time = timer.Stop();
+
+  timer.Start();
+  std::uint64_t checksum = 0;
+  for (std::size_t i = 0; i < mapped.size(); ++i) {
+    auto it = mapped[i];
+    for (std::uint32_t j = 0; j < (it.inflated_len + 31) >> 5; ++j) {
+      checksum += it.deflated_data[j];
+    }
+  }
+  double scan_time = timer.Stop();
+
+  std::cout << "[biosoup::MappedNucleicAcidStore] " << num_reads << " reads"
+            << ": parse and encode text " << parse_time << " s"
+            << ", write binary " << write_time << " s"
+            << ", map binary " << map_time << " s"
+            << ", first scan of mapped blocks " << scan_time << " s"
+            << " (checksum " << checksum << ")"
+            << std::endl;
+
+  std::remove(fastq_path.c_str());
+  std::remove(binary_path.c_str());
+  return 0;
+}
@@ -0,0 +1,162 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/minimizer_index.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
+
+// usage: biosoup_minimizer_index_bench [genome length] [k] [w] [path]
+int main(int argc, char** argv) {
+  std::uint32_t genome_len = argc > 1 ? std::atoi(argv[1]) : 20000000;
+  std::uint32_t k = argc > 2 ? std::atoi(argv[2]) : 15;
+  std::uint32_t w = argc > 3 ? std::atoi(argv[3]) : 10;
+  std::string path = argc > 4 ? argv[4] : "biosoup_minimizer_index_bench.bin";
+
+  std::mt19937 generator(42);
+  std::string genome(genome_len, 'A');
+  for (auto& it : genome) {
+    it = "ACGT"[generator() & 3];
+  }
+  for (std::uint32_t i = 0; i < genome_len / 10000; ++i) {  // 10% repeats
+    std::uint32_t len = 500 + generator() % 1000;
+    std::uint32_t begin = generator() % (genome_len - len);
+    genome.replace(
+        generator() % (genome_len - len), len, genome, begin, len);
+  }
+  std::vector<std::unique_ptr<biosoup::NucleicAcid>> contigs;
+  for (std::uint32_t i = 0; i < 16; ++i) {
+    contigs.emplace_back(new biosoup::NucleicAcid(
+        "contig",
+        genome.substr(genome_len / 16 * i, genome_len / 16)));
+    contigs.back()->id = i;
+  }
+  std::vector<std::unique_ptr<biosoup::NucleicAcid>> reads;
+  std::uint64_t num_bases = 0;
+  for (std::uint32_t i = 0; i < 2000; ++i) {
+    std::uint32_t len = 5000 + generator() % 10000;
+    std::string data = genome.substr(generator() % (genome_len - len), len);
+    for (std::uint32_t j = 0; j < len / 20; ++j) {  // 5% substitutions
+      data[generator() % len] = "ACGT"[generator() & 3];
+    }
+    reads.emplace_back(new biosoup::NucleicAcid("read", data));
+    if (i & 1) {
+      reads.back()->ReverseAndComplement();
+    }
+    num_bases += len;
+  }
+
+  biosoup::Timer timer{};
+  std::uint64_t checksum = 0;
+
+  // std::unordered_map of location vectors, as done by hand
+  {
+    timer.Start();
+    std::unordered_map<std::uint64_t, std::vector<biosoup::MinimizerLocation>> index;  // NOLINT
+    std::vector<biosoup::Kmer> minimizers;
+    for (const auto& it : contigs) {
+      minimizers.clear();
+      biosoup::Minimize(*it, k, w, &minimizers);
+      for (const auto& jt : minimizers) {
+        index[jt.value].push_back(biosoup::MinimizerLocation{
+            static_cast<std::uint32_t>(it->id),
+            jt.position << 1 | jt.strand});
+      }
+    }
+    double time = timer.Stop();
+    std::uint64_t num_bytes = index.bucket_count() * sizeof(void*);
+    for (const auto& it : index) {
+      num_bytes += 32 + sizeof(it) +
+          it.second.capacity() * sizeof(biosoup::MinimizerLocation);
+    }
+    std::cout << "[biosoup::MinimizerIndex] std::unordered_map build: "
+              << genome_len / time / 1e6 << " M bases/s, ~"
+              << (num_bytes >> 20) << " MiB" << std::endl;
+
+    timer.Start();
+    std::vector<biosoup::MinimizerHit> hits;
+    for (const auto& it : reads) {
+      hits.clear();
+      minimizers.clear();
+      biosoup::Minimize(*it, k, w, &minimizers);
+      for (const auto& jt : minimizers) {
+        auto kt = index.find(jt.value);
+        if (kt == index.end()) {
+          continue;
+        }
+        for (const auto& lt : kt->second) {
+          hits.push_back(biosoup::MinimizerHit{
+              lt.id, lt.position(), jt.position, jt.strand == lt.strand()});
+        }
+      }
+      checksum += hits.size();
+    }
+    time = timer.Stop();
+    std::cout << "[biosoup::MinimizerIndex] std::unordered_map query: "
+              << num_bases / time / 1e6 << " M bases/s" << std::endl;
+  }
+
+  std::vector<std::uint32_t> num_threads{1};
+  while (num_threads.back() * 2 <= std::thread::hardware_concurrency()) {
+    num_threads.emplace_back(num_threads.back() * 2);
+  }
+  for (auto it : num_threads) {
+    timer.Start();
+    biosoup::MinimizerIndex m{contigs, k, w, 0.0002, it};
+    double time = timer.Stop();
+    checksum += m.num_locations();
+    std::cout << "[biosoup::MinimizerIndex] " << it << " thread(s) build: "
+              << genome_len / time / 1e6 << " M bases/s, "
+              << (m.memory_usage() >> 20) << " MiB, "
+              << m.num_minimizers() << " minimizers, "
+              << m.num_masked() << " masked" << std::endl;
+    if (it == 1) {
+      std::vector<biosoup::MinimizerHit> hits;
+      timer.Start();
+      for (const auto& jt : reads) {
+        hits.clear();
+        checksum += m.Query(*jt, &hits);
+      }
+      time = timer.Stop();
+      std::cout << "[biosoup::MinimizerIndex] query: "
+                << num_bases / time / 1e6 << " M bases/s" << std::endl;
+
+      timer.Start();
+      m.Write(path);
+      time = timer.Stop();
+      std::cout << "[biosoup::MinimizerIndex] write: "
+                << time * 1e3 << " ms" << std::endl;
+    }
+  }
+
+  timer.Start();
+  biosoup::MinimizerIndex m{path};
+  double time = timer.Stop();
+  std::cout << "[biosoup::MinimizerIndex] mapped: "
+            << time * 1e3 << " ms" << std::endl;
+
+  std::vector<biosoup::MinimizerHit> hits;
+  timer.Start();
+  for (const auto& it : reads) {
+    hits.clear();
+    checksum += m.Query(*it, &hits);
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::MinimizerIndex] query (mapped): "
+            << num_bases / time / 1e6 << " M bases/s" << std::endl;
+
+  std::remove(path.c_str());
+  std::cout << "[biosoup::MinimizerIndex] checksum " << checksum << std::endl;
+
+  return 0;
+}
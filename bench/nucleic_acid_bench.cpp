@@ -0,0 +1,207 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/nucleic_acid.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
+
+std::atomic<std::uint64_t> num_allocations{0};
+
+void* operator new(std::size_t size) {
+  ++num_allocations;
+  if (void* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+namespace {
+
+using DeflateFunction = bool (*)(const char*, std::uint32_t, std::uint64_t*);
+using InflateFunction =
+    void (*)(const std::uint64_t*, std::uint32_t, std::uint32_t, bool, char*);
+
+// per base loops used before the word parallel kernels
+bool DeflateBaseline(
+    const char* data, std::uint32_t data_len,
+    std::uint64_t* dst) {
+  std::uint64_t block = 0;
+  for (std::uint32_t i = 0; i < data_len; ++i) {
+    std::uint64_t c = biosoup::kNucleotideCoder[static_cast<std::uint8_t>(data[i])];  // NOLINT
+    if (c == 255ULL) {
+      return false;
+    }
+    block |= c << ((i << 1) & 63);
+    if (((i + 1) & 31) == 0 || i == data_len - 1) {
+      *dst++ = block;
+      block = 0;
+    }
+  }
+  return true;
+}
+
+void InflateBaseline(
+    const std::uint64_t* src,
+    std::uint32_t begin, std::uint32_t len,
+    bool is_reverse_complement,
+    char* dst) {
+  for (std::uint32_t i = 0; i < len; ++i) {
+    std::uint32_t j = is_reverse_complement ? begin + len - i - 1 : begin + i;
+    std::uint64_t x = is_reverse_complement ? 3 : 0;
+    dst[i] = biosoup::kNucleotideDecoder[((src[j >> 5] >> ((j << 1) & 63)) & 3) ^ x];  // NOLINT
+  }
+}
+
+double Throughput(std::uint64_t bytes, std::uint32_t repeats, double seconds) {
+  return bytes * repeats / seconds / 1e9;
+}
+
+// short windows of many reads, as inflated by consensus stages
+void BenchmarkWindows() {
+  std::mt19937 generator(42);
+  std::vector<std::unique_ptr<biosoup::NucleicAcid>> reads;
+  for (std::uint32_t i = 0; i < 200; ++i) {
+    std::string data(50000, 'A'), quality(50000, '!');
+    for (std::uint32_t j = 0; j < data.size(); ++j) {
+      data[j] = "ACGT"[generator() & 3];
+      quality[j] = '!' + generator() % 40;
+    }
+    reads.emplace_back(new biosoup::NucleicAcid("read", data, quality));
+  }
+  std::vector<biosoup::InflateRequest> requests(1U << 20);
+  for (auto& it : requests) {
+    it.nucleic_acid = reads[generator() % reads.size()].get();
+    it.begin = generator() % (50000 - 500);
+    it.len = 500;
+  }
+
+  biosoup::Timer timer{};
+  std::uint64_t checksum = 0;
+  auto report = [&] (const char* name, std::uint64_t allocations) -> void {
+    double time = timer.Stop();
+    std::cout << "[biosoup::NucleicAcid] windows " << name << ": "
+              << requests.size() / time / 1e6 << " M windows/s, "
+              << static_cast<double>(allocations) / requests.size()
+              << " allocations/window" << std::endl;
+  };
+
+  std::uint64_t allocations = num_allocations;
+  timer.Start();
+  for (const auto& it : requests) {
+    checksum += it.nucleic_acid->InflateData(it.begin, it.len)[0];
+    checksum += it.nucleic_acid->InflateQuality(it.begin, it.len)[0];
+  }
+  report("std::string", num_allocations - allocations);
+
+  allocations = num_allocations;
+  timer.Start();
+  std::string data, quality;
+  for (const auto& it : requests) {
+    it.nucleic_acid->InflateData(it.begin, it.len, &data);
+    it.nucleic_acid->InflateQuality(it.begin, it.len, &quality);
+    checksum += data[0] + quality[0];
+  }
+  report("reused buffers", num_allocations - allocations);
+
+  std::vector<std::uint32_t> num_threads{1};
+  while (num_threads.back() * 2 <= std::thread::hardware_concurrency()) {
+    num_threads.emplace_back(num_threads.back() * 2);
+  }
+  std::vector<std::uint64_t> data_offsets, quality_offsets;
+  std::vector<biosoup::InflateRequest> batch;
+  for (auto it : num_threads) {
+    allocations = num_allocations;
+    timer.Start();
+    for (std::size_t i = 0; i < requests.size(); i += 4096) {
+      batch.assign(
+          requests.begin() + i,
+          requests.begin() + std::min(requests.size(), i + 4096));
+      biosoup::InflateDataBatch(batch, &data, &data_offsets, it);
+      biosoup::InflateQualityBatch(batch, &quality, &quality_offsets, it);
+      checksum += data[data_offsets[7]] + quality[quality_offsets[7]];
+    }
+    std::string name = "batches of 4096, " + std::to_string(it) + " thread(s)";  // NOLINT
+    report(name.c_str(), num_allocations - allocations);
+  }
+  std::cout << "[biosoup::NucleicAcid] checksum " << checksum << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::uint32_t mib = argc > 1 ? std::atoi(argv[1]) : 64;
+  std::uint32_t repeats = argc > 2 ? std::atoi(argv[2]) : 8;
+
+  std::mt19937 generator(42);
+  std::string data(mib << 20, 'A');
+  for (auto& it : data) {
+    it = "ACGTacgt"[generator() & 7];
+  }
+  std::vector<std::uint64_t> deflated((data.size() + 31) >> 5);
+  std::string inflated(data.size(), 'A');
+
+  std::vector<std::pair<const char*, DeflateFunction>> deflaters{
+      {"baseline", DeflateBaseline},
+      {"scalar", biosoup::detail::DeflateScalar}};
+  std::vector<std::pair<const char*, InflateFunction>> inflaters{
+      {"baseline", InflateBaseline},
+      {"scalar", biosoup::detail::InflateScalar}};
+#if defined(BIOSOUP_X86_DISPATCH)
+  if (biosoup::detail::simd_level() >= biosoup::detail::SimdLevel::kSse42) {
+    deflaters.emplace_back("sse4.2", biosoup::detail::DeflateSse42);
+    inflaters.emplace_back("sse4.2", biosoup::detail::InflateSse42);
+  }
+  if (biosoup::detail::simd_level() >= biosoup::detail::SimdLevel::kAvx2) {
+    deflaters.emplace_back("avx2", biosoup::detail::DeflateAvx2);
+    inflaters.emplace_back("avx2", biosoup::detail::InflateAvx2);
+  }
+#endif
+
+  biosoup::Timer timer{};
+  for (const auto& it : deflaters) {
+    timer.Start();
+    for (std::uint32_t i = 0; i < repeats; ++i) {
+      it.second(data.c_str(), data.size(), deflated.data());
+    }
+    std::cout << "[biosoup::NucleicAcid] deflate " << it.first << ": "
+              << Throughput(data.size(), repeats, timer.Stop()) << " GB/s"
+              << std::endl;
+  }
+  for (const auto& it : inflaters) {
+    for (bool is_reverse_complement : {false, true}) {
+      timer.Start();
+      for (std::uint32_t i = 0; i < repeats; ++i) {
+        it.second(
+            deflated.data(), 1, data.size() - 2,
+            is_reverse_complement,
+            &inflated[0]);
+      }
+      std::cout << "[biosoup::NucleicAcid] inflate"
+                << (is_reverse_complement ? " (reverse complement) " : " ")
+                << it.first << ": "
+                << Throughput(data.size(), repeats, timer.Stop()) << " GB/s"
+                << std::endl;
+    }
+  }
+
+  BenchmarkWindows();
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/nucleic_acid_compare.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
+
+namespace {
+
+using CompareFunction = std::uint32_t (*)(
+    const std::uint64_t*, const std::uint64_t*, std::uint32_t);
+
+}  // namespace
+
+// usage: biosoup_nucleic_acid_compare_bench [length] [window length]
+int main(int argc, char** argv) {
+  std::uint32_t len = argc > 1 ? std::atoi(argv[1]) : 1U << 24;
+  std::uint32_t window_len = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+  std::mt19937 generator(42);
+  std::string data(len, 'A');
+  for (auto& it : data) {
+    it = "ACGT"[generator() & 3];
+  }
+  std::string other = data;
+  for (std::uint32_t i = 0; i < len / 100; ++i) {
+    other[generator() % len] = "ACGT"[generator() & 3];
+  }
+  biosoup::NucleicAcid lhs{"lhs", data}, rhs{"rhs", other};
+
+  biosoup::Timer timer{};
+  std::uint64_t checksum = 0;
+
+  std::vector<std::pair<const char*, CompareFunction>> kernels{
+      {"scalar", biosoup::detail::HammingDistanceScalar}};
+#if defined(BIOSOUP_X86_DISPATCH)
+  if (biosoup::detail::simd_level() >= biosoup::detail::SimdLevel::kSse42) {
+    kernels.emplace_back("sse4.2", biosoup::detail::HammingDistanceSse42);
+  }
+  if (biosoup::detail::simd_level() >= biosoup::detail::SimdLevel::kAvx2) {
+    kernels.emplace_back("avx2", biosoup::detail::HammingDistanceAvx2);
+  }
+#endif
+  for (const auto& it : kernels) {
+    timer.Start();
+    for (std::uint32_t i = 0; i < 16; ++i) {
+      checksum += it.second(
+          lhs.deflated_data.data(), rhs.deflated_data.data(), len);
+    }
+    std::cout << "[biosoup::NucleicAcidCompare] Hamming distance "
+              << it.first << ": " << 16. * len / timer.Stop() / 1e9
+              << " G bases/s" << std::endl;
+  }
+
+  std::vector<std::uint32_t> offsets(1U << 16);
+  for (auto& it : offsets) {
+    it = generator() % (len - window_len);
+  }
+  auto report = [&] (const char* name) -> void {
+    double time = timer.Stop();
+    std::cout << "[biosoup::NucleicAcidCompare] " << name << ": "
+              << offsets.size() / time / 1e6 << " M windows/s" << std::endl;
+  };
+
+  // inflating both sides and comparing characters, as done by hand
+  timer.Start();
+  std::string a(window_len, 'A'), b(window_len, 'A');
+  for (std::uint32_t i = 0; i < offsets.size(); ++i) {
+    lhs.InflateData(offsets[i], window_len, &a[0]);
+    rhs.InflateData(offsets[(i + 1) & 0xFFFF], window_len, &b[0]);
+    for (std::uint32_t j = 0; j < window_len; ++j) {
+      checksum += a[j] != b[j];
+    }
+  }
+  report("inflated Hamming distance");
+
+  biosoup::NucleicAcidView l{lhs}, r{rhs};
+  for (int k = 0; k < 2; ++k, l.ReverseAndComplement()) {
+    timer.Start();
+    for (std::uint32_t i = 0; i < offsets.size(); ++i) {
+      checksum += biosoup::HammingDistance(
+          l.Slice(offsets[i], window_len),
+          r.Slice(offsets[(i + 1) & 0xFFFF], window_len));
+    }
+    report(k ? "packed Hamming distance (reverse complement)" :
+               "packed Hamming distance");
+  }
+
+  timer.Start();
+  for (std::uint32_t i = 0; i < offsets.size(); ++i) {
+    lhs.InflateData(offsets[i], window_len, &a[0]);
+    rhs.InflateData(offsets[i], window_len, &b[0]);
+    std::uint32_t j = 0;
+    while (j < window_len && a[j] == b[j]) {
+      ++j;
+    }
+    checksum += j;
+  }
+  report("inflated common prefix");
+
+  timer.Start();
+  for (std::uint32_t i = 0; i < offsets.size(); ++i) {
+    checksum += biosoup::CommonPrefixLength(
+        l.Slice(offsets[i], window_len),
+        r.Slice(offsets[i], window_len));
+  }
+  report("packed common prefix");
+
+  timer.Start();
+  for (std::uint32_t i = 0; i < offsets.size(); ++i) {
+    lhs.InflateData(offsets[i], window_len, &a[0]);
+    for (std::uint32_t j = 0; j < window_len; ++j) {
+      checksum += a[j] == 'C' || a[j] == 'G';
+    }
+  }
+  report("inflated GC count");
+
+  timer.Start();
+  for (std::uint32_t i = 0; i < offsets.size(); ++i) {
+    checksum += biosoup::GcCount(l.Slice(offsets[i], window_len));
+  }
+  report("packed GC count");
+
+  std::cout << "[biosoup::NucleicAcidCompare] checksum " << checksum
+            << std::endl;
+
+  return 0;
+}
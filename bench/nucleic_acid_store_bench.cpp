@@ -0,0 +1,114 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/nucleic_acid_store.hpp"
+
+#include <sys/resource.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
+
+namespace {
+
+std::uint64_t num_allocations = 0;
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  ++num_allocations;
+  if (void* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+namespace {
+
+long PeakRss() {  // NOLINT
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+}  // namespace
+
+// usage: biosoup_nucleic_acid_store_bench [objects|store] [reads] [length]
+// run each mode separately to get a meaningful peak RSS
+int main(int argc, char** argv) {
+  std::string mode = argc > 1 ? argv[1] : "store";
+  std::uint32_t num_reads = argc > 2 ? std::atoi(argv[2]) : 200000;
+  std::uint32_t read_len = argc > 3 ? std::atoi(argv[3]) : 2000;
+
+  std::mt19937 generator(42);
+  std::string data(read_len, 'A');
+  std::string quality(read_len, '!');
+  for (std::uint32_t i = 0; i < read_len; ++i) {
+    data[i] = "ACGT"[generator() & 3];
+    quality[i] = '!' + generator() % 40;
+  }
+
+  biosoup::Timer timer{};
+  std::uint64_t allocations = num_allocations;
+  std::uint64_t checksum = 0;
+  double build_time = 0, teardown_time = 0;
+  if (mode == "objects") {
+    timer.Start();
+    std::unique_ptr<std::vector<biosoup::NucleicAcid>> reads(
+        new std::vector<biosoup::NucleicAcid>());
+    for (std::uint32_t i = 0; i < num_reads; ++i) {
+      reads->emplace_back("read" + std::to_string(i), data, quality);
+    }
+    build_time = timer.Stop();
+    for (const auto& it : *reads) {
+      checksum += it.Code(it.inflated_len / 2);
+    }
+    allocations = num_allocations - allocations;
+    timer.Start();
+    reads.reset();
+    teardown_time = timer.Stop();
+  } else {
+    timer.Start();
+    std::unique_ptr<biosoup::NucleicAcidStore> reads(
+        new biosoup::NucleicAcidStore());
+    for (std::uint32_t i = 0; i < num_reads; ++i) {
+      reads->Append("read" + std::to_string(i), data, quality);
+    }
+    build_time = timer.Stop();
+    for (std::size_t i = 0; i < reads->size(); ++i) {
+      auto it = (*reads)[i];
+      checksum += it.Code(it.inflated_len / 2);
+    }
+    allocations = num_allocations - allocations;
+    timer.Start();
+    reads.reset();
+    teardown_time = timer.Stop();
+  }
+
+  std::cout << "[biosoup::NucleicAcidStore] " << mode
+            << ": build " << build_time << " s"
+            << ", teardown " << teardown_time << " s"
+            << ", allocations " << allocations
+            << ", peak RSS " << PeakRss() / 1024 << " MiB"
+            << " (checksum " << checksum << ")"
+            << std::endl;
+
+  return 0;
+}
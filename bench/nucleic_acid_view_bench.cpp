@@ -0,0 +1,65 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/nucleic_acid_view.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
+
+// usage: biosoup_nucleic_acid_view_bench [contig length] [window length]
+int main(int argc, char** argv) {
+  std::uint32_t contig_len = argc > 1 ? std::atoi(argv[1]) : 5000000;
+  std::uint32_t window_len = argc > 2 ? std::atoi(argv[2]) : 500;
+
+  std::mt19937 generator(42);
+  std::string data(contig_len, 'A'), quality(contig_len, '!');
+  for (std::uint32_t i = 0; i < contig_len; ++i) {
+    data[i] = "ACGT"[generator() & 3];
+    quality[i] = '!' + generator() % 40;
+  }
+  biosoup::NucleicAcid contig{"contig", data, quality};
+  std::uint32_t num_windows = 2000;
+
+  biosoup::Timer timer{};
+  std::uint64_t checksum = 0;
+
+  // copy of the contig per window, as done by hand when handing windows over
+  timer.Start();
+  for (std::uint32_t i = 0; i < num_windows; ++i) {
+    biosoup::NucleicAcid copy{contig};
+    std::uint32_t begin = (i * 7919ULL * window_len) % (contig_len - window_len);  // NOLINT
+    checksum += copy.InflateData(begin, window_len)[0];
+    checksum += copy.InflateQuality(begin, window_len)[0];
+  }
+  double time = timer.Stop();
+  std::cout << "[biosoup::NucleicAcidView] copy + InflateData: "
+            << num_windows / time / 1e3 << " K windows/s" << std::endl;
+
+  std::string buffer(window_len, '\0');
+  num_windows *= 1000;
+  for (int r = 0; r < 2; ++r, contig.ReverseAndComplement()) {
+    timer.Start();
+    biosoup::NucleicAcidView view{contig};
+    for (std::uint32_t i = 0; i < num_windows; ++i) {
+      std::uint32_t begin = (i * 7919ULL * window_len) % (contig_len - window_len);  // NOLINT
+      biosoup::NucleicAcidView window = view.Slice(begin, window_len);
+      window.InflateData(0, window_len, &buffer[0]);
+      checksum += buffer[0];
+      window.InflateQuality(0, window_len, &buffer[0]);
+      checksum += buffer[0];
+    }
+    time = timer.Stop();
+    std::cout << "[biosoup::NucleicAcidView] Slice + InflateData"
+              << (r ? " (reverse complement): " : ": ")
+              << num_windows / time / 1e3 << " K windows/s" << std::endl;
+  }
+
+  std::cout << "[biosoup::NucleicAcidView] checksum " << checksum << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/object_id.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+struct Object {
+  static std::atomic<biosoup::ObjectId> num_objects;
+};
+
+std::atomic<biosoup::ObjectId> Object::num_objects{0};
+
+// runs f() on num_threads threads, returns elapsed seconds
+template<typename F>
+double Run(std::uint32_t num_threads, F f) {
+  biosoup::Timer timer{};
+  timer.Start();
+  std::vector<std::thread> threads;
+  for (std::uint32_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back(f);
+  }
+  for (auto& it : threads) {
+    it.join();
+  }
+  return timer.Stop();
+}
+
+// usage: biosoup_object_id_bench [ids per thread] [block size]
+int main(int argc, char** argv) {
+  std::uint32_t num_ids = argc > 1 ? std::atoi(argv[1]) : 50000000;
+  std::uint32_t block_size = argc > 2 ? std::atoi(argv[2]) : 4096;
+
+  std::vector<std::uint32_t> num_threads{1};
+  while (num_threads.back() * 2 <= 4 * std::thread::hardware_concurrency()) {
+    num_threads.emplace_back(num_threads.back() * 2);
+  }
+
+  std::atomic<std::uint64_t> checksum{0};
+  for (auto it : num_threads) {
+    double total = static_cast<double>(num_ids) * it;
+
+    // num_objects++ in every constructor
+    double time = Run(it, [&] () -> void {
+      std::uint64_t sum = 0;
+      for (std::uint32_t i = 0; i < num_ids; ++i) {
+        sum += Object::num_objects++;
+      }
+      checksum += sum;
+    });
+    std::cout << "[biosoup::ObjectId] global atomic, " << it << " thread(s): "
+              << total / time / 1e6 << " M ids/s" << std::endl;
+
+    time = Run(it, [&] () -> void {
+      std::uint64_t sum = 0;
+      for (std::uint32_t i = 0; i < num_ids; i += block_size) {
+        biosoup::IdScope<Object> scope{block_size};
+        for (std::uint32_t j = 0; j < block_size; ++j) {
+          sum += biosoup::NextId<Object>();
+        }
+      }
+      checksum += sum;
+    });
+    std::cout << "[biosoup::ObjectId] IdScope of " << block_size << ", "
+              << it << " thread(s): " << total / time / 1e6 << " M ids/s"
+              << std::endl;
+  }
+
+  std::cout << "[biosoup::ObjectId] checksum " << checksum << std::endl;
+
+  return 0;
+}
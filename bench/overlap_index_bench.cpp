@@ -0,0 +1,165 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/overlap_index.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+// usage: biosoup_overlap_index_bench [reads] [length] [coverage]
+int main(int argc, char** argv) {
+  std::uint32_t num_reads = argc > 1 ? std::atoi(argv[1]) : 50000;
+  std::uint32_t read_len = argc > 2 ? std::atoi(argv[2]) : 10000;
+  std::uint32_t coverage = argc > 3 ? std::atoi(argv[3]) : 30;
+
+  // reads sampled uniformly from a genome, overlaps between all pairs which
+  // share at least 1000 bases
+  std::mt19937 generator(42);
+  std::uint64_t genome_len = static_cast<std::uint64_t>(num_reads) * read_len / coverage;  // NOLINT
+  std::vector<std::uint64_t> begins(num_reads);
+  std::vector<std::uint32_t> lens(num_reads);
+  for (std::uint32_t i = 0; i < num_reads; ++i) {
+    begins[i] = generator() % genome_len;
+    lens[i] = read_len / 2 + generator() % read_len;
+  }
+  std::vector<std::uint32_t> order(num_reads);
+  for (std::uint32_t i = 0; i < num_reads; ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(),
+      [&] (std::uint32_t lhs, std::uint32_t rhs) -> bool {
+        return begins[lhs] < begins[rhs];
+      });
+  std::vector<biosoup::Overlap> overlaps;
+  for (std::uint32_t i = 0; i < num_reads; ++i) {
+    std::uint32_t x = order[i];
+    for (std::uint32_t j = i + 1; j < num_reads; ++j) {
+      std::uint32_t y = order[j];
+      std::uint64_t end = std::min(begins[x] + lens[x], begins[y] + lens[y]);
+      if (begins[y] + 1000 > begins[x] + lens[x]) {
+        break;
+      }
+      if (end < begins[y] + 1000) {
+        continue;
+      }
+      overlaps.emplace_back(
+          x, begins[y] - begins[x], end - begins[x],
+          y, 0, end - begins[y],
+          end - begins[y]);
+    }
+  }
+  std::cout << "[biosoup::OverlapIndex] " << overlaps.size() << " overlaps"
+            << std::endl;
+
+  std::vector<std::uint32_t> num_threads{1};
+  while (num_threads.back() * 2 <= std::thread::hardware_concurrency()) {
+    num_threads.emplace_back(num_threads.back() * 2);
+  }
+
+  biosoup::Timer timer{};
+  biosoup::OverlapIndex index{};
+  for (auto it : num_threads) {
+    timer.Start();
+    index = biosoup::OverlapIndex(overlaps, it);
+    double time = timer.Stop();
+    std::cout << "[biosoup::OverlapIndex] build, " << it << " thread(s): "
+              << time << " s" << std::endl;
+  }
+
+  std::uint32_t num_queries = 1000;
+  std::vector<std::uint32_t> ids(num_queries), query_begins(num_queries);
+  for (std::uint32_t i = 0; i < num_queries; ++i) {
+    ids[i] = generator() % num_reads;
+    query_begins[i] = generator() % lens[ids[i]];
+  }
+  std::uint64_t checksum = 0;
+
+  // linear scans, as done by hand in tools using biosoup
+  timer.Start();
+  for (std::uint32_t i = 0; i < num_queries; ++i) {
+    std::uint32_t begin = query_begins[i], end = begin + 500;
+    for (const auto& it : overlaps) {
+      checksum +=
+          (it.lhs_id == ids[i] && it.lhs_begin < end && begin < it.lhs_end) +
+          (it.rhs_id == ids[i] && it.rhs_begin < end && begin < it.rhs_end);
+    }
+  }
+  double time = timer.Stop();
+  std::cout << "[biosoup::OverlapIndex] range, linear scan: "
+            << num_queries / time << " queries/s" << std::endl;
+
+  timer.Start();
+  std::vector<std::uint32_t> found;
+  for (std::uint32_t i = 0; i < num_queries; ++i) {
+    found.clear();
+    index.Find(ids[i], query_begins[i], query_begins[i] + 500, &found);
+    checksum += found.size();
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::OverlapIndex] range, index: "
+            << num_queries / time << " queries/s" << std::endl;
+
+  timer.Start();
+  std::vector<std::uint8_t> is_contained(num_reads, 0);
+  for (const auto& it : overlaps) {
+    if (it.lhs_begin == 0 && it.lhs_end == lens[it.lhs_id]) {
+      is_contained[it.lhs_id] = 1;
+    }
+    if (it.rhs_begin == 0 && it.rhs_end == lens[it.rhs_id]) {
+      is_contained[it.rhs_id] = 1;
+    }
+  }
+  checksum += std::count(is_contained.begin(), is_contained.end(), 1);
+  time = timer.Stop();
+  std::cout << "[biosoup::OverlapIndex] containment, linear scan: "
+            << time << " s" << std::endl;
+
+  for (auto it : num_threads) {
+    timer.Start();
+    checksum += index.ContainedReads(
+        [&] (std::uint32_t id) -> std::uint32_t { return lens[id]; },
+        0,
+        it).size();
+    time = timer.Stop();
+    std::cout << "[biosoup::OverlapIndex] containment, " << it
+              << " thread(s): " << time << " s" << std::endl;
+  }
+
+  timer.Start();
+  for (std::uint32_t i = 0; i < 100; ++i) {
+    std::vector<std::uint32_t> depth(lens[ids[i]], 0);
+    for (const auto& it : overlaps) {
+      if (it.lhs_id == ids[i]) {
+        for (std::uint32_t j = it.lhs_begin; j < it.lhs_end; ++j) {
+          ++depth[j];
+        }
+      }
+      if (it.rhs_id == ids[i]) {
+        for (std::uint32_t j = it.rhs_begin; j < it.rhs_end; ++j) {
+          ++depth[j];
+        }
+      }
+    }
+    checksum += depth[0];
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::OverlapIndex] coverage, linear scan: "
+            << 100 / time << " reads/s" << std::endl;
+
+  timer.Start();
+  for (std::uint32_t i = 0; i < num_queries; ++i) {
+    checksum += index.Coverage(ids[i], 0, lens[ids[i]])[0];
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::OverlapIndex] coverage, index: "
+            << num_queries / time << " reads/s" << std::endl;
+
+  std::cout << "[biosoup::OverlapIndex] checksum " << checksum << std::endl;
+
+  return 0;
+}
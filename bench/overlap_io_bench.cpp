@@ -0,0 +1,158 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/overlap_io.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+// usage: biosoup_overlap_io_bench [overlaps] [memory limit in MiB] [path]
+int main(int argc, char** argv) {
+  std::uint32_t num_overlaps = argc > 1 ? std::atoi(argv[1]) : 5000000;
+  std::uint64_t memory_limit = (argc > 2 ? std::atoi(argv[2]) : 64) * (1ULL << 20);  // NOLINT
+  std::string path = argc > 3 ? argv[3] : "biosoup_overlap_io_bench.paf";
+
+  std::mt19937 generator(42);
+  biosoup::OverlapStore s{};
+  s.Reserve(num_overlaps);
+  for (std::uint32_t i = 0; i < num_overlaps; ++i) {
+    std::uint32_t begin = generator() % 20000;
+    s.Append(
+        generator() % 100000, begin, begin + 1000 + generator() % 5000,
+        generator() % 100000, begin / 2, begin / 2 + 1000 + generator() % 5000,  // NOLINT
+        generator() % 5000,
+        generator() & 1);
+  }
+  auto name = [] (std::uint32_t id) -> std::string {
+    return "read" + std::to_string(id);
+  };
+  auto length = [] (std::uint32_t id) -> std::uint32_t {
+    return 30000 + id % 1000;
+  };
+
+  std::vector<std::uint32_t> num_threads{1};
+  while (num_threads.back() * 2 <= std::thread::hardware_concurrency()) {
+    num_threads.emplace_back(num_threads.back() * 2);
+  }
+
+  biosoup::Timer timer{};
+  std::uint64_t checksum = 0;
+
+  // std::ostream and sscanf, as done by hand in tools using biosoup
+  timer.Start();
+  {
+    std::ofstream os(path);
+    for (std::size_t i = 0; i < s.size(); ++i) {
+      os << name(s.lhs_id(i)) << "\t" << length(s.lhs_id(i)) << "\t"
+         << s.lhs_begin(i) << "\t" << s.lhs_end(i) << "\t"
+         << (s.strand(i) ? '+' : '-') << "\t"
+         << name(s.rhs_id(i)) << "\t" << length(s.rhs_id(i)) << "\t"
+         << s.rhs_begin(i) << "\t" << s.rhs_end(i) << "\t"
+         << s.score(i) << "\t"
+         << std::max(s.lhs_end(i) - s.lhs_begin(i), s.rhs_end(i) - s.rhs_begin(i))  // NOLINT
+         << "\t255\n";
+    }
+  }
+  double time = timer.Stop();
+  std::cout << "[biosoup::WritePaf] std::ostream: "
+            << s.size() / time / 1e6 << " M overlaps/s" << std::endl;
+
+  for (auto it : num_threads) {
+    timer.Start();
+    biosoup::WritePaf(s, name, length, biosoup::WriteFile(path), it);
+    time = timer.Stop();
+    std::cout << "[biosoup::WritePaf] " << it << " thread(s): "
+              << s.size() / time / 1e6 << " M overlaps/s" << std::endl;
+  }
+
+  timer.Start();
+  {
+    std::vector<biosoup::Overlap> dst;
+    std::ifstream is(path);
+    std::string line;
+    char lhs_name[64], rhs_name[64], strand;
+    std::uint32_t lhs_len, lhs_begin, lhs_end, rhs_len, rhs_begin, rhs_end;
+    std::uint32_t score, block_len, quality;
+    while (std::getline(is, line)) {
+      std::sscanf(
+          line.c_str(), "%63s %u %u %u %c %63s %u %u %u %u %u %u",
+          lhs_name, &lhs_len, &lhs_begin, &lhs_end, &strand,
+          rhs_name, &rhs_len, &rhs_begin, &rhs_end,
+          &score, &block_len, &quality);
+      dst.emplace_back(
+          std::atoi(lhs_name + 4), lhs_begin, lhs_end,
+          std::atoi(rhs_name + 4), rhs_begin, rhs_end,
+          score,
+          strand == '+');
+    }
+    checksum += dst.size();
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::OverlapParser] sscanf: "
+            << s.size() / time / 1e6 << " M overlaps/s" << std::endl;
+
+  auto id = [] (const char* name, std::uint32_t) -> std::uint32_t {
+    return std::atoi(name + 4);
+  };
+  for (auto it : num_threads) {
+    timer.Start();
+    biosoup::OverlapParser p{biosoup::ReadFile(path), id, it};
+    for (auto b = p.Parse(1U << 30); !b.empty(); b = p.Parse(1U << 30)) {
+      checksum += b.size();
+    }
+    time = timer.Stop();
+    std::cout << "[biosoup::OverlapParser] " << it << " thread(s): "
+              << s.size() / time / 1e6 << " M overlaps/s" << std::endl;
+  }
+  std::remove(path.c_str());
+
+  timer.Start();
+  {
+    std::vector<biosoup::Overlap> v;
+    v.reserve(s.size());
+    for (std::size_t i = 0; i < s.size(); ++i) {
+      v.emplace_back(s[i]);
+    }
+    std::stable_sort(v.begin(), v.end(),
+        [] (const biosoup::Overlap& lhs, const biosoup::Overlap& rhs) -> bool {  // NOLINT
+          return lhs.lhs_id < rhs.lhs_id ||
+              (lhs.lhs_id == rhs.lhs_id && lhs.lhs_begin < rhs.lhs_begin);
+        });
+    checksum += v.front().lhs_id;
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::OverlapSorter] std::stable_sort in memory: "
+            << time << " s" << std::endl;
+
+  std::vector<std::uint64_t> limits{1ULL << 40, memory_limit};  // in memory
+  for (auto it : num_threads) {
+    for (auto limit : limits) {
+      timer.Start();
+      biosoup::OverlapSorter sorter{biosoup::OverlapSorter::kLhs, limit, ".", it};  // NOLINT
+      for (std::size_t i = 0; i < s.size(); i += 1U << 20) {
+        biosoup::OverlapStore batch{};
+        batch.Append(s, i, std::min<std::size_t>(s.size(), i + (1U << 20)));
+        sorter.Add(batch);
+      }
+      for (auto b = sorter.Next(); !b.empty(); b = sorter.Next()) {
+        checksum += b.lhs_id(0);
+      }
+      time = timer.Stop();
+      std::cout << "[biosoup::OverlapSorter] " << it << " thread(s), "
+                << sorter.num_runs() << " run(s): " << time << " s"
+                << std::endl;
+    }
+  }
+
+  std::cout << "[biosoup::OverlapIo] checksum " << checksum << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/overlap_store.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+// usage: biosoup_overlap_store_bench [overlaps] [reads] [aligned fraction]
+int main(int argc, char** argv) {
+  std::uint32_t num_overlaps = argc > 1 ? std::atoi(argv[1]) : 5000000;
+  std::uint32_t num_reads = argc > 2 ? std::atoi(argv[2]) : 100000;
+  double aligned = argc > 3 ? std::atof(argv[3]) : 0.1;
+
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> distribution(0, 1);
+  std::vector<biosoup::Overlap> overlaps;
+  overlaps.reserve(num_overlaps);
+  for (std::uint32_t i = 0; i < num_overlaps; ++i) {
+    std::uint32_t begin = generator() % 20000;
+    overlaps.emplace_back(
+        generator() % num_reads, begin, begin + 5000,
+        generator() % num_reads, 0, 5000,
+        generator() % 5000,
+        static_cast<bool>(generator() & 1));
+    if (distribution(generator) < aligned) {
+      for (std::uint32_t j = 0; j < 20; ++j) {
+        overlaps.back().alignment += std::to_string(generator() % 500 + 1);
+        overlaps.back().alignment += "MID"[j % 3];
+      }
+    }
+  }
+
+  std::uint64_t memory = overlaps.capacity() * sizeof(biosoup::Overlap);
+  for (const auto& it : overlaps) {
+    if (it.alignment.capacity() > 15) {  // beyond small string optimization
+      memory += it.alignment.capacity() + 1;
+    }
+  }
+  std::cout << "[biosoup::OverlapStore] std::vector<Overlap>: "
+            << memory / static_cast<double>(num_overlaps) << " B/overlap"
+            << std::endl;
+
+  biosoup::Timer timer{};
+  biosoup::OverlapStore store{};
+  store.Reserve(num_overlaps);
+  timer.Start();
+  for (const auto& it : overlaps) {
+    store.Append(it);
+  }
+  double time = timer.Stop();
+  std::cout << "[biosoup::OverlapStore] OverlapStore: "
+            << store.memory_usage() / static_cast<double>(num_overlaps)
+            << " B/overlap, conversion " << num_overlaps / time / 1e6
+            << " M overlaps/s" << std::endl;
+
+  timer.Start();
+  std::stable_sort(overlaps.begin(), overlaps.end(),
+      [] (const biosoup::Overlap& lhs, const biosoup::Overlap& rhs) {
+        return lhs.lhs_id < rhs.lhs_id ||
+            (lhs.lhs_id == rhs.lhs_id && lhs.lhs_begin < rhs.lhs_begin);
+      });
+  time = timer.Stop();
+  std::cout << "[biosoup::OverlapStore] std::stable_sort: "
+            << time << " s" << std::endl;
+
+  timer.Start();
+  store.SortByLhs();
+  time = timer.Stop();
+  std::cout << "[biosoup::OverlapStore] SortByLhs: "
+            << time << " s" << std::endl;
+
+  timer.Start();
+  overlaps.erase(std::remove_if(overlaps.begin(), overlaps.end(),
+      [] (const biosoup::Overlap& o) { return o.score < 2500; }),
+      overlaps.end());
+  time = timer.Stop();
+  std::cout << "[biosoup::OverlapStore] std::remove_if: "
+            << time << " s" << std::endl;
+
+  timer.Start();
+  store.Filter([&] (std::uint32_t i) { return store.score(i) >= 2500; });
+  time = timer.Stop();
+  std::cout << "[biosoup::OverlapStore] Filter: "
+            << time << " s" << std::endl;
+
+  std::cout << "[biosoup::OverlapStore] checksum "
+            << overlaps.size() + store.size() << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/packed_quality.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "biosoup/timer.hpp"
+
+// usage: biosoup_packed_quality_bench [reads] [length]
+int main(int argc, char** argv) {
+  std::uint32_t num_reads = argc > 1 ? std::atoi(argv[1]) : 1000;
+  std::uint32_t read_len = argc > 2 ? std::atoi(argv[2]) : 20000;
+
+  std::mt19937 generator(42);
+  std::normal_distribution<double> distribution(18, 8);  // long read like
+  std::vector<std::vector<std::int8_t>> reads(num_reads);
+  for (auto& it : reads) {
+    it.resize(read_len);
+    for (auto& jt : it) {
+      jt = std::max(0., std::min(50., distribution(generator)));
+    }
+  }
+
+  biosoup::Timer timer{};
+  std::string dst(read_len, '!');
+  std::uint64_t checksum = 0;
+
+  std::uint64_t memory = 0;
+  timer.Start();
+  for (const auto& it : reads) {
+    memory += it.capacity();
+    for (std::uint32_t i = 0; i < read_len; ++i) {
+      dst[i] = it[i] + '!';
+    }
+    checksum += dst[read_len / 2];
+  }
+  double time = timer.Stop();
+  std::cout << "[biosoup::PackedQuality] int8_t: "
+            << memory / static_cast<double>(num_reads * read_len)
+            << " B/score, inflate "
+            << num_reads * read_len / time / 1e9 << " G scores/s"
+            << std::endl;
+
+  for (int lossy = 0; lossy < 2; ++lossy) {
+    std::vector<biosoup::PackedQuality> packed;
+    timer.Start();
+    for (const auto& it : reads) {
+      if (lossy) {
+        packed.emplace_back(
+            it.data(), read_len, biosoup::QualityBinning::Illumina());
+      } else {
+        packed.emplace_back(it.data(), read_len);
+      }
+    }
+    double pack_time = timer.Stop();
+
+    memory = 0;
+    timer.Start();
+    for (const auto& it : packed) {
+      memory += it.memory_usage();
+      it.Inflate(0, read_len, false, &dst[0]);
+      checksum += dst[read_len / 2];
+    }
+    double inflate_time = timer.Stop();
+
+    timer.Start();
+    for (const auto& it : packed) {
+      for (std::uint32_t i = 0; i < read_len; i += 7) {
+        checksum += it[i];
+      }
+    }
+    double score_time = timer.Stop();
+
+    std::cout << "[biosoup::PackedQuality] "
+              << (lossy ? "binned (Illumina)" : "lossless")
+              << ": " << memory / static_cast<double>(num_reads * read_len)
+              << " B/score, pack "
+              << num_reads * read_len / pack_time / 1e9 << " G scores/s"
+              << ", inflate "
+              << num_reads * read_len / inflate_time / 1e9 << " G scores/s"
+              << ", random Score "
+              << num_reads * (read_len / 7) / score_time / 1e9 << " G scores/s"
+              << std::endl;
+  }
+  std::cout << "[biosoup::PackedQuality] checksum " << checksum << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/parser.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "biosoup/nucleic_acid.hpp"
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
+
+// usage: biosoup_parser_bench [reads] [length] [path]
+int main(int argc, char** argv) {
+  std::uint32_t num_reads = argc > 1 ? std::atoi(argv[1]) : 20000;
+  std::uint32_t read_len = argc > 2 ? std::atoi(argv[2]) : 5000;
+  std::string path = argc > 3 ? argv[3] : "biosoup_parser_bench.fastq";
+
+  std::mt19937 generator(42);
+  {
+    std::ofstream os(path);
+    std::string data(read_len, 'A'), quality(read_len, '!');
+    for (std::uint32_t i = 0; i < num_reads; ++i) {
+      for (std::uint32_t j = 0; j < read_len; ++j) {
+        data[j] = "ACGT"[generator() & 3];
+        quality[j] = '!' + generator() % 40;
+      }
+      os << "@read" << i << "\n" << data << "\n+\n" << quality << "\n";
+    }
+  }
+  double num_bytes = num_reads * (2. * read_len + 16);
+
+  biosoup::Timer timer{};
+  std::uint64_t checksum = 0;
+
+  // line by line, as done by hand in tools using biosoup
+  timer.Start();
+  {
+    std::ifstream is(path);
+    std::string name, data, plus, quality;
+    std::vector<std::unique_ptr<biosoup::NucleicAcid>> dst;
+    while (std::getline(is, name) && std::getline(is, data) &&
+           std::getline(is, plus) && std::getline(is, quality)) {
+      dst.emplace_back(new biosoup::NucleicAcid(
+          name.c_str() + 1, name.size() - 1,
+          data.c_str(), data.size(),
+          quality.c_str(), quality.size()));
+    }
+    checksum += dst.size();
+  }
+  double time = timer.Stop();
+  std::cout << "[biosoup::Parser] std::getline: "
+            << num_bytes / time / 1e6 << " MB/s" << std::endl;
+
+  std::vector<std::uint32_t> num_threads{1};
+  while (num_threads.back() * 2 <= std::thread::hardware_concurrency()) {
+    num_threads.emplace_back(num_threads.back() * 2);
+  }
+  for (auto it : num_threads) {
+    timer.Start();
+    biosoup::Parser<biosoup::NucleicAcid> p{biosoup::ReadFile(path), it};
+    for (auto b = p.Parse(1U << 30); !b.empty(); b = p.Parse(1U << 30)) {
+      checksum += b.size();
+    }
+    time = timer.Stop();
+    std::cout << "[biosoup::Parser] " << it << " thread(s): "
+              << num_bytes / time / 1e6 << " MB/s" << std::endl;
+  }
+
+  timer.Start();
+  {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    std::vector<char> buffer(1U << 22);
+    while (std::size_t n = std::fread(buffer.data(), 1, buffer.size(), f)) {
+      checksum += buffer[n - 1];
+    }
+    std::fclose(f);
+  }
+  time = timer.Stop();
+  std::cout << "[biosoup::Parser] fread only: "
+            << num_bytes / time / 1e6 << " MB/s" << std::endl;
+
+#if defined(BIOSOUP_USE_ZLIB)
+  {
+    std::string gz_path = path + ".gz";
+    gzFile f = gzopen(gz_path.c_str(), "wb1");
+    std::ifstream is(path, std::ios::binary);
+    std::vector<char> buffer(1U << 22);
+    while (is.read(buffer.data(), buffer.size()), is.gcount() > 0) {
+      gzwrite(f, buffer.data(), is.gcount());
+    }
+    gzclose(f);
+
+    timer.Start();
+    biosoup::Parser<biosoup::NucleicAcid> p{
+        biosoup::ReadGzipFile(gz_path),
+        std::thread::hardware_concurrency()};
+    for (auto b = p.Parse(1U << 30); !b.empty(); b = p.Parse(1U << 30)) {
+      checksum += b.size();
+    }
+    time = timer.Stop();
+    std::cout << "[biosoup::Parser] gzip, "
+              << std::thread::hardware_concurrency() << " thread(s): "
+              << num_bytes / time / 1e6 << " MB/s" << std::endl;
+    std::remove(gz_path.c_str());
+  }
+#endif
+
+  std::remove(path.c_str());
+  std::cout << "[biosoup::Parser] checksum " << checksum << std::endl;
+
+  return 0;
+}
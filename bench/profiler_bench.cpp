@@ -0,0 +1,64 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/profiler.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+#include "biosoup/timer.hpp"
+
+// usage: biosoup_profiler_bench [scopes]
+int main(int argc, char** argv) {
+  std::uint32_t num_scopes = argc > 1 ? std::atoi(argv[1]) : 10000000;
+
+  biosoup::Timer timer{};
+  volatile std::uint64_t sink = 0;
+
+  // without scopes, as with BIOSOUP_DISABLE_PROFILER defined
+  timer.Start();
+  for (std::uint32_t i = 0; i < num_scopes; ++i) {
+    sink = sink + i;
+  }
+  double base = timer.Stop();
+  std::cout << "[biosoup::Profiler] compiled out: "
+            << base / num_scopes * 1e9 << " ns/scope" << std::endl;
+
+  // a Timer per scope, as done by hand in tools using biosoup
+  timer.Start();
+  double total = 0;
+  for (std::uint32_t i = 0; i < num_scopes; ++i) {
+    biosoup::Timer t{};
+    t.Start();
+    sink = sink + i;
+    total += t.Stop();
+  }
+  double time = timer.Stop();
+  std::cout << "[biosoup::Profiler] biosoup::Timer: "
+            << (time - base) / num_scopes * 1e9 << " ns/scope" << std::endl;
+
+  for (bool use_tsc : {false, true}) {
+    for (bool is_enabled : {false, true}) {
+      biosoup::Profiler p{use_tsc};
+      p.set_is_enabled(is_enabled);
+      timer.Start();
+      for (std::uint32_t i = 0; i < num_scopes; ++i) {
+        BIOSOUP_PROFILE_SCOPE(&p, "scope");
+        sink = sink + i;
+      }
+      time = timer.Stop();
+      std::cout << "[biosoup::Profiler] " << (use_tsc ? "tsc" : "steady_clock")  // NOLINT
+                << (is_enabled ? ", enabled: " : ", disabled: ")
+                << (time - base) / num_scopes * 1e9 << " ns/scope" << std::endl;
+      if (is_enabled) {
+        auto s = p.Summary();
+        std::cout << "[biosoup::Profiler] " << s[0].path << " " << s[0].count
+                  << " x, p50 " << s[0].p50 * 1e9 << " ns" << std::endl;
+      }
+    }
+  }
+
+  std::cout << "[biosoup::Profiler] checksum " << sink + (total > 0)
+            << std::endl;
+
+  return 0;
+}
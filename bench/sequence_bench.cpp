@@ -0,0 +1,91 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/sequence.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+std::atomic<biosoup::ObjectId> biosoup::Sequence::num_objects{0};
+
+// switch based implementation preceding the table driven one
+void ReverseAndComplementBySwitch(biosoup::Sequence* s) {
+  for (auto& it : s->data) {
+    switch (static_cast<char>(std::toupper(static_cast<unsigned char>(it)))) {
+      case 'A': it = 'T'; break;
+      case 'C': it = 'G'; break;
+      case 'G': it = 'C'; break;
+      case 'T': case 'U': it = 'A'; break;
+      case 'R': it = 'Y'; break;
+      case 'Y': it = 'R'; break;
+      case 'K': it = 'M'; break;
+      case 'M': it = 'K'; break;
+      case 'B': it = 'V'; break;
+      case 'D': it = 'H'; break;
+      case 'H': it = 'D'; break;
+      case 'V': it = 'B'; break;
+      default: break;
+    }
+  }
+  std::reverse(s->data.begin(), s->data.end());
+  std::reverse(s->quality.begin(), s->quality.end());
+}
+
+// usage: biosoup_sequence_bench [sequences] [length] [repeats]
+int main(int argc, char** argv) {
+  std::uint32_t num_sequences = argc > 1 ? std::atoi(argv[1]) : 100;
+  std::uint32_t sequence_len = argc > 2 ? std::atoi(argv[2]) : 1000000;
+  std::uint32_t num_repeats = argc > 3 ? std::atoi(argv[3]) : 10;
+
+  std::mt19937 generator(42);
+  std::vector<biosoup::Sequence> sequences;
+  std::string data(sequence_len, 'A'), quality(sequence_len, '!');
+  for (std::uint32_t i = 0; i < num_sequences; ++i) {
+    for (std::uint32_t j = 0; j < sequence_len; ++j) {
+      data[j] = "ACGTacgtN"[generator() % 9];
+      quality[j] = '!' + generator() % 40;
+    }
+    sequences.emplace_back("bench", data, quality);
+  }
+  double num_bases =
+      static_cast<double>(num_sequences) * sequence_len * num_repeats;
+
+  biosoup::Timer timer{};
+  for (int with_quality = 1; with_quality >= 0; --with_quality) {
+    if (!with_quality) {
+      for (auto& it : sequences) {
+        it.quality.clear();
+      }
+    }
+
+    timer.Start();
+    for (std::uint32_t i = 0; i < num_repeats; ++i) {
+      for (auto& it : sequences) {
+        ReverseAndComplementBySwitch(&it);
+      }
+    }
+    double time = timer.Stop();
+    std::cout << "[biosoup::Sequence] switch"
+              << (with_quality ? " with quality" : "") << ": "
+              << num_bases / time / 1e9 << " G bases/s" << std::endl;
+
+    timer.Start();
+    for (std::uint32_t i = 0; i < num_repeats; ++i) {
+      for (auto& it : sequences) {
+        it.ReverseAndComplement();
+      }
+    }
+    time = timer.Stop();
+    std::cout << "[biosoup::Sequence] ReverseAndComplement"
+              << (with_quality ? " with quality" : "") << ": "
+              << num_bases / time / 1e9 << " G bases/s" << std::endl;
+  }
+
+  return 0;
+}
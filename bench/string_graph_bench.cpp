@@ -0,0 +1,187 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/string_graph.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "biosoup/timer.hpp"
+
+// usage: biosoup_string_graph_bench [reads] [length] [coverage]
+int main(int argc, char** argv) {
+  std::uint32_t num_reads = argc > 1 ? std::atoi(argv[1]) : 100000;
+  std::uint32_t read_len = argc > 2 ? std::atoi(argv[2]) : 10000;
+  std::uint32_t coverage = argc > 3 ? std::atoi(argv[3]) : 30;
+
+  // reads sampled uniformly from both strands of a genome, overlaps between
+  // all pairs which share at least 1000 bases
+  std::mt19937 generator(42);
+  std::uint64_t genome_len = static_cast<std::uint64_t>(num_reads) * read_len / coverage;  // NOLINT
+  std::vector<std::uint64_t> begins(num_reads);
+  std::vector<std::uint32_t> lens(num_reads);
+  std::vector<bool> is_reverse(num_reads);
+  for (std::uint32_t i = 0; i < num_reads; ++i) {
+    begins[i] = generator() % genome_len;
+    lens[i] = read_len / 2 + generator() % read_len;
+    is_reverse[i] = generator() & 1;
+  }
+  std::vector<std::uint32_t> order(num_reads);
+  for (std::uint32_t i = 0; i < num_reads; ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(),
+      [&] (std::uint32_t lhs, std::uint32_t rhs) -> bool {
+        return begins[lhs] < begins[rhs];
+      });
+  auto coordinate = [&] (std::uint32_t id, std::uint64_t i) -> std::uint32_t {
+    return is_reverse[id] ? lens[id] - i : i;
+  };
+  std::vector<biosoup::Overlap> overlaps;
+  for (std::uint32_t i = 0; i < num_reads; ++i) {
+    std::uint32_t x = order[i];
+    for (std::uint32_t j = i + 1; j < num_reads; ++j) {
+      std::uint32_t y = order[j];
+      std::uint64_t end = std::min(begins[x] + lens[x], begins[y] + lens[y]);
+      if (begins[y] + 1000 > begins[x] + lens[x]) {
+        break;
+      }
+      if (end < begins[y] + 1000) {
+        continue;
+      }
+      std::uint32_t xb = coordinate(x, begins[y] - begins[x]);
+      std::uint32_t xe = coordinate(x, end - begins[x]);
+      std::uint32_t yb = coordinate(y, 0), ye = coordinate(y, end - begins[y]);  // NOLINT
+      overlaps.emplace_back(
+          x, std::min(xb, xe), std::max(xb, xe),
+          y, std::min(yb, ye), std::max(yb, ye),
+          end - begins[y],
+          is_reverse[x] == is_reverse[y]);
+    }
+  }
+  std::cout << "[biosoup::StringGraph] " << overlaps.size() << " overlaps"
+            << std::endl;
+
+  biosoup::Timer timer{};
+  std::uint64_t checksum = 0;
+
+  // adjacency lists and transitive reduction, as done by hand
+  timer.Start();
+  {
+    std::vector<std::uint8_t> is_contained(num_reads, 0);
+    for (const auto& it : overlaps) {
+      std::uint32_t lb = it.lhs_begin, le = lens[it.lhs_id] - it.lhs_end;
+      std::uint32_t rb = it.strand ? it.rhs_begin : lens[it.rhs_id] - it.rhs_end;  // NOLINT
+      std::uint32_t re = it.strand ? lens[it.rhs_id] - it.rhs_end : it.rhs_begin;  // NOLINT
+      if (lb <= rb && le <= re) {
+        is_contained[it.lhs_id] = 1;
+      } else if (lb >= rb && le >= re) {
+        is_contained[it.rhs_id] = 1;
+      }
+    }
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> graph(
+        num_reads * 2ULL);
+    for (const auto& it : overlaps) {
+      if (is_contained[it.lhs_id] || is_contained[it.rhs_id]) {
+        continue;
+      }
+      std::uint32_t lb = it.lhs_begin, le = lens[it.lhs_id] - it.lhs_end;
+      std::uint32_t rb = it.strand ? it.rhs_begin : lens[it.rhs_id] - it.rhs_end;  // NOLINT
+      std::uint32_t re = it.strand ? lens[it.rhs_id] - it.rhs_end : it.rhs_begin;  // NOLINT
+      std::uint32_t l = it.lhs_id << 1, r = it.rhs_id << 1 | !it.strand;
+      if (lb > rb) {
+        graph[l].emplace_back(lb - rb, r);
+        graph[r ^ 1].emplace_back(re - le, l ^ 1);
+      } else {
+        graph[r].emplace_back(rb - lb, l);
+        graph[l ^ 1].emplace_back(le - re, r ^ 1);
+      }
+    }
+    for (auto& it : graph) {
+      std::sort(it.begin(), it.end());
+    }
+    std::vector<std::uint8_t> marks(graph.size(), 0);
+    std::vector<std::vector<std::uint32_t>> reduced(graph.size());
+    for (std::uint32_t v = 0; v < graph.size(); ++v) {
+      if (graph[v].empty()) {
+        continue;
+      }
+      for (const auto& it : graph[v]) {
+        marks[it.second] = 1;
+      }
+      std::uint64_t longest = graph[v].back().first;
+      for (const auto& it : graph[v]) {
+        if (marks[it.second] != 1) {
+          continue;
+        }
+        for (const auto& jt : graph[it.second]) {
+          if (it.first + jt.first > longest) {
+            break;
+          }
+          if (marks[jt.second] == 1) {
+            marks[jt.second] = 2;
+          }
+        }
+      }
+      for (const auto& it : graph[v]) {
+        if (marks[it.second] == 2) {
+          reduced[v].emplace_back(it.second);
+        }
+        marks[it.second] = 0;
+      }
+    }
+    std::uint64_t num_edges = 0;
+    for (std::uint32_t v = 0; v < graph.size(); ++v) {
+      auto& e = graph[v];
+      e.erase(std::remove_if(e.begin(), e.end(),
+          [&] (const std::pair<std::uint32_t, std::uint32_t>& it) -> bool {
+            return std::find(reduced[v].begin(), reduced[v].end(), it.second) != reduced[v].end();  // NOLINT
+          }), e.end());
+      num_edges += e.size();
+    }
+    checksum += num_edges;
+    double time = timer.Stop();
+    std::cout << "[biosoup::StringGraph] done by hand: " << time << " s, "
+              << num_edges << " edges" << std::endl;
+  }
+
+  std::vector<std::uint32_t> num_threads{1};
+  while (num_threads.back() * 2 <= std::thread::hardware_concurrency()) {
+    num_threads.emplace_back(num_threads.back() * 2);
+  }
+  for (auto it : num_threads) {
+    timer.Start();
+    biosoup::StringGraph g{
+        overlaps,
+        [&] (std::uint32_t id) -> std::uint32_t { return lens[id]; },
+        0,
+        it};
+    double time = timer.Stop();
+    std::cout << "[biosoup::StringGraph] build, " << it << " thread(s): "
+              << time << " s, " << g.num_edges() << " edges" << std::endl;
+
+    timer.Start();
+    g.RemoveTransitiveEdges(0, it);
+    time = timer.Stop();
+    std::cout << "[biosoup::StringGraph] transitive reduction, " << it
+              << " thread(s): " << time << " s, " << g.num_edges() << " edges"
+              << std::endl;
+
+    timer.Start();
+    std::uint32_t num_removed = g.RemoveTips(4, it);
+    num_removed += g.PopBubbles(8, it);
+    time = timer.Stop();
+    std::cout << "[biosoup::StringGraph] tips and bubbles, " << it
+              << " thread(s): " << time << " s, " << num_removed << " reads"
+              << std::endl;
+    checksum += g.num_edges() + num_removed;
+  }
+
+  std::cout << "[biosoup::StringGraph] checksum " << checksum << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,335 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_ALIGNER_HPP_
+#define BIOSOUP_ALIGNER_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "biosoup/cigar.hpp"
+#include "biosoup/detail/bits.hpp"
+#include "biosoup/detail/parallel.hpp"
+#include "biosoup/nucleic_acid_compare.hpp"
+#include "biosoup/nucleic_acid_view.hpp"
+#include "biosoup/overlap.hpp"
+
+namespace biosoup {
+namespace detail {
+
+// lower bits of the 2-bit groups of x, packed into the lowest 32 bits
+inline std::uint64_t CompressEvenBits(std::uint64_t x) {
+  x &= 0x5555555555555555ULL;
+  x = (x | (x >> 1)) & 0x3333333333333333ULL;
+  x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+  x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+  x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+  return (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+}
+
+// bit i is set if base i of 32 packed bases x equals code
+inline std::uint64_t MatchBases(std::uint64_t x, std::uint64_t code) {
+  x ^= code * 0x5555555555555555ULL;
+  return CompressEvenBits(~(x | (x >> 1)));
+}
+
+// Advances a block of 64 cells of a column of the edit distance matrix (Myers
+// 1999, with blocks as in Hyyro 2003). Pv and Mv hold positive and negative
+// vertical differences of the previous column, eq the matches of the new
+// column, hin the horizontal difference above the block. Returns the
+// horizontal difference of the last cell.
+inline std::int32_t AdvanceBlock(
+    std::uint64_t* pv,
+    std::uint64_t* mv,
+    std::uint64_t eq,
+    std::int32_t hin) {
+  std::uint64_t hin_is_negative = hin < 0;
+  std::uint64_t xv = eq | *mv;
+  eq |= hin_is_negative;
+  std::uint64_t xh = (((eq & *pv) + *pv) ^ *pv) | eq;
+  std::uint64_t ph = *mv | ~(xh | *pv);
+  std::uint64_t mh = *pv & xh;
+  std::int32_t hout = static_cast<std::int32_t>(ph >> 63) -
+      static_cast<std::int32_t>(mh >> 63);
+  ph = (ph << 1) | (hin > 0);
+  mh = (mh << 1) | hin_is_negative;
+  *pv = mh | ~(xv | ph);
+  *mv = ph & xv;
+  return hout;
+}
+
+}  // namespace detail
+
+// Global alignment of nucleic acids with unit edit costs, computed 64 cells
+// at a time with the bit-parallel algorithm of Myers and Hyyro on blocks of
+// lhs bases. Match masks of blocks are built from the 2-bit encoding, 32
+// bases per word, so views can be in either orientation and nothing is
+// inflated. Only blocks within band bases of the diagonal from the first to
+// the last cell are computed (all of them if band is UINT32_MAX), which
+// gives the optimal alignment whenever it stays within the band and an
+// upper bound otherwise.
+//
+// Vertical differences and scores of computed blocks are kept for the
+// traceback in buffers reused between alignments, so an Aligner is meant to
+// be used by one thread at a time.
+class Aligner {
+ public:
+  explicit Aligner(std::uint32_t band = 512)
+      : band_(band),
+        lhs_len_(0),
+        rhs_len_(0),
+        lhs_(nullptr),
+        rhs_(nullptr),
+        lhs_buffer_(),
+        rhs_buffer_(),
+        peq_(),
+        columns_(),
+        pv_(),
+        mv_(),
+        scores_() {}
+
+  Aligner(const Aligner&) = default;
+  Aligner& operator=(const Aligner&) = default;
+
+  Aligner(Aligner&&) = default;
+  Aligner& operator=(Aligner&&) = default;
+
+  ~Aligner() = default;
+
+  std::uint32_t band() const {
+    return band_;
+  }
+
+  std::uint32_t EditDistance(
+      const NucleicAcidView& lhs,
+      const NucleicAcidView& rhs) {
+    Fill(lhs, rhs);
+    return Score(lhs_len_, rhs_len_);
+  }
+
+  // appends the binary CIGAR (=, X, I and D, where I consumes lhs) of lhs
+  // aligned to rhs, returns the edit distance
+  std::uint32_t Align(
+      const NucleicAcidView& lhs,
+      const NucleicAcidView& rhs,
+      std::vector<std::uint32_t>* cigar) {
+    Fill(lhs, rhs);
+    std::uint32_t first = cigar->size();
+    auto append = [&] (CigarOperation op) -> void {
+      if (cigar->size() > first && CigarOp(cigar->back()) == op) {
+        cigar->back() += 1U << 4;
+      } else {
+        cigar->emplace_back(CigarWord(1, op));
+      }
+    };
+    std::uint32_t i = lhs_len_, j = rhs_len_;
+    while (i > 0 && j > 0) {
+      std::int64_t score = Score(i, j);
+      bool is_match = Code(lhs_, i - 1) == Code(rhs_, j - 1);
+      if (Score(i - 1, j - 1) + !is_match == score) {
+        append(is_match ? kCigarEqual : kCigarMismatch);
+        --i;
+        --j;
+      } else if (Score(i - 1, j) + 1 == score) {
+        append(kCigarInsertion);
+        --i;
+      } else {
+        append(kCigarDeletion);
+        --j;
+      }
+    }
+    for (; i > 0; --i) {
+      append(kCigarInsertion);
+    }
+    for (; j > 0; --j) {
+      append(kCigarDeletion);
+    }
+    std::reverse(cigar->begin() + first, cigar->end());
+    return Score(lhs_len_, rhs_len_);
+  }
+
+  // aligns the regions of an overlap of lhs and rhs (whole sequences), with
+  // the reverse complement of the lhs region on the reverse strand as in
+  // PAF, stores the CIGAR to overlap->alignment and the number of matching
+  // bases to overlap->score, returns the edit distance
+  std::uint32_t Align(
+      const NucleicAcidView& lhs,
+      const NucleicAcidView& rhs,
+      Overlap* overlap) {
+    if (overlap->lhs_begin > overlap->lhs_end ||
+        overlap->lhs_end > lhs.inflated_len ||
+        overlap->rhs_begin > overlap->rhs_end ||
+        overlap->rhs_end > rhs.inflated_len) {
+      throw std::invalid_argument(
+          "[biosoup::Aligner::Align] error: "
+          "overlap exceeds sequence length");
+    }
+    NucleicAcidView l = lhs.Slice(
+        overlap->lhs_begin, overlap->lhs_end - overlap->lhs_begin);
+    NucleicAcidView r = rhs.Slice(
+        overlap->rhs_begin, overlap->rhs_end - overlap->rhs_begin);
+    if (!overlap->strand) {
+      l.ReverseAndComplement();
+    }
+    std::vector<std::uint32_t> cigar;
+    std::uint32_t dst = Align(l, r, &cigar);
+    overlap->alignment = DecodeCigar(cigar);
+    overlap->score = 0;
+    for (const auto& it : cigar) {
+      if (CigarOp(it) == kCigarEqual) {
+        overlap->score += CigarLength(it);
+      }
+    }
+    return dst;
+  }
+
+  // aligns overlaps in place (see above) on num_threads threads, given views
+  // of whole sequences by id, sequence(id) -> NucleicAcidView. Overlaps are
+  // split into groups taken dynamically, each aligned with its own buffers.
+  template<typename S>
+  void Align(
+      S sequence,
+      std::vector<Overlap>* overlaps,
+      std::uint32_t num_threads = std::thread::hardware_concurrency()) const {
+    num_threads = std::max(num_threads, 1U);
+    std::size_t num_groups = std::min<std::size_t>(
+        overlaps->size(), num_threads * 16ULL);
+    detail::ParallelFor(num_groups, num_threads, [&] (std::size_t i) -> void {
+      Aligner aligner{band_};
+      for (std::size_t j = overlaps->size() * i / num_groups;
+           j < overlaps->size() * (i + 1) / num_groups;
+           ++j) {
+        Overlap& it = (*overlaps)[j];
+        aligner.Align(sequence(it.lhs_id), sequence(it.rhs_id), &it);
+      }
+    });
+  }
+
+ private:
+  struct Column {
+    std::uint32_t first;  // block
+    std::uint32_t num_blocks;
+    std::uint64_t offset;  // of the first block in pv_, mv_ and scores_
+  };
+
+  static std::uint64_t Code(const std::uint64_t* data, std::uint32_t i) {
+    return (data[i >> 5] >> ((i & 31) << 1)) & 3;
+  }
+
+  // Score of cell (i, j), i.e. of lhs[0, i) aligned to rhs[0, j). Cells
+  // between the top row of a column and the block above its first one are
+  // not defined. The cell right above the first block is one more than its
+  // left neighbour, and cells below the last block are one more than their
+  // upper neighbours, which are the differences blocks are computed with.
+  std::int64_t Score(std::uint32_t i, std::uint32_t j) const {
+    if (i == 0) {
+      return j;
+    }
+    if (j == 0) {
+      return i;
+    }
+    const Column& c = columns_[j];
+    std::uint32_t b = (i - 1) >> 6;
+    if (b < c.first) {
+      if (i != c.first << 6) {
+        return kUndefined;
+      }
+      return scores_[c.offset] -
+          detail::Popcount(pv_[c.offset]) +
+          detail::Popcount(mv_[c.offset]);
+    }
+    if (b >= c.first + c.num_blocks) {
+      std::uint64_t last = c.first + c.num_blocks;
+      return scores_[c.offset + c.num_blocks - 1] + (i - (last << 6));
+    }
+    std::uint64_t k = c.offset + b - c.first;
+    std::uint32_t shift = (i - 1) & 63;
+    std::uint64_t mask = shift == 63 ? 0 : ~0ULL << (shift + 1);
+    return scores_[k] -
+        detail::Popcount(pv_[k] & mask) +
+        detail::Popcount(mv_[k] & mask);
+  }
+
+  void Fill(const NucleicAcidView& lhs, const NucleicAcidView& rhs) {
+    lhs_len_ = lhs.inflated_len;
+    rhs_len_ = rhs.inflated_len;
+    if (lhs_len_ == 0 || rhs_len_ == 0) {
+      return;
+    }
+
+    // match masks of lhs blocks for each base
+    std::uint32_t num_words = (lhs_len_ + 31) >> 5;
+    std::uint32_t num_blocks = (lhs_len_ + 63) >> 6;
+    lhs_buffer_.resize(num_words);
+    lhs_ = detail::PackBases(lhs, 0, lhs_len_, lhs_buffer_.data());
+    rhs_buffer_.resize((rhs_len_ + 31) >> 5);
+    rhs_ = detail::PackBases(rhs, 0, rhs_len_, rhs_buffer_.data());
+    peq_.resize(4ULL * num_blocks);
+    for (std::uint32_t b = 0; b < num_blocks; ++b) {
+      std::uint64_t lo = lhs_[b << 1];
+      std::uint64_t hi = (b << 1) + 1 < num_words ? lhs_[(b << 1) + 1] : 0;
+      std::uint32_t len = std::min(lhs_len_ - (b << 6), 64U);
+      std::uint64_t mask = len == 64 ? ~0ULL : (1ULL << len) - 1;
+      for (std::uint64_t c = 0; c < 4; ++c) {
+        peq_[c * num_blocks + b] = mask & (
+            detail::MatchBases(lo, c) | detail::MatchBases(hi, c) << 32);
+      }
+    }
+
+    columns_.resize(rhs_len_ + 1ULL);
+    columns_[0] = Column{0, 0, 0};
+    pv_.clear();
+    mv_.clear();
+    scores_.clear();
+    for (std::uint32_t j = 1; j <= rhs_len_; ++j) {
+      std::uint64_t center = static_cast<std::uint64_t>(j) * lhs_len_ / rhs_len_;  // NOLINT
+      std::uint64_t lo = center > band_ ? center - band_ : 1;
+      std::uint64_t hi = std::min<std::uint64_t>(lhs_len_, center + band_);
+      std::uint32_t first = (std::max<std::uint64_t>(lo, 1) - 1) >> 6;
+      std::uint32_t last = (std::max<std::uint64_t>(hi, 1) - 1) >> 6;
+      const std::uint64_t* eq = &peq_[Code(rhs_, j - 1) * num_blocks];
+
+      Column prev = columns_[j - 1];
+      Column& c = columns_[j];
+      c = Column{first, last - first + 1, pv_.size()};
+      std::int32_t hin = 1;  // above the first block
+      for (std::uint32_t b = first; b <= last; ++b) {
+        std::uint64_t pv = ~0ULL, mv = 0;
+        std::int64_t score = 0;
+        if (b >= prev.first && b < prev.first + prev.num_blocks) {
+          std::uint64_t k = prev.offset + b - prev.first;
+          pv = pv_[k];
+          mv = mv_[k];
+          score = scores_[k];
+        } else {
+          score = Score((b + 1) << 6, j - 1);
+        }
+        hin = detail::AdvanceBlock(&pv, &mv, eq[b], hin);
+        pv_.emplace_back(pv);
+        mv_.emplace_back(mv);
+        scores_.emplace_back(score + hin);
+      }
+    }
+  }
+
+  static constexpr std::int64_t kUndefined = INT64_MAX / 2;
+
+  std::uint32_t band_;
+  std::uint32_t lhs_len_;
+  std::uint32_t rhs_len_;
+  const std::uint64_t* lhs_;  // packed bases in the orientation of views
+  const std::uint64_t* rhs_;
+  std::vector<std::uint64_t> lhs_buffer_;
+  std::vector<std::uint64_t> rhs_buffer_;
+  std::vector<std::uint64_t> peq_;  // match masks of blocks per base
+  std::vector<Column> columns_;  // of rhs bases
+  std::vector<std::uint64_t> pv_;  // of blocks
+  std::vector<std::uint64_t> mv_;
+  std::vector<std::int64_t> scores_;  // of the last cells of blocks
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_ALIGNER_HPP_
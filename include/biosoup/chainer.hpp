@@ -0,0 +1,505 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_CHAINER_HPP_
+#define BIOSOUP_CHAINER_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "biosoup/detail/parallel.hpp"
+#include "biosoup/detail/simd.hpp"
+#include "biosoup/minimizer_index.hpp"
+#include "biosoup/overlap.hpp"
+
+namespace biosoup {
+namespace detail {
+
+// Kernels find the best predecessor j in [first, i) of anchor i, given lhs
+// positions q, rhs positions t (non-decreasing) and chain scores f of
+// anchors. Anchor j is a valid predecessor if it precedes i by at least one
+// and at most max_gap bases on both sequences, with distances dq and dt
+// differing by at most bandwidth, and it scores
+// f[j] + min(dq, dt, k) - ((|dq - dt| * gap_scale) >> 8). Ties are broken in
+// favour of the closest anchor. Return -1 if there is no valid predecessor.
+struct ChainParameters {
+  std::int32_t k;
+  std::int32_t max_gap;
+  std::int32_t bandwidth;
+  std::int32_t gap_scale;  // cost of a base of gap in 1/256
+};
+
+inline std::int32_t BestPredecessorScalar(
+    const std::int32_t* q,
+    const std::int32_t* t,
+    const std::int32_t* f,
+    std::int32_t first,
+    std::int32_t i,
+    const ChainParameters& p,
+    std::int32_t* score) {
+  std::int32_t dst = -1;
+  for (std::int32_t j = first; j < i; ++j) {
+    std::int32_t dq = q[i] - q[j], dt = t[i] - t[j];
+    if (dq <= 0 || dt <= 0 || dq > p.max_gap || dt > p.max_gap) {
+      continue;
+    }
+    std::int32_t gap = dq > dt ? dq - dt : dt - dq;
+    if (gap > p.bandwidth) {
+      continue;
+    }
+    std::int32_t s = f[j] + std::min(std::min(dq, dt), p.k) -
+        ((gap * p.gap_scale) >> 8);
+    if (dst == -1 || s >= *score) {
+      *score = s;
+      dst = j;
+    }
+  }
+  return dst;
+}
+
+// merges lanes of a vector kernel with the scalar tail [j, i)
+inline std::int32_t BestPredecessorLanes(
+    const std::int32_t* lane_scores,
+    const std::int32_t* lane_ids,
+    std::uint32_t num_lanes,
+    const std::int32_t* q,
+    const std::int32_t* t,
+    const std::int32_t* f,
+    std::int32_t j,
+    std::int32_t i,
+    const ChainParameters& p,
+    std::int32_t* score) {
+  std::int32_t dst = -1;
+  for (std::uint32_t l = 0; l < num_lanes; ++l) {
+    if (lane_ids[l] != -1 && (dst == -1 || lane_scores[l] > *score ||
+        (lane_scores[l] == *score && lane_ids[l] > dst))) {
+      *score = lane_scores[l];
+      dst = lane_ids[l];
+    }
+  }
+  std::int32_t s = 0;
+  std::int32_t tail = BestPredecessorScalar(q, t, f, j, i, p, &s);
+  if (tail != -1 && (dst == -1 || s >= *score)) {
+    *score = s;
+    dst = tail;
+  }
+  return dst;
+}
+
+#if defined(BIOSOUP_X86_DISPATCH)
+
+BIOSOUP_TARGET_SSE42 inline std::int32_t BestPredecessorSse42(
+    const std::int32_t* q,
+    const std::int32_t* t,
+    const std::int32_t* f,
+    std::int32_t first,
+    std::int32_t i,
+    const ChainParameters& p,
+    std::int32_t* score) {
+  const __m128i qi = _mm_set1_epi32(q[i]);
+  const __m128i ti = _mm_set1_epi32(t[i]);
+  const __m128i k = _mm_set1_epi32(p.k);
+  const __m128i max_gap = _mm_set1_epi32(p.max_gap);
+  const __m128i bandwidth = _mm_set1_epi32(p.bandwidth);
+  const __m128i gap_scale = _mm_set1_epi32(p.gap_scale);
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i ones = _mm_set1_epi32(-1);
+  __m128i best = _mm_set1_epi32(INT32_MIN);
+  __m128i best_ids = ones;
+  __m128i ids = _mm_setr_epi32(first, first + 1, first + 2, first + 3);
+  std::int32_t j = first;
+  for (; i - j >= 4; j += 4) {
+    __m128i dq = _mm_sub_epi32(qi, _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + j)));  // NOLINT
+    __m128i dt = _mm_sub_epi32(ti, _mm_loadu_si128(reinterpret_cast<const __m128i*>(t + j)));  // NOLINT
+    __m128i gap = _mm_abs_epi32(_mm_sub_epi32(dq, dt));
+    __m128i invalid = _mm_or_si128(
+        _mm_or_si128(_mm_cmpgt_epi32(one, dq), _mm_cmpgt_epi32(one, dt)),
+        _mm_or_si128(
+            _mm_cmpgt_epi32(dq, max_gap),
+            _mm_cmpgt_epi32(dt, max_gap)));
+    invalid = _mm_or_si128(invalid, _mm_cmpgt_epi32(gap, bandwidth));
+    __m128i s = _mm_add_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(f + j)),
+        _mm_min_epi32(_mm_min_epi32(dq, dt), k));
+    s = _mm_sub_epi32(s, _mm_srai_epi32(_mm_mullo_epi32(gap, gap_scale), 8));
+    __m128i update = _mm_andnot_si128(
+        _mm_or_si128(invalid, _mm_cmpgt_epi32(best, s)), ones);
+    best = _mm_blendv_epi8(best, s, update);
+    best_ids = _mm_blendv_epi8(best_ids, ids, update);
+    ids = _mm_add_epi32(ids, _mm_set1_epi32(4));
+  }
+  std::int32_t lane_scores[4], lane_ids[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lane_scores), best);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lane_ids), best_ids);
+  return BestPredecessorLanes(lane_scores, lane_ids, 4, q, t, f, j, i, p, score);  // NOLINT
+}
+
+BIOSOUP_TARGET_AVX2 inline std::int32_t BestPredecessorAvx2(
+    const std::int32_t* q,
+    const std::int32_t* t,
+    const std::int32_t* f,
+    std::int32_t first,
+    std::int32_t i,
+    const ChainParameters& p,
+    std::int32_t* score) {
+  const __m256i qi = _mm256_set1_epi32(q[i]);
+  const __m256i ti = _mm256_set1_epi32(t[i]);
+  const __m256i k = _mm256_set1_epi32(p.k);
+  const __m256i max_gap = _mm256_set1_epi32(p.max_gap);
+  const __m256i bandwidth = _mm256_set1_epi32(p.bandwidth);
+  const __m256i gap_scale = _mm256_set1_epi32(p.gap_scale);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i ones = _mm256_set1_epi32(-1);
+  __m256i best = _mm256_set1_epi32(INT32_MIN);
+  __m256i best_ids = ones;
+  __m256i ids = _mm256_add_epi32(
+      _mm256_set1_epi32(first),
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  std::int32_t j = first;
+  for (; i - j >= 8; j += 8) {
+    __m256i dq = _mm256_sub_epi32(qi, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q + j)));  // NOLINT
+    __m256i dt = _mm256_sub_epi32(ti, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t + j)));  // NOLINT
+    __m256i gap = _mm256_abs_epi32(_mm256_sub_epi32(dq, dt));
+    __m256i invalid = _mm256_or_si256(
+        _mm256_or_si256(
+            _mm256_cmpgt_epi32(one, dq),
+            _mm256_cmpgt_epi32(one, dt)),
+        _mm256_or_si256(
+            _mm256_cmpgt_epi32(dq, max_gap),
+            _mm256_cmpgt_epi32(dt, max_gap)));
+    invalid = _mm256_or_si256(invalid, _mm256_cmpgt_epi32(gap, bandwidth));
+    __m256i s = _mm256_add_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(f + j)),
+        _mm256_min_epi32(_mm256_min_epi32(dq, dt), k));
+    s = _mm256_sub_epi32(s, _mm256_srai_epi32(_mm256_mullo_epi32(gap, gap_scale), 8));  // NOLINT
+    __m256i update = _mm256_andnot_si256(
+        _mm256_or_si256(invalid, _mm256_cmpgt_epi32(best, s)), ones);
+    best = _mm256_blendv_epi8(best, s, update);
+    best_ids = _mm256_blendv_epi8(best_ids, ids, update);
+    ids = _mm256_add_epi32(ids, _mm256_set1_epi32(8));
+  }
+  std::int32_t lane_scores[8], lane_ids[8];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lane_scores), best);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lane_ids), best_ids);
+  return BestPredecessorLanes(lane_scores, lane_ids, 8, q, t, f, j, i, p, score);  // NOLINT
+}
+
+#endif  // BIOSOUP_X86_DISPATCH
+
+inline std::int32_t BestPredecessor(
+    const std::int32_t* q,
+    const std::int32_t* t,
+    const std::int32_t* f,
+    std::int32_t first,
+    std::int32_t i,
+    const ChainParameters& p,
+    std::int32_t* score) {
+#if defined(BIOSOUP_X86_DISPATCH)
+  switch (simd_level()) {
+    case SimdLevel::kAvx2:
+      return BestPredecessorAvx2(q, t, f, first, i, p, score);
+    case SimdLevel::kSse42:
+      return BestPredecessorSse42(q, t, f, first, i, p, score);
+    default:
+      break;
+  }
+#endif
+  return BestPredecessorScalar(q, t, f, first, i, p, score);
+}
+
+}  // namespace detail
+
+// seed shared by a pair of sequences, e.g. a minimizer of length k starting
+// at lhs_position in lhs and at rhs_position in rhs (on forward strands)
+struct Anchor {
+  std::uint32_t lhs_position;
+  std::uint32_t rhs_position;
+  bool strand;  // true if the seed has the same orientation in both
+};
+
+struct AnchorBatch {  // anchors of a pair of sequences
+  std::uint32_t lhs_id;
+  std::uint32_t rhs_id;
+  std::vector<Anchor> anchors;
+};
+
+// Chains anchors of pairs of sequences into overlaps, in the manner of
+// minimap2. Anchors of each strand are sorted by rhs position (negated on
+// the reverse strand so that chains are co-linear) and each one looks back
+// at up to lookback preceding anchors within max_gap bases, which are scored
+// in SIMD lanes. Extending a chain from anchor j to anchor i adds
+// min(dq, dt, k) minus a linear gap cost of 0.01 * k per base of |dq - dt|,
+// where dq and dt are the distances of anchors in lhs and rhs, and anchors
+// further than bandwidth bases off the diagonal are not chained. Chains are
+// then extracted in order of decreasing score, with each anchor used once,
+// and the ones with at least min_anchors anchors and min_score are kept as
+// Overlap records scored by the chain.
+//
+// Positions of anchors have to fit into 31 bits.
+class Chainer {
+ public:
+  explicit Chainer(
+      std::uint32_t k,
+      std::uint32_t min_anchors = 3,
+      std::uint32_t min_score = 40,
+      std::uint32_t max_gap = 5000,
+      std::uint32_t bandwidth = 500,
+      std::uint32_t lookback = 64)
+      : min_anchors_(std::max(min_anchors, 1U)),
+        min_score_(min_score),
+        lookback_(lookback),
+        parameters_() {
+    if (k == 0 || k > 32) {
+      throw std::invalid_argument(
+          "[biosoup::Chainer::Chainer] error: k is not in [1, 32]");
+    }
+    if (lookback == 0 || lookback > INT32_MAX) {
+      throw std::invalid_argument(
+          "[biosoup::Chainer::Chainer] error: "
+          "lookback is not in [1, 2^31)");
+    }
+    parameters_.k = k;
+    parameters_.gap_scale = std::max(k * 256 / 100, 1U);
+    if (max_gap > INT32_MAX ||
+        bandwidth > static_cast<std::uint32_t>(INT32_MAX / parameters_.gap_scale)) {  // NOLINT
+      throw std::invalid_argument(
+          "[biosoup::Chainer::Chainer] error: gap is too large");
+    }
+    parameters_.max_gap = max_gap;
+    parameters_.bandwidth = bandwidth;
+  }
+
+  Chainer(const Chainer&) = default;
+  Chainer& operator=(const Chainer&) = default;
+
+  Chainer(Chainer&&) = default;
+  Chainer& operator=(Chainer&&) = default;
+
+  ~Chainer() = default;
+
+  std::uint32_t k() const {
+    return parameters_.k;
+  }
+
+  // appends overlaps of lhs_id and rhs_id in order of decreasing score,
+  // returns their number
+  std::size_t Chain(
+      std::uint32_t lhs_id,
+      std::uint32_t rhs_id,
+      const std::vector<Anchor>& anchors,
+      std::vector<Overlap>* dst) const {
+    Buffer buffer;
+    return Chain(lhs_id, rhs_id, anchors.data(), anchors.size(), &buffer, dst);  // NOLINT
+  }
+
+  // appends overlaps of query lhs_id given its hits (see
+  // MinimizerIndex::Query), in order of indexed sequences and decreasing
+  // score, returns their number
+  std::size_t Chain(
+      std::uint32_t lhs_id,
+      const std::vector<MinimizerHit>& hits,
+      std::vector<Overlap>* dst) const {
+    std::vector<MinimizerHit> sorted(hits);
+    std::stable_sort(sorted.begin(), sorted.end(),
+        [] (const MinimizerHit& lhs, const MinimizerHit& rhs) -> bool {
+          return lhs.id < rhs.id;
+        });
+    Buffer buffer;
+    std::vector<Anchor> anchors;
+    std::size_t n = 0;
+    for (auto it = sorted.begin(); it != sorted.end();) {
+      auto jt = it;
+      anchors.clear();
+      for (; jt != sorted.end() && jt->id == it->id; ++jt) {
+        anchors.push_back(Anchor{jt->query_position, jt->position, jt->strand});  // NOLINT
+      }
+      n += Chain(lhs_id, it->id, anchors.data(), anchors.size(), &buffer, dst);  // NOLINT
+      it = jt;
+    }
+    return n;
+  }
+
+  // chains batches in blocks taken by num_threads threads, overlaps are
+  // returned in the order of batches
+  std::vector<Overlap> Chain(
+      const std::vector<AnchorBatch>& batches,
+      std::uint32_t num_threads = std::thread::hardware_concurrency()) const {
+    std::size_t num_blocks = (batches.size() + kBlockSize - 1) / kBlockSize;
+    std::vector<std::vector<Overlap>> overlaps(num_blocks);
+    detail::ParallelFor(num_blocks, num_threads, [&] (std::size_t block) -> void {  // NOLINT
+      Buffer buffer;
+      std::size_t last = std::min<std::size_t>(
+          batches.size(), (block + 1) * kBlockSize);
+      for (std::size_t i = block * kBlockSize; i < last; ++i) {
+        const AnchorBatch& it = batches[i];
+        Chain(
+            it.lhs_id, it.rhs_id,
+            it.anchors.data(), it.anchors.size(),
+            &buffer,
+            &overlaps[block]);
+      }
+    });
+    std::size_t n = 0;
+    for (const auto& it : overlaps) {
+      n += it.size();
+    }
+    std::vector<Overlap> dst;
+    dst.reserve(n);
+    for (auto& it : overlaps) {
+      std::move(it.begin(), it.end(), std::back_inserter(dst));
+      std::vector<Overlap>().swap(it);
+    }
+    return dst;
+  }
+
+ private:
+  enum : std::uint32_t {
+    kBlockSize = 64  // batches processed per task
+  };
+
+  struct Buffer {  // reused between pairs of sequences
+    std::vector<std::uint64_t> keys;  // rhs << 32 | lhs positions
+    std::vector<std::int32_t> q;
+    std::vector<std::int32_t> t;
+    std::vector<std::int32_t> f;
+    std::vector<std::int32_t> predecessors;
+    std::vector<std::int32_t> order;
+    std::vector<std::uint8_t> is_used;
+  };
+
+  std::size_t Chain(
+      std::uint32_t lhs_id,
+      std::uint32_t rhs_id,
+      const Anchor* anchors,
+      std::size_t num_anchors,
+      Buffer* buffer,
+      std::vector<Overlap>* dst) const {
+    std::size_t first = dst->size();
+    for (bool strand : {true, false}) {
+      buffer->keys.clear();
+      for (std::size_t i = 0; i < num_anchors; ++i) {
+        const Anchor& it = anchors[i];
+        if (it.strand != strand) {
+          continue;
+        }
+        if (it.lhs_position > INT32_MAX || it.rhs_position > INT32_MAX) {
+          throw std::invalid_argument(
+              "[biosoup::Chainer::Chain] error: position is too large");
+        }
+        std::uint64_t t = strand ? it.rhs_position : INT32_MAX - it.rhs_position;  // NOLINT
+        buffer->keys.emplace_back(t << 32 | it.lhs_position);
+      }
+      ChainStrand(lhs_id, rhs_id, strand, buffer, dst);
+    }
+    std::stable_sort(dst->begin() + first, dst->end(),
+        [] (const Overlap& lhs, const Overlap& rhs) -> bool {
+          return lhs.score > rhs.score;
+        });
+    return dst->size() - first;
+  }
+
+  void ChainStrand(
+      std::uint32_t lhs_id,
+      std::uint32_t rhs_id,
+      bool strand,
+      Buffer* buffer,
+      std::vector<Overlap>* dst) const {
+    auto& keys = buffer->keys;
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    if (keys.size() < min_anchors_) {
+      return;
+    }
+
+    std::int32_t n = keys.size();
+    auto& q = buffer->q;
+    auto& t = buffer->t;
+    auto& f = buffer->f;
+    auto& predecessors = buffer->predecessors;
+    q.resize(n);
+    t.resize(n);
+    f.resize(n);
+    predecessors.resize(n);
+    for (std::int32_t i = 0; i < n; ++i) {
+      q[i] = keys[i] & 0xFFFFFFFF;
+      t[i] = keys[i] >> 32;
+    }
+    for (std::int32_t i = 0, lo = 0; i < n; ++i) {
+      while (t[i] - t[lo] > parameters_.max_gap) {
+        ++lo;
+      }
+      std::int32_t score = 0;
+      std::int32_t j = detail::BestPredecessor(
+          q.data(), t.data(), f.data(),
+          static_cast<std::int32_t>(std::max<std::int64_t>(
+              lo, static_cast<std::int64_t>(i) - lookback_)),
+          i,
+          parameters_,
+          &score);
+      if (j != -1 && score > parameters_.k) {
+        f[i] = score;
+        predecessors[i] = j;
+      } else {
+        f[i] = parameters_.k;
+        predecessors[i] = -1;
+      }
+    }
+
+    // chains are backtracked from the best scoring anchors and stop at
+    // anchors of previous chains, whose scores are subtracted
+    auto& order = buffer->order;
+    order.resize(n);
+    for (std::int32_t i = 0; i < n; ++i) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(),
+        [&] (std::int32_t lhs, std::int32_t rhs) -> bool {
+          return f[lhs] > f[rhs] || (f[lhs] == f[rhs] && lhs < rhs);
+        });
+    auto& is_used = buffer->is_used;
+    is_used.assign(n, 0);
+    for (const auto& i : order) {
+      if (is_used[i]) {
+        continue;
+      }
+      std::uint32_t num_anchors = 0;
+      std::int32_t begin = i, j = i;
+      for (; j != -1 && !is_used[j]; j = predecessors[j]) {
+        is_used[j] = 1;
+        ++num_anchors;
+        begin = j;
+      }
+      std::int32_t score = f[i] - (j == -1 ? 0 : f[j]);
+      if (num_anchors < min_anchors_ || score <= 0 ||
+          static_cast<std::uint32_t>(score) < min_score_) {
+        continue;
+      }
+      std::uint32_t k = parameters_.k;
+      if (strand) {
+        dst->emplace_back(
+            lhs_id, q[begin], q[i] + k,
+            rhs_id, t[begin], t[i] + k,
+            score);
+      } else {
+        dst->emplace_back(
+            lhs_id, q[begin], q[i] + k,
+            rhs_id, INT32_MAX - t[i], INT32_MAX - t[begin] + k,
+            score,
+            false);
+      }
+    }
+  }
+
+  std::uint32_t min_anchors_;
+  std::uint32_t min_score_;
+  std::uint32_t lookback_;
+  detail::ChainParameters parameters_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_CHAINER_HPP_
@@ -0,0 +1,262 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_CIGAR_HPP_
+#define BIOSOUP_CIGAR_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "biosoup/overlap.hpp"
+
+namespace biosoup {
+
+// Binary CIGAR as in BAM, each operation is a 32-bit word (length << 4 | op)
+// where op indexes "MIDNSHP=X"
+enum CigarOperation : std::uint32_t {
+  kCigarMatch,
+  kCigarInsertion,
+  kCigarDeletion,
+  kCigarSkip,
+  kCigarSoftClip,
+  kCigarHardClip,
+  kCigarPadding,
+  kCigarEqual,
+  kCigarMismatch
+};
+
+inline const char* CigarOperations() {
+  return "MIDNSHP=X";
+}
+
+inline std::uint32_t CigarWord(std::uint32_t len, CigarOperation op) {
+  return len << 4 | op;
+}
+
+inline std::uint32_t CigarLength(std::uint32_t word) {
+  return word >> 4;
+}
+
+inline CigarOperation CigarOp(std::uint32_t word) {
+  return static_cast<CigarOperation>(word & 15);
+}
+
+// appends the binary form of a text CIGAR to dst
+inline void EncodeCigar(
+    const char* cigar, std::uint32_t cigar_len,
+    std::vector<std::uint32_t>* dst) {
+  static const struct OperationTable {
+    OperationTable() {
+      for (std::uint32_t i = 0; i < 256; ++i) {
+        data[i] = -1;
+      }
+      for (std::uint32_t i = 0; CigarOperations()[i]; ++i) {
+        data[static_cast<std::uint8_t>(CigarOperations()[i])] = i;
+      }
+    }
+    std::int8_t data[256];
+  } table;
+
+  std::uint64_t len = 0;
+  bool has_len = false;
+  for (std::uint32_t i = 0; i < cigar_len; ++i) {
+    char c = cigar[i];
+    if (c >= '0' && c <= '9') {
+      len = len * 10 + (c - '0');
+      has_len = true;
+      if (len >= (1U << 28)) {
+        throw std::invalid_argument(
+            "[biosoup::EncodeCigar] error: operation too long");
+      }
+      continue;
+    }
+    std::int8_t op = table.data[static_cast<std::uint8_t>(c)];
+    if (op < 0 || !has_len) {
+      throw std::invalid_argument(
+          "[biosoup::EncodeCigar] error: invalid CIGAR " +
+          std::string(cigar, cigar_len));
+    }
+    dst->emplace_back(CigarWord(len, static_cast<CigarOperation>(op)));
+    len = 0;
+    has_len = false;
+  }
+  if (has_len) {
+    throw std::invalid_argument(
+        "[biosoup::EncodeCigar] error: invalid CIGAR " +
+        std::string(cigar, cigar_len));
+  }
+}
+
+inline std::vector<std::uint32_t> EncodeCigar(const std::string& cigar) {
+  std::vector<std::uint32_t> dst;
+  EncodeCigar(cigar.c_str(), cigar.size(), &dst);
+  return dst;
+}
+
+inline std::string DecodeCigar(
+    const std::uint32_t* cigar, std::uint32_t cigar_len) {
+  std::string dst;
+  for (std::uint32_t i = 0; i < cigar_len; ++i) {
+    dst += std::to_string(CigarLength(cigar[i]));
+    dst += CigarOp(cigar[i]) < 9 ? CigarOperations()[CigarOp(cigar[i])] : '?';  // NOLINT
+  }
+  return dst;
+}
+
+inline std::string DecodeCigar(const std::vector<std::uint32_t>& cigar) {
+  return DecodeCigar(cigar.data(), cigar.size());
+}
+
+// Binary CIGAR with summary statistics and prefix sums of consumed bases.
+// The lhs (query) is consumed by M, I, S, = and X, the rhs (target) by M, D,
+// N, = and X. Positions are relative to the start of the CIGAR on each
+// sequence. M is counted as a match as the sequences are not known.
+class Cigar {
+ public:
+  Cigar()
+      : words_(),
+        lhs_prefix_(1, 0),
+        rhs_prefix_(1, 0),
+        num_matches_(0),
+        num_mismatches_(0),
+        num_insertions_(0),
+        num_deletions_(0) {}
+
+  explicit Cigar(const std::string& cigar)
+      : Cigar(cigar.c_str(), cigar.size()) {}
+
+  Cigar(const char* cigar, std::uint32_t cigar_len)
+      : Cigar() {
+    EncodeCigar(cigar, cigar_len, &words_);
+    Summarize();
+  }
+
+  Cigar(const std::uint32_t* cigar, std::uint32_t cigar_len)
+      : Cigar() {
+    words_.assign(cigar, cigar + cigar_len);
+    Summarize();
+  }
+
+  explicit Cigar(const Overlap& overlap)
+      : Cigar(overlap.alignment) {}
+
+  Cigar(const Cigar&) = default;
+  Cigar& operator=(const Cigar&) = default;
+
+  Cigar(Cigar&&) = default;
+  Cigar& operator=(Cigar&&) = default;
+
+  ~Cigar() = default;
+
+  const std::vector<std::uint32_t>& words() const {
+    return words_;
+  }
+
+  std::uint32_t size() const {  // number of operations
+    return words_.size();
+  }
+
+  bool empty() const {
+    return words_.empty();
+  }
+
+  std::uint32_t lhs_len() const {
+    return lhs_prefix_.back();
+  }
+
+  std::uint32_t rhs_len() const {
+    return rhs_prefix_.back();
+  }
+
+  std::uint32_t num_matches() const {
+    return num_matches_;
+  }
+
+  std::uint32_t num_mismatches() const {
+    return num_mismatches_;
+  }
+
+  std::uint32_t num_insertions() const {  // bases, without clipping
+    return num_insertions_;
+  }
+
+  std::uint32_t num_deletions() const {
+    return num_deletions_;
+  }
+
+  std::uint32_t EditDistance() const {
+    return num_mismatches_ + num_insertions_ + num_deletions_;
+  }
+
+  // matches over alignment columns
+  double Identity() const {
+    std::uint64_t num_columns = num_matches_ + EditDistance();
+    return num_columns ? num_matches_ / static_cast<double>(num_columns) : 0;
+  }
+
+  std::string ToString() const {
+    return DecodeCigar(words_);
+  }
+
+  // position on the rhs aligned to lhs_pos, or the next aligned one for
+  // insertions and clips, in O(log n)
+  std::uint32_t LhsToRhs(std::uint32_t lhs_pos) const {
+    return Project(lhs_prefix_, rhs_prefix_, lhs_pos);
+  }
+
+  std::uint32_t RhsToLhs(std::uint32_t rhs_pos) const {
+    return Project(rhs_prefix_, lhs_prefix_, rhs_pos);
+  }
+
+ private:
+  static bool ConsumesLhs(CigarOperation op) {
+    return (0x193U >> op) & 1;  // M, I, S, =, X
+  }
+
+  static bool ConsumesRhs(CigarOperation op) {
+    return (0x18DU >> op) & 1;  // M, D, N, =, X
+  }
+
+  void Summarize() {
+    lhs_prefix_.reserve(words_.size() + 1);
+    rhs_prefix_.reserve(words_.size() + 1);
+    for (auto it : words_) {
+      std::uint32_t len = CigarLength(it);
+      CigarOperation op = CigarOp(it);
+      switch (op) {
+        case kCigarMatch: case kCigarEqual: num_matches_ += len; break;
+        case kCigarMismatch: num_mismatches_ += len; break;
+        case kCigarInsertion: num_insertions_ += len; break;
+        case kCigarDeletion: num_deletions_ += len; break;
+        default: break;
+      }
+      lhs_prefix_.emplace_back(lhs_prefix_.back() + (ConsumesLhs(op) ? len : 0));  // NOLINT
+      rhs_prefix_.emplace_back(rhs_prefix_.back() + (ConsumesRhs(op) ? len : 0));  // NOLINT
+    }
+  }
+
+  static std::uint32_t Project(
+      const std::vector<std::uint32_t>& src,
+      const std::vector<std::uint32_t>& dst,
+      std::uint32_t pos) {
+    if (pos >= src.back()) {
+      return dst.back();
+    }
+    std::size_t i = std::upper_bound(src.begin(), src.end(), pos) - src.begin() - 1;  // NOLINT
+    return dst[i] + (dst[i + 1] > dst[i] ? pos - src[i] : 0);
+  }
+
+  std::vector<std::uint32_t> words_;
+  std::vector<std::uint32_t> lhs_prefix_;
+  std::vector<std::uint32_t> rhs_prefix_;
+  std::uint32_t num_matches_;
+  std::uint32_t num_mismatches_;
+  std::uint32_t num_insertions_;
+  std::uint32_t num_deletions_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_CIGAR_HPP_
@@ -0,0 +1,205 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_CONCURRENT_PROGRESS_BAR_HPP_
+#define BIOSOUP_CONCURRENT_PROGRESS_BAR_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "biosoup/timer.hpp"
+
+namespace biosoup {
+
+// Progress bar which can be advanced from many threads at once. Events are
+// counted in relaxed atomics sharded by thread (each on its own cache line),
+// so Add never locks. The bar with rate and ETA is drawn to os at most
+// max_fps times per second, either on demand with Render or by a background
+// thread between Start and Stop.
+class ConcurrentProgressBar {
+ public:
+  ConcurrentProgressBar(
+      std::uint64_t num_events,
+      std::uint32_t num_ticks = 20,
+      std::ostream* os = &std::cerr,
+      const std::string& label = "",
+      double max_fps = 10)
+      : num_events_(num_events),
+        num_ticks_(std::max(num_ticks, 1U)),
+        os_(os),
+        label_(label),
+        interval_(static_cast<std::int64_t>(1e9 / std::max(max_fps, 1e-3))),
+        timer_(),
+        last_render_(-interval_),
+        is_stopped_(false),
+        mutex_(),
+        cv_(),
+        renderer_() {
+    for (auto& it : shards_) {
+      it.value = 0;
+    }
+    timer_.Start();
+  }
+
+  ConcurrentProgressBar(const ConcurrentProgressBar&) = delete;
+  ConcurrentProgressBar& operator=(const ConcurrentProgressBar&) = delete;
+
+  ConcurrentProgressBar(ConcurrentProgressBar&&) = delete;
+  ConcurrentProgressBar& operator=(ConcurrentProgressBar&&) = delete;
+
+  ~ConcurrentProgressBar() {
+    Stop();
+  }
+
+  std::uint64_t num_events() const {
+    return num_events_;
+  }
+
+  // approximate while other threads are adding events
+  std::uint64_t event_counter() const {
+    std::uint64_t dst = 0;
+    for (const auto& it : shards_) {
+      dst += it.value.load(std::memory_order_relaxed);
+    }
+    return dst;
+  }
+
+  void Add(std::uint64_t n = 1) {
+    shards_[ShardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  ConcurrentProgressBar& operator++() {
+    Add(1);
+    return *this;
+  }
+
+  // draws the bar if the last drawing is at least 1 / max_fps seconds old
+  // (or force is set), returns whether it did
+  bool Render(bool force = false) {
+    std::int64_t now = Now();
+    std::int64_t last = last_render_.load(std::memory_order_relaxed);
+    if (!force && (now - last < interval_ ||
+        !last_render_.compare_exchange_strong(last, now))) {
+      return false;
+    }
+    last_render_ = now;
+    std::string line = ToString();
+    std::lock_guard<std::mutex> lock(mutex_);
+    *os_ << "\r" << line << std::flush;
+    return true;
+  }
+
+  // starts drawing from a background thread
+  void Start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (renderer_.joinable()) {
+      return;
+    }
+    is_stopped_ = false;
+    renderer_ = std::thread([this] () -> void {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (!cv_.wait_for(
+          lock,
+          std::chrono::nanoseconds(interval_),
+          [this] () -> bool { return is_stopped_; })) {
+        lock.unlock();
+        Render();
+        lock.lock();
+      }
+    });
+  }
+
+  // stops the background thread and draws the final state with a newline
+  void Stop() {
+    std::thread renderer;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!renderer_.joinable()) {
+        return;
+      }
+      is_stopped_ = true;
+      std::swap(renderer, renderer_);
+    }
+    cv_.notify_all();
+    renderer.join();
+    Render(true);
+    std::lock_guard<std::mutex> lock(mutex_);
+    *os_ << std::endl;
+  }
+
+  // label [=====>    ] 50% 10/20 | 1.5e+03 events/s | ETA 00:00:07
+  std::string ToString() const {
+    std::uint64_t n = std::min(event_counter(), num_events_);
+    double ratio = num_events_ ? n / static_cast<double>(num_events_) : 1;
+    std::uint32_t num_done = ratio * num_ticks_;
+
+    std::string dst = label_.empty() ? "" : label_ + " ";
+    dst += "[" + std::string(num_done, '=');
+    if (num_done < num_ticks_) {
+      dst += ">" + std::string(num_ticks_ - num_done - 1, ' ');
+    }
+    dst += "] " + std::to_string(static_cast<std::uint32_t>(ratio * 100)) + "% ";  // NOLINT
+    dst += std::to_string(n) + "/" + std::to_string(num_events_);
+
+    double time = timer_.Lap();
+    double rate = time > 0 ? n / time : 0;
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), " | %.3g events/s | ETA ", rate);
+    dst += buffer;
+    if (rate > 0 || n == num_events_) {
+      std::uint64_t eta = rate > 0 ? (num_events_ - n) / rate + 0.5 : 0;
+      std::snprintf(buffer, sizeof(buffer), "%02u:%02u:%02u",
+          static_cast<std::uint32_t>(eta / 3600),
+          static_cast<std::uint32_t>(eta / 60 % 60),
+          static_cast<std::uint32_t>(eta % 60));
+      dst += buffer;
+    } else {
+      dst += "--:--:--";
+    }
+    return dst;
+  }
+
+ private:
+  enum : std::uint32_t {
+    kNumShards = 64
+  };
+
+  struct alignas(64) Shard {  // before C++17 only if not allocated with new
+    std::atomic<std::uint64_t> value;
+  };
+
+  // threads are assigned shards in order of their first use
+  static std::uint32_t ShardIndex() {
+    static std::atomic<std::uint32_t> num_threads{0};
+    static thread_local std::uint32_t index = num_threads++ % kNumShards;
+    return index;
+  }
+
+  std::int64_t Now() const {
+    return timer_.Lap() * 1e9;
+  }
+
+  std::uint64_t num_events_;
+  std::uint32_t num_ticks_;
+  std::ostream* os_;
+  std::string label_;
+  std::int64_t interval_;  // between drawings in ns
+  Timer timer_;
+  std::atomic<std::int64_t> last_render_;  // ns since construction
+  bool is_stopped_;
+  std::mutex mutex_;  // guards os_ and the renderer
+  std::condition_variable cv_;
+  std::thread renderer_;
+  Shard shards_[kNumShards];
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_CONCURRENT_PROGRESS_BAR_HPP_
@@ -0,0 +1,62 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_DETAIL_BITS_HPP_
+#define BIOSOUP_DETAIL_BITS_HPP_
+
+#include <cstdint>
+
+namespace biosoup {
+namespace detail {
+
+// portable, builtins are library calls without -mpopcnt
+inline std::uint32_t Popcount(std::uint64_t x) {
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (x * 0x0101010101010101ULL) >> 56;
+}
+
+inline std::uint32_t TrailingZeros(std::uint64_t x) {  // x != 0
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(x);
+#else
+  std::uint32_t dst = 0;
+  for (; (x & 1) == 0; x >>= 1) {
+    ++dst;
+  }
+  return dst;
+#endif
+}
+
+struct SelectInByteTable {  // position of the set bit with rank r in byte i
+  SelectInByteTable() {
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      for (std::uint32_t j = 0, r = 0; j < 8; ++j) {
+        if (i & (1U << j)) {
+          data[r++][i] = j;
+        }
+      }
+    }
+  }
+
+  std::uint8_t data[8][256];
+};
+
+// position of the set bit of x with rank r (r < Popcount(x)), the byte which
+// holds it is found by comparing all cumulative byte counts to r at once
+inline std::uint32_t SelectInWord(std::uint64_t x, std::uint32_t r) {
+  static const SelectInByteTable table{};
+  std::uint64_t s = x - ((x >> 1) & 0x5555555555555555ULL);
+  s = (s & 0x3333333333333333ULL) + ((s >> 2) & 0x3333333333333333ULL);
+  s = ((s + (s >> 4)) & 0x0F0F0F0F0F0F0F0FULL) * 0x0101010101010101ULL;
+  std::uint64_t le = ((r * 0x0101010101010101ULL | 0x8080808080808080ULL) - s) &  // NOLINT
+      0x8080808080808080ULL;  // bytes with cumulative counts up to r
+  std::uint32_t i = (((le >> 7) * 0x0101010101010101ULL) >> 56) << 3;
+  r -= ((s << 8) >> i) & 0xFF;
+  return i + table.data[r][(x >> i) & 0xFF];
+}
+
+}  // namespace detail
+}  // namespace biosoup
+
+#endif  // BIOSOUP_DETAIL_BITS_HPP_
@@ -0,0 +1,253 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_DETAIL_CHUNK_PIPELINE_HPP_
+#define BIOSOUP_DETAIL_CHUNK_PIPELINE_HPP_
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "biosoup/io.hpp"
+
+namespace biosoup {
+namespace detail {
+
+// A reader thread splits the input into chunks of whole units (records,
+// lines), which are converted to R on a pool of worker threads and handed
+// out in input order. At most max_chunks chunks are held at a time.
+template<typename R>
+class ChunkPipeline {
+ public:
+  // returns the end of the last complete unit in data (at least chunk_size
+  // bytes), 0 if there is none; at the end of input it is called once more
+  // with is_eof set and all remaining data (terminated with '\n') is taken.
+  // While a chunk grows, data[0, begin) is what the previous call for it saw
+  // and returned 0 on (begin is 0 on the first call), so only the tail needs
+  // to be searched and splitting stays linear in the chunk length
+  using SplitFunction = std::function<std::size_t(
+      const std::string& data, std::size_t begin, bool is_eof)>;
+  using ConvertFunction =
+      std::function<void(const char* begin, const char* end, R* dst)>;
+
+  ChunkPipeline(
+      ReadFunction read,
+      SplitFunction split,
+      ConvertFunction convert,
+      std::uint32_t num_threads,
+      std::size_t chunk_size,
+      std::size_t max_chunks)  // 0 for 2 * num_threads + 2
+      : read_(std::move(read)),
+        split_(std::move(split)),
+        convert_(std::move(convert)),
+        chunk_size_(std::max<std::size_t>(chunk_size, 1)),
+        slots_(max_chunks ? max_chunks : 2 * std::max(num_threads, 1U) + 2),
+        num_chunks_(0),
+        next_chunk_(0),
+        next_result_(0),
+        is_eof_(false),
+        is_stopped_(false),
+        error_(),
+        mutex_(),
+        cv_(),
+        threads_() {
+    threads_.emplace_back(&ChunkPipeline::Read, this);
+    for (std::uint32_t i = 0; i < std::max(num_threads, 1U); ++i) {
+      threads_.emplace_back(&ChunkPipeline::Work, this);
+    }
+  }
+
+  ChunkPipeline(const ChunkPipeline&) = delete;
+  ChunkPipeline& operator=(const ChunkPipeline&) = delete;
+
+  ChunkPipeline(ChunkPipeline&&) = delete;
+  ChunkPipeline& operator=(ChunkPipeline&&) = delete;
+
+  ~ChunkPipeline() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_stopped_ = true;
+    }
+    cv_.notify_all();
+    for (auto& it : threads_) {
+      it.join();
+    }
+  }
+
+  // swaps the result of the next chunk with dst, false at the end of input;
+  // rethrows errors of the reader or the workers
+  bool Next(R* dst, std::uint64_t* num_bytes) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      Slot& slot = slots_[next_result_ % slots_.size()];
+      cv_.wait(lock, [&] () -> bool {
+        return error_ ||
+            slot.state == kConverted ||
+            (is_eof_ && next_result_ == num_chunks_);
+      });
+      if (error_) {
+        std::rethrow_exception(error_);
+      }
+      if (slot.state != kConverted) {
+        return false;
+      }
+      std::swap(*dst, slot.result);
+      *num_bytes = slot.data.size();
+      slot.state = kFree;
+      ++next_result_;
+    }
+    cv_.notify_all();
+    return true;
+  }
+
+ private:
+  enum State {
+    kFree,
+    kRead,
+    kConverted
+  };
+
+  struct Slot {
+    Slot()
+        : data(),
+          result(),
+          state(kFree) {}
+
+    std::string data;
+    R result;
+    State state;
+  };
+
+  void Fail(std::exception_ptr error) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) {
+        error_ = error;
+      }
+      is_stopped_ = true;
+    }
+    cv_.notify_all();
+  }
+
+  void Read() {
+    try {
+      std::string carry;
+      bool is_eof = false;
+      for (std::uint64_t i = 0; !is_eof;) {
+        Slot& slot = slots_[i % slots_.size()];
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          cv_.wait(lock, [&] () -> bool {
+            return is_stopped_ || slot.state == kFree;
+          });
+          if (is_stopped_) {
+            return;
+          }
+        }
+
+        std::string& data = slot.data;
+        data.assign(carry);
+        std::size_t boundary = 0;
+        std::size_t scanned = 0;
+        while (!is_eof) {
+          if (data.size() >= chunk_size_) {
+            if ((boundary = split_(data, scanned, false)) > 0) {
+              break;
+            }
+            scanned = data.size();
+          }
+          std::size_t len = data.size();
+          data.resize(len + chunk_size_);
+          std::size_t n = read_(&data[len], chunk_size_);
+          data.resize(len + n);
+          is_eof = n == 0;
+        }
+        if (is_eof) {
+          if (!data.empty() && data.back() != '\n') {
+            data.push_back('\n');
+          }
+          split_(data, scanned, true);
+          boundary = data.size();
+        }
+        carry.assign(data, boundary, std::string::npos);
+        data.resize(boundary);
+        if (data.empty()) {
+          continue;
+        }
+
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          slot.state = kRead;
+          num_chunks_ = ++i;
+        }
+        cv_.notify_all();
+      }
+    } catch (...) {
+      Fail(std::current_exception());
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_eof_ = true;
+    }
+    cv_.notify_all();
+  }
+
+  void Work() {
+    while (true) {
+      Slot* slot = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] () -> bool {
+          return is_stopped_ || is_eof_ || next_chunk_ < num_chunks_;
+        });
+        if (is_stopped_ || next_chunk_ == num_chunks_) {
+          return;
+        }
+        slot = &slots_[next_chunk_++ % slots_.size()];
+      }
+
+      try {
+        slot->result = R();
+        convert_(
+            slot->data.data(),
+            slot->data.data() + slot->data.size(),
+            &slot->result);
+      } catch (...) {
+        Fail(std::current_exception());
+        return;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slot->state = kConverted;
+      }
+      cv_.notify_all();
+    }
+  }
+
+  ReadFunction read_;
+  SplitFunction split_;
+  ConvertFunction convert_;
+  std::size_t chunk_size_;
+  std::vector<Slot> slots_;  // chunk i is held in slots_[i % slots_.size()]
+  std::uint64_t num_chunks_;  // published by the reader
+  std::uint64_t next_chunk_;  // to be converted
+  std::uint64_t next_result_;  // to be handed out
+  bool is_eof_;
+  bool is_stopped_;
+  std::exception_ptr error_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace detail
+}  // namespace biosoup
+
+#endif  // BIOSOUP_DETAIL_CHUNK_PIPELINE_HPP_
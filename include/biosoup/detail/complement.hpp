@@ -0,0 +1,203 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_DETAIL_COMPLEMENT_HPP_
+#define BIOSOUP_DETAIL_COMPLEMENT_HPP_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "biosoup/detail/simd.hpp"
+
+namespace biosoup {
+namespace detail {
+
+// Watson-Crick complements of IUPAC codes, complemented characters are upper
+// case while the rest (S, W, N, gaps, ...) are left as they are
+struct ComplementTable {
+  ComplementTable() {
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      data[i] = static_cast<char>(i);
+    }
+    const char* src = "ACGTURYKMBDHV";
+    const char* dst = "TGCAAYRMKVHDB";
+    for (std::uint32_t i = 0; src[i]; ++i) {
+      data[static_cast<std::uint8_t>(src[i])] = dst[i];
+      data[static_cast<std::uint8_t>(src[i] | 0x20)] = dst[i];
+    }
+  }
+
+  char operator[](char c) const {
+    return data[static_cast<std::uint8_t>(c)];
+  }
+
+  char data[256];
+};
+
+inline const ComplementTable& Complement() {
+  static const ComplementTable table{};
+  return table;
+}
+
+// Reverses and complements data in place, quality (if not nullptr, of the
+// same length) is reversed in the same pass. Both ends are processed towards
+// the middle so each character is loaded and stored once.
+inline void ReverseAndComplementScalar(
+    char* data,
+    char* quality,
+    std::size_t len) {
+  const ComplementTable& table = Complement();
+  std::size_t i = 0, j = len;
+  for (; i + 1 < j; ++i, --j) {
+    char c = data[i];
+    data[i] = table[data[j - 1]];
+    data[j - 1] = table[c];
+    if (quality) {
+      std::swap(quality[i], quality[j - 1]);
+    }
+  }
+  if (i + 1 == j) {
+    data[i] = table[data[i]];
+  }
+}
+
+#if defined(BIOSOUP_X86_DISPATCH)
+
+// Letters are folded to indices 1-26 of two 16-entry tables holding their
+// upper case complements, or 0 if the letter is left as it is.
+
+/* clang-format off */
+#define BIOSOUP_COMPLEMENT_TABLES(set)                                        \
+  const auto low_table = set(                                                \
+      0, 'T', 'V', 'G', 'H', 0, 0, 'C', 'D', 0, 0, 'M', 0, 'K', 0, 0);       \
+  const auto high_table = set(                                               \
+      0, 0, 'Y', 0, 'A', 'A', 'B', 0, 0, 'R', 0, 0, 0, 0, 0, 0);
+/* clang-format on */
+
+BIOSOUP_TARGET_SSE42 inline __m128i ComplementSse42(__m128i x) {
+  BIOSOUP_COMPLEMENT_TABLES(_mm_setr_epi8)
+  __m128i is_letter = _mm_cmplt_epi8(
+      _mm_add_epi8(_mm_or_si128(x, _mm_set1_epi8(0x20)), _mm_set1_epi8(0x1F)),
+      _mm_set1_epi8(-102));  // 'a'-'z' are shifted to [-128, -103]
+  __m128i index = _mm_and_si128(x, _mm_set1_epi8(0x1F));
+  __m128i is_high = _mm_cmpgt_epi8(index, _mm_set1_epi8(15));
+  __m128i c = _mm_blendv_epi8(
+      _mm_shuffle_epi8(low_table, index),
+      _mm_shuffle_epi8(high_table, index),
+      is_high);
+  __m128i is_complemented = _mm_andnot_si128(
+      _mm_cmpeq_epi8(c, _mm_setzero_si128()),
+      is_letter);
+  return _mm_blendv_epi8(x, c, is_complemented);
+}
+
+BIOSOUP_TARGET_SSE42 inline void ReverseAndComplementSse42(
+    char* data,
+    char* quality,
+    std::size_t len) {
+  const __m128i reverse = _mm_setr_epi8(
+      15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  std::size_t i = 0, j = len;
+  for (; j - i >= 32; i += 16, j -= 16) {
+    __m128i* front = reinterpret_cast<__m128i*>(data + i);
+    __m128i* back = reinterpret_cast<__m128i*>(data + j - 16);
+    __m128i x = _mm_loadu_si128(front);
+    __m128i y = _mm_loadu_si128(back);
+    _mm_storeu_si128(front, _mm_shuffle_epi8(ComplementSse42(y), reverse));
+    _mm_storeu_si128(back, _mm_shuffle_epi8(ComplementSse42(x), reverse));
+    if (quality) {
+      front = reinterpret_cast<__m128i*>(quality + i);
+      back = reinterpret_cast<__m128i*>(quality + j - 16);
+      x = _mm_loadu_si128(front);
+      y = _mm_loadu_si128(back);
+      _mm_storeu_si128(front, _mm_shuffle_epi8(y, reverse));
+      _mm_storeu_si128(back, _mm_shuffle_epi8(x, reverse));
+    }
+  }
+  ReverseAndComplementScalar(
+      data + i,
+      quality ? quality + i : nullptr,
+      j - i);
+}
+
+#define BIOSOUP_BROADCAST_SSE(...) \
+  _mm256_broadcastsi128_si256(_mm_setr_epi8(__VA_ARGS__))
+
+BIOSOUP_TARGET_AVX2 inline __m256i ComplementAvx2(__m256i x) {
+  BIOSOUP_COMPLEMENT_TABLES(BIOSOUP_BROADCAST_SSE)
+  __m256i is_letter = _mm256_cmpgt_epi8(
+      _mm256_set1_epi8(-102),
+      _mm256_add_epi8(
+          _mm256_or_si256(x, _mm256_set1_epi8(0x20)),
+          _mm256_set1_epi8(0x1F)));
+  __m256i index = _mm256_and_si256(x, _mm256_set1_epi8(0x1F));
+  __m256i is_high = _mm256_cmpgt_epi8(index, _mm256_set1_epi8(15));
+  __m256i c = _mm256_blendv_epi8(
+      _mm256_shuffle_epi8(low_table, index),
+      _mm256_shuffle_epi8(high_table, index),
+      is_high);
+  __m256i is_complemented = _mm256_andnot_si256(
+      _mm256_cmpeq_epi8(c, _mm256_setzero_si256()),
+      is_letter);
+  return _mm256_blendv_epi8(x, c, is_complemented);
+}
+
+BIOSOUP_TARGET_AVX2 inline __m256i ReverseAvx2(__m256i x) {
+  const __m256i reverse = BIOSOUP_BROADCAST_SSE(
+      15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  x = _mm256_shuffle_epi8(x, reverse);
+  return _mm256_permute2x128_si256(x, x, 1);
+}
+
+BIOSOUP_TARGET_AVX2 inline void ReverseAndComplementAvx2(
+    char* data,
+    char* quality,
+    std::size_t len) {
+  std::size_t i = 0, j = len;
+  for (; j - i >= 64; i += 32, j -= 32) {
+    __m256i* front = reinterpret_cast<__m256i*>(data + i);
+    __m256i* back = reinterpret_cast<__m256i*>(data + j - 32);
+    __m256i x = _mm256_loadu_si256(front);
+    __m256i y = _mm256_loadu_si256(back);
+    _mm256_storeu_si256(front, ReverseAvx2(ComplementAvx2(y)));
+    _mm256_storeu_si256(back, ReverseAvx2(ComplementAvx2(x)));
+    if (quality) {
+      front = reinterpret_cast<__m256i*>(quality + i);
+      back = reinterpret_cast<__m256i*>(quality + j - 32);
+      x = _mm256_loadu_si256(front);
+      y = _mm256_loadu_si256(back);
+      _mm256_storeu_si256(front, ReverseAvx2(y));
+      _mm256_storeu_si256(back, ReverseAvx2(x));
+    }
+  }
+  ReverseAndComplementSse42(
+      data + i,
+      quality ? quality + i : nullptr,
+      j - i);
+}
+
+#undef BIOSOUP_BROADCAST_SSE
+#undef BIOSOUP_COMPLEMENT_TABLES
+
+#endif  // BIOSOUP_X86_DISPATCH
+
+inline void ReverseAndComplement(
+    char* data,
+    char* quality,
+    std::size_t len) {
+#if defined(BIOSOUP_X86_DISPATCH)
+  switch (simd_level()) {
+    case SimdLevel::kAvx2:
+      return ReverseAndComplementAvx2(data, quality, len);
+    case SimdLevel::kSse42:
+      return ReverseAndComplementSse42(data, quality, len);
+    default:
+      break;
+  }
+#endif
+  ReverseAndComplementScalar(data, quality, len);
+}
+
+}  // namespace detail
+}  // namespace biosoup
+
+#endif  // BIOSOUP_DETAIL_COMPLEMENT_HPP_
@@ -0,0 +1,101 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_DETAIL_MAPPED_FILE_HPP_
+#define BIOSOUP_DETAIL_MAPPED_FILE_HPP_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace biosoup {
+namespace detail {
+
+// read-only shared mapping, the page cache is shared between processes
+class MappedFile {
+ public:
+  MappedFile()
+      : data_(nullptr),
+        size_(0) {}
+
+  explicit MappedFile(const std::string& path)
+      : MappedFile() {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+      throw std::runtime_error(
+          "[biosoup::detail::MappedFile::MappedFile] error: unable to open " +
+          path);
+    }
+    struct stat status {};
+    if (fstat(fd, &status) == -1) {
+      close(fd);
+      throw std::runtime_error(
+          "[biosoup::detail::MappedFile::MappedFile] error: unable to stat " +
+          path);
+    }
+    size_ = status.st_size;
+    if (size_) {
+      void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+      if (data == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error(
+            "[biosoup::detail::MappedFile::MappedFile] error: unable to map " +
+            path);
+      }
+      data_ = static_cast<const char*>(data);
+    }
+    close(fd);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other)
+      : data_(other.data_),
+        size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+
+  MappedFile& operator=(MappedFile&& other) {
+    if (this != &other) {
+      Unmap();
+      data_ = other.data_;
+      size_ = other.size_;
+      other.data_ = nullptr;
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  ~MappedFile() {
+    Unmap();
+  }
+
+  const char* data() const {
+    return data_;
+  }
+
+  std::uint64_t size() const {
+    return size_;
+  }
+
+ private:
+  void Unmap() {
+    if (data_) {
+      munmap(const_cast<char*>(data_), size_);
+    }
+  }
+
+  const char* data_;
+  std::uint64_t size_;
+};
+
+}  // namespace detail
+}  // namespace biosoup
+
+#endif  // BIOSOUP_DETAIL_MAPPED_FILE_HPP_
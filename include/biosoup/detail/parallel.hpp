@@ -0,0 +1,173 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_DETAIL_PARALLEL_HPP_
+#define BIOSOUP_DETAIL_PARALLEL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <exception>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace biosoup {
+namespace detail {
+
+// Calls f(i) for i in [0, n) on num_threads threads (including the calling
+// one), which take indices dynamically. The first exception is rethrown.
+template<typename F>
+void ParallelFor(std::size_t n, std::uint32_t num_threads, F f) {
+  num_threads = std::min<std::size_t>(std::max(num_threads, 1U), n);
+  if (num_threads <= 1) {
+    for (std::size_t i = 0; i < n; ++i) {
+      f(i);
+    }
+    return;
+  }
+
+  std::atomic<std::size_t> next{0};
+  std::exception_ptr error;
+  std::mutex mutex;
+  auto work = [&] () -> void {
+    try {
+      for (std::size_t i; (i = next++) < n;) {
+        f(i);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+      next = n;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (std::uint32_t i = 1; i < num_threads; ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto& it : threads) {
+    it.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+// Bytes held by tasks running in parallel (on top of used). A task holds
+// a Lease, whose construction blocks until its bytes fit under limit or no
+// other task holds any, so that a task larger than limit still runs (on its
+// own). Once the lease is gone, its bytes (or set_num_freed of them) are
+// returned. A task which does not know its size upfront acquires bytes
+// through its lease as it goes instead, waiting as if it did not run.
+class MemoryBudget {
+ public:
+  class Lease {
+   public:
+    Lease(MemoryBudget* budget, std::uint64_t n)
+        : budget_(budget),
+          num_freed_(n) {
+      budget_->Acquire(n);
+    }
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    Lease(Lease&&) = delete;
+    Lease& operator=(Lease&&) = delete;
+
+    ~Lease() {
+      budget_->Release(num_freed_);
+    }
+
+    // bytes the task frees at its end, if not all it acquired
+    void set_num_freed(std::uint64_t n) {
+      num_freed_ = n;
+    }
+
+    // bytes the task needs on top of its lease, kept once the lease is gone
+    void Acquire(std::uint64_t n) {
+      budget_->Grow(n);
+    }
+
+    // bytes the task frees before its end, not counted by set_num_freed
+    void Release(std::uint64_t n) {
+      budget_->Shrink(n);
+    }
+
+   private:
+    MemoryBudget* budget_;
+    std::uint64_t num_freed_;
+  };
+
+  explicit MemoryBudget(std::uint64_t limit, std::uint64_t used = 0)
+      : limit_(limit),
+        used_(used),
+        num_tasks_(0),
+        mutex_(),
+        cv_() {}
+
+  MemoryBudget(const MemoryBudget&) = delete;
+  MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+  MemoryBudget(MemoryBudget&&) = delete;
+  MemoryBudget& operator=(MemoryBudget&&) = delete;
+
+  ~MemoryBudget() = default;
+
+ private:
+  void Acquire(std::uint64_t n) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] () -> bool {
+      return used_ + n <= limit_ || num_tasks_ == 0;
+    });
+    used_ += n;
+    ++num_tasks_;
+  }
+
+  void Release(std::uint64_t n) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      used_ -= std::min(n, used_);
+      --num_tasks_;
+    }
+    cv_.notify_all();
+  }
+
+  // a running task does not count while it waits, so that tasks waiting
+  // here at once do not block each other
+  void Grow(std::uint64_t n) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (--num_tasks_ == 0) {
+      cv_.notify_all();
+    }
+    cv_.wait(lock, [&] () -> bool {
+      return used_ + n <= limit_ || num_tasks_ == 0;
+    });
+    used_ += n;
+    ++num_tasks_;
+  }
+
+  void Shrink(std::uint64_t n) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      used_ -= std::min(n, used_);
+    }
+    cv_.notify_all();
+  }
+
+ private:
+  std::uint64_t limit_;
+  std::uint64_t used_;
+  std::uint32_t num_tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+}  // namespace detail
+}  // namespace biosoup
+
+#endif  // BIOSOUP_DETAIL_PARALLEL_HPP_
@@ -0,0 +1,49 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_DETAIL_SIMD_HPP_
+#define BIOSOUP_DETAIL_SIMD_HPP_
+
+// x86 kernels are compiled with function level target attributes and
+// selected at runtime, so no -m flags are needed by the users of biosoup
+#if defined(__x86_64__) && (defined(__clang__) || (defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define BIOSOUP_X86_DISPATCH 1
+#define BIOSOUP_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define BIOSOUP_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+namespace biosoup {
+namespace detail {
+
+enum class SimdLevel {
+  kScalar,
+  kSse42,  // with POPCNT
+  kAvx2
+};
+
+inline SimdLevel DetectSimdLevel() {
+#if defined(BIOSOUP_X86_DISPATCH)
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("popcnt")) {  // not implied by SSE4.2 or AVX2
+    return SimdLevel::kScalar;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::kAvx2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return SimdLevel::kSse42;
+  }
+#endif
+  return SimdLevel::kScalar;
+}
+
+inline SimdLevel simd_level() {  // detected once per process
+  static const SimdLevel level = DetectSimdLevel();
+  return level;
+}
+
+}  // namespace detail
+}  // namespace biosoup
+
+#endif  // BIOSOUP_DETAIL_SIMD_HPP_
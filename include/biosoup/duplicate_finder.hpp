@@ -0,0 +1,236 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_DUPLICATE_FINDER_HPP_
+#define BIOSOUP_DUPLICATE_FINDER_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "biosoup/detail/parallel.hpp"
+#include "biosoup/fingerprint.hpp"
+#include "biosoup/io.hpp"
+#include "biosoup/nucleic_acid.hpp"
+
+namespace biosoup {
+
+// Groups nucleic acids with equal bases and ambiguous runs (in either
+// orientation if is_canonical) by their fingerprints, so that batches of
+// sequences can be released once added. Fingerprints are computed by
+// num_threads threads and split into 256 shards by their top bits. Whenever
+// shards would take more than memory_limit they are spilled to shard files in
+// tmp_dir. Find sorts one shard at a time per thread, and loads spilled
+// shards only while they fit into memory_limit next to those in memory (see
+// detail::MemoryBudget).
+class DuplicateFinder {
+ public:
+  enum : std::uint32_t {
+    kNumShards = 256
+  };
+
+  explicit DuplicateFinder(
+      bool is_canonical = true,
+      std::uint64_t memory_limit = 1ULL << 32,
+      const std::string& tmp_dir = ".",
+      std::uint32_t num_threads = std::thread::hardware_concurrency())
+      : is_canonical_(is_canonical),
+        memory_limit_(memory_limit),
+        num_threads_(std::max(num_threads, 1U)),
+        prefix_(),
+        shards_(kNumShards),
+        num_sequences_(0),
+        num_spills_(0),
+        is_found_(false) {
+    prefix_ = detail::TemporaryPrefix(tmp_dir, "duplicates");
+  }
+
+  DuplicateFinder(const DuplicateFinder&) = delete;
+  DuplicateFinder& operator=(const DuplicateFinder&) = delete;
+
+  DuplicateFinder(DuplicateFinder&&) = delete;
+  DuplicateFinder& operator=(DuplicateFinder&&) = delete;
+
+  ~DuplicateFinder() {
+    if (num_spills_) {
+      for (std::uint32_t i = 0; i < kNumShards; ++i) {
+        shards_[i].file.reset();
+        std::remove(Path(i).c_str());
+      }
+    }
+  }
+
+  std::uint64_t num_sequences() const {  // added so far
+    return num_sequences_;
+  }
+
+  std::size_t num_spills() const {
+    return num_spills_;
+  }
+
+  std::uint64_t memory_usage() const {  // of the shards
+    return num_records() * sizeof(Record);
+  }
+
+  void Add(const std::vector<std::unique_ptr<NucleicAcid>>& sequences) {
+    if (is_found_) {
+      throw std::logic_error(
+          "[biosoup::DuplicateFinder::Add] error: duplicates already found");
+    }
+    std::vector<Record> records(sequences.size());
+    detail::ParallelFor(
+        (sequences.size() + kBatchSize - 1) / kBatchSize,
+        num_threads_,
+        [&] (std::size_t i) -> void {
+          for (std::size_t j = i * kBatchSize;
+               j < std::min<std::size_t>((i + 1) * kBatchSize, sequences.size());  // NOLINT
+               ++j) {
+            records[j] = Record{
+                is_canonical_ ?
+                    ComputeCanonicalFingerprint(*sequences[j]) :
+                    ComputeFingerprint(*sequences[j]),
+                sequences[j]->id};
+          }
+        });
+    for (const auto& it : records) {
+      shards_[it.fingerprint.hi >> 56].records.emplace_back(it);
+    }
+    num_sequences_ += sequences.size();
+    if (memory_usage() > memory_limit_) {
+      Spill();
+    }
+  }
+
+  // Returns groups of at least two ids with equal fingerprints, ids in each
+  // group and groups by their first id in increasing order. No more sequences
+  // can be added afterwards.
+  std::vector<std::vector<ObjectId>> Find() {
+    if (is_found_) {
+      throw std::logic_error(
+          "[biosoup::DuplicateFinder::Find] error: duplicates already found");
+    }
+    is_found_ = true;
+
+    detail::MemoryBudget budget{memory_limit_, memory_usage()};
+    std::vector<std::vector<std::vector<ObjectId>>> groups(kNumShards);
+    detail::ParallelFor(kNumShards, num_threads_, [&] (std::size_t i) -> void {
+      Shard& s = shards_[i];
+      std::uint64_t num_bytes = s.file ?
+          (s.num_spilled + s.records.size()) * sizeof(Record) : 0;
+      detail::MemoryBudget::Lease lease{&budget, num_bytes};
+      lease.set_num_freed(num_bytes + s.records.size() * sizeof(Record));
+      if (s.file) {
+        s.file->Close();
+        s.file.reset();
+        std::vector<Record> records(s.num_spilled);
+        records.reserve(s.num_spilled + s.records.size());
+        ReadFunction read = ReadFile(Path(i));
+        for (std::size_t j = 0, n = records.size() * sizeof(Record), m;
+             j < n;
+             j += m) {
+          if ((m = read(reinterpret_cast<char*>(records.data()) + j, n - j)) == 0) {  // NOLINT
+            throw std::runtime_error(
+                "[biosoup::DuplicateFinder::Find] error: truncated " + Path(i));
+          }
+        }
+        std::remove(Path(i).c_str());
+        records.insert(records.end(), s.records.begin(), s.records.end());
+        records.swap(s.records);
+      }
+
+      std::sort(s.records.begin(), s.records.end(),
+          [] (const Record& lhs, const Record& rhs) -> bool {
+            return lhs.fingerprint < rhs.fingerprint ||
+                (lhs.fingerprint == rhs.fingerprint && lhs.id < rhs.id);
+          });
+      for (auto it = s.records.begin(); it != s.records.end();) {
+        auto jt = it + 1;
+        while (jt != s.records.end() && jt->fingerprint == it->fingerprint) {
+          ++jt;
+        }
+        if (jt - it > 1) {
+          groups[i].emplace_back();
+          for (; it != jt; ++it) {
+            groups[i].back().emplace_back(it->id);
+          }
+        }
+        it = jt;
+      }
+      std::vector<Record>().swap(s.records);
+    });
+
+    std::vector<std::vector<ObjectId>> dst;
+    for (auto& it : groups) {
+      std::move(it.begin(), it.end(), std::back_inserter(dst));
+    }
+    std::sort(dst.begin(), dst.end(),
+        [] (const std::vector<ObjectId>& lhs, const std::vector<ObjectId>& rhs) -> bool {  // NOLINT
+          return lhs.front() < rhs.front();
+        });
+    return dst;
+  }
+
+ private:
+  enum : std::uint32_t {
+    kBatchSize = 1U << 10  // sequences fingerprinted at once
+  };
+
+  struct Record {
+    Fingerprint fingerprint;
+    ObjectId id;
+  };
+
+  struct Shard {
+    std::vector<Record> records;
+    std::unique_ptr<FileWriter> file;  // shard file, once spilled
+    std::uint64_t num_spilled = 0;
+  };
+
+  std::string Path(std::uint32_t i) const {
+    return prefix_ + std::to_string(i) + ".bin";
+  }
+
+  std::uint64_t num_records() const {
+    std::uint64_t dst = 0;
+    for (const auto& it : shards_) {
+      dst += it.records.size();
+    }
+    return dst;
+  }
+
+  void Spill() {
+    detail::ParallelFor(kNumShards, num_threads_, [&] (std::size_t i) -> void {
+      Shard& s = shards_[i];
+      if (s.records.empty()) {
+        return;
+      }
+      if (!s.file) {
+        s.file.reset(new FileWriter(Path(i)));
+      }
+      s.file->Write(
+          reinterpret_cast<const char*>(s.records.data()),
+          s.records.size() * sizeof(Record));
+      s.num_spilled += s.records.size();
+      std::vector<Record>().swap(s.records);
+    });
+    ++num_spills_;
+  }
+
+  bool is_canonical_;
+  std::uint64_t memory_limit_;
+  std::uint32_t num_threads_;
+  std::string prefix_;  // of shard files
+  std::vector<Shard> shards_;
+  std::uint64_t num_sequences_;
+  std::size_t num_spills_;
+  bool is_found_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_DUPLICATE_FINDER_HPP_
@@ -0,0 +1,171 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_FINGERPRINT_HPP_
+#define BIOSOUP_FINGERPRINT_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "biosoup/detail/complement.hpp"
+#include "biosoup/nucleic_acid.hpp"
+#include "biosoup/nucleic_acid_compare.hpp"
+#include "biosoup/nucleic_acid_view.hpp"
+
+namespace biosoup {
+
+// 128-bit hash of bases
+struct Fingerprint {
+  bool operator==(const Fingerprint& other) const {
+    return hi == other.hi && lo == other.lo;
+  }
+
+  bool operator!=(const Fingerprint& other) const {
+    return !(*this == other);
+  }
+
+  bool operator<(const Fingerprint& other) const {
+    return hi < other.hi || (hi == other.hi && lo < other.lo);
+  }
+
+  std::uint64_t hi;
+  std::uint64_t lo;
+};
+
+namespace detail {
+
+// MurmurHash3 (x64, 128-bit) over packed bases, 2 words per block
+
+inline std::uint64_t RotateLeft(std::uint64_t x, std::uint32_t n) {
+  return (x << n) | (x >> (64 - n));
+}
+
+inline std::uint64_t FinalizeHash(std::uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xFF51AFD7ED558CCDULL;
+  x ^= x >> 33;
+  x *= 0xC4CEB9FE1A85EC53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+// Ambiguous runs within the view, in its orientation. Their bases are packed
+// as A on the forward strand and as T on the reverse one, so they are cleared
+// before hashing.
+inline std::vector<AmbiguousRun> OrientAmbiguousRuns(
+    const NucleicAcidView& view) {
+  std::vector<AmbiguousRun> dst = view.AmbiguousRuns();
+  if (view.is_reverse_complement) {
+    std::reverse(dst.begin(), dst.end());
+    for (auto& it : dst) {
+      it.begin = view.inflated_len - it.begin - it.len;
+      it.c = Complement()[it.c];
+    }
+  }
+  return dst;
+}
+
+inline Fingerprint HashBases(
+    const NucleicAcidView& view,
+    const std::vector<AmbiguousRun>& runs = {}) {  // see OrientAmbiguousRuns
+  const std::uint64_t c1 = 0x87C37B91114253D5ULL;
+  const std::uint64_t c2 = 0x4CF5AD432745937FULL;
+  std::uint64_t h1 = 0, h2 = 0;
+
+  std::uint64_t buffer[kChunkSize / 32];
+  auto run = runs.begin();
+  for (std::uint32_t i = 0, len; i < view.inflated_len; i += len) {
+    len = std::min<std::uint32_t>(view.inflated_len - i, kChunkSize);
+    const std::uint64_t* src = PackBases(view, i, len, buffer);
+    std::uint32_t n = (len + 31) >> 5;
+    for (; run != runs.end() && run->begin < i + len; ++run) {
+      if (src != buffer) {
+        std::copy(src, src + n, buffer);
+        src = buffer;
+      }
+      std::uint32_t last = std::min(run->begin + run->len, i + len);
+      for (std::uint32_t j = std::max(run->begin, i) - i; j < last - i; ++j) {
+        buffer[j >> 5] &= ~(3ULL << ((j & 31) << 1));
+      }
+      if (run->begin + run->len > i + len) {  // continues in the next chunk
+        break;
+      }
+    }
+    std::uint32_t j = 0;
+    for (; j + 1 < (len >> 5); j += 2) {
+      std::uint64_t k1 = src[j], k2 = src[j + 1];
+      h1 ^= RotateLeft(k1 * c1, 31) * c2;
+      h1 = (RotateLeft(h1, 27) + h2) * 5 + 0x52DCE729;
+      h2 ^= RotateLeft(k2 * c2, 33) * c1;
+      h2 = (RotateLeft(h2, 31) + h1) * 5 + 0x38495AB5;
+    }
+    // tail of the last chunk, bases past its end are ignored
+    std::uint64_t k1 = j < n ? src[j] & BaseMask(len - (j << 5)) : 0;
+    std::uint64_t k2 = j + 1 < n ? src[j + 1] & BaseMask(len - ((j + 1) << 5)) : 0;  // NOLINT
+    h2 ^= RotateLeft(k2 * c2, 33) * c1;
+    h1 ^= RotateLeft(k1 * c1, 31) * c2;
+  }
+
+  for (const auto& it : runs) {
+    std::uint64_t k1 = (static_cast<std::uint64_t>(it.begin) << 32) | it.len;
+    std::uint64_t k2 = static_cast<std::uint8_t>(it.c);
+    h1 ^= RotateLeft(k1 * c1, 31) * c2;
+    h1 = (RotateLeft(h1, 27) + h2) * 5 + 0x52DCE729;
+    h2 ^= RotateLeft(k2 * c2, 33) * c1;
+    h2 = (RotateLeft(h2, 31) + h1) * 5 + 0x38495AB5;
+  }
+
+  h1 ^= view.inflated_len;
+  h2 ^= view.inflated_len;
+  h1 += h2;
+  h2 += h1;
+  h1 = FinalizeHash(h1);
+  h2 = FinalizeHash(h2);
+  h1 += h2;
+  h2 += h1;
+  return Fingerprint{h2, h1};
+}
+
+inline Fingerprint HashCanonicalBases(const NucleicAcidView& view) {
+  NucleicAcidView reverse = view;
+  reverse.ReverseAndComplement();
+  std::vector<AmbiguousRun> runs = OrientAmbiguousRuns(view);
+  if (!runs.empty()) {  // packed bases of both strands differ
+    return std::min(
+        HashBases(view, runs),
+        HashBases(reverse, OrientAmbiguousRuns(reverse)));
+  }
+  std::uint32_t i = CommonPrefixLength(view, reverse);
+  return HashBases(
+      i < view.inflated_len && reverse.Code(i) < view.Code(i) ? reverse : view);
+}
+
+}  // namespace detail
+
+// Fingerprints are computed over packed bases (32 at a time, past the last one
+// ignored) in the orientation of the sequence, without inflating it. Equal
+// bases give equal fingerprints and different ones collide with probability
+// of about 2^-128. Ambiguous runs within the sequence are hashed as well.
+
+inline Fingerprint ComputeFingerprint(const NucleicAcidView& view) {
+  return detail::HashBases(view, detail::OrientAmbiguousRuns(view));
+}
+
+inline Fingerprint ComputeFingerprint(const NucleicAcid& nucleic_acid) {
+  return ComputeFingerprint(NucleicAcidView(nucleic_acid));
+}
+
+// fingerprint of the lexicographically smaller one of the sequence and its
+// reverse complement (the smaller fingerprint if there are ambiguous runs),
+// equal for both strands
+inline Fingerprint ComputeCanonicalFingerprint(const NucleicAcidView& view) {
+  return detail::HashCanonicalBases(view);
+}
+
+inline Fingerprint ComputeCanonicalFingerprint(const NucleicAcid& nucleic_acid) {  // NOLINT
+  return detail::HashCanonicalBases(NucleicAcidView(nucleic_acid));
+}
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_FINGERPRINT_HPP_
@@ -0,0 +1,284 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_HPC_NUCLEIC_ACID_HPP_
+#define BIOSOUP_HPC_NUCLEIC_ACID_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "biosoup/detail/bits.hpp"
+#include "biosoup/nucleic_acid.hpp"
+#include "biosoup/overlap.hpp"
+
+namespace biosoup {
+
+// Homopolymer compressed (HPC) nucleic acid, i.e. each run of equal bases is
+// collapsed into a single one. Collapsed bases are packed as in NucleicAcid,
+// while run lengths are kept as a bit vector over raw bases with a set bit at
+// the start of each run (1 bit per raw base). HPC to raw coordinate
+// translation is a select query on the bit vector, answered by scanning from
+// the sampled position of every 64th set bit, and its inverse is a rank query,
+// answered from counts of set bits sampled every 512 bits.
+//
+// Ambiguous runs are not kept, as characters are mapped to bases first.
+class HpcNucleicAcid {
+ public:
+  enum : std::uint32_t {
+    kRankSampleRate = 512,  // in bits
+    kSelectSampleRate = 64  // in set bits
+  };
+
+  HpcNucleicAcid()
+      : id(0),
+        name(),
+        deflated_data(),
+        inflated_len(0),
+        raw_len(0),
+        is_reverse_complement(false),
+        run_starts_(),
+        ranks_(1, 0),
+        selects_() {}
+
+  HpcNucleicAcid(const std::string& name, const std::string& data)
+      : HpcNucleicAcid(name.c_str(), name.size(), data.c_str(), data.size()) {}
+
+  HpcNucleicAcid(
+      const char* name, std::uint32_t name_len,
+      const char* data, std::uint32_t data_len)
+      : HpcNucleicAcid() {
+    id = NextId<NucleicAcid>();
+    this->name.assign(name, name_len);
+    Reserve(data_len);
+    std::uint64_t blocks[32];
+    for (std::uint32_t i = 0; i < data_len; i += 1024) {
+      std::uint32_t n = std::min(data_len - i, 1024U);
+      if (!detail::Deflate(data + i, n, blocks)) {
+        throw std::invalid_argument(
+            "[biosoup::HpcNucleicAcid::HpcNucleicAcid] error: "
+            "not a nucleotide");
+      }
+      for (std::uint32_t j = 0; j < n; j += 32) {
+        Append(blocks[j >> 5], std::min(n - j, 32U));
+      }
+    }
+    Finalize();
+  }
+
+  // keeps the id, name and orientation
+  explicit HpcNucleicAcid(const NucleicAcid& nucleic_acid)
+      : HpcNucleicAcid() {
+    id = nucleic_acid.id;
+    name = nucleic_acid.name;
+    is_reverse_complement = nucleic_acid.is_reverse_complement;
+    Reserve(nucleic_acid.inflated_len);
+    for (std::uint32_t i = 0; i < nucleic_acid.inflated_len; i += 32) {
+      Append(
+          nucleic_acid.deflated_data[i >> 5],
+          std::min(nucleic_acid.inflated_len - i, 32U));
+    }
+    Finalize();
+  }
+
+  HpcNucleicAcid(const HpcNucleicAcid&) = default;
+  HpcNucleicAcid& operator=(const HpcNucleicAcid&) = default;
+
+  HpcNucleicAcid(HpcNucleicAcid&&) = default;
+  HpcNucleicAcid& operator=(HpcNucleicAcid&&) = default;
+
+  ~HpcNucleicAcid() = default;
+
+  std::uint64_t Code(std::uint32_t i) const {
+    std::uint64_t x = 0;
+    if (is_reverse_complement) {
+      i = inflated_len - i - 1;
+      x = 3;
+    }
+    return ((deflated_data[i >> 5] >> ((i << 1) & 63)) & 3) ^ x;
+  }
+
+  // collapsed bases
+  std::string InflateData(std::uint32_t i = 0, std::uint32_t len = -1) const {
+    if (i >= inflated_len) {
+      return std::string{};
+    }
+    len = std::min(len, inflated_len - i);
+    std::string dst(len, '\0');
+    if (is_reverse_complement) {
+      i = inflated_len - i - len;
+    }
+    detail::Inflate(deflated_data.data(), i, len, is_reverse_complement, &dst[0]);  // NOLINT
+    return dst;
+  }
+
+  // raw bases, i.e. collapsed bases [i, i + len) with their runs restored
+  std::string InflateRawData(std::uint32_t i = 0, std::uint32_t len = -1) const {  // NOLINT
+    if (i >= inflated_len) {
+      return std::string{};
+    }
+    len = std::min(len, inflated_len - i);
+    std::string dst{};
+    dst.reserve(RawPosition(i + len) - RawPosition(i));
+    std::uint32_t begin = RawPosition(i);
+    for (std::uint32_t j = i; j < i + len; ++j) {
+      std::uint32_t end = RawPosition(j + 1);
+      dst.append(end - begin, kNucleotideDecoder[Code(j)]);
+      begin = end;
+    }
+    return dst;
+  }
+
+  // raw position of the first base of the run collapsed into base i, in the
+  // orientation of the sequence (raw_len for i = inflated_len)
+  std::uint32_t RawPosition(std::uint32_t i) const {
+    return is_reverse_complement ?
+        raw_len - Select(inflated_len - i) :
+        Select(i);
+  }
+
+  // collapsed base covering raw position i, in the orientation of the
+  // sequence (inflated_len for i = raw_len)
+  std::uint32_t HpcPosition(std::uint32_t i) const {
+    if (i >= raw_len) {
+      return inflated_len;
+    }
+    return is_reverse_complement ?
+        inflated_len - Rank(raw_len - i) :
+        Rank(i + 1) - 1;
+  }
+
+  std::uint32_t RunLength(std::uint32_t i) const {
+    return RawPosition(i + 1) - RawPosition(i);
+  }
+
+  void ReverseAndComplement() {  // Watson-Crick base pairing
+    is_reverse_complement ^= 1;
+  }
+
+  ObjectId id;
+  std::string name;
+  std::vector<std::uint64_t> deflated_data;  // collapsed bases
+  std::uint32_t inflated_len;  // number of collapsed bases
+  std::uint32_t raw_len;
+  bool is_reverse_complement;
+
+ private:
+  // number of runs starting at forward raw positions [0, i)
+  std::uint32_t Rank(std::uint32_t i) const {
+    std::uint32_t dst = ranks_[i / kRankSampleRate];
+    std::uint32_t j = i / kRankSampleRate * (kRankSampleRate / 64);
+    for (; j < i / 64; ++j) {
+      dst += detail::Popcount(run_starts_[j]);
+    }
+    if (i & 63) {
+      dst += detail::Popcount(
+          run_starts_[i / 64] & ((1ULL << (i & 63)) - 1));
+    }
+    return dst;
+  }
+
+  // forward raw position of the start of run i (raw_len for i = inflated_len)
+  std::uint32_t Select(std::uint32_t i) const {
+    if (i >= inflated_len) {
+      return raw_len;
+    }
+    std::uint32_t p = selects_[i / kSelectSampleRate];
+    std::uint32_t r = i % kSelectSampleRate;
+    std::uint32_t j = p / 64;
+    std::uint64_t word = run_starts_[j] & (-1ULL << (p & 63));
+    for (std::uint32_t c; r >= (c = detail::Popcount(word));) {
+      r -= c;
+      word = run_starts_[++j];
+    }
+    return j * 64 + detail::SelectInWord(word, r);
+  }
+
+  void Reserve(std::uint32_t raw_len) {
+    run_starts_.reserve((raw_len + 63ULL) / 64);
+    deflated_data.reserve((raw_len + 31ULL) / 32);
+  }
+
+  // appends the first n bases of block, raw_len has to be divisible by 32
+  void Append(std::uint64_t block, std::uint32_t n) {
+    std::uint64_t previous = inflated_len ?
+        deflated_data.back() >> (((inflated_len - 1) & 31) << 1) & 3 :
+        ~block & 3;
+    std::uint64_t x = block ^ ((block << 2) | previous);
+    if (n < 32) {
+      x &= (1ULL << (n << 1)) - 1;
+    }
+    // non-zero lanes are the starts of runs, their low bits are compressed
+    x = (x | (x >> 1)) & 0x5555555555555555ULL;
+    x = (x | (x >> 1)) & 0x3333333333333333ULL;
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+
+    if ((raw_len & 63) == 0) {
+      run_starts_.emplace_back(x);
+    } else {
+      run_starts_.back() |= x << 32;
+    }
+    raw_len += n;
+
+    for (; x; x &= x - 1) {
+      std::uint64_t c = (block >> (detail::TrailingZeros(x) << 1)) & 3;
+      if ((inflated_len & 31) == 0) {
+        deflated_data.emplace_back(0);
+      }
+      deflated_data.back() |= c << ((inflated_len & 31) << 1);
+      ++inflated_len;
+    }
+  }
+
+  void Finalize() {
+    deflated_data.shrink_to_fit();
+    ranks_.clear();
+    selects_.clear();
+    std::uint32_t num_runs = 0;
+    for (std::uint32_t i = 0; i < run_starts_.size(); ++i) {
+      if (i % (kRankSampleRate / 64) == 0) {
+        ranks_.emplace_back(num_runs);
+      }
+      std::uint32_t c = detail::Popcount(run_starts_[i]);
+      for (std::uint32_t r; (r = selects_.size() * kSelectSampleRate) < num_runs + c;) {  // NOLINT
+        selects_.emplace_back(
+            i * 64 + detail::SelectInWord(run_starts_[i], r - num_runs));
+      }
+      num_runs += c;
+    }
+    ranks_.emplace_back(num_runs);
+    selects_.shrink_to_fit();
+  }
+
+  std::vector<std::uint64_t> run_starts_;
+  std::vector<std::uint32_t> ranks_;  // runs before every 512th raw position
+  std::vector<std::uint32_t> selects_;  // raw positions of every 64th run
+};
+
+// Lifts an overlap between homopolymer compressed sequences to their raw
+// bases. Coordinates are taken on the forward strands, as in Overlap, and the
+// alignment is dropped as it refers to collapsed bases.
+inline Overlap LiftOverlap(
+    const Overlap& overlap,
+    const HpcNucleicAcid& lhs,
+    const HpcNucleicAcid& rhs) {
+  auto lift = [] (const HpcNucleicAcid& s, std::uint32_t i) -> std::uint32_t {
+    i = std::min(i, s.inflated_len);
+    return s.is_reverse_complement ?
+        s.raw_len - s.RawPosition(s.inflated_len - i) :
+        s.RawPosition(i);
+  };
+  return Overlap(
+      overlap.lhs_id, lift(lhs, overlap.lhs_begin), lift(lhs, overlap.lhs_end),
+      overlap.rhs_id, lift(rhs, overlap.rhs_begin), lift(rhs, overlap.rhs_end),
+      overlap.score,
+      overlap.strand);
+}
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_HPC_NUCLEIC_ACID_HPP_
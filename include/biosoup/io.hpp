@@ -0,0 +1,150 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_IO_HPP_
+#define BIOSOUP_IO_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#if defined(BIOSOUP_USE_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace biosoup {
+
+// source of raw bytes, returns the number of bytes stored to dst (0 at end)
+using ReadFunction = std::function<std::size_t(char* dst, std::size_t len)>;
+
+inline ReadFunction ReadFile(const std::string& path) {
+  std::shared_ptr<std::FILE> file(
+      std::fopen(path.c_str(), "rb"),
+      [] (std::FILE* f) -> void {
+        if (f) {
+          std::fclose(f);
+        }
+      });
+  if (!file) {
+    throw std::runtime_error(
+        "[biosoup::ReadFile] error: unable to open " + path);
+  }
+  return [file] (char* dst, std::size_t len) -> std::size_t {
+    return std::fread(dst, 1, len, file.get());
+  };
+}
+
+#if defined(BIOSOUP_USE_ZLIB)
+
+// reads both gzip compressed and plain files
+inline ReadFunction ReadGzipFile(const std::string& path) {
+  std::shared_ptr<gzFile_s> file(
+      gzopen(path.c_str(), "r"),
+      [] (gzFile f) -> void {
+        if (f) {
+          gzclose(f);
+        }
+      });
+  if (!file) {
+    throw std::runtime_error(
+        "[biosoup::ReadGzipFile] error: unable to open " + path);
+  }
+  gzbuffer(file.get(), 1U << 20);
+  return [file, path] (char* dst, std::size_t len) -> std::size_t {
+    int n = gzread(
+        file.get(), dst,
+        static_cast<unsigned>(std::min<std::size_t>(len, 1U << 30)));
+    if (n < 0) {
+      throw std::runtime_error(
+          "[biosoup::ReadGzipFile] error: unable to decompress " + path);
+    }
+    return n;
+  };
+}
+
+#endif
+
+// Buffered sink of raw bytes in a file. Write checks every call, Close
+// flushes and closes the file and reports errors of both once, so it has to
+// be called before the file is read back. The destructor closes the file
+// without reporting errors (e.g. while unwinding).
+class FileWriter {
+ public:
+  explicit FileWriter(const std::string& path)
+      : file_(std::fopen(path.c_str(), "wb")),
+        path_(path) {
+    if (!file_) {
+      throw std::runtime_error(
+          "[biosoup::FileWriter::FileWriter] error: unable to open " + path);
+    }
+  }
+
+  FileWriter(const FileWriter&) = delete;
+  FileWriter& operator=(const FileWriter&) = delete;
+
+  FileWriter(FileWriter&&) = delete;
+  FileWriter& operator=(FileWriter&&) = delete;
+
+  ~FileWriter() {
+    if (file_) {
+      std::fclose(file_);
+    }
+  }
+
+  void Write(const char* data, std::size_t len) {
+    if (std::fwrite(data, 1, len, file_) != len) {
+      throw std::runtime_error(
+          "[biosoup::FileWriter::Write] error: unable to write " + path_);
+    }
+  }
+
+  void Close() {
+    if (!file_) {
+      return;
+    }
+    bool is_flushed = std::fflush(file_) == 0;
+    bool is_closed = std::fclose(file_) == 0;
+    file_ = nullptr;
+    if (!is_flushed || !is_closed) {
+      throw std::runtime_error(
+          "[biosoup::FileWriter::Close] error: unable to write " + path_);
+    }
+  }
+
+ private:
+  std::FILE* file_;
+  std::string path_;
+};
+
+// sink of raw bytes, throws on failure
+using WriteFunction = std::function<void(const char* data, std::size_t len)>;
+
+// The file is closed with the last copy of the function, errors of that last
+// flush can not be reported (use FileWriter where they matter).
+inline WriteFunction WriteFile(const std::string& path) {
+  std::shared_ptr<FileWriter> file = std::make_shared<FileWriter>(path);
+  return [file] (const char* data, std::size_t len) -> void {
+    file->Write(data, len);
+  };
+}
+
+namespace detail {
+
+// Prefix of temporary files in dir, random so that objects sharing dir do
+// not collide. The files hold raw structs in host endianness and are only
+// read back by the object which wrote them.
+inline std::string TemporaryPrefix(const std::string& dir, const char* name) {
+  char id[16];
+  std::snprintf(id, sizeof(id), "%08x", std::random_device()());
+  return dir + "/biosoup_" + name + "_" + id + "_";
+}
+
+}  // namespace detail
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_IO_HPP_
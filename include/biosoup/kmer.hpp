@@ -0,0 +1,264 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_KMER_HPP_
+#define BIOSOUP_KMER_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "biosoup/nucleic_acid.hpp"
+#include "biosoup/nucleic_acid_view.hpp"
+
+namespace biosoup {
+
+struct Kmer {
+  std::uint64_t value;  // canonical k-mer or its hash
+  std::uint32_t position;  // of the first base
+  bool strand;  // true if the k-mer is canonical as read
+};
+
+// invertible mixing of k-mers to avoid lexicographically small minimizers
+inline std::uint64_t HashKmer(std::uint64_t kmer, std::uint64_t mask) {
+  kmer = ((~kmer) + (kmer << 21)) & mask;
+  kmer = kmer ^ (kmer >> 24);
+  kmer = ((kmer + (kmer << 3)) + (kmer << 8)) & mask;
+  kmer = kmer ^ (kmer >> 14);
+  kmer = ((kmer + (kmer << 2)) + (kmer << 4)) & mask;
+  kmer = kmer ^ (kmer >> 28);
+  kmer = (kmer + (kmer << 31)) & mask;
+  return kmer;
+}
+
+inline std::uint64_t KmerMask(std::uint32_t k) {
+  return k == 32 ? -1ULL : (1ULL << (k << 1)) - 1;
+}
+
+// Extracts canonical k-mers (k <= 32) in batches by shifting 2-bit blocks out
+// of deflated data. The forward strand is traversed, so k-mers of reverse
+// complemented sequences come in decreasing order of position. K-mers which
+// overlap ambiguous runs are skipped.
+class KmerIterator {
+ public:
+  KmerIterator(const NucleicAcid& nucleic_acid, std::uint32_t k)
+      : KmerIterator(NucleicAcidView(nucleic_acid), k) {}
+
+  KmerIterator(const NucleicAcidView& nucleic_acid, std::uint32_t k)
+      : KmerIterator(
+          nucleic_acid.deflated_data,
+          nucleic_acid.inflated_len,
+          nucleic_acid.is_reverse_complement,
+          k,
+          nucleic_acid.begin,
+          nucleic_acid.ambiguous_runs,
+          nucleic_acid.ambiguous_runs + nucleic_acid.num_ambiguous_runs) {}
+
+  KmerIterator(
+      const std::uint64_t* deflated_data,
+      std::uint32_t inflated_len,
+      bool is_reverse_complement,
+      std::uint32_t k,
+      std::uint32_t begin = 0,  // of the first base in deflated_data
+      const AmbiguousRun* first_run = nullptr,  // positions in deflated_data
+      const AmbiguousRun* last_run = nullptr)
+      : deflated_data_(deflated_data),
+        end_(begin + inflated_len),
+        is_reverse_complement_(is_reverse_complement),
+        k_(CheckK(k)),  // before the mask, which is undefined for k > 32
+        mask_(KmerMask(k)),
+        shift_((k - 1) << 1),
+        position_offset_(is_reverse_complement ?
+            begin + inflated_len - k : 0 - begin),
+        position_step_(is_reverse_complement ? -1 : 1),
+        i_(begin),
+        forward_(0),
+        reverse_(0),
+        run_(nullptr),
+        last_run_(nullptr),
+        stop_(-1) {
+    if (inflated_len < k_) {
+      i_ = end_;
+      return;
+    }
+    run_ = std::partition_point(
+        first_run, last_run,
+        [&] (const AmbiguousRun& run) { return run.begin + run.len <= begin; });
+    last_run_ = last_run;
+    if (run_ != last_run_) {
+      stop_ = std::max(run_->begin, begin);
+    }
+    Restart();
+  }
+
+  KmerIterator(const KmerIterator&) = default;
+  KmerIterator& operator=(const KmerIterator&) = default;
+
+  KmerIterator(KmerIterator&&) = default;
+  KmerIterator& operator=(KmerIterator&&) = default;
+
+  ~KmerIterator() = default;
+
+  // stores up to n k-mers to dst, returns 0 once the sequence is exhausted
+  std::size_t Next(Kmer* dst, std::size_t n) {
+    std::size_t m = 0;
+    while (m < n && i_ < end_) {
+      if (i_ == stop_) {
+        Restart();
+        continue;
+      }
+      std::uint64_t block = deflated_data_[i_ >> 5] >> ((i_ << 1) & 63);
+      std::uint32_t end = std::min<std::uint64_t>(
+          std::min(std::min(end_, stop_), (i_ | 31) + 1),
+          i_ + (n - m));
+      for (; i_ < end; ++i_, ++m, block >>= 2) {
+        Push(block & 3);
+        bool is_forward = forward_ <= reverse_;
+        dst[m].value = is_forward ? forward_ : reverse_;
+        dst[m].position = position_offset_ + position_step_ * (i_ + 1 - k_);
+        dst[m].strand = is_forward != is_reverse_complement_ ||
+            forward_ == reverse_;
+      }
+    }
+    return m;
+  }
+
+ private:
+  static std::uint32_t CheckK(std::uint32_t k) {
+    if (k == 0 || k > 32) {
+      throw std::invalid_argument(
+          "[biosoup::KmerIterator::KmerIterator] error: k is not in [1, 32]");
+    }
+    return k;
+  }
+
+  // skips ambiguous runs at i_ and pushes the first k - 1 bases after them
+  void Restart() {
+    for (std::uint32_t j = 0;
+         (j + 1 < k_ || i_ == stop_) && i_ < end_;) {
+      if (i_ == stop_) {  // the run may start before begin
+        i_ = run_->begin + run_->len;
+        ++run_;
+        stop_ = run_ == last_run_ ? -1 : run_->begin;
+        j = 0;
+        continue;
+      }
+      Push((deflated_data_[i_ >> 5] >> ((i_ << 1) & 63)) & 3);
+      ++i_;
+      ++j;
+    }
+  }
+
+  void Push(std::uint64_t c) {
+    forward_ = ((forward_ << 2) | c) & mask_;
+    reverse_ = (reverse_ >> 2) | ((c ^ 3) << shift_);
+  }
+
+  const std::uint64_t* deflated_data_;
+  std::uint32_t end_;
+  bool is_reverse_complement_;
+  std::uint32_t k_;
+  std::uint64_t mask_;
+  std::uint32_t shift_;
+  std::uint32_t position_offset_;  // wraps around for views with begin > 0
+  std::uint32_t position_step_;  // wraps around for the reverse strand
+  std::uint32_t i_;
+  std::uint64_t forward_;
+  std::uint64_t reverse_;
+  const AmbiguousRun* run_;  // next ambiguous run
+  const AmbiguousRun* last_run_;
+  std::uint32_t stop_;  // begin of run_ in deflated_data
+};
+
+// Appends (w, k)-minimizers of hashed canonical k-mers in increasing order of
+// position, i.e. the smallest hash of each window of w consecutive k-mers
+// (the leftmost one on ties, each occurrence reported once). Windows restart
+// after ambiguous runs.
+template<typename T>
+void Minimize(
+    const T& nucleic_acid,  // NucleicAcid or NucleicAcidView
+    std::uint32_t k, std::uint32_t w,
+    std::vector<Kmer>* dst) {
+  if (w == 0) {
+    throw std::invalid_argument(
+        "[biosoup::Minimize] error: empty window");
+  }
+  std::size_t first = dst->size();
+  KmerIterator it{nucleic_acid, k};
+  std::uint64_t mask = KmerMask(k);
+
+  Kmer batch[256];
+  std::vector<Kmer> window(w);  // last w k-mers in a ring buffer
+  std::uint32_t slot = w - 1, minimizer = 0;  // slots of the last k-mer
+  std::uint64_t num_kmers = 0, age = 0;  // k-mers since the minimizer
+  std::uint32_t step = nucleic_acid.is_reverse_complement ? -1 : 1;
+  for (std::size_t n; (n = it.Next(batch, 256)) > 0;) {
+    for (std::size_t i = 0; i < n; ++i, ++num_kmers) {
+      if (num_kmers &&
+          batch[i].position != window[slot].position + step) {  // skipped
+        if (num_kmers < w) {
+          dst->emplace_back(window[minimizer]);
+        }
+        num_kmers = 0;
+      }
+      batch[i].value = HashKmer(batch[i].value, mask);
+      slot = slot + 1 == w ? 0 : slot + 1;
+      window[slot] = batch[i];
+      bool is_new = false;
+      if (num_kmers == 0 || batch[i].value < window[minimizer].value) {
+        minimizer = slot;
+        age = 0;
+        is_new = true;
+      } else if (++age == w) {  // expired, rescan from the oldest k-mer
+        minimizer = slot + 1 == w ? 0 : slot + 1;
+        age = w - 1;
+        for (std::uint32_t j = 1, s = minimizer; j < w; ++j) {
+          s = s + 1 == w ? 0 : s + 1;
+          if (window[s].value < window[minimizer].value) {
+            minimizer = s;
+            age = w - 1 - j;
+          }
+        }
+        is_new = true;
+      }
+      if (num_kmers + 1 == w || (num_kmers + 1 > w && is_new)) {
+        dst->emplace_back(window[minimizer]);
+      }
+    }
+  }
+  if (num_kmers && num_kmers < w) {  // shorter than a window
+    dst->emplace_back(window[minimizer]);
+  }
+  if (nucleic_acid.is_reverse_complement) {
+    std::reverse(dst->begin() + first, dst->end());
+  }
+}
+
+namespace detail {
+
+// reference extraction through Code(i)
+template<typename T>
+void CanonicalKmersByCode(
+    const T& nucleic_acid,
+    std::uint32_t k,
+    std::vector<Kmer>* dst) {
+  std::uint64_t mask = KmerMask(k), forward = 0, reverse = 0;
+  for (std::uint32_t i = 0; i < nucleic_acid.inflated_len; ++i) {
+    std::uint64_t c = nucleic_acid.Code(i);
+    forward = ((forward << 2) | c) & mask;
+    reverse = (reverse >> 2) | ((c ^ 3) << ((k - 1) << 1));
+    if (i + 1 >= k) {
+      dst->push_back(Kmer{
+          std::min(forward, reverse),
+          i + 1 - k,
+          forward <= reverse});
+    }
+  }
+}
+
+}  // namespace detail
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_KMER_HPP_
@@ -0,0 +1,400 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_KMER_COUNTER_HPP_
+#define BIOSOUP_KMER_COUNTER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <stdexcept>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "biosoup/detail/parallel.hpp"
+#include "biosoup/io.hpp"
+#include "biosoup/kmer.hpp"
+#include "biosoup/nucleic_acid.hpp"
+
+namespace biosoup {
+
+struct KmerCount {
+  std::uint64_t kmer;  // canonical
+  std::uint64_t count;
+};
+
+// Counts canonical k-mers (k <= 32) of nucleic acids. K-mers are split into
+// 256 partitions by the top bits of their hash (HashKmer), each counted in
+// its own open addressing table with linear probing. Groups of sequences are
+// taken dynamically by num_threads threads, which insert the extracted k-mers
+// into partitions in batches, locking one partition at a time. A table which
+// would grow past memory_limit (counting all tables) is spilled to a run file
+// in tmp_dir instead. Count merges runs back into their tables, which take
+// memory from a budget of memory_limit as they grow, so that partitions are
+// merged in parallel while their growth fits (and one at a time past it),
+// and leaves the k-mers of each partition in place, sorted by hash.
+class KmerCounter {
+ public:
+  enum : std::uint32_t {
+    kNumPartitions = 256,
+    kMaxHistogram = 1U << 16
+  };
+
+  explicit KmerCounter(
+      std::uint32_t k,
+      std::uint64_t memory_limit = 1ULL << 32,
+      const std::string& tmp_dir = ".",
+      std::uint32_t num_threads = std::thread::hardware_concurrency())
+      : k_(CheckK(k)),  // before the mask, which is undefined for k > 32
+        mask_(KmerMask(k)),
+        shift_(k > 4 ? 2 * k - 8 : 0),
+        memory_limit_(memory_limit),
+        num_threads_(std::max(num_threads, 1U)),
+        prefix_(),
+        partitions_(),
+        memory_usage_(0),
+        num_kmers_(0),
+        is_counted_(false),
+        num_counted_kmers_(0),
+        histogram_() {
+    prefix_ = detail::TemporaryPrefix(tmp_dir, "kmers");
+    for (std::uint32_t i = 0; i < kNumPartitions; ++i) {
+      partitions_.emplace_back(new Partition());
+      partitions_.back()->table.resize(kMinCapacity);
+      memory_usage_ += kMinCapacity * sizeof(KmerCount);
+    }
+  }
+
+  KmerCounter(const KmerCounter&) = delete;
+  KmerCounter& operator=(const KmerCounter&) = delete;
+
+  KmerCounter(KmerCounter&&) = delete;
+  KmerCounter& operator=(KmerCounter&&) = delete;
+
+  ~KmerCounter() {
+    for (const auto& it : partitions_) {
+      for (const auto& jt : it->runs) {
+        std::remove(jt.c_str());
+      }
+    }
+  }
+
+  std::uint32_t k() const {
+    return k_;
+  }
+
+  std::uint64_t num_kmers() const {  // added so far, with repetitions
+    return num_kmers_;
+  }
+
+  std::size_t num_runs() const {
+    std::size_t dst = 0;
+    for (const auto& it : partitions_) {
+      dst += it->runs.size();
+    }
+    return dst;
+  }
+
+  std::uint64_t memory_usage() const {  // of the tables
+    return memory_usage_;
+  }
+
+  void Add(const std::vector<std::unique_ptr<NucleicAcid>>& sequences) {
+    if (is_counted_) {
+      throw std::logic_error(
+          "[biosoup::KmerCounter::Add] error: k-mers already counted");
+    }
+    std::size_t num_groups = std::min<std::size_t>(
+        sequences.size(),
+        num_threads_ * 16);
+    detail::ParallelFor(num_groups, num_threads_, [&] (std::size_t i) -> void {
+      std::vector<std::vector<std::uint64_t>> batches(kNumPartitions);
+      Kmer kmers[256];
+      std::uint64_t num_kmers = 0;
+      for (std::size_t j = sequences.size() * i / num_groups;
+           j < sequences.size() * (i + 1) / num_groups;
+           ++j) {
+        KmerIterator it{*sequences[j], k_};
+        for (std::size_t n; (n = it.Next(kmers, 256)) > 0; num_kmers += n) {
+          for (std::size_t l = 0; l < n; ++l) {
+            std::uint64_t p = HashKmer(kmers[l].value, mask_) >> shift_;
+            batches[p].emplace_back(kmers[l].value);
+            if (batches[p].size() == kBatchSize) {
+              Insert(p, batches[p]);
+              batches[p].clear();
+            }
+          }
+        }
+      }
+      for (std::uint32_t p = 0; p < kNumPartitions; ++p) {
+        Insert(p, batches[p]);
+      }
+      num_kmers_ += num_kmers;
+    });
+  }
+
+  // Merges runs and keeps k-mers occurring at least min_count times, after
+  // which no more k-mers can be added.
+  void Count(std::uint64_t min_count = 1) {
+    if (is_counted_) {
+      throw std::logic_error(
+          "[biosoup::KmerCounter::Count] error: k-mers already counted");
+    }
+    is_counted_ = true;
+
+    // tables are already counted in memory_usage_, and how much they grow
+    // depends on how many k-mers repeat across runs, so each partition
+    // acquires growth from the budget as it happens
+    detail::MemoryBudget budget{memory_limit_, memory_usage_};
+    std::vector<std::vector<std::uint64_t>> histograms(kNumPartitions);
+    detail::ParallelFor(kNumPartitions, num_threads_, [&] (std::size_t i) -> void {  // NOLINT
+      Partition& p = *partitions_[i];
+      detail::MemoryBudget::Lease lease{&budget, 0};
+
+      std::vector<KmerCount> buffer(1U << 12);
+      for (const auto& it : p.runs) {
+        ReadFunction read = ReadFile(it);
+        for (std::size_t n; (n = read(
+                 reinterpret_cast<char*>(buffer.data()),
+                 buffer.size() * sizeof(KmerCount))) > 0;) {
+          for (std::size_t j = 0; j < n / sizeof(KmerCount); ++j) {
+            Insert(i, &p, buffer[j].kmer, buffer[j].count, &lease);
+          }
+        }
+        std::remove(it.c_str());
+      }
+      p.runs.clear();
+
+      std::vector<std::uint64_t>& histogram = histograms[i];
+      std::size_t num_kmers = 0;
+      for (const auto& it : p.table) {
+        if (it.count == 0) {
+          continue;
+        }
+        std::uint64_t c = std::min<std::uint64_t>(it.count, kMaxHistogram);
+        if (histogram.size() <= c) {
+          histogram.resize(c + 1, 0);
+        }
+        ++histogram[c];
+        if (it.count >= min_count) {
+          p.table[num_kmers++] = it;
+        }
+      }
+
+      // hashes are computed once, sorted next to the k-mers and kept for Find
+      struct Entry {
+        std::uint64_t hash;
+        KmerCount kmer;
+      };
+      lease.Acquire(num_kmers * sizeof(Entry));
+      std::vector<Entry> entries(num_kmers);
+      for (std::size_t j = 0; j < num_kmers; ++j) {
+        entries[j] = Entry{HashKmer(p.table[j].kmer, mask_), p.table[j]};
+      }
+      std::uint64_t num_bytes = p.table.size() * sizeof(KmerCount);
+      std::vector<KmerCount>().swap(p.table);
+      lease.Release(num_bytes);
+      std::sort(entries.begin(), entries.end(),
+          [] (const Entry& lhs, const Entry& rhs) -> bool {
+            return lhs.hash < rhs.hash;
+          });
+      lease.Acquire(num_kmers * (sizeof(KmerCount) + sizeof(std::uint64_t)));
+      p.table.resize(num_kmers);
+      p.hashes.resize(num_kmers);
+      for (std::size_t j = 0; j < num_kmers; ++j) {
+        p.table[j] = entries[j].kmer;
+        p.hashes[j] = entries[j].hash;
+      }
+      std::vector<Entry>().swap(entries);
+      lease.Release(num_kmers * sizeof(Entry));
+    });
+    memory_usage_ = 0;
+
+    for (std::uint32_t i = 0; i < kNumPartitions; ++i) {
+      num_counted_kmers_ += partitions_[i]->table.size();
+      if (histogram_.size() < histograms[i].size()) {
+        histogram_.resize(histograms[i].size(), 0);
+      }
+      for (std::size_t j = 0; j < histograms[i].size(); ++j) {
+        histogram_[j] += histograms[i][j];
+      }
+    }
+  }
+
+  std::size_t num_counted_kmers() const {  // left by Count
+    return num_counted_kmers_;
+  }
+
+  // k-mers of partition i left by Count, in increasing order of their hash,
+  // which also increases with i
+  const std::vector<KmerCount>& kmers(std::uint32_t i) const {
+    static const std::vector<KmerCount> empty;
+    return is_counted_ ? partitions_[i]->table : empty;
+  }
+
+  // count of a canonical k-mer left by Count, 0 otherwise
+  std::uint64_t Find(std::uint64_t kmer) const {
+    if (!is_counted_) {
+      return 0;
+    }
+    std::uint64_t hash = HashKmer(kmer, mask_);
+    const Partition& p = *partitions_[hash >> shift_];
+    std::size_t i = std::lower_bound(p.hashes.begin(), p.hashes.end(), hash) -
+        p.hashes.begin();
+    return i < p.table.size() && p.table[i].kmer == kmer ? p.table[i].count : 0;  // NOLINT
+  }
+
+  // number of distinct k-mers by count, of all k-mers counted by Count, with
+  // the last entry holding those occurring kMaxHistogram times or more
+  const std::vector<std::uint64_t>& histogram() const {
+    return histogram_;
+  }
+
+  // writes non-empty histogram entries as "<count> <number of k-mers>" lines
+  void WriteHistogram(const WriteFunction& write) const {
+    std::string dst;
+    for (std::size_t i = 1; i < histogram_.size(); ++i) {
+      if (histogram_[i]) {
+        dst += std::to_string(i) + " " + std::to_string(histogram_[i]) + "\n";
+      }
+    }
+    write(dst.data(), dst.size());
+  }
+
+ private:
+  enum : std::uint32_t {
+    kBatchSize = 1U << 10,
+    kMinCapacity = 1U << 6
+  };
+
+  struct Partition {
+    Partition()
+        : mutex(),
+          table(),
+          size(0),
+          runs(),
+          hashes() {}
+
+    std::mutex mutex;
+    std::vector<KmerCount> table;  // slots with count 0 are empty
+    std::size_t size;
+    std::vector<std::string> runs;
+    std::vector<std::uint64_t> hashes;  // of table, left by Count
+  };
+
+  static std::uint32_t CheckK(std::uint32_t k) {
+    if (k == 0 || k > 32) {
+      throw std::invalid_argument(
+          "[biosoup::KmerCounter::KmerCounter] error: k is not in [1, 32]");
+    }
+    return k;
+  }
+
+  void Insert(std::uint32_t i, const std::vector<std::uint64_t>& kmers) {
+    Partition* p = partitions_[i].get();
+    std::lock_guard<std::mutex> lock(p->mutex);
+    for (auto it : kmers) {
+      Insert(i, p, it, 1, nullptr);
+    }
+  }
+
+  // tables grow at 70% load, or are spilled if growing would exceed
+  // memory_limit_, unless a lease is given to acquire the growth from
+  void Insert(
+      std::uint32_t i, Partition* p,
+      std::uint64_t kmer, std::uint64_t count,
+      detail::MemoryBudget::Lease* lease) {
+    if ((p->size + 1) * 10 > p->table.size() * 7 && !Grow(p, lease)) {
+      Spill(i, p);
+    }
+    Emplace(p, kmer, count);
+  }
+
+  // a table of c slots takes 3c slots while it grows to 2c
+  bool Grow(Partition* p, detail::MemoryBudget::Lease* lease) {
+    std::uint64_t num_bytes = p->table.size() * sizeof(KmerCount);
+    if (lease) {
+      lease->Acquire(2 * num_bytes);
+    } else if (memory_usage_.fetch_add(num_bytes) + num_bytes > memory_limit_) {  // NOLINT
+      memory_usage_ -= num_bytes;
+      return false;
+    }
+    {
+      std::vector<KmerCount> table(p->table.size() * 2, KmerCount{0, 0});
+      table.swap(p->table);
+      p->size = 0;
+      for (const auto& it : table) {
+        if (it.count) {
+          Emplace(p, it.kmer, it.count);
+        }
+      }
+    }
+    if (lease) {
+      lease->Release(num_bytes);
+    }
+    return true;
+  }
+
+  void Spill(std::uint32_t i, Partition* p) {
+    p->runs.emplace_back(
+        prefix_ + std::to_string(i) + "_" + std::to_string(p->runs.size()) +
+        ".bin");
+    FileWriter file{p->runs.back()};
+    std::vector<KmerCount> buffer;
+    buffer.reserve(1U << 12);
+    for (auto& it : p->table) {
+      if (it.count == 0) {
+        continue;
+      }
+      buffer.emplace_back(it);
+      it.count = 0;
+      if (buffer.size() == buffer.capacity()) {
+        file.Write(
+            reinterpret_cast<const char*>(buffer.data()),
+            buffer.size() * sizeof(KmerCount));
+        buffer.clear();
+      }
+    }
+    file.Write(
+        reinterpret_cast<const char*>(buffer.data()),
+        buffer.size() * sizeof(KmerCount));
+    file.Close();
+    p->size = 0;
+  }
+
+  void Emplace(Partition* p, std::uint64_t kmer, std::uint64_t count) {
+    std::size_t mask = p->table.size() - 1;
+    for (std::size_t i = HashKmer(kmer, mask_) & mask;; i = (i + 1) & mask) {
+      KmerCount& it = p->table[i];
+      if (it.count == 0) {
+        it = KmerCount{kmer, count};
+        ++p->size;
+        return;
+      }
+      if (it.kmer == kmer) {
+        it.count += count;
+        return;
+      }
+    }
+  }
+
+  std::uint32_t k_;
+  std::uint64_t mask_;
+  std::uint32_t shift_;  // of hashes to partitions
+  std::uint64_t memory_limit_;
+  std::uint32_t num_threads_;
+  std::string prefix_;  // of run files
+  std::vector<std::unique_ptr<Partition>> partitions_;
+  std::atomic<std::uint64_t> memory_usage_;
+  std::atomic<std::uint64_t> num_kmers_;
+  bool is_counted_;
+  std::size_t num_counted_kmers_;
+  std::vector<std::uint64_t> histogram_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_KMER_COUNTER_HPP_
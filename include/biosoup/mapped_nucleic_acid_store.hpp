@@ -0,0 +1,486 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_MAPPED_NUCLEIC_ACID_STORE_HPP_
+#define BIOSOUP_MAPPED_NUCLEIC_ACID_STORE_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "biosoup/detail/mapped_file.hpp"
+#include "biosoup/nucleic_acid.hpp"
+#include "biosoup/nucleic_acid_store.hpp"
+#include "biosoup/nucleic_acid_view.hpp"
+
+namespace biosoup {
+
+// Read-only collection of nucleic acids served directly from a memory mapped
+// binary file. The file starts with a fixed header holding the magic bytes,
+// a byte order marker, format version, number of sequences and the byte
+// offsets of the sections (ids, lengths, orientations, name offsets, names,
+// block offsets, blocks, quality offsets, quality scores, ambiguous run
+// offsets, ambiguous runs, lower case run offsets, lower case runs), each
+// aligned to 8 bytes. Offset tables have size() + 1 entries and integers are
+// stored in the byte order of the writer, files from hosts of the other one
+// are rejected. Runs are stored as laid out in memory, with zeroed padding.
+class MappedNucleicAcidStore {
+ public:
+  static constexpr std::uint32_t kVersion = 3;
+
+  MappedNucleicAcidStore()
+      : file_(),
+        num_sequences_(0),
+        ids_(nullptr),
+        inflated_lens_(nullptr),
+        is_reverse_complement_(nullptr),
+        name_offsets_(nullptr),
+        names_(nullptr),
+        data_offsets_(nullptr),
+        deflated_data_(nullptr),
+        quality_offsets_(nullptr),
+        quality_(nullptr),
+        ambiguous_run_offsets_(nullptr),
+        ambiguous_runs_(nullptr),
+        lower_case_run_offsets_(nullptr),
+        lower_case_runs_(nullptr) {}
+
+  explicit MappedNucleicAcidStore(const std::string& path)
+      : MappedNucleicAcidStore() {
+    file_ = detail::MappedFile(path);
+
+    Header header{};
+    if (file_.size() < sizeof(header)) {
+      throw std::invalid_argument(
+          "[biosoup::MappedNucleicAcidStore::MappedNucleicAcidStore] error: "
+          "truncated file " + path);
+    }
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if (std::memcmp(header.magic, Magic(), sizeof(header.magic)) != 0) {
+      throw std::invalid_argument(
+          "[biosoup::MappedNucleicAcidStore::MappedNucleicAcidStore] error: "
+          "not a biosoup nucleic acid file " + path);
+    }
+    if (header.byte_order != kByteOrder) {
+      throw std::invalid_argument(
+          "[biosoup::MappedNucleicAcidStore::MappedNucleicAcidStore] error: "
+          "byte order of " + path + " differs from the host");
+    }
+    if (header.version != kVersion || header.num_sections != kNumSections) {
+      throw std::invalid_argument(
+          "[biosoup::MappedNucleicAcidStore::MappedNucleicAcidStore] error: "
+          "unsupported version of " + path);
+    }
+    for (std::uint32_t i = 0; i < kNumSections; ++i) {
+      if (header.offsets[i] > header.offsets[i + 1] ||
+          header.offsets[i] % 8 != 0) {
+        throw std::invalid_argument(
+            "[biosoup::MappedNucleicAcidStore::MappedNucleicAcidStore] error: "
+            "corrupted section table in " + path);
+      }
+    }
+    if (header.offsets[0] < sizeof(header) ||
+        header.offsets[kNumSections] > file_.size()) {
+      throw std::invalid_argument(
+          "[biosoup::MappedNucleicAcidStore::MappedNucleicAcidStore] error: "
+          "truncated file " + path);
+    }
+    auto section_len = [&] (std::uint32_t i) -> std::uint64_t {
+      return header.offsets[i + 1] - header.offsets[i];
+    };
+    std::uint64_t n = header.num_sequences;
+    if (n > file_.size() ||
+        section_len(kIds) < n * sizeof(std::uint32_t) ||
+        section_len(kInflatedLens) < n * sizeof(std::uint32_t) ||
+        section_len(kOrientations) < n ||
+        section_len(kNameOffsets) < (n + 1) * sizeof(std::uint64_t) ||
+        section_len(kDataOffsets) < (n + 1) * sizeof(std::uint64_t) ||
+        section_len(kQualityOffsets) < (n + 1) * sizeof(std::uint64_t) ||
+        section_len(kAmbiguousRunOffsets) < (n + 1) * sizeof(std::uint64_t) ||
+        section_len(kLowerCaseRunOffsets) < (n + 1) * sizeof(std::uint64_t)) {
+      throw std::invalid_argument(
+          "[biosoup::MappedNucleicAcidStore::MappedNucleicAcidStore] error: "
+          "corrupted section table in " + path);
+    }
+
+    num_sequences_ = header.num_sequences;
+    ids_ = Section<std::uint32_t>(header, kIds);
+    inflated_lens_ = Section<std::uint32_t>(header, kInflatedLens);
+    is_reverse_complement_ = Section<std::uint8_t>(header, kOrientations);
+    name_offsets_ = Section<std::uint64_t>(header, kNameOffsets);
+    names_ = Section<char>(header, kNames);
+    data_offsets_ = Section<std::uint64_t>(header, kDataOffsets);
+    deflated_data_ = Section<std::uint64_t>(header, kDeflatedData);
+    quality_offsets_ = Section<std::uint64_t>(header, kQualityOffsets);
+    quality_ = Section<std::int8_t>(header, kQuality);
+    ambiguous_run_offsets_ = Section<std::uint64_t>(
+        header, kAmbiguousRunOffsets);
+    ambiguous_runs_ = Section<AmbiguousRun>(header, kAmbiguousRuns);
+    lower_case_run_offsets_ = Section<std::uint64_t>(
+        header, kLowerCaseRunOffsets);
+    lower_case_runs_ = Section<LowerCaseRun>(header, kLowerCaseRuns);
+
+    // offsets are checked once here so that operator[] stays in the mapping
+    if (!IsMonotone(name_offsets_, n, section_len(kNames)) ||
+        !IsMonotone(
+            data_offsets_, n,
+            section_len(kDeflatedData) / sizeof(std::uint64_t)) ||
+        !IsMonotone(quality_offsets_, n, section_len(kQuality)) ||
+        !IsMonotone(
+            ambiguous_run_offsets_, n,
+            section_len(kAmbiguousRuns) / sizeof(AmbiguousRun)) ||
+        !IsMonotone(
+            lower_case_run_offsets_, n,
+            section_len(kLowerCaseRuns) / sizeof(LowerCaseRun))) {
+      throw std::invalid_argument(
+          "[biosoup::MappedNucleicAcidStore::MappedNucleicAcidStore] error: "
+          "corrupted offsets in " + path);
+    }
+    for (std::uint64_t i = 0; i < n; ++i) {
+      std::uint64_t num_scores = quality_offsets_[i + 1] - quality_offsets_[i];
+      if (data_offsets_[i + 1] - data_offsets_[i] <
+              (inflated_lens_[i] + 31ULL) >> 5 ||
+          (num_scores != 0 && num_scores < inflated_lens_[i]) ||
+          !AreRunsValid(
+              ambiguous_runs_ + ambiguous_run_offsets_[i],
+              ambiguous_runs_ + ambiguous_run_offsets_[i + 1],
+              inflated_lens_[i]) ||
+          !AreRunsValid(
+              lower_case_runs_ + lower_case_run_offsets_[i],
+              lower_case_runs_ + lower_case_run_offsets_[i + 1],
+              inflated_lens_[i])) {
+        throw std::invalid_argument(
+            "[biosoup::MappedNucleicAcidStore::MappedNucleicAcidStore] error: "
+            "corrupted lengths in " + path);
+      }
+    }
+  }
+
+  MappedNucleicAcidStore(const MappedNucleicAcidStore&) = delete;
+  MappedNucleicAcidStore& operator=(const MappedNucleicAcidStore&) = delete;
+
+  MappedNucleicAcidStore(MappedNucleicAcidStore&&) = default;
+  MappedNucleicAcidStore& operator=(MappedNucleicAcidStore&&) = default;
+
+  ~MappedNucleicAcidStore() = default;
+
+  std::size_t size() const {
+    return num_sequences_;
+  }
+
+  bool empty() const {
+    return num_sequences_ == 0;
+  }
+
+  NucleicAcidView operator[](std::size_t i) const {
+    NucleicAcidView dst(
+        ids_[i],
+        names_ + name_offsets_[i],
+        name_offsets_[i + 1] - name_offsets_[i],
+        deflated_data_ + data_offsets_[i],
+        quality_offsets_[i] == quality_offsets_[i + 1] ?
+            nullptr : quality_ + quality_offsets_[i],
+        inflated_lens_[i],
+        is_reverse_complement_[i]);
+    dst.ambiguous_runs = ambiguous_runs_ + ambiguous_run_offsets_[i];
+    dst.num_ambiguous_runs =
+        ambiguous_run_offsets_[i + 1] - ambiguous_run_offsets_[i];
+    dst.lower_case_runs = lower_case_runs_ + lower_case_run_offsets_[i];
+    dst.num_lower_case_runs =
+        lower_case_run_offsets_[i + 1] - lower_case_run_offsets_[i];
+    return dst;
+  }
+
+  static void Write(const std::string& path, const NucleicAcidStore& src) {
+    Write(path, src.size(), [&] (std::size_t i) -> NucleicAcidView {
+      return src[i];
+    });
+  }
+
+  static void Write(
+      const std::string& path,
+      const std::vector<std::unique_ptr<NucleicAcid>>& src) {
+    Write(path, src.size(), [&] (std::size_t i) -> NucleicAcidView {
+      return NucleicAcidView(*src[i]);
+    });
+  }
+
+  // writes views returned by view(i) for i in [0, n), each has to stay valid
+  // until the next call
+  template<typename F>
+  static void Write(const std::string& path, std::size_t n, F view) {
+    std::ofstream os(path, std::ios::binary);
+    if (!os.is_open()) {
+      throw std::runtime_error(
+          "[biosoup::MappedNucleicAcidStore::Write] error: unable to open " +
+          path);
+    }
+
+    std::uint64_t num_name_bytes = 0, num_blocks = 0, num_scores = 0;
+    std::uint64_t num_ambiguous_runs = 0, num_lower_case_runs = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      NucleicAcidView it = view(i);
+      num_name_bytes += it.name_len;
+      num_blocks += (it.inflated_len + 31ULL) >> 5;
+      num_scores += it.has_quality() ? it.inflated_len : 0;
+      num_ambiguous_runs += it.AmbiguousRuns().size();
+      num_lower_case_runs += it.LowerCaseRuns().size();
+    }
+
+    const std::uint64_t section_sizes[kNumSections] = {
+        n * sizeof(std::uint32_t),
+        n * sizeof(std::uint32_t),
+        n * sizeof(std::uint8_t),
+        (n + 1) * sizeof(std::uint64_t),
+        num_name_bytes,
+        (n + 1) * sizeof(std::uint64_t),
+        num_blocks * sizeof(std::uint64_t),
+        (n + 1) * sizeof(std::uint64_t),
+        num_scores,
+        (n + 1) * sizeof(std::uint64_t),
+        num_ambiguous_runs * sizeof(AmbiguousRun),
+        (n + 1) * sizeof(std::uint64_t),
+        num_lower_case_runs * sizeof(LowerCaseRun)};
+
+    Header header{};
+    std::memcpy(header.magic, Magic(), sizeof(header.magic));
+    header.byte_order = kByteOrder;
+    header.version = kVersion;
+    header.num_sections = kNumSections;
+    header.num_sequences = n;
+    header.offsets[0] = Align(sizeof(header));
+    for (std::uint32_t i = 0; i < kNumSections; ++i) {
+      header.offsets[i + 1] = Align(header.offsets[i] + section_sizes[i]);
+    }
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::uint64_t offset = 0;
+    std::uint64_t num_bytes = sizeof(header);
+    auto put = [&] (const void* data, std::uint64_t len) -> void {
+      os.write(static_cast<const char*>(data), len);
+      num_bytes += len;
+    };
+    auto pad = [&] () -> void {
+      static const char zeros[8] = {0};
+      put(zeros, Align(num_bytes) - num_bytes);
+    };
+
+    pad();
+    for (std::size_t i = 0; i < n; ++i) {
+      if (view(i).id > UINT32_MAX) {
+        throw std::invalid_argument(
+            "[biosoup::MappedNucleicAcidStore::Write] error: id exceeds 32 bits");  // NOLINT
+      }
+      std::uint32_t id = view(i).id;
+      put(&id, sizeof(id));
+    }
+    pad();
+    for (std::size_t i = 0; i < n; ++i) {
+      std::uint32_t inflated_len = view(i).inflated_len;
+      put(&inflated_len, sizeof(inflated_len));
+    }
+    pad();
+    for (std::size_t i = 0; i < n; ++i) {
+      std::uint8_t is_reverse_complement = view(i).is_reverse_complement;
+      put(&is_reverse_complement, sizeof(is_reverse_complement));
+    }
+    pad();
+    put(&(offset = 0), sizeof(offset));
+    for (std::size_t i = 0; i < n; ++i) {
+      offset += view(i).name_len;
+      put(&offset, sizeof(offset));
+    }
+    pad();
+    for (std::size_t i = 0; i < n; ++i) {
+      NucleicAcidView it = view(i);
+      put(it.name, it.name_len);
+    }
+    pad();
+    put(&(offset = 0), sizeof(offset));
+    for (std::size_t i = 0; i < n; ++i) {
+      offset += (view(i).inflated_len + 31ULL) >> 5;
+      put(&offset, sizeof(offset));
+    }
+    pad();
+    std::vector<std::uint64_t> blocks;  // of views not aligned to a block
+    for (std::size_t i = 0; i < n; ++i) {
+      NucleicAcidView it = view(i);
+      std::uint64_t num_blocks = (it.inflated_len + 31ULL) >> 5;
+      if ((it.begin & 31) == 0) {
+        put(it.deflated_data + (it.begin >> 5),
+            num_blocks * sizeof(std::uint64_t));
+        continue;
+      }
+      blocks.resize(num_blocks);
+      const std::uint64_t* src = it.deflated_data + (it.begin >> 5);
+      std::uint64_t last = (it.begin + it.inflated_len - 1ULL) >> 5;
+      std::uint32_t shift = (it.begin & 31) << 1;
+      for (std::uint64_t j = 0; j < num_blocks; ++j) {
+        blocks[j] = src[j] >> shift;
+        if ((it.begin >> 5) + j + 1 <= last) {
+          blocks[j] |= src[j + 1] << (64 - shift);
+        }
+      }
+      put(blocks.data(), num_blocks * sizeof(std::uint64_t));
+    }
+    pad();
+    put(&(offset = 0), sizeof(offset));
+    for (std::size_t i = 0; i < n; ++i) {
+      NucleicAcidView it = view(i);
+      offset += it.has_quality() ? it.inflated_len : 0;
+      put(&offset, sizeof(offset));
+    }
+    pad();
+    std::vector<std::int8_t> scores;  // for packed quality scores
+    for (std::size_t i = 0; i < n; ++i) {
+      NucleicAcidView it = view(i);
+      if (it.quality) {
+        put(it.quality + it.begin, it.inflated_len);
+      } else if (it.packed_quality) {
+        scores.resize(it.inflated_len);
+        for (std::uint32_t j = 0; j < it.inflated_len; ++j) {
+          scores[j] = (*it.packed_quality)[it.begin + j];
+        }
+        put(scores.data(), scores.size());
+      }
+    }
+    pad();
+    put(&(offset = 0), sizeof(offset));
+    for (std::size_t i = 0; i < n; ++i) {
+      offset += view(i).AmbiguousRuns().size();
+      put(&offset, sizeof(offset));
+    }
+    pad();
+    for (std::size_t i = 0; i < n; ++i) {  // clipped to the view
+      for (const auto& jt : view(i).AmbiguousRuns()) {
+        AmbiguousRun run;
+        std::memset(&run, 0, sizeof(run));
+        run.begin = jt.begin;
+        run.len = jt.len;
+        run.c = jt.c;
+        put(&run, sizeof(run));
+      }
+    }
+    pad();
+    put(&(offset = 0), sizeof(offset));
+    for (std::size_t i = 0; i < n; ++i) {
+      offset += view(i).LowerCaseRuns().size();
+      put(&offset, sizeof(offset));
+    }
+    pad();
+    for (std::size_t i = 0; i < n; ++i) {
+      for (const auto& jt : view(i).LowerCaseRuns()) {
+        put(&jt, sizeof(jt));
+      }
+    }
+    pad();
+
+    if (!os.good()) {
+      throw std::runtime_error(
+          "[biosoup::MappedNucleicAcidStore::Write] error: unable to write " +
+          path);
+    }
+  }
+
+ private:
+  enum Sections : std::uint32_t {
+    kIds,
+    kInflatedLens,
+    kOrientations,
+    kNameOffsets,
+    kNames,
+    kDataOffsets,
+    kDeflatedData,
+    kQualityOffsets,
+    kQuality,
+    kAmbiguousRunOffsets,
+    kAmbiguousRuns,
+    kLowerCaseRunOffsets,
+    kLowerCaseRuns,
+    kNumSections
+  };
+
+  static_assert(
+      sizeof(AmbiguousRun) == 12 && sizeof(LowerCaseRun) == 8,
+      "unexpected layout of runs");
+
+  static const char* Magic() {
+    return "BIOSOUPN";
+  }
+
+  // reads as 0x04030201 on hosts of the other byte order
+  static constexpr std::uint32_t kByteOrder = 0x01020304;
+
+  struct Header {
+    char magic[8];
+    std::uint32_t byte_order;
+    std::uint32_t version;
+    std::uint32_t num_sections;
+    std::uint32_t reserved;  // zero
+    std::uint64_t num_sequences;
+    std::uint64_t offsets[kNumSections + 1];  // last one is the end of data
+  };
+
+  template<typename T>
+  const T* Section(const Header& header, std::uint32_t i) const {
+    return reinterpret_cast<const T*>(file_.data() + header.offsets[i]);
+  }
+
+  // n + 1 non-decreasing offsets starting at 0 and ending within bound
+  static bool IsMonotone(
+      const std::uint64_t* offsets, std::uint64_t n,
+      std::uint64_t bound) {
+    if (offsets[0] != 0 || offsets[n] > bound) {
+      return false;
+    }
+    for (std::uint64_t i = 0; i < n; ++i) {
+      if (offsets[i] > offsets[i + 1]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // sorted, disjoint and within inflated_len
+  template<typename T>
+  static bool AreRunsValid(
+      const T* first, const T* last,
+      std::uint64_t inflated_len) {
+    for (std::uint64_t end = 0; first != last; ++first) {
+      if (first->len == 0 || first->begin < end ||
+          static_cast<std::uint64_t>(first->begin) + first->len >
+              inflated_len) {
+        return false;
+      }
+      end = first->begin + first->len;
+    }
+    return true;
+  }
+
+  static std::uint64_t Align(std::uint64_t offset) {
+    return (offset + 7) & ~7ULL;
+  }
+
+  detail::MappedFile file_;
+  std::uint64_t num_sequences_;
+  const std::uint32_t* ids_;
+  const std::uint32_t* inflated_lens_;
+  const std::uint8_t* is_reverse_complement_;
+  const std::uint64_t* name_offsets_;
+  const char* names_;
+  const std::uint64_t* data_offsets_;
+  const std::uint64_t* deflated_data_;
+  const std::uint64_t* quality_offsets_;
+  const std::int8_t* quality_;
+  const std::uint64_t* ambiguous_run_offsets_;
+  const AmbiguousRun* ambiguous_runs_;
+  const std::uint64_t* lower_case_run_offsets_;
+  const LowerCaseRun* lower_case_runs_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_MAPPED_NUCLEIC_ACID_STORE_HPP_
@@ -0,0 +1,558 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_MINIMIZER_INDEX_HPP_
+#define BIOSOUP_MINIMIZER_INDEX_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "biosoup/detail/mapped_file.hpp"
+#include "biosoup/detail/parallel.hpp"
+#include "biosoup/kmer.hpp"
+#include "biosoup/nucleic_acid.hpp"
+
+namespace biosoup {
+
+// occurrence of a minimizer in an indexed sequence, packed into 8 bytes
+struct MinimizerLocation {
+  std::uint32_t position() const {
+    return position_strand >> 1;
+  }
+
+  bool strand() const {
+    return position_strand & 1;
+  }
+
+  std::uint32_t id;
+  std::uint32_t position_strand;  // position << 1 | strand
+};
+
+// minimizer shared by a query and an indexed sequence
+struct MinimizerHit {
+  std::uint32_t id;  // of the indexed sequence
+  std::uint32_t position;  // in the indexed sequence
+  std::uint32_t query_position;
+  bool strand;  // true if the minimizer has the same orientation in both
+};
+
+// Read-only map from hashed (w, k)-minimizers (see Minimize) to their
+// locations in a set of nucleic acids. Minimizers are extracted in parallel,
+// scattered into 256 partitions by the top bits of their hash (one radix
+// pass) and each partition is sorted on its own. The most frequent fraction
+// of distinct minimizers is masked, i.e. kept out of the index.
+//
+// The layout is flat: sorted distinct minimizers, each paired with the offset
+// of its first location, plus a bucket table indexed by the top bits of the
+// hash which narrows each lookup to about four minimizers. The same
+// arrays are written by Write and served from a memory mapped file by the
+// path constructor, with a header and 8 byte aligned sections laid out as in
+// MappedNucleicAcidStore.
+class MinimizerIndex {
+ public:
+  static constexpr std::uint32_t kVersion = 2;
+
+  enum : std::uint32_t {
+    kNumPartitions = 256
+  };
+
+  MinimizerIndex()
+      : file_(),
+        k_(0),
+        w_(0),
+        bucket_bits_(0),
+        threshold_(0),
+        num_masked_(0),
+        num_minimizers_(0),
+        num_locations_(0),
+        buckets_(nullptr),
+        minimizers_(nullptr),
+        locations_(nullptr),
+        bucket_storage_(),
+        minimizer_storage_(),
+        location_storage_() {}
+
+  // ids and lengths of sequences have to fit into 32 and 31 bits respectively,
+  // frequency is the fraction of distinct minimizers to be masked
+  MinimizerIndex(
+      const std::vector<std::unique_ptr<NucleicAcid>>& sequences,
+      std::uint32_t k,
+      std::uint32_t w,
+      double frequency = 0.0002,
+      std::uint32_t num_threads = std::thread::hardware_concurrency())
+      : MinimizerIndex() {
+    if (k == 0 || k > 32) {
+      throw std::invalid_argument(
+          "[biosoup::MinimizerIndex::MinimizerIndex] error: "
+          "k is not in [1, 32]");
+    }
+    if (w == 0) {
+      throw std::invalid_argument(
+          "[biosoup::MinimizerIndex::MinimizerIndex] error: empty window");
+    }
+    if (frequency < 0 || frequency >= 1) {
+      throw std::invalid_argument(
+          "[biosoup::MinimizerIndex::MinimizerIndex] error: "
+          "frequency is not in [0, 1)");
+    }
+    k_ = k;
+    w_ = w;
+    Build(sequences, frequency, std::max(num_threads, 1U));
+  }
+
+  explicit MinimizerIndex(const std::string& path)
+      : MinimizerIndex() {
+    file_ = detail::MappedFile(path);
+
+    Header header{};
+    if (file_.size() < sizeof(header)) {
+      throw std::invalid_argument(
+          "[biosoup::MinimizerIndex::MinimizerIndex] error: "
+          "truncated file " + path);
+    }
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if (std::memcmp(header.magic, Magic(), sizeof(header.magic)) != 0) {
+      throw std::invalid_argument(
+          "[biosoup::MinimizerIndex::MinimizerIndex] error: "
+          "not a biosoup minimizer index file " + path);
+    }
+    if (header.byte_order != kByteOrder ||
+        header.version != kVersion ||
+        header.num_sections != kNumSections) {
+      throw std::invalid_argument(
+          "[biosoup::MinimizerIndex::MinimizerIndex] error: "
+          "unsupported version of " + path);
+    }
+    for (std::uint32_t i = 0; i < kNumSections; ++i) {
+      if (header.offsets[i] > header.offsets[i + 1] ||
+          header.offsets[i] % 8 != 0) {
+        throw std::invalid_argument(
+            "[biosoup::MinimizerIndex::MinimizerIndex] error: "
+            "corrupted section table in " + path);
+      }
+    }
+    if (header.offsets[0] < sizeof(header) ||
+        header.offsets[kNumSections] > file_.size()) {
+      throw std::invalid_argument(
+          "[biosoup::MinimizerIndex::MinimizerIndex] error: "
+          "truncated file " + path);
+    }
+    auto section_len = [&] (std::uint32_t i) -> std::uint64_t {
+      return header.offsets[i + 1] - header.offsets[i];
+    };
+    if (header.k > 32 || (header.k != 0 && (header.w == 0 ||
+        header.bucket_bits > 2 * header.k ||
+        header.bucket_bits >= 64 ||
+        (1ULL << header.bucket_bits) > file_.size() ||
+        header.num_minimizers > file_.size() ||
+        header.num_locations > file_.size() ||
+        section_len(kBuckets) <
+            ((1ULL << header.bucket_bits) + 1) * sizeof(std::uint64_t) ||
+        section_len(kMinimizers) <
+            (header.num_minimizers + 1) * sizeof(Minimizer) ||
+        section_len(kLocations) <
+            header.num_locations * sizeof(MinimizerLocation))) ||
+        (header.k == 0 && header.num_minimizers != 0)) {
+      throw std::invalid_argument(
+          "[biosoup::MinimizerIndex::MinimizerIndex] error: "
+          "corrupted section table in " + path);
+    }
+
+    k_ = header.k;
+    w_ = header.w;
+    bucket_bits_ = header.bucket_bits;
+    threshold_ = header.threshold;
+    num_masked_ = header.num_masked;
+    num_minimizers_ = header.num_minimizers;
+    num_locations_ = header.num_locations;
+    buckets_ = Section<std::uint64_t>(header, kBuckets);
+    minimizers_ = Section<Minimizer>(header, kMinimizers);
+    locations_ = Section<MinimizerLocation>(header, kLocations);
+
+    // offsets are checked once here so that Find stays in the mapping
+    if (k_ != 0 && !AreOffsetsValid()) {
+      throw std::invalid_argument(
+          "[biosoup::MinimizerIndex::MinimizerIndex] error: "
+          "corrupted offsets in " + path);
+    }
+  }
+
+  MinimizerIndex(const MinimizerIndex&) = delete;
+  MinimizerIndex& operator=(const MinimizerIndex&) = delete;
+
+  MinimizerIndex(MinimizerIndex&&) = default;
+  MinimizerIndex& operator=(MinimizerIndex&&) = default;
+
+  ~MinimizerIndex() = default;
+
+  std::uint32_t k() const {
+    return k_;
+  }
+
+  std::uint32_t w() const {
+    return w_;
+  }
+
+  std::uint64_t num_minimizers() const {  // distinct, without masked ones
+    return num_minimizers_;
+  }
+
+  std::uint64_t num_locations() const {
+    return num_locations_;
+  }
+
+  std::uint64_t num_masked() const {  // distinct
+    return num_masked_;
+  }
+
+  std::uint64_t threshold() const {  // largest number of kept occurrences
+    return threshold_;
+  }
+
+  std::uint64_t memory_usage() const {  // of the flat arrays
+    return ((1ULL << bucket_bits_) + 1) * sizeof(std::uint64_t) +
+        (num_minimizers_ + 1) * sizeof(Minimizer) +
+        num_locations_ * sizeof(MinimizerLocation);
+  }
+
+  // locations of a hashed minimizer, empty if it is absent or masked
+  std::pair<const MinimizerLocation*, const MinimizerLocation*> Find(
+      std::uint64_t value) const {
+    if (num_minimizers_ == 0 || value > KmerMask(k_)) {
+      return std::make_pair(nullptr, nullptr);
+    }
+    std::uint64_t b = Bucket(value);
+    const Minimizer* last = minimizers_ + buckets_[b + 1];
+    for (const Minimizer* it = minimizers_ + buckets_[b]; it != last; ++it) {
+      if (it->value >= value) {
+        if (it->value != value) {
+          break;
+        }
+        return std::make_pair(
+            locations_ + it->offset,
+            locations_ + (it + 1)->offset);
+      }
+    }
+    return std::make_pair(nullptr, nullptr);
+  }
+
+  // appends hits of all minimizers of a NucleicAcid or NucleicAcidView in
+  // increasing order of query position, returns their number
+  template<typename T>
+  std::size_t Query(const T& nucleic_acid, std::vector<MinimizerHit>* dst) const {  // NOLINT
+    if (num_minimizers_ == 0) {
+      return 0;
+    }
+    std::size_t first = dst->size();
+    std::vector<Kmer> minimizers;
+    Minimize(nucleic_acid, k_, w_, &minimizers);
+    for (const auto& it : minimizers) {
+      auto locations = Find(it.value);
+      for (auto jt = locations.first; jt != locations.second; ++jt) {
+        dst->push_back(MinimizerHit{
+            jt->id,
+            jt->position(),
+            it.position,
+            it.strand == jt->strand()});
+      }
+    }
+    return dst->size() - first;
+  }
+
+  void Write(const std::string& path) const {
+    std::ofstream os(path, std::ios::binary);
+    if (!os.is_open()) {
+      throw std::runtime_error(
+          "[biosoup::MinimizerIndex::Write] error: unable to open " + path);
+    }
+
+    std::uint64_t num_buckets = k_ ? (1ULL << bucket_bits_) + 1 : 0;
+    std::uint64_t num_entries = k_ ? num_minimizers_ + 1 : 0;
+    const std::uint64_t section_sizes[kNumSections] = {
+        num_buckets * sizeof(std::uint64_t),
+        num_entries * sizeof(Minimizer),
+        num_locations_ * sizeof(MinimizerLocation)};
+    const void* sections[kNumSections] = {buckets_, minimizers_, locations_};
+
+    Header header{};
+    std::memcpy(header.magic, Magic(), sizeof(header.magic));
+    header.byte_order = kByteOrder;
+    header.version = kVersion;
+    header.num_sections = kNumSections;
+    header.k = k_;
+    header.w = w_;
+    header.bucket_bits = bucket_bits_;
+    header.threshold = threshold_;
+    header.num_masked = num_masked_;
+    header.num_minimizers = num_minimizers_;
+    header.num_locations = num_locations_;
+    header.offsets[0] = Align(sizeof(header));
+    for (std::uint32_t i = 0; i < kNumSections; ++i) {
+      header.offsets[i + 1] = Align(header.offsets[i] + section_sizes[i]);
+    }
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    static const char zeros[8] = {0};
+    os.write(zeros, header.offsets[0] - sizeof(header));
+    for (std::uint32_t i = 0; i < kNumSections; ++i) {
+      os.write(static_cast<const char*>(sections[i]), section_sizes[i]);
+      os.write(zeros, header.offsets[i + 1] - header.offsets[i] - section_sizes[i]);  // NOLINT
+    }
+
+    if (!os.good()) {
+      throw std::runtime_error(
+          "[biosoup::MinimizerIndex::Write] error: unable to write " + path);
+    }
+  }
+
+ private:
+  enum Sections : std::uint32_t {
+    kBuckets,
+    kMinimizers,
+    kLocations,
+    kNumSections
+  };
+
+  static const char* Magic() {
+    return "BIOSOUPM";
+  }
+
+  struct Minimizer {
+    std::uint64_t value;
+    std::uint64_t offset;  // of the first location
+  };
+
+  // reads as 0x04030201 on hosts of the other byte order
+  static constexpr std::uint32_t kByteOrder = 0x01020304;
+
+  struct Header {
+    char magic[8];
+    std::uint32_t byte_order;
+    std::uint32_t version;
+    std::uint32_t num_sections;
+    std::uint32_t reserved;  // zero
+    std::uint32_t k;
+    std::uint32_t w;
+    std::uint64_t bucket_bits;
+    std::uint64_t threshold;
+    std::uint64_t num_masked;
+    std::uint64_t num_minimizers;
+    std::uint64_t num_locations;
+    std::uint64_t offsets[kNumSections + 1];  // last one is the end of data
+  };
+
+  struct Entry {
+    std::uint64_t value;
+    MinimizerLocation location;
+  };
+
+  template<typename T>
+  const T* Section(const Header& header, std::uint32_t i) const {
+    return reinterpret_cast<const T*>(file_.data() + header.offsets[i]);
+  }
+
+  static std::uint64_t Align(std::uint64_t offset) {
+    return (offset + 7) & ~7ULL;
+  }
+
+  // bucket and minimizer offsets are non-decreasing and within the arrays
+  bool AreOffsetsValid() const {
+    std::uint64_t num_buckets = 1ULL << bucket_bits_;
+    if (buckets_[num_buckets] > num_minimizers_ ||
+        minimizers_[num_minimizers_].offset > num_locations_) {
+      return false;
+    }
+    for (std::uint64_t i = 0; i < num_buckets; ++i) {
+      if (buckets_[i] > buckets_[i + 1]) {
+        return false;
+      }
+    }
+    for (std::uint64_t i = 0; i < num_minimizers_; ++i) {
+      if (minimizers_[i].offset > minimizers_[i + 1].offset) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::uint64_t Bucket(std::uint64_t value) const {
+    return bucket_bits_ ? value >> (2 * k_ - bucket_bits_) : 0;
+  }
+
+  void Build(
+      const std::vector<std::unique_ptr<NucleicAcid>>& sequences,
+      double frequency,
+      std::uint32_t num_threads) {
+    std::uint32_t shift = k_ > 4 ? 2 * k_ - 8 : 0;  // into partitions
+
+    // minimizers of groups of sequences, counted per partition
+    std::size_t num_groups = std::min<std::size_t>(
+        sequences.size(), num_threads * 16ULL);
+    std::vector<std::vector<Entry>> groups(num_groups);
+    std::vector<std::uint64_t> counts(num_groups * kNumPartitions, 0);
+    detail::ParallelFor(num_groups, num_threads, [&] (std::size_t i) -> void {
+      std::vector<Kmer> minimizers;
+      for (std::size_t j = sequences.size() * i / num_groups;
+           j < sequences.size() * (i + 1) / num_groups;
+           ++j) {
+        const NucleicAcid& it = *sequences[j];
+        if (it.id > UINT32_MAX || it.inflated_len > INT32_MAX) {
+          throw std::invalid_argument(
+              "[biosoup::MinimizerIndex::MinimizerIndex] error: "
+              "id or length of " + it.name + " is too large");
+        }
+        minimizers.clear();
+        Minimize(it, k_, w_, &minimizers);
+        for (const auto& jt : minimizers) {
+          groups[i].push_back(Entry{
+              jt.value,
+              MinimizerLocation{
+                  static_cast<std::uint32_t>(it.id),
+                  jt.position << 1 | jt.strand}});
+          ++counts[i * kNumPartitions + (jt.value >> shift)];
+        }
+      }
+    });
+
+    // radix pass, partition major
+    std::vector<std::uint64_t> partitions(kNumPartitions + 1, 0);
+    for (std::uint32_t i = 0; i < kNumPartitions; ++i) {
+      partitions[i + 1] = partitions[i];
+      for (std::size_t j = 0; j < num_groups; ++j) {
+        std::uint64_t count = counts[j * kNumPartitions + i];
+        counts[j * kNumPartitions + i] = partitions[i + 1];
+        partitions[i + 1] += count;
+      }
+    }
+    std::vector<Entry> entries(partitions.back());
+    detail::ParallelFor(num_groups, num_threads, [&] (std::size_t i) -> void {
+      for (const auto& it : groups[i]) {
+        entries[counts[i * kNumPartitions + (it.value >> shift)]++] = it;
+      }
+      std::vector<Entry>().swap(groups[i]);
+    });
+
+    // occurrences of distinct minimizers per partition
+    std::vector<std::vector<std::uint64_t>> occurrences(kNumPartitions);
+    detail::ParallelFor(kNumPartitions, num_threads, [&] (std::size_t i) -> void {  // NOLINT
+      auto first = entries.begin() + partitions[i];
+      auto last = entries.begin() + partitions[i + 1];
+      std::sort(first, last, [] (const Entry& lhs, const Entry& rhs) -> bool {
+        return lhs.value < rhs.value ||
+            (lhs.value == rhs.value &&
+                (lhs.location.id < rhs.location.id ||
+                    (lhs.location.id == rhs.location.id &&
+                        lhs.location.position_strand <
+                            rhs.location.position_strand)));
+      });
+      for (auto it = first; it != last;) {
+        auto jt = it;
+        while (jt != last && jt->value == it->value) {
+          ++jt;
+        }
+        occurrences[i].emplace_back(jt - it);
+        it = jt;
+      }
+    });
+
+    // frequency masking
+    std::vector<std::uint64_t> sorted;
+    for (const auto& it : occurrences) {
+      sorted.insert(sorted.end(), it.begin(), it.end());
+    }
+    std::size_t num_masked = sorted.size() * frequency;
+    threshold_ = 0;
+    if (num_masked < sorted.size()) {
+      std::nth_element(
+          sorted.begin(),
+          sorted.begin() + num_masked,
+          sorted.end(),
+          std::greater<std::uint64_t>());
+      threshold_ = sorted[num_masked];
+    }
+    std::vector<std::uint64_t>().swap(sorted);
+
+    std::vector<std::uint64_t> minimizer_offsets(kNumPartitions + 1, 0);
+    std::vector<std::uint64_t> location_offsets(kNumPartitions + 1, 0);
+    for (std::uint32_t i = 0; i < kNumPartitions; ++i) {
+      minimizer_offsets[i + 1] = minimizer_offsets[i];
+      location_offsets[i + 1] = location_offsets[i];
+      for (const auto& it : occurrences[i]) {
+        if (it <= threshold_) {
+          ++minimizer_offsets[i + 1];
+          location_offsets[i + 1] += it;
+        } else {
+          ++num_masked_;
+        }
+      }
+    }
+    num_minimizers_ = minimizer_offsets.back();
+    num_locations_ = location_offsets.back();
+
+    // flat layout
+    minimizer_storage_.resize(num_minimizers_ + 1);  // with a sentinel
+    location_storage_.resize(num_locations_);
+    detail::ParallelFor(kNumPartitions, num_threads, [&] (std::size_t i) -> void {  // NOLINT
+      std::uint64_t m = minimizer_offsets[i];
+      std::uint64_t l = location_offsets[i];
+      const Entry* it = entries.data() + partitions[i];
+      for (const auto& jt : occurrences[i]) {
+        if (jt <= threshold_) {
+          minimizer_storage_[m++] = Minimizer{it->value, l};
+          for (std::uint64_t j = 0; j < jt; ++j) {
+            location_storage_[l++] = it[j].location;
+          }
+        }
+        it += jt;
+      }
+    });
+    minimizer_storage_.back() = Minimizer{0, num_locations_};
+    std::vector<Entry>().swap(entries);
+
+    // about four minimizers per bucket
+    while (bucket_bits_ < 2 * k_ &&
+           (1ULL << bucket_bits_) * 4 < num_minimizers_) {
+      ++bucket_bits_;
+    }
+    std::uint64_t num_buckets = 1ULL << bucket_bits_;
+    bucket_storage_.resize(num_buckets + 1);
+    for (std::uint64_t i = 0, j = 0; i < num_buckets; ++i) {
+      bucket_storage_[i] = j;
+      while (j < num_minimizers_ && Bucket(minimizer_storage_[j].value) == i) {
+        ++j;
+      }
+    }
+    bucket_storage_.back() = num_minimizers_;
+
+    buckets_ = bucket_storage_.data();
+    minimizers_ = minimizer_storage_.data();
+    locations_ = location_storage_.data();
+  }
+
+  detail::MappedFile file_;
+  std::uint32_t k_;
+  std::uint32_t w_;
+  std::uint64_t bucket_bits_;
+  std::uint64_t threshold_;
+  std::uint64_t num_masked_;
+  std::uint64_t num_minimizers_;
+  std::uint64_t num_locations_;
+  const std::uint64_t* buckets_;
+  const Minimizer* minimizers_;
+  const MinimizerLocation* locations_;
+  std::vector<std::uint64_t> bucket_storage_;
+  std::vector<Minimizer> minimizer_storage_;
+  std::vector<MinimizerLocation> location_storage_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_MINIMIZER_INDEX_HPP_
@@ -6,11 +6,21 @@
 #include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <numeric>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "biosoup/detail/complement.hpp"
+#include "biosoup/detail/parallel.hpp"
+#include "biosoup/detail/simd.hpp"
+#include "biosoup/object_id.hpp"
+#include "biosoup/packed_quality.hpp"
+
 namespace biosoup {
 
 /* clang-format off */
@@ -30,12 +40,435 @@ constexpr static std::uint8_t kNucleotideCoder[] = {
     255,   0,   1,   1,   0, 255, 255,   2,
       3, 255, 255,   2, 255,   1,   0, 255,
     255, 255,   0,   1,   3,   3,   2,   0,
-    255,   3, 255, 255, 255, 255, 255, 255
+    255,   3, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255
 };
 /* clang-format on */
 
 constexpr static char kNucleotideDecoder[] = {'A', 'C', 'G', 'T'};
 
+namespace detail {
+
+// Packs data_len characters into 2-bit blocks of 32 bases (dst has to hold
+// (data_len + 31) / 32 blocks), returns false if any character is not a
+// nucleotide. Inflate* unpacks raw positions [begin, begin + len) into dst,
+// in reverse and complemented if is_reverse_complement is set.
+
+inline bool DeflateScalar(const char *data, std::uint32_t data_len,
+                          std::uint64_t *dst) {
+  std::uint64_t invalid = 0;
+  for (std::uint32_t i = 0; i < data_len; i += 32) {
+    std::uint32_t n = std::min(data_len - i, 32U);
+    std::uint64_t block = 0;
+    for (std::uint32_t j = 0; j < n; ++j) {
+      std::uint64_t c = kNucleotideCoder[static_cast<std::uint8_t>(data[i + j])];
+      invalid |= c;
+      block |= (c & 3) << (j << 1);
+    }
+    dst[i >> 5] = block;
+  }
+  return (invalid & 4) == 0; // only 255 has the third bit set
+}
+
+struct InflateTable { // 4 bases per byte of a block
+  explicit InflateTable(bool is_reverse_complement) {
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      for (std::uint32_t j = 0; j < 4; ++j) {
+        data[i][is_reverse_complement ? 3 - j : j] =
+            kNucleotideDecoder[((i >> (j << 1)) & 3) ^
+                               (is_reverse_complement ? 3 : 0)];
+      }
+    }
+  }
+
+  char data[256][4];
+};
+
+inline const InflateTable &ForwardInflateTable() {
+  static const InflateTable table(false);
+  return table;
+}
+
+inline const InflateTable &ReverseComplementInflateTable() {
+  static const InflateTable table(true);
+  return table;
+}
+
+inline char InflateBase(const std::uint64_t *src, std::uint32_t i,
+                        std::uint64_t x) {
+  return kNucleotideDecoder[((src[i >> 5] >> ((i << 1) & 63)) & 3) ^ x];
+}
+
+// shared by all kernels, Block(src, dst) unpacks 32 bases at once
+template <typename Block, typename ReverseComplementBlock>
+inline void InflateWith(const std::uint64_t *src, std::uint32_t begin,
+                        std::uint32_t len, bool is_reverse_complement,
+                        char *dst, Block block,
+                        ReverseComplementBlock reverse_complement_block) {
+  std::uint32_t end = begin + len;
+  if (!is_reverse_complement) {
+    for (; begin < end && (begin & 31); ++begin) {
+      *dst++ = InflateBase(src, begin, 0);
+    }
+    for (; end - begin >= 32; begin += 32, dst += 32) {
+      block(src[begin >> 5], dst);
+    }
+    for (; begin < end; ++begin) {
+      *dst++ = InflateBase(src, begin, 0);
+    }
+  } else {
+    for (; end > begin && (end & 31); --end) {
+      *dst++ = InflateBase(src, end - 1, 3);
+    }
+    for (; end - begin >= 32; end -= 32, dst += 32) {
+      reverse_complement_block(src[(end >> 5) - 1], dst);
+    }
+    for (; end > begin; --end) {
+      *dst++ = InflateBase(src, end - 1, 3);
+    }
+  }
+}
+
+struct ScalarBlock {
+  void operator()(std::uint64_t block, char *dst) const {
+    const InflateTable &table = ForwardInflateTable();
+    for (std::uint32_t i = 0; i < 8; ++i, block >>= 8) {
+      std::memcpy(dst + (i << 2), table.data[block & 255], 4);
+    }
+  }
+};
+
+struct ScalarReverseComplementBlock {
+  void operator()(std::uint64_t block, char *dst) const {
+    const InflateTable &table = ReverseComplementInflateTable();
+    for (std::uint32_t i = 0; i < 8; ++i, block >>= 8) {
+      std::memcpy(dst + ((7 - i) << 2), table.data[block & 255], 4);
+    }
+  }
+};
+
+inline void InflateScalar(const std::uint64_t *src, std::uint32_t begin,
+                          std::uint32_t len, bool is_reverse_complement,
+                          char *dst) {
+  InflateWith(src, begin, len, is_reverse_complement, dst, ScalarBlock(),
+              ScalarReverseComplementBlock());
+}
+
+#if defined(BIOSOUP_X86_DISPATCH)
+
+// Nucleotides are classified by their high and low nibbles: the high nibble
+// selects one of three classes ('-', A-O/a-o, P-Z/p-z), the low nibble picks
+// the code and whether the character is valid in that class.
+
+/* clang-format off */
+#define BIOSOUP_NUCLEOTIDE_TABLES(set)                                        \
+  const auto valid_table = set(                                              \
+      0, 2, 6, 6, 6, 4, 4, 6, 2, 4, 0, 2, 0, 3, 2, 0);                       \
+  const auto class_table = set(                                              \
+      0, 0, 1, 0, 2, 4, 2, 4, 0, 0, 0, 0, 0, 0, 0, 0);                       \
+  const auto even_table = set(                                               \
+      0, 0, 1, 1, 0, 0, 0, 2, 3, 0, 0, 2, 0, 1, 0, 0);                       \
+  const auto odd_table = set(                                                \
+      0, 0, 0, 1, 3, 3, 2, 0, 0, 3, 0, 0, 0, 0, 0, 0);
+/* clang-format on */
+
+#define BIOSOUP_SET_SSE(...) _mm_setr_epi8(__VA_ARGS__)
+#define BIOSOUP_SET_AVX(...) \
+  _mm256_broadcastsi128_si256(_mm_setr_epi8(__VA_ARGS__))
+
+BIOSOUP_TARGET_SSE42 inline std::uint32_t
+DeflateSse42Chunk(const char *data, __m128i *invalid) {
+  BIOSOUP_NUCLEOTIDE_TABLES(BIOSOUP_SET_SSE)
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  const __m128i one = _mm_set1_epi8(1);
+
+  __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+  __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), nibble);
+  __m128i lo = _mm_and_si128(x, nibble);
+  __m128i cls = _mm_shuffle_epi8(class_table, hi);
+  *invalid = _mm_or_si128(
+      *invalid,
+      _mm_cmpeq_epi8(_mm_and_si128(_mm_shuffle_epi8(valid_table, lo), cls),
+                     _mm_setzero_si128()));
+  __m128i code =
+      _mm_blendv_epi8(_mm_shuffle_epi8(even_table, lo),
+                      _mm_shuffle_epi8(odd_table, lo),
+                      _mm_cmpeq_epi8(_mm_and_si128(hi, one), one));
+  code = _mm_andnot_si128(_mm_cmpeq_epi8(cls, one), code); // '-'
+
+  code = _mm_maddubs_epi16(code, _mm_set1_epi16(0x0401));
+  code = _mm_madd_epi16(code, _mm_set1_epi32(0x00100001));
+  code = _mm_shuffle_epi8(
+      code, _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                          -1, -1));
+  return static_cast<std::uint32_t>(_mm_cvtsi128_si32(code));
+}
+
+BIOSOUP_TARGET_SSE42 inline bool DeflateSse42(const char *data,
+                                              std::uint32_t data_len,
+                                              std::uint64_t *dst) {
+  __m128i invalid = _mm_setzero_si128();
+  std::uint32_t i = 0;
+  for (; data_len - i >= 32; i += 32) {
+    std::uint64_t lo = DeflateSse42Chunk(data + i, &invalid);
+    std::uint64_t hi = DeflateSse42Chunk(data + i + 16, &invalid);
+    dst[i >> 5] = lo | (hi << 32);
+  }
+  return _mm_testz_si128(invalid, invalid) &&
+         DeflateScalar(data + i, data_len - i, dst + (i >> 5));
+}
+
+BIOSOUP_TARGET_AVX2 inline bool DeflateAvx2(const char *data,
+                                            std::uint32_t data_len,
+                                            std::uint64_t *dst) {
+  BIOSOUP_NUCLEOTIDE_TABLES(BIOSOUP_SET_AVX)
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  const __m256i one = _mm256_set1_epi8(1);
+  const __m256i pairs = _mm256_set1_epi16(0x0401);
+  const __m256i quads = _mm256_set1_epi32(0x00100001);
+  const __m256i gather = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+      0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+  const __m256i lanes = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+
+  __m256i invalid = _mm256_setzero_si256();
+  std::uint32_t i = 0;
+  for (; data_len - i >= 32; i += 32) {
+    __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+    __m256i lo = _mm256_and_si256(x, nibble);
+    __m256i cls = _mm256_shuffle_epi8(class_table, hi);
+    invalid = _mm256_or_si256(
+        invalid, _mm256_cmpeq_epi8(
+                     _mm256_and_si256(_mm256_shuffle_epi8(valid_table, lo), cls),
+                     _mm256_setzero_si256()));
+    __m256i code = _mm256_blendv_epi8(
+        _mm256_shuffle_epi8(even_table, lo), _mm256_shuffle_epi8(odd_table, lo),
+        _mm256_cmpeq_epi8(_mm256_and_si256(hi, one), one));
+    code = _mm256_andnot_si256(_mm256_cmpeq_epi8(cls, one), code); // '-'
+
+    code = _mm256_madd_epi16(_mm256_maddubs_epi16(code, pairs), quads);
+    code = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(code, gather), lanes);
+    dst[i >> 5] = static_cast<std::uint64_t>(
+        _mm_cvtsi128_si64(_mm256_castsi256_si128(code)));
+  }
+  return _mm256_testz_si256(invalid, invalid) &&
+         DeflateScalar(data + i, data_len - i, dst + (i >> 5));
+}
+
+#undef BIOSOUP_SET_AVX
+#undef BIOSOUP_SET_SSE
+#undef BIOSOUP_NUCLEOTIDE_TABLES
+
+// Each output byte gets a copy of the block byte holding its base, the base
+// is then masked, shifted to the lowest two bits and looked up.
+
+struct Sse42Block {
+  BIOSOUP_TARGET_SSE42 void operator()(std::uint64_t block, char *dst) const {
+    const __m128i mask = _mm_set1_epi32(static_cast<int>(0xC0300C03));
+    const __m128i lut = _mm_setr_epi8('A', 'C', 'G', 'T', 0, 0, 0, 0, 0, 0, 0,
+                                      0, 0, 0, 0, 0);
+    __m128i x = _mm_set1_epi64x(static_cast<long long>(block)); // NOLINT
+    __m128i lo = _mm_shuffle_epi8(
+        x, _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3));
+    __m128i hi = _mm_shuffle_epi8(
+        x, _mm_setr_epi8(4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), Decode(lo, mask, lut));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16),
+                     Decode(hi, mask, lut));
+  }
+
+  BIOSOUP_TARGET_SSE42 static __m128i Decode(__m128i x, __m128i mask,
+                                             __m128i lut) {
+    x = _mm_and_si128(x, mask);
+    x = _mm_or_si128(x, _mm_srli_epi16(x, 2));
+    x = _mm_or_si128(x, _mm_srli_epi16(x, 4));
+    return _mm_shuffle_epi8(lut, _mm_and_si128(x, _mm_set1_epi8(3)));
+  }
+};
+
+struct Sse42ReverseComplementBlock {
+  BIOSOUP_TARGET_SSE42 void operator()(std::uint64_t block, char *dst) const {
+    const __m128i mask = _mm_set1_epi32(0x030C30C0);
+    const __m128i lut = _mm_setr_epi8('T', 'G', 'C', 'A', 0, 0, 0, 0, 0, 0, 0,
+                                      0, 0, 0, 0, 0);
+    __m128i x = _mm_set1_epi64x(static_cast<long long>(block)); // NOLINT
+    __m128i hi = _mm_shuffle_epi8(
+        x, _mm_setr_epi8(7, 7, 7, 7, 6, 6, 6, 6, 5, 5, 5, 5, 4, 4, 4, 4));
+    __m128i lo = _mm_shuffle_epi8(
+        x, _mm_setr_epi8(3, 3, 3, 3, 2, 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),
+                     Sse42Block::Decode(hi, mask, lut));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16),
+                     Sse42Block::Decode(lo, mask, lut));
+  }
+};
+
+BIOSOUP_TARGET_SSE42 inline void InflateSse42(const std::uint64_t *src,
+                                              std::uint32_t begin,
+                                              std::uint32_t len,
+                                              bool is_reverse_complement,
+                                              char *dst) {
+  InflateWith(src, begin, len, is_reverse_complement, dst, Sse42Block(),
+              Sse42ReverseComplementBlock());
+}
+
+struct Avx2Block {
+  BIOSOUP_TARGET_AVX2 void operator()(std::uint64_t block, char *dst) const {
+    const __m256i spread = _mm256_setr_epi8(
+        0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+        4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7);
+    const __m256i lut = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        'A', 'C', 'G', 'T', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+    Decode(block, spread, _mm256_set1_epi32(static_cast<int>(0xC0300C03)),
+           lut, dst);
+  }
+
+  BIOSOUP_TARGET_AVX2 static void Decode(std::uint64_t block, __m256i spread,
+                                         __m256i mask, __m256i lut,
+                                         char *dst) {
+    __m256i x = _mm256_set1_epi64x(static_cast<long long>(block)); // NOLINT
+    x = _mm256_and_si256(_mm256_shuffle_epi8(x, spread), mask);
+    x = _mm256_or_si256(x, _mm256_srli_epi16(x, 2));
+    x = _mm256_or_si256(x, _mm256_srli_epi16(x, 4));
+    x = _mm256_shuffle_epi8(lut, _mm256_and_si256(x, _mm256_set1_epi8(3)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), x);
+  }
+};
+
+struct Avx2ReverseComplementBlock {
+  BIOSOUP_TARGET_AVX2 void operator()(std::uint64_t block, char *dst) const {
+    const __m256i spread = _mm256_setr_epi8(
+        7, 7, 7, 7, 6, 6, 6, 6, 5, 5, 5, 5, 4, 4, 4, 4,
+        3, 3, 3, 3, 2, 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0);
+    const __m256i lut = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        'T', 'G', 'C', 'A', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+    Avx2Block::Decode(block, spread, _mm256_set1_epi32(0x030C30C0), lut, dst);
+  }
+};
+
+BIOSOUP_TARGET_AVX2 inline void InflateAvx2(const std::uint64_t *src,
+                                            std::uint32_t begin,
+                                            std::uint32_t len,
+                                            bool is_reverse_complement,
+                                            char *dst) {
+  InflateWith(src, begin, len, is_reverse_complement, dst, Avx2Block(),
+              Avx2ReverseComplementBlock());
+}
+
+#endif // BIOSOUP_X86_DISPATCH
+
+inline bool Deflate(const char *data, std::uint32_t data_len,
+                    std::uint64_t *dst) {
+#if defined(BIOSOUP_X86_DISPATCH)
+  switch (simd_level()) {
+  case SimdLevel::kAvx2:
+    return DeflateAvx2(data, data_len, dst);
+  case SimdLevel::kSse42:
+    return DeflateSse42(data, data_len, dst);
+  default:
+    break;
+  }
+#endif
+  return DeflateScalar(data, data_len, dst);
+}
+
+inline void Inflate(const std::uint64_t *src, std::uint32_t begin,
+                    std::uint32_t len, bool is_reverse_complement, char *dst) {
+#if defined(BIOSOUP_X86_DISPATCH)
+  switch (simd_level()) {
+  case SimdLevel::kAvx2:
+    return InflateAvx2(src, begin, len, is_reverse_complement, dst);
+  case SimdLevel::kSse42:
+    return InflateSse42(src, begin, len, is_reverse_complement, dst);
+  default:
+    break;
+  }
+#endif
+  InflateScalar(src, begin, len, is_reverse_complement, dst);
+}
+
+} // namespace detail
+
+struct AmbiguousRun { // equal characters other than A, C, G, T (and U)
+  std::uint32_t begin;
+  std::uint32_t len;
+  char c;  // upper case, lower_case_runs keep the case
+};
+
+struct LowerCaseRun {  // soft-masked bases and ambiguous characters
+  std::uint32_t begin;
+  std::uint32_t len;
+};
+
+namespace detail {
+
+// Overwrite inflated forward positions [begin, begin + len) in dst with the
+// runs in [first, last) (sorted, on the forward strand), which NucleicAcid and
+// NucleicAcidView use to restore what deflation dropped.
+
+inline void RestoreAmbiguous(const AmbiguousRun *first,
+                             const AmbiguousRun *last, std::uint32_t begin,
+                             std::uint32_t len, bool is_reverse_complement,
+                             char *dst) {
+  std::uint32_t end = begin + len;
+  auto it = std::partition_point(first, last, [&](const AmbiguousRun &run) {
+    return run.begin + run.len <= begin;
+  });
+  for (; it != last && it->begin < end; ++it) {
+    std::uint32_t lo = std::max(it->begin, begin);
+    std::uint32_t hi = std::min(it->begin + it->len, end);
+    if (is_reverse_complement) {
+      std::fill(dst + (end - hi), dst + (end - lo), Complement()[it->c]);
+    } else {
+      std::fill(dst + (lo - begin), dst + (hi - begin), it->c);
+    }
+  }
+}
+
+// same as RestoreAmbiguous, complemented bases are lower cased as well
+inline void RestoreLowerCase(const LowerCaseRun *first,
+                             const LowerCaseRun *last, std::uint32_t begin,
+                             std::uint32_t len, bool is_reverse_complement,
+                             char *dst) {
+  std::uint32_t end = begin + len;
+  auto it = std::partition_point(first, last, [&](const LowerCaseRun &run) {
+    return run.begin + run.len <= begin;
+  });
+  for (; it != last && it->begin < end; ++it) {
+    std::uint32_t lo = std::max(it->begin, begin);
+    std::uint32_t hi = std::min(it->begin + it->len, end);
+    char *jt = dst + (is_reverse_complement ? end - hi : lo - begin);
+    for (char *kt = jt + (hi - lo); jt != kt; ++jt) {
+      *jt = static_cast<char>(*jt | 0x20); // only letters are recorded
+    }
+  }
+}
+
+} // namespace detail
+
+// optional layers of a NucleicAcid, allocated only once one of them is used
+struct NucleicAcidExtras {
+  PackedQuality packed_quality; // used if quality is empty
+  std::vector<AmbiguousRun> ambiguous_runs; // sorted, forward strand
+  std::vector<LowerCaseRun> lower_case_runs; // sorted, forward strand
+};
+
 class NucleicAcid {
 public:
   NucleicAcid() = default;
@@ -43,24 +476,23 @@ public:
   NucleicAcid(const std::string &name, const std::string &data)
       : NucleicAcid(name.c_str(), name.size(), data.c_str(), data.size()) {}
 
+  // keep_ambiguous stores characters which do not map to a single base in
+  // ambiguous_runs and lower case stretches in lower_case_runs, so that
+  // InflateData reproduces them (U is read as T, as without keep_ambiguous)
   NucleicAcid(const char *name_ptr, std::uint32_t name_len,
-              const char *data_ptr, std::uint32_t data_len)
-      : id(num_objects++), name(name_ptr, name_len), deflated_data(), quality(),
-        inflated_len(data_len), is_reverse_complement(0) {
-    deflated_data.reserve(data_len / 32. + .999);
-    std::uint64_t block = 0;
-    for (std::uint32_t i = 0; i < data_len; ++i) {
-      std::uint64_t c =
-          kNucleotideCoder[static_cast<std::uint8_t>(data_ptr[i])];
-      if (c == 255ULL) {
-        throw std::invalid_argument(
-            "[biosoup::NucleicAcid::NucleicAcid] error: not a nucleotide");
-      }
-      block |= c << ((i << 1) & 63);
-      if (((i + 1) & 31) == 0 || i == data_len - 1) {
-        deflated_data.emplace_back(block);
-        block = 0;
-      }
+              const char *data_ptr, std::uint32_t data_len,
+              bool keep_ambiguous = false)
+      : id(NextId<NucleicAcid>()), name(name_ptr, name_len),
+        deflated_data((static_cast<std::uint64_t>(data_len) + 31) >> 5),
+        quality(), extras(),
+        inflated_len(data_len),
+        is_reverse_complement(0) {
+    if (!detail::Deflate(data_ptr, data_len, deflated_data.data())) {
+      throw std::invalid_argument(
+          "[biosoup::NucleicAcid::NucleicAcid] error: not a nucleotide");
+    }
+    if (keep_ambiguous) {
+      FindAmbiguousRuns(data_ptr, data_len);
     }
   }
 
@@ -71,16 +503,29 @@ public:
 
   NucleicAcid(const char *name_ptr, std::uint32_t name_len,
               const char *data_ptr, std::uint32_t data_len,
-              const char *quality_ptr, std::uint32_t quality_len)
-      : NucleicAcid(name_ptr, name_len, data_ptr, data_len) {
+              const char *quality_ptr, std::uint32_t quality_len,
+              bool keep_ambiguous = false)
+      : NucleicAcid(name_ptr, name_len, data_ptr, data_len, keep_ambiguous) {
     quality = std::vector<std::int8_t>(quality_len);
     for (size_t i = 0; i < quality_len; ++i) {
       quality[i] = quality_ptr[i] - '!';
     }
   }
 
-  NucleicAcid(const NucleicAcid &) = default;
-  NucleicAcid &operator=(const NucleicAcid &) = default;
+  NucleicAcid(const NucleicAcid &other)
+      : id(other.id), name(other.name), deflated_data(other.deflated_data),
+        quality(other.quality),
+        extras(other.extras ? new NucleicAcidExtras(*other.extras) : nullptr),
+        inflated_len(other.inflated_len),
+        is_reverse_complement(other.is_reverse_complement) {}
+
+  NucleicAcid &operator=(const NucleicAcid &other) {
+    if (this != &other) {
+      NucleicAcid tmp(other);
+      *this = std::move(tmp);
+    }
+    return *this;
+  }
 
   NucleicAcid(NucleicAcid &&) = default;
   NucleicAcid &operator=(NucleicAcid &&) = default;
@@ -100,35 +545,117 @@ public:
     if (is_reverse_complement) {
       i = inflated_len - i - 1;
     }
-    return quality[i];
+    return quality.empty() ? extras->packed_quality[i] : quality[i];
   }
 
-  std::string InflateData(std::uint32_t i = 0, std::uint32_t len = -1) const {
+  // writes up to len bases starting at i to dst, returns their number
+  std::uint32_t InflateData(std::uint32_t i, std::uint32_t len,
+                            char *dst) const {
     if (i >= inflated_len) {
-      return std::string{};
+      return 0;
     }
     len = std::min(len, inflated_len - i);
+    if (is_reverse_complement) {
+      i = inflated_len - i - len;
+    }
+    detail::Inflate(deflated_data.data(), i, len, is_reverse_complement, dst);
+    if (extras) {
+      const auto &a = extras->ambiguous_runs;
+      const auto &l = extras->lower_case_runs;
+      detail::RestoreAmbiguous(a.data(), a.data() + a.size(), i, len,
+                               is_reverse_complement, dst);
+      detail::RestoreLowerCase(l.data(), l.data() + l.size(), i, len,
+                               is_reverse_complement, dst);
+    }
+    return len;
+  }
 
-    std::string dst{};
-    dst.reserve(len);
-    for (; len; ++i, --len) {
-      dst += kNucleotideDecoder[Code(i)];
+  // replaces the content of dst, reusing its capacity
+  void InflateData(std::uint32_t i, std::uint32_t len, std::string *dst) const {
+    dst->resize(i < inflated_len ? std::min(len, inflated_len - i) : 0);
+    if (!dst->empty()) {
+      InflateData(i, len, &(*dst)[0]);
     }
+  }
+
+  std::string InflateData(std::uint32_t i = 0, std::uint32_t len = -1) const {
+    std::string dst{};
+    InflateData(i, len, &dst);
     return dst;
   }
 
-  std::string InflateQuality(std::uint32_t i = 0,
-                             std::uint32_t len = -1) const { // NOLINT
-    if (quality.empty() || i >= inflated_len) {
-      return std::string{};
+  bool has_quality() const {
+    return !quality.empty() || !packed_quality().empty();
+  }
+
+  // empty unless CompressQuality was called
+  const PackedQuality &packed_quality() const {
+    static const PackedQuality empty{};
+    return extras ? extras->packed_quality : empty;
+  }
+
+  // empty unless constructed with keep_ambiguous
+  const std::vector<AmbiguousRun> &ambiguous_runs() const {
+    static const std::vector<AmbiguousRun> empty{};
+    return extras ? extras->ambiguous_runs : empty;
+  }
+
+  const std::vector<LowerCaseRun> &lower_case_runs() const {
+    static const std::vector<LowerCaseRun> empty{};
+    return extras ? extras->lower_case_runs : empty;
+  }
+
+  // replaces the runs, e.g. when copying a stored nucleic acid back
+  void SetRuns(std::vector<AmbiguousRun> ambiguous,
+               std::vector<LowerCaseRun> lower_case) {
+    if (ambiguous.empty() && lower_case.empty() && !extras) {
+      return;
+    }
+    MutableExtras().ambiguous_runs.swap(ambiguous);
+    extras->lower_case_runs.swap(lower_case);
+  }
+
+  // writes up to len Phred + 33 scores starting at i to dst, returns their
+  // number (0 if there are no quality scores)
+  std::uint32_t InflateQuality(std::uint32_t i, std::uint32_t len,
+                               char *dst) const {
+    if (!has_quality() || i >= inflated_len) {
+      return 0;
     }
     len = std::min(len, inflated_len - i);
+    if (is_reverse_complement) {
+      i = inflated_len - i - len;
+    }
+    if (quality.empty()) {
+      extras->packed_quality.Inflate(i, len, is_reverse_complement, dst);
+    } else if (is_reverse_complement) {
+      const std::int8_t *src = quality.data() + i;
+      for (std::uint32_t j = len; j; --j) {
+        *dst++ = src[j - 1] + '!';
+      }
+    } else {
+      const std::int8_t *src = quality.data() + i;
+      for (std::uint32_t j = 0; j < len; ++j) {
+        dst[j] = src[j] + '!';
+      }
+    }
+    return len;
+  }
 
-    std::string dst{};
-    dst.reserve(len);
-    for (; len; ++i, --len) {
-      dst += Score(i) + '!';
+  // replaces the content of dst, reusing its capacity
+  void InflateQuality(std::uint32_t i, std::uint32_t len,
+                      std::string *dst) const {
+    dst->resize(has_quality() && i < inflated_len ?
+                std::min(len, inflated_len - i) : 0);
+    if (!dst->empty()) {
+      InflateQuality(i, len, &(*dst)[0]);
     }
+  }
+
+  std::string InflateQuality(std::uint32_t i = 0,
+                             std::uint32_t len = -1) const { // NOLINT
+    std::string dst{};
+    InflateQuality(i, len, &dst);
     return dst;
   }
 
@@ -136,16 +663,189 @@ public:
     is_reverse_complement ^= 1;
   }
 
-  static std::atomic<std::uint32_t> num_objects;
+  bool IsAmbiguous(std::uint32_t i) const {
+    const std::vector<AmbiguousRun> &runs = ambiguous_runs();
+    if (runs.empty()) {
+      return false;
+    }
+    if (is_reverse_complement) {
+      i = inflated_len - i - 1;
+    }
+    auto it = std::upper_bound(
+        runs.begin(), runs.end(), i,
+        [](std::uint32_t i, const AmbiguousRun &run) { return i < run.begin; });
+    return it != runs.begin() && i - (it - 1)->begin < (it - 1)->len;
+  }
+
+  // replaces quality with its packed representation, lossless by default
+  void CompressQuality() {
+    if (!quality.empty()) {
+      MutableExtras().packed_quality =
+          PackedQuality(quality.data(), quality.size());
+      std::vector<std::int8_t>().swap(quality);
+    }
+  }
+
+  void CompressQuality(const QualityBinning &binning) {
+    if (!quality.empty()) {
+      MutableExtras().packed_quality =
+          PackedQuality(quality.data(), quality.size(), binning);
+      std::vector<std::int8_t>().swap(quality);
+    }
+  }
+
+  static std::atomic<ObjectId> num_objects;
 
-  std::uint32_t id; // (optional) initialize num_objects to 0
+  ObjectId id; // (optional) initialize num_objects to 0
   std::string name;
   std::vector<std::uint64_t> deflated_data;
   std::vector<std::int8_t> quality;
+  std::unique_ptr<NucleicAcidExtras> extras; // (optional) nullptr if unused
   std::uint32_t inflated_len;
   bool is_reverse_complement;
+
+private:
+  NucleicAcidExtras &MutableExtras() {
+    if (!extras) {
+      extras.reset(new NucleicAcidExtras());
+    }
+    return *extras;
+  }
+
+  static bool IsUnambiguous(char c) {
+    switch (c) {
+    case 'A': case 'C': case 'G': case 'T': case 'U': // U is packed as T
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  static bool IsLowerCase(char c) {
+    return c >= 'a' && c <= 'z';
+  }
+
+  void FindAmbiguousRuns(const char *data_ptr, std::uint32_t data_len) {
+    std::vector<AmbiguousRun> ambiguous;
+    std::vector<LowerCaseRun> lower_case;
+    for (std::uint32_t i = 0; i < data_len; ++i) {
+      char c = data_ptr[i];
+      if (IsLowerCase(c)) {
+        if (!lower_case.empty() &&
+            lower_case.back().begin + lower_case.back().len == i) {
+          ++lower_case.back().len;
+        } else {
+          lower_case.push_back(LowerCaseRun{i, 1});
+        }
+        c = static_cast<char>(c & ~0x20);
+      }
+      if (IsUnambiguous(c)) {
+        continue;
+      }
+      if (!ambiguous.empty() && ambiguous.back().c == c &&
+          ambiguous.back().begin + ambiguous.back().len == i) {
+        ++ambiguous.back().len;
+      } else {
+        ambiguous.push_back(AmbiguousRun{i, 1, c});
+      }
+    }
+    ambiguous.shrink_to_fit();
+    lower_case.shrink_to_fit();
+    SetRuns(std::move(ambiguous), std::move(lower_case));
+  }
 };
 
+// window [begin, begin + len) of a nucleic acid in its orientation, see
+// InflateDataBatch
+struct InflateRequest {
+  const NucleicAcid *nucleic_acid;
+  std::uint32_t begin;
+  std::uint32_t len;
+};
+
+namespace detail {
+
+inline void InflateBatch(const std::vector<InflateRequest> &requests,
+                         bool is_quality, std::uint32_t num_threads,
+                         std::string *dst,
+                         std::vector<std::uint64_t> *offsets) {
+  offsets->resize(requests.size() + 1);
+  (*offsets)[0] = 0;
+  for (std::size_t i = 0; i < requests.size(); ++i) {
+    const InflateRequest &it = requests[i];
+    const NucleicAcid &n = *it.nucleic_acid;
+    bool is_empty = it.begin >= n.inflated_len ||
+                    (is_quality && !n.has_quality());
+    (*offsets)[i + 1] = (*offsets)[i] +
+        (is_empty ? 0 : std::min(it.len, n.inflated_len - it.begin));
+  }
+  dst->resize(offsets->back());
+  if (dst->empty()) {
+    return;
+  }
+
+  // requests of the same nucleic acid are inflated together and in order,
+  // sorting copies rather than indices avoids scattered reads
+  struct Item {
+    const NucleicAcid *nucleic_acid;
+    std::uint32_t begin;
+    std::uint32_t index;
+  };
+  auto is_less = [](const Item &lhs, const Item &rhs) -> bool {
+    if (lhs.nucleic_acid != rhs.nucleic_acid) {
+      return std::less<const NucleicAcid *>()(lhs.nucleic_acid,
+                                              rhs.nucleic_acid);
+    }
+    return lhs.begin < rhs.begin;
+  };
+  std::vector<Item> order(requests.size());
+  for (std::size_t i = 0; i < requests.size(); ++i) {
+    order[i] = Item{requests[i].nucleic_acid, requests[i].begin,
+                    static_cast<std::uint32_t>(i)};
+  }
+  if (!std::is_sorted(order.begin(), order.end(), is_less)) {
+    std::sort(order.begin(), order.end(), is_less);
+  }
+
+  const std::size_t kChunkSize = 256;
+  char *data = &(*dst)[0];
+  ParallelFor(
+      (order.size() + kChunkSize - 1) / kChunkSize, num_threads,
+      [&](std::size_t chunk) {
+        std::size_t end = std::min(order.size(), (chunk + 1) * kChunkSize);
+        for (std::size_t i = chunk * kChunkSize; i < end; ++i) {
+          const InflateRequest &it = requests[order[i].index];
+          char *dst = data + (*offsets)[order[i].index];
+          if (is_quality) {
+            it.nucleic_acid->InflateQuality(it.begin, it.len, dst);
+          } else {
+            it.nucleic_acid->InflateData(it.begin, it.len, dst);
+          }
+        }
+      });
+}
+
+} // namespace detail
+
+// Inflates data of all requests into dst, request i occupying
+// [offsets[i], offsets[i + 1]). Buffers are reused between calls and
+// requests are spread among num_threads threads.
+inline void InflateDataBatch(const std::vector<InflateRequest> &requests,
+                             std::string *dst,
+                             std::vector<std::uint64_t> *offsets,
+                             std::uint32_t num_threads = 1) {
+  detail::InflateBatch(requests, false, num_threads, dst, offsets);
+}
+
+// InflateDataBatch counterpart for quality scores, empty for nucleic acids
+// without them
+inline void InflateQualityBatch(const std::vector<InflateRequest> &requests,
+                                std::string *dst,
+                                std::vector<std::uint64_t> *offsets,
+                                std::uint32_t num_threads = 1) {
+  detail::InflateBatch(requests, true, num_threads, dst, offsets);
+}
+
 } // namespace biosoup
 
 #endif // BIOSOUP_NUCLEIC_ACID_HPP_
@@ -0,0 +1,371 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_NUCLEIC_ACID_COMPARE_HPP_
+#define BIOSOUP_NUCLEIC_ACID_COMPARE_HPP_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "biosoup/detail/bits.hpp"
+#include "biosoup/detail/simd.hpp"
+#include "biosoup/nucleic_acid_view.hpp"
+
+namespace biosoup {
+namespace detail {
+
+// Kernels take packed bases, 32 per word with the first one in the lowest
+// bits, and the number of bases len (bits of the last word past len are
+// ignored).
+
+inline std::uint64_t BaseMask(std::uint32_t len) {  // lowest len bases
+  return len >= 32 ? -1ULL : (1ULL << (len << 1)) - 1;
+}
+
+// lower bit of each base which differs in lhs and rhs
+inline std::uint64_t MismatchBits(std::uint64_t lhs, std::uint64_t rhs) {
+  std::uint64_t x = lhs ^ rhs;
+  return (x | (x >> 1)) & 0x5555555555555555ULL;
+}
+
+// lower bit of each C or G (encoded as 01 and 10)
+inline std::uint64_t GcBits(std::uint64_t x) {
+  return (x ^ (x >> 1)) & 0x5555555555555555ULL;
+}
+
+inline std::uint32_t HammingDistanceScalar(
+    const std::uint64_t* lhs,
+    const std::uint64_t* rhs,
+    std::uint32_t len) {
+  std::uint32_t dst = 0;
+  for (std::uint32_t i = 0; i < len; i += 32) {
+    dst += Popcount(MismatchBits(*lhs++, *rhs++) & BaseMask(len - i));
+  }
+  return dst;
+}
+
+// position of the first differing base, len if there is none
+inline std::uint32_t MismatchScalar(
+    const std::uint64_t* lhs,
+    const std::uint64_t* rhs,
+    std::uint32_t len) {
+  for (std::uint32_t i = 0; i < len; i += 32) {
+    std::uint64_t x = MismatchBits(*lhs++, *rhs++) & BaseMask(len - i);
+    if (x) {
+      return i + (TrailingZeros(x) >> 1);
+    }
+  }
+  return len;
+}
+
+inline std::uint32_t GcCountScalar(
+    const std::uint64_t* data,
+    std::uint32_t len) {
+  std::uint32_t dst = 0;
+  for (std::uint32_t i = 0; i < len; i += 32) {
+    dst += Popcount(GcBits(*data++) & BaseMask(len - i));
+  }
+  return dst;
+}
+
+#if defined(BIOSOUP_X86_DISPATCH)
+
+BIOSOUP_TARGET_SSE42 inline std::uint32_t HammingDistanceSse42(
+    const std::uint64_t* lhs,
+    const std::uint64_t* rhs,
+    std::uint32_t len) {
+  std::uint32_t i = 0, dst = 0;
+  for (; len - i >= 32; i += 32) {
+    dst += _mm_popcnt_u64(MismatchBits(*lhs++, *rhs++));
+  }
+  return dst + HammingDistanceScalar(lhs, rhs, len - i);
+}
+
+BIOSOUP_TARGET_SSE42 inline std::uint32_t MismatchSse42(
+    const std::uint64_t* lhs,
+    const std::uint64_t* rhs,
+    std::uint32_t len) {
+  std::uint32_t i = 0;
+  for (; len - i >= 64; i += 64, lhs += 2, rhs += 2) {
+    __m128i x = _mm_cmpeq_epi64(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs)));
+    if (_mm_movemask_epi8(x) != 0xFFFF) {
+      break;
+    }
+  }
+  return i + MismatchScalar(lhs, rhs, len - i);
+}
+
+BIOSOUP_TARGET_SSE42 inline std::uint32_t GcCountSse42(
+    const std::uint64_t* data,
+    std::uint32_t len) {
+  std::uint32_t i = 0, dst = 0;
+  for (; len - i >= 32; i += 32) {
+    dst += _mm_popcnt_u64(GcBits(*data++));
+  }
+  return dst + GcCountScalar(data, len - i);
+}
+
+// sums set bits of x into the 64-bit lanes of acc
+BIOSOUP_TARGET_AVX2 inline __m256i PopcountAvx2(__m256i x, __m256i acc) {
+  const __m256i lut = _mm256_setr_epi8(
+      0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+      0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  __m256i n = _mm256_add_epi8(
+      _mm256_shuffle_epi8(lut, _mm256_and_si256(x, nibble)),
+      _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble)));  // NOLINT
+  return _mm256_add_epi64(acc, _mm256_sad_epu8(n, _mm256_setzero_si256()));
+}
+
+BIOSOUP_TARGET_AVX2 inline std::uint32_t SumAvx2(__m256i acc) {
+  __m128i x = _mm_add_epi64(
+      _mm256_castsi256_si128(acc),
+      _mm256_extracti128_si256(acc, 1));
+  return _mm_cvtsi128_si64(x) + _mm_extract_epi64(x, 1);
+}
+
+BIOSOUP_TARGET_AVX2 inline std::uint32_t HammingDistanceAvx2(
+    const std::uint64_t* lhs,
+    const std::uint64_t* rhs,
+    std::uint32_t len) {
+  const __m256i low = _mm256_set1_epi64x(0x5555555555555555LL);
+  __m256i acc = _mm256_setzero_si256();
+  std::uint32_t i = 0;
+  for (; len - i >= 128; i += 128, lhs += 4, rhs += 4) {
+    __m256i x = _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs)));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, 1)), low);
+    acc = PopcountAvx2(x, acc);
+  }
+  return SumAvx2(acc) + HammingDistanceSse42(lhs, rhs, len - i);
+}
+
+BIOSOUP_TARGET_AVX2 inline std::uint32_t MismatchAvx2(
+    const std::uint64_t* lhs,
+    const std::uint64_t* rhs,
+    std::uint32_t len) {
+  std::uint32_t i = 0;
+  for (; len - i >= 128; i += 128, lhs += 4, rhs += 4) {
+    __m256i x = _mm256_cmpeq_epi64(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs)));
+    if (_mm256_movemask_epi8(x) != -1) {
+      break;
+    }
+  }
+  return i + MismatchSse42(lhs, rhs, len - i);
+}
+
+BIOSOUP_TARGET_AVX2 inline std::uint32_t GcCountAvx2(
+    const std::uint64_t* data,
+    std::uint32_t len) {
+  const __m256i low = _mm256_set1_epi64x(0x5555555555555555LL);
+  __m256i acc = _mm256_setzero_si256();
+  std::uint32_t i = 0;
+  for (; len - i >= 128; i += 128, data += 4) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    x = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 1)), low);
+    acc = PopcountAvx2(x, acc);
+  }
+  return SumAvx2(acc) + GcCountSse42(data, len - i);
+}
+
+#endif  // BIOSOUP_X86_DISPATCH
+
+inline std::uint32_t HammingDistance(
+    const std::uint64_t* lhs,
+    const std::uint64_t* rhs,
+    std::uint32_t len) {
+#if defined(BIOSOUP_X86_DISPATCH)
+  switch (simd_level()) {
+    case SimdLevel::kAvx2:
+      return HammingDistanceAvx2(lhs, rhs, len);
+    case SimdLevel::kSse42:
+      return HammingDistanceSse42(lhs, rhs, len);
+    default:
+      break;
+  }
+#endif
+  return HammingDistanceScalar(lhs, rhs, len);
+}
+
+inline std::uint32_t Mismatch(
+    const std::uint64_t* lhs,
+    const std::uint64_t* rhs,
+    std::uint32_t len) {
+#if defined(BIOSOUP_X86_DISPATCH)
+  switch (simd_level()) {
+    case SimdLevel::kAvx2:
+      return MismatchAvx2(lhs, rhs, len);
+    case SimdLevel::kSse42:
+      return MismatchSse42(lhs, rhs, len);
+    default:
+      break;
+  }
+#endif
+  return MismatchScalar(lhs, rhs, len);
+}
+
+inline std::uint32_t GcCount(const std::uint64_t* data, std::uint32_t len) {
+#if defined(BIOSOUP_X86_DISPATCH)
+  switch (simd_level()) {
+    case SimdLevel::kAvx2:
+      return GcCountAvx2(data, len);
+    case SimdLevel::kSse42:
+      return GcCountSse42(data, len);
+    default:
+      break;
+  }
+#endif
+  return GcCountScalar(data, len);
+}
+
+// reverses the order of 2-bit groups
+inline std::uint64_t ReverseBases(std::uint64_t x) {
+  x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);  // NOLINT
+  x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);  // NOLINT
+  x = ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);  // NOLINT
+  x = ((x >> 16) & 0x0000FFFF0000FFFFULL) | ((x & 0x0000FFFF0000FFFFULL) << 16);  // NOLINT
+  return (x >> 32) | (x << 32);
+}
+
+// forward bases [i, i + len) with len <= 32, reading only words holding them
+inline std::uint64_t LoadBases(
+    const std::uint64_t* data,
+    std::uint32_t i,
+    std::uint32_t len) {
+  std::uint32_t shift = (i & 31) << 1;
+  std::uint64_t x = data[i >> 5] >> shift;
+  if ((i & 31) + len > 32) {
+    x |= data[(i >> 5) + 1] << (64 - shift);
+  }
+  return x & BaseMask(len);
+}
+
+// Bases [i, i + len) of a view in its orientation, packed into dst unless
+// they can be read in place. Returns a pointer to the packed bases.
+inline const std::uint64_t* PackBases(
+    const NucleicAcidView& view,
+    std::uint32_t i,
+    std::uint32_t len,
+    std::uint64_t* dst) {
+  if (!view.is_reverse_complement) {
+    i += view.begin;
+    if ((i & 31) == 0) {
+      return view.deflated_data + (i >> 5);
+    }
+    for (std::uint32_t j = 0; j < len; j += 32, i += 32) {
+      dst[j >> 5] = LoadBases(view.deflated_data, i, std::min(len - j, 32U));
+    }
+    return dst;
+  }
+  std::uint32_t end = view.begin + view.inflated_len - i;  // forward strand
+  for (std::uint32_t j = 0; j < len; j += 32) {
+    std::uint32_t n = std::min(len - j, 32U);
+    std::uint64_t x = LoadBases(view.deflated_data, end - j - n, n);
+    dst[j >> 5] = (ReverseBases(x) >> ((32 - n) << 1)) ^ BaseMask(n);
+  }
+  return dst;
+}
+
+enum : std::uint32_t {
+  kChunkSize = 2048  // bases packed at once
+};
+
+// Calls f(lhs, rhs, i, len) on packed bases [i, i + len) of both views in
+// chunks while it returns true, up to the length of the shorter view. Chunks
+// start small and grow, so early exits do not pack bases in vain.
+template<typename F>
+void ForEachChunk(
+    const NucleicAcidView& lhs,
+    const NucleicAcidView& rhs,
+    F f) {
+  std::uint64_t lhs_buffer[kChunkSize / 32], rhs_buffer[kChunkSize / 32];
+  std::uint32_t len = std::min(lhs.inflated_len, rhs.inflated_len);
+  std::uint32_t chunk_size = 128;
+  for (std::uint32_t i = 0, n; i < len; i += n) {
+    n = std::min(len - i, chunk_size);
+    chunk_size = std::min<std::uint32_t>(chunk_size << 1, kChunkSize);
+    if (!f(PackBases(lhs, i, n, lhs_buffer),
+           PackBases(rhs, i, n, rhs_buffer),
+           i, n)) {
+      return;
+    }
+  }
+}
+
+}  // namespace detail
+
+// Comparisons of nucleic acids carried out on 32 bases at a time in the 2-bit
+// encoding. Views can start at any base and be in either orientation, so
+// regions are compared with NucleicAcidView(nucleic_acid).Slice(i, len).
+// Ambiguous bases are compared as stored in deflated_data.
+
+// number of differing bases in the first min(lhs, rhs length) ones
+inline std::uint32_t HammingDistance(
+    const NucleicAcidView& lhs,
+    const NucleicAcidView& rhs) {
+  std::uint32_t dst = 0;
+  detail::ForEachChunk(lhs, rhs, [&] (
+      const std::uint64_t* l, const std::uint64_t* r,
+      std::uint32_t, std::uint32_t len) -> bool {
+    dst += detail::HammingDistance(l, r, len);
+    return true;
+  });
+  return dst;
+}
+
+// length of the longest common prefix
+inline std::uint32_t CommonPrefixLength(
+    const NucleicAcidView& lhs,
+    const NucleicAcidView& rhs) {
+  std::uint32_t dst = std::min(lhs.inflated_len, rhs.inflated_len);
+  detail::ForEachChunk(lhs, rhs, [&] (
+      const std::uint64_t* l, const std::uint64_t* r,
+      std::uint32_t i, std::uint32_t len) -> bool {
+    std::uint32_t j = detail::Mismatch(l, r, len);
+    if (j < len) {
+      dst = i + j;
+      return false;
+    }
+    return true;
+  });
+  return dst;
+}
+
+// length of the longest common suffix, i.e. the longest common prefix of
+// the reverse complements
+inline std::uint32_t CommonSuffixLength(
+    const NucleicAcidView& lhs,
+    const NucleicAcidView& rhs) {
+  std::uint32_t len = std::min(lhs.inflated_len, rhs.inflated_len);
+  NucleicAcidView l = lhs.Slice(lhs.inflated_len - len);
+  NucleicAcidView r = rhs.Slice(rhs.inflated_len - len);
+  l.ReverseAndComplement();
+  r.ReverseAndComplement();
+  return CommonPrefixLength(l, r);
+}
+
+inline bool Equal(const NucleicAcidView& lhs, const NucleicAcidView& rhs) {
+  return lhs.inflated_len == rhs.inflated_len &&
+      CommonPrefixLength(lhs, rhs) == lhs.inflated_len;
+}
+
+// number of C and G bases
+inline std::uint32_t GcCount(const NucleicAcidView& nucleic_acid) {
+  NucleicAcidView forward = nucleic_acid;  // complement keeps C and G
+  forward.is_reverse_complement = false;
+  std::uint64_t buffer[detail::kChunkSize / 32];
+  std::uint32_t dst = 0;
+  for (std::uint32_t i = 0, len; i < forward.inflated_len; i += len) {
+    len = std::min<std::uint32_t>(forward.inflated_len - i, detail::kChunkSize);
+    dst += detail::GcCount(detail::PackBases(forward, i, len, buffer), len);
+  }
+  return dst;
+}
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_NUCLEIC_ACID_COMPARE_HPP_
@@ -0,0 +1,377 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_NUCLEIC_ACID_STORE_HPP_
+#define BIOSOUP_NUCLEIC_ACID_STORE_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "biosoup/nucleic_acid.hpp"
+#include "biosoup/nucleic_acid_view.hpp"
+
+namespace biosoup {
+
+namespace detail {
+
+// Hands out contiguous ranges from large blocks which are never moved, so
+// pointers stay valid and growth does not copy (or double) the payload.
+template<typename T>
+class Arena {
+ public:
+  explicit Arena(std::size_t block_size = (1U << 25) / sizeof(T))
+      : blocks_(),
+        block_size_(block_size),
+        block_len_(0),
+        block_capacity_(0),
+        size_(0) {}
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  Arena(Arena&&) = default;
+  Arena& operator=(Arena&&) = default;
+
+  ~Arena() = default;
+
+  std::uint64_t size() const {  // number of allocated elements
+    return size_;
+  }
+
+  std::uint64_t capacity() const {
+    std::uint64_t dst = 0;
+    for (const auto& it : blocks_) {
+      dst += it.second;
+    }
+    return dst;
+  }
+
+  T* Allocate(std::size_t n) {  // never nullptr, even if n == 0
+    if (blocks_.empty() || block_capacity_ - block_len_ < n) {
+      block_capacity_ = std::max(block_size_, n);
+      blocks_.emplace_back(
+          std::unique_ptr<T[]>(new T[block_capacity_]),
+          block_capacity_);
+      block_len_ = 0;
+    }
+    T* dst = blocks_.back().first.get() + block_len_;
+    block_len_ += n;
+    size_ += n;
+    return dst;
+  }
+
+  void Deallocate(std::size_t n) {  // only the last allocation
+    block_len_ -= n;
+    size_ -= n;
+  }
+
+ private:
+  std::vector<std::pair<std::unique_ptr<T[]>, std::size_t>> blocks_;
+  std::size_t block_size_;
+  std::size_t block_len_;
+  std::size_t block_capacity_;
+  std::uint64_t size_;
+};
+
+}  // namespace detail
+
+// Collection of nucleic acids packed into a few large buffers (32 MiB blocks)
+// instead of three heap allocations per NucleicAcid. The buffers never move,
+// so views stay valid until the store is cleared or destroyed. Ambiguous and
+// lower case runs are kept in a side table which only lists sequences that
+// have any, so they cost nothing otherwise.
+class NucleicAcidStore {
+ public:
+  NucleicAcidStore()
+      : ids_(),
+        names_(),
+        name_lens_(),
+        deflated_data_(),
+        inflated_lens_(),
+        quality_(),
+        is_reverse_complement_(),
+        name_arena_(),
+        data_arena_(),
+        quality_arena_(),
+        runs_(),
+        ambiguous_run_arena_((1U << 20) / sizeof(AmbiguousRun)),
+        lower_case_run_arena_((1U << 20) / sizeof(LowerCaseRun)) {}
+
+  NucleicAcidStore(const NucleicAcidStore&) = delete;
+  NucleicAcidStore& operator=(const NucleicAcidStore&) = delete;
+
+  NucleicAcidStore(NucleicAcidStore&&) = default;
+  NucleicAcidStore& operator=(NucleicAcidStore&&) = default;
+
+  ~NucleicAcidStore() = default;
+
+  std::size_t size() const {
+    return ids_.size();
+  }
+
+  bool empty() const {
+    return ids_.empty();
+  }
+
+  std::uint64_t num_name_bytes() const {
+    return name_arena_.size();
+  }
+
+  std::uint64_t num_blocks() const {  // 64-bit words of 2-bit bases
+    return data_arena_.size();
+  }
+
+  std::uint64_t num_scores() const {
+    return quality_arena_.size();
+  }
+
+  // bytes held by the store
+  std::uint64_t memory_usage() const {
+    return ids_.capacity() * sizeof(ObjectId) +
+        names_.capacity() * sizeof(const char*) +
+        name_lens_.capacity() * sizeof(std::uint32_t) +
+        deflated_data_.capacity() * sizeof(const std::uint64_t*) +
+        inflated_lens_.capacity() * sizeof(std::uint32_t) +
+        quality_.capacity() * sizeof(const std::int8_t*) +
+        is_reverse_complement_.capacity() +
+        name_arena_.capacity() +
+        data_arena_.capacity() * sizeof(std::uint64_t) +
+        quality_arena_.capacity() +
+        runs_.capacity() * sizeof(Runs) +
+        ambiguous_run_arena_.capacity() * sizeof(AmbiguousRun) +
+        lower_case_run_arena_.capacity() * sizeof(LowerCaseRun);
+  }
+
+  void Reserve(std::size_t num_sequences) {
+    ids_.reserve(num_sequences);
+    names_.reserve(num_sequences);
+    name_lens_.reserve(num_sequences);
+    deflated_data_.reserve(num_sequences);
+    inflated_lens_.reserve(num_sequences);
+    quality_.reserve(num_sequences);
+    is_reverse_complement_.reserve(num_sequences);
+  }
+
+  void Clear() {
+    *this = NucleicAcidStore();
+  }
+
+  // returns the position of the new sequence in the store
+  std::size_t Append(const std::string& name, const std::string& data) {
+    return Append(name.c_str(), name.size(), data.c_str(), data.size());
+  }
+
+  std::size_t Append(
+      const std::string& name,
+      const std::string& data,
+      const std::string& quality) {
+    return Append(
+        name.c_str(), name.size(),
+        data.c_str(), data.size(),
+        quality.c_str(), quality.size());
+  }
+
+  std::size_t Append(
+      const char* name, std::uint32_t name_len,
+      const char* data, std::uint32_t data_len) {
+    return Append(name, name_len, data, data_len, nullptr, 0);
+  }
+
+  std::size_t Append(
+      const char* name, std::uint32_t name_len,
+      const char* data, std::uint32_t data_len,
+      const char* quality, std::uint32_t quality_len) {
+    std::size_t num_words = (static_cast<std::uint64_t>(data_len) + 31) >> 5;
+    std::uint64_t* deflated_data = data_arena_.Allocate(num_words);
+    if (!detail::Deflate(data, data_len, deflated_data)) {
+      data_arena_.Deallocate(num_words);
+      throw std::invalid_argument(
+          "[biosoup::NucleicAcidStore::Append] error: not a nucleotide");
+    }
+    if (quality_len != 0 && quality_len != data_len) {
+      data_arena_.Deallocate(num_words);
+      throw std::invalid_argument(
+          "[biosoup::NucleicAcidStore::Append] error: "
+          "quality length differs from data length");
+    }
+
+    std::int8_t* scores = nullptr;
+    if (quality_len) {
+      scores = quality_arena_.Allocate(quality_len);
+      for (std::uint32_t i = 0; i < quality_len; ++i) {
+        scores[i] = quality[i] - '!';
+      }
+    }
+
+    return Emplace(
+        NextId<NucleicAcid>(),
+        name, name_len,
+        deflated_data,
+        scores,
+        data_len,
+        false);
+  }
+
+  // keeps the id, orientation and runs of nucleic_acid
+  std::size_t Append(const NucleicAcid& nucleic_acid) {
+    std::uint64_t* deflated_data =
+        data_arena_.Allocate(nucleic_acid.deflated_data.size());
+    std::copy(
+        nucleic_acid.deflated_data.begin(),
+        nucleic_acid.deflated_data.end(),
+        deflated_data);
+
+    std::int8_t* scores = nullptr;
+    if (!nucleic_acid.quality.empty()) {
+      scores = quality_arena_.Allocate(nucleic_acid.quality.size());
+      std::copy(
+          nucleic_acid.quality.begin(),
+          nucleic_acid.quality.end(),
+          scores);
+    } else if (nucleic_acid.has_quality()) {
+      const PackedQuality& packed_quality = nucleic_acid.packed_quality();
+      scores = quality_arena_.Allocate(packed_quality.size());
+      for (std::uint32_t i = 0; i < packed_quality.size(); ++i) {
+        scores[i] = packed_quality[i];
+      }
+    }
+
+    std::size_t i = Emplace(
+        nucleic_acid.id,
+        nucleic_acid.name.c_str(), nucleic_acid.name.size(),
+        deflated_data,
+        scores,
+        nucleic_acid.inflated_len,
+        nucleic_acid.is_reverse_complement);
+
+    const auto& ambiguous_runs = nucleic_acid.ambiguous_runs();
+    const auto& lower_case_runs = nucleic_acid.lower_case_runs();
+    if (!ambiguous_runs.empty() || !lower_case_runs.empty()) {
+      Runs runs{
+          i,
+          ambiguous_run_arena_.Allocate(ambiguous_runs.size()),
+          static_cast<std::uint32_t>(ambiguous_runs.size()),
+          lower_case_run_arena_.Allocate(lower_case_runs.size()),
+          static_cast<std::uint32_t>(lower_case_runs.size())};
+      std::copy(
+          ambiguous_runs.begin(),
+          ambiguous_runs.end(),
+          runs.ambiguous_runs);
+      std::copy(
+          lower_case_runs.begin(),
+          lower_case_runs.end(),
+          runs.lower_case_runs);
+      runs_.emplace_back(runs);
+    }
+    return i;
+  }
+
+  NucleicAcidView operator[](std::size_t i) const {
+    NucleicAcidView dst(
+        ids_[i],
+        names_[i], name_lens_[i],
+        deflated_data_[i],
+        quality_[i],
+        inflated_lens_[i],
+        is_reverse_complement_[i]);
+    const Runs* runs = FindRuns(i);
+    if (runs) {
+      dst.ambiguous_runs = runs->ambiguous_runs;
+      dst.num_ambiguous_runs = runs->num_ambiguous_runs;
+      dst.lower_case_runs = runs->lower_case_runs;
+      dst.num_lower_case_runs = runs->num_lower_case_runs;
+    }
+    return dst;
+  }
+
+  // persistent counterpart of NucleicAcidView::ReverseAndComplement
+  void ReverseAndComplement(std::size_t i) {
+    is_reverse_complement_[i] ^= 1;
+  }
+
+  NucleicAcid ToNucleicAcid(std::size_t i) const {
+    NucleicAcid dst{};
+    dst.id = ids_[i];
+    dst.name.assign(names_[i], name_lens_[i]);
+    dst.deflated_data.assign(
+        deflated_data_[i],
+        deflated_data_[i] + ((inflated_lens_[i] + 31ULL) >> 5));
+    if (quality_[i]) {
+      dst.quality.assign(quality_[i], quality_[i] + inflated_lens_[i]);
+    }
+    dst.inflated_len = inflated_lens_[i];
+    dst.is_reverse_complement = is_reverse_complement_[i];
+    const Runs* runs = FindRuns(i);
+    if (runs) {
+      dst.SetRuns(
+          std::vector<AmbiguousRun>(
+              runs->ambiguous_runs,
+              runs->ambiguous_runs + runs->num_ambiguous_runs),
+          std::vector<LowerCaseRun>(
+              runs->lower_case_runs,
+              runs->lower_case_runs + runs->num_lower_case_runs));
+    }
+    return dst;
+  }
+
+ private:
+  struct Runs {  // of sequence i
+    std::size_t i;
+    AmbiguousRun* ambiguous_runs;
+    std::uint32_t num_ambiguous_runs;
+    LowerCaseRun* lower_case_runs;
+    std::uint32_t num_lower_case_runs;
+  };
+
+  const Runs* FindRuns(std::size_t i) const {
+    if (runs_.empty()) {
+      return nullptr;
+    }
+    auto it = std::lower_bound(
+        runs_.begin(), runs_.end(), i,
+        [] (const Runs& runs, std::size_t i) { return runs.i < i; });
+    return it != runs_.end() && it->i == i ? &*it : nullptr;
+  }
+
+  std::size_t Emplace(
+      ObjectId id,
+      const char* name, std::uint32_t name_len,
+      const std::uint64_t* deflated_data,
+      const std::int8_t* quality,
+      std::uint32_t inflated_len,
+      bool is_reverse_complement) {
+    char* name_copy = name_arena_.Allocate(name_len);
+    std::copy(name, name + name_len, name_copy);
+
+    ids_.emplace_back(id);
+    names_.emplace_back(name_copy);
+    name_lens_.emplace_back(name_len);
+    deflated_data_.emplace_back(deflated_data);
+    inflated_lens_.emplace_back(inflated_len);
+    quality_.emplace_back(quality);
+    is_reverse_complement_.emplace_back(is_reverse_complement);
+    return ids_.size() - 1;
+  }
+
+  std::vector<ObjectId> ids_;
+  std::vector<const char*> names_;
+  std::vector<std::uint32_t> name_lens_;
+  std::vector<const std::uint64_t*> deflated_data_;
+  std::vector<std::uint32_t> inflated_lens_;
+  std::vector<const std::int8_t*> quality_;  // nullptr if there is none
+  std::vector<std::uint8_t> is_reverse_complement_;
+  detail::Arena<char> name_arena_;
+  detail::Arena<std::uint64_t> data_arena_;
+  detail::Arena<std::int8_t> quality_arena_;
+  std::vector<Runs> runs_;  // sorted by position
+  detail::Arena<AmbiguousRun> ambiguous_run_arena_;
+  detail::Arena<LowerCaseRun> lower_case_run_arena_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_NUCLEIC_ACID_STORE_HPP_
@@ -0,0 +1,235 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_NUCLEIC_ACID_VIEW_HPP_
+#define BIOSOUP_NUCLEIC_ACID_VIEW_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "biosoup/nucleic_acid.hpp"
+#include "biosoup/packed_quality.hpp"
+
+namespace biosoup {
+
+// Non-owning counterpart of NucleicAcid, valid while the storage it points to.
+// It covers inflated_len bases of the forward strand starting at begin, in
+// the orientation given by is_reverse_complement, so windows of a sequence
+// can be passed around and sliced further without copying. Ambiguous and
+// lower case runs of the whole source are shared by all of its slices.
+class NucleicAcidView {
+ public:
+  NucleicAcidView()
+      : id(0),
+        name(nullptr),
+        name_len(0),
+        deflated_data(nullptr),
+        quality(nullptr),
+        packed_quality(nullptr),
+        ambiguous_runs(nullptr),
+        num_ambiguous_runs(0),
+        lower_case_runs(nullptr),
+        num_lower_case_runs(0),
+        begin(0),
+        inflated_len(0),
+        is_reverse_complement(false) {}
+
+  NucleicAcidView(
+      ObjectId id,
+      const char* name, std::uint32_t name_len,
+      const std::uint64_t* deflated_data,
+      const std::int8_t* quality,  // nullptr if there are no quality scores
+      std::uint32_t inflated_len,
+      bool is_reverse_complement = false)
+      : id(id),
+        name(name),
+        name_len(name_len),
+        deflated_data(deflated_data),
+        quality(quality),
+        packed_quality(nullptr),
+        ambiguous_runs(nullptr),
+        num_ambiguous_runs(0),
+        lower_case_runs(nullptr),
+        num_lower_case_runs(0),
+        begin(0),
+        inflated_len(inflated_len),
+        is_reverse_complement(is_reverse_complement) {}
+
+  explicit NucleicAcidView(const NucleicAcid& nucleic_acid)
+      : id(nucleic_acid.id),
+        name(nucleic_acid.name.c_str()),
+        name_len(nucleic_acid.name.size()),
+        deflated_data(nucleic_acid.deflated_data.data()),
+        quality(nucleic_acid.quality.empty() ?
+            nullptr : nucleic_acid.quality.data()),
+        packed_quality(nucleic_acid.packed_quality().empty() ?
+            nullptr : &nucleic_acid.packed_quality()),
+        ambiguous_runs(nucleic_acid.ambiguous_runs().data()),
+        num_ambiguous_runs(nucleic_acid.ambiguous_runs().size()),
+        lower_case_runs(nucleic_acid.lower_case_runs().data()),
+        num_lower_case_runs(nucleic_acid.lower_case_runs().size()),
+        begin(0),
+        inflated_len(nucleic_acid.inflated_len),
+        is_reverse_complement(nucleic_acid.is_reverse_complement) {}
+
+  NucleicAcidView(const NucleicAcidView&) = default;
+  NucleicAcidView& operator=(const NucleicAcidView&) = default;
+
+  NucleicAcidView(NucleicAcidView&&) = default;
+  NucleicAcidView& operator=(NucleicAcidView&&) = default;
+
+  ~NucleicAcidView() = default;
+
+  bool has_quality() const {
+    return quality != nullptr || packed_quality != nullptr;
+  }
+
+  std::uint64_t Code(std::uint32_t i) const {
+    std::uint64_t x = 0;
+    if (is_reverse_complement) {
+      i = inflated_len - i - 1;
+      x = 3;
+    }
+    i += begin;
+    return ((deflated_data[i >> 5] >> ((i << 1) & 63)) & 3) ^ x;
+  }
+
+  std::uint8_t Score(std::uint32_t i) const {
+    if (is_reverse_complement) {
+      i = inflated_len - i - 1;
+    }
+    i += begin;
+    return quality ? quality[i] : (*packed_quality)[i];
+  }
+
+  std::string Name() const {
+    return std::string(name, name_len);
+  }
+
+  // bases [i, i + len) in the orientation of the view, len is clipped
+  NucleicAcidView Slice(std::uint32_t i, std::uint32_t len = -1) const {
+    NucleicAcidView dst = *this;
+    i = std::min(i, inflated_len);
+    dst.inflated_len = std::min(len, inflated_len - i);
+    dst.begin += is_reverse_complement ?
+        inflated_len - i - dst.inflated_len : i;
+    return dst;
+  }
+
+  // writes up to len bases starting at i to dst, returns their number
+  std::uint32_t InflateData(
+      std::uint32_t i, std::uint32_t len,
+      char* dst) const {
+    if (i >= inflated_len) {
+      return 0;
+    }
+    len = std::min(len, inflated_len - i);
+    if (is_reverse_complement) {
+      i = inflated_len - i - len;
+    }
+    detail::Inflate(deflated_data, begin + i, len, is_reverse_complement, dst);
+    detail::RestoreAmbiguous(
+        ambiguous_runs, ambiguous_runs + num_ambiguous_runs,
+        begin + i, len, is_reverse_complement, dst);
+    detail::RestoreLowerCase(
+        lower_case_runs, lower_case_runs + num_lower_case_runs,
+        begin + i, len, is_reverse_complement, dst);
+    return len;
+  }
+
+  std::string InflateData(std::uint32_t i = 0, std::uint32_t len = -1) const {
+    if (i >= inflated_len) {
+      return std::string{};
+    }
+    std::string dst(std::min(len, inflated_len - i), '\0');
+    InflateData(i, len, &dst[0]);
+    return dst;
+  }
+
+  // writes up to len Phred + 33 scores starting at i to dst, returns their
+  // number (0 if there are no quality scores)
+  std::uint32_t InflateQuality(
+      std::uint32_t i, std::uint32_t len,
+      char* dst) const {
+    if (!has_quality() || i >= inflated_len) {
+      return 0;
+    }
+    len = std::min(len, inflated_len - i);
+    if (is_reverse_complement) {
+      i = inflated_len - i - len;
+    }
+    if (quality == nullptr) {
+      packed_quality->Inflate(begin + i, len, is_reverse_complement, dst);
+    } else if (is_reverse_complement) {
+      const std::int8_t* src = quality + begin + i;
+      for (std::uint32_t j = len; j; --j) {
+        *dst++ = src[j - 1] + '!';
+      }
+    } else {
+      const std::int8_t* src = quality + begin + i;
+      for (std::uint32_t j = 0; j < len; ++j) {
+        dst[j] = src[j] + '!';
+      }
+    }
+    return len;
+  }
+
+  std::string InflateQuality(std::uint32_t i = 0, std::uint32_t len = -1) const {  // NOLINT
+    if (!has_quality() || i >= inflated_len) {
+      return std::string{};
+    }
+    std::string dst(std::min(len, inflated_len - i), '\0');
+    InflateQuality(i, len, &dst[0]);
+    return dst;
+  }
+
+  void ReverseAndComplement() {  // Watson-Crick base pairing
+    is_reverse_complement ^= 1;
+  }
+
+  // ambiguous runs clipped to the view, relative to begin on the forward
+  // strand
+  std::vector<AmbiguousRun> AmbiguousRuns() const {
+    return ClipRuns(ambiguous_runs, ambiguous_runs + num_ambiguous_runs);
+  }
+
+  std::vector<LowerCaseRun> LowerCaseRuns() const {
+    return ClipRuns(lower_case_runs, lower_case_runs + num_lower_case_runs);
+  }
+
+  ObjectId id;
+  const char* name;
+  std::uint32_t name_len;
+  const std::uint64_t* deflated_data;
+  const std::int8_t* quality;
+  const PackedQuality* packed_quality;  // (optional) used if quality is nullptr
+  const AmbiguousRun* ambiguous_runs;  // (optional) of the whole source
+  std::uint32_t num_ambiguous_runs;
+  const LowerCaseRun* lower_case_runs;  // (optional) of the whole source
+  std::uint32_t num_lower_case_runs;
+  std::uint32_t begin;  // of the first base on the forward strand
+  std::uint32_t inflated_len;
+  bool is_reverse_complement;
+
+ private:
+  template<typename T>
+  std::vector<T> ClipRuns(const T* first, const T* last) const {
+    std::uint32_t end = begin + inflated_len;
+    std::vector<T> dst;
+    first = std::partition_point(first, last, [&] (const T& run) {
+      return run.begin + run.len <= begin;
+    });
+    for (; first != last && first->begin < end; ++first) {
+      dst.emplace_back(*first);
+      dst.back().begin = std::max(first->begin, begin) - begin;
+      dst.back().len = std::min(first->begin + first->len, end) - begin -
+          dst.back().begin;
+    }
+    return dst;
+  }
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_NUCLEIC_ACID_VIEW_HPP_
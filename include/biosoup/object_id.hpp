@@ -0,0 +1,96 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_OBJECT_ID_HPP_
+#define BIOSOUP_OBJECT_ID_HPP_
+
+#include <cstdint>
+
+namespace biosoup {
+
+// ids of Sequence and NucleicAcid objects, define BIOSOUP_USE_64BIT_IDS for
+// more than 2^32 objects (num_objects then has to be defined as
+// std::atomic<std::uint64_t>)
+#if defined(BIOSOUP_USE_64BIT_IDS)
+using ObjectId = std::uint64_t;
+#else
+using ObjectId = std::uint32_t;
+#endif
+
+namespace detail {
+
+struct IdRange {
+  ObjectId next;
+  ObjectId end;
+};
+
+template<typename T>
+IdRange*& ThreadIdRange() {  // innermost IdScope<T> of the calling thread
+  static thread_local IdRange* range = nullptr;
+  return range;
+}
+
+}  // namespace detail
+
+// reserves n consecutive ids for objects of type T with a single atomic
+// operation on T::num_objects, returns the first one
+template<typename T>
+ObjectId ReserveIds(ObjectId n) {
+  return T::num_objects.fetch_add(n);
+}
+
+// id of a new object of type T, taken from the innermost IdScope<T> of the
+// calling thread while it has ids left, otherwise from T::num_objects
+template<typename T>
+ObjectId NextId() {
+  detail::IdRange* range = detail::ThreadIdRange<T>();
+  if (range && range->next < range->end) {
+    return range->next++;
+  }
+  return T::num_objects++;
+}
+
+// Objects of type T constructed by the calling thread during the lifetime of
+// the scope get ids from [begin, end), without touching the shared counter.
+// Reserving a block per batch keeps ids dense, e.g.
+//   IdScope<Sequence> scope(num_records);  // ids of this batch
+//   for (...) sequences.emplace_back(new Sequence(...));
+template<typename T>
+class IdScope {
+ public:
+  IdScope(ObjectId begin, ObjectId end)
+      : range_{begin, end},
+        previous_(detail::ThreadIdRange<T>()) {
+    detail::ThreadIdRange<T>() = &range_;
+  }
+
+  explicit IdScope(ObjectId n)  // reserves n ids
+      : IdScope(ReserveIds<T>(n), 0) {
+    range_.end = range_.next + n;
+  }
+
+  IdScope(const IdScope&) = delete;
+  IdScope& operator=(const IdScope&) = delete;
+
+  IdScope(IdScope&&) = delete;
+  IdScope& operator=(IdScope&&) = delete;
+
+  ~IdScope() {
+    detail::ThreadIdRange<T>() = previous_;
+  }
+
+  ObjectId next() const {
+    return range_.next;
+  }
+
+  ObjectId end() const {
+    return range_.end;
+  }
+
+ private:
+  detail::IdRange range_;
+  detail::IdRange* previous_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_OBJECT_ID_HPP_
@@ -0,0 +1,372 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_OVERLAP_INDEX_HPP_
+#define BIOSOUP_OVERLAP_INDEX_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "biosoup/detail/parallel.hpp"
+#include "biosoup/overlap.hpp"
+#include "biosoup/overlap_store.hpp"
+
+namespace biosoup {
+
+// Intervals which overlaps span on their reads (both lhs and rhs), grouped by
+// read and kept as implicit augmented interval trees: intervals of a read are
+// sorted by begin and each one at an odd position is the root of the subtree
+// spanning its neighbours, labelled with the maximal end within it. Queries
+// return indices of overlaps in the collection the index was built from.
+class OverlapIndex {
+ public:
+  OverlapIndex()
+      : offsets_(1, 0),
+        intervals_() {}
+
+  explicit OverlapIndex(
+      const OverlapStore& overlaps,
+      std::uint32_t num_threads = std::thread::hardware_concurrency())
+      : OverlapIndex() {
+    Build(
+        overlaps.size(),
+        [&] (std::size_t i, bool is_rhs) -> Interval {
+          return is_rhs ?
+              Interval(overlaps.rhs_begin(i), overlaps.rhs_end(i), i, overlaps.rhs_id(i)) :  // NOLINT
+              Interval(overlaps.lhs_begin(i), overlaps.lhs_end(i), i, overlaps.lhs_id(i));  // NOLINT
+        },
+        num_threads);
+  }
+
+  explicit OverlapIndex(
+      const std::vector<Overlap>& overlaps,
+      std::uint32_t num_threads = std::thread::hardware_concurrency())
+      : OverlapIndex() {
+    Build(
+        overlaps.size(),
+        [&] (std::size_t i, bool is_rhs) -> Interval {
+          const Overlap& o = overlaps[i];
+          return is_rhs ?
+              Interval(o.rhs_begin, o.rhs_end, i, o.rhs_id) :
+              Interval(o.lhs_begin, o.lhs_end, i, o.lhs_id);
+        },
+        num_threads);
+  }
+
+  OverlapIndex(const OverlapIndex&) = default;
+  OverlapIndex& operator=(const OverlapIndex&) = default;
+
+  OverlapIndex(OverlapIndex&&) = default;
+  OverlapIndex& operator=(OverlapIndex&&) = default;
+
+  ~OverlapIndex() = default;
+
+  std::uint32_t num_reads() const {  // largest id + 1
+    return offsets_.size() - 1;
+  }
+
+  std::size_t num_intervals(std::uint32_t id) const {
+    return id < num_reads() ? offsets_[id + 1] - offsets_[id] : 0;
+  }
+
+  // appends overlaps with an interval on read id intersecting [begin, end)
+  void Find(
+      std::uint32_t id, std::uint32_t begin, std::uint32_t end,
+      std::vector<std::uint32_t>* dst) const {
+    if (begin >= end) {
+      return;
+    }
+    Query(id, end, begin, [&] (const Interval& interval) -> void {
+      dst->emplace_back(interval.overlap);
+    });
+  }
+
+  // appends overlaps with an interval on read id containing [begin, end)
+  void FindContaining(
+      std::uint32_t id, std::uint32_t begin, std::uint32_t end,
+      std::vector<std::uint32_t>* dst) const {
+    Query(id, begin + 1ULL, end ? end - 1ULL : 0, [&] (const Interval& interval) -> void {  // NOLINT
+      dst->emplace_back(interval.overlap);
+    });
+  }
+
+  // whether an overlap covers read id of length len up to tolerance bases on
+  // each side (a self overlap of the read counts as well)
+  bool IsContained(
+      std::uint32_t id, std::uint32_t len,
+      std::uint32_t tolerance = 0) const {
+    bool is_contained = false;
+    std::uint32_t end = len > tolerance ? len - tolerance : 0;
+    Query(id, tolerance + 1ULL, end ? end - 1ULL : 0, [&] (const Interval&) -> void {  // NOLINT
+      is_contained = true;
+    });
+    return is_contained;
+  }
+
+  // ids of contained reads, len(id) gives read lengths
+  template<typename L>
+  std::vector<std::uint32_t> ContainedReads(
+      L len,
+      std::uint32_t tolerance = 0,
+      std::uint32_t num_threads = std::thread::hardware_concurrency()) const {
+    std::vector<std::uint8_t> is_contained(num_reads(), 0);
+    detail::ParallelFor(
+        (num_reads() + kBlockSize - 1) / kBlockSize,
+        num_threads,
+        [&] (std::size_t block) -> void {
+          std::uint32_t last = std::min<std::uint64_t>(
+              num_reads(), (block + 1) * kBlockSize);
+          for (std::uint32_t i = block * kBlockSize; i < last; ++i) {
+            is_contained[i] = num_intervals(i) && IsContained(i, len(i), tolerance);  // NOLINT
+          }
+        });
+    std::vector<std::uint32_t> dst;
+    for (std::uint32_t i = 0; i < num_reads(); ++i) {
+      if (is_contained[i]) {
+        dst.emplace_back(i);
+      }
+    }
+    return dst;
+  }
+
+  // per-base depth of [begin, end) of read id, dst[i] is the number of
+  // intervals covering position begin + i
+  std::vector<std::uint32_t> Coverage(
+      std::uint32_t id, std::uint32_t begin, std::uint32_t end) const {
+    if (begin >= end) {
+      return std::vector<std::uint32_t>();
+    }
+    std::vector<std::int64_t> deltas(end - begin + 1, 0);
+    Query(id, end, begin, [&] (const Interval& interval) -> void {
+      ++deltas[std::max(interval.begin, begin) - begin];
+      --deltas[std::min(interval.end, end) - begin];
+    });
+    std::vector<std::uint32_t> dst(deltas.size() - 1);
+    std::int64_t depth = 0;
+    for (std::size_t i = 0; i < dst.size(); ++i) {
+      dst[i] = depth += deltas[i];
+    }
+    return dst;
+  }
+
+ private:
+  enum : std::uint32_t {
+    kBlockSize = 1U << 10,  // reads processed per task
+    kOverlapBlockSize = 1U << 16,  // overlaps processed per task
+    kNumBuckets = 256  // of consecutive reads, filled in parallel
+  };
+
+  struct Interval {
+    Interval() = default;
+
+    Interval(
+        std::uint32_t begin, std::uint32_t end,
+        std::uint32_t overlap,
+        std::uint32_t max_end)  // read id during construction
+        : begin(begin),
+          end(end),
+          max_end(max_end),
+          overlap(overlap) {}
+
+    std::uint32_t begin;
+    std::uint32_t end;
+    std::uint32_t max_end;  // within the subtree
+    std::uint32_t overlap;
+  };
+
+  template<typename F>
+  void Build(std::size_t num_overlaps, F interval, std::uint32_t num_threads) {
+    if (num_overlaps > UINT32_MAX) {
+      throw std::length_error(
+          "[biosoup::OverlapIndex::OverlapIndex] error: too many overlaps");
+    }
+    std::size_t num_blocks =
+        (num_overlaps + kOverlapBlockSize - 1) / kOverlapBlockSize;
+    auto for_each_block = [&] (std::function<void(std::size_t, std::size_t, std::size_t)> f) -> void {  // NOLINT
+      detail::ParallelFor(num_blocks, num_threads, [&] (std::size_t block) -> void {  // NOLINT
+        f(block,
+          block * kOverlapBlockSize,
+          std::min<std::size_t>((block + 1) * kOverlapBlockSize, num_overlaps));  // NOLINT
+      });
+    };
+
+    std::vector<std::uint64_t> max_ids(num_blocks, 0);
+    for_each_block([&] (std::size_t block, std::size_t first, std::size_t last) -> void {  // NOLINT
+      std::uint64_t max_id = 0;
+      for (std::size_t i = first; i < last; ++i) {
+        for (bool is_rhs : {false, true}) {
+          max_id = std::max<std::uint64_t>(
+              max_id, interval(i, is_rhs).max_end + 1ULL);
+        }
+      }
+      max_ids[block] = max_id;
+    });
+    std::uint64_t num_reads = 0;
+    for (const auto& it : max_ids) {
+      num_reads = std::max(num_reads, it);
+    }
+    if (num_reads > UINT32_MAX) {  // num_reads() would wrap
+      throw std::length_error(
+          "[biosoup::OverlapIndex::OverlapIndex] error: too many reads");
+    }
+
+    // intervals are scattered into buckets of consecutive reads by each block
+    // (at positions given by prefix sums of per-block counts), and each
+    // bucket is then sorted into place on its own
+    std::uint32_t shift = 0;
+    while (num_reads && ((num_reads - 1) >> shift) >= kNumBuckets) {
+      ++shift;
+    }
+    std::vector<std::uint64_t> positions(num_blocks * kNumBuckets, 0);
+    for_each_block([&] (std::size_t block, std::size_t first, std::size_t last) -> void {  // NOLINT
+      std::uint64_t* counts = &positions[block * kNumBuckets];
+      for (std::size_t i = first; i < last; ++i) {
+        for (bool is_rhs : {false, true}) {
+          ++counts[interval(i, is_rhs).max_end >> shift];
+        }
+      }
+    });
+    std::vector<std::uint64_t> buckets(kNumBuckets + 1, 0);
+    for (std::uint32_t j = 0; j < kNumBuckets; ++j) {
+      buckets[j + 1] = buckets[j];
+      for (std::size_t block = 0; block < num_blocks; ++block) {
+        std::uint64_t n = positions[block * kNumBuckets + j];
+        positions[block * kNumBuckets + j] = buckets[j + 1];
+        buckets[j + 1] += n;
+      }
+    }
+    intervals_.resize(buckets.back());
+    for_each_block([&] (std::size_t block, std::size_t first, std::size_t last) -> void {  // NOLINT
+      std::uint64_t* next = &positions[block * kNumBuckets];
+      for (std::size_t i = first; i < last; ++i) {
+        for (bool is_rhs : {false, true}) {
+          Interval it = interval(i, is_rhs);
+          intervals_[next[it.max_end >> shift]++] = it;
+        }
+      }
+    });
+    std::vector<std::uint64_t>().swap(positions);
+
+    // buckets keep the order of overlaps, so intervals with equal begin stay
+    // in it as well
+    offsets_.assign(num_reads + 1, 0);
+    detail::ParallelFor(kNumBuckets, num_threads, [&] (std::size_t j) -> void {
+      std::uint64_t first = std::min<std::uint64_t>(j << shift, num_reads);
+      std::uint64_t last = std::min<std::uint64_t>((j + 1) << shift, num_reads);  // NOLINT
+      if (first == last) {
+        return;
+      }
+      std::stable_sort(
+          intervals_.begin() + buckets[j],
+          intervals_.begin() + buckets[j + 1],
+          [] (const Interval& lhs, const Interval& rhs) -> bool {
+            return lhs.max_end < rhs.max_end ||
+                (lhs.max_end == rhs.max_end && lhs.begin < rhs.begin);
+          });
+      for (std::uint64_t k = buckets[j]; k < buckets[j + 1]; ++k) {
+        ++offsets_[intervals_[k].max_end + 1ULL];
+      }
+      offsets_[first + 1] += buckets[j];
+      for (std::uint64_t i = first + 1; i < last; ++i) {
+        offsets_[i + 1] += offsets_[i];
+      }
+      // offsets_[first] is written by j - 1, buckets[j] holds the same value
+      for (std::uint64_t i = first; i < last; ++i) {
+        std::uint64_t begin = i == first ? buckets[j] : offsets_[i];
+        Augment(intervals_.data() + begin, offsets_[i + 1] - begin);
+      }
+    });
+  }
+
+  static std::uint32_t MaxLevel(std::size_t n) {
+    std::uint32_t level = 0;
+    while ((2ULL << level) <= n) {
+      ++level;
+    }
+    return level;
+  }
+
+  // labels each subtree root with the maximal end within the subtree,
+  // nodes missing from the right of the last complete subtree are treated
+  // as the rightmost existing one
+  static void Augment(Interval* intervals, std::size_t n) {
+    if (n == 0) {
+      return;
+    }
+    std::size_t last_i = 0;
+    std::uint32_t last = 0;
+    for (std::size_t i = 0; i < n; i += 2) {
+      last_i = i;
+      last = intervals[i].max_end = intervals[i].end;
+    }
+    for (std::uint32_t k = 1; (1ULL << k) <= n; ++k) {
+      std::size_t x = 1ULL << (k - 1);
+      for (std::size_t i = (x << 1) - 1; i < n; i += x << 2) {
+        std::uint32_t lhs = intervals[i - x].max_end;
+        std::uint32_t rhs = i + x < n ? intervals[i + x].max_end : last;
+        intervals[i].max_end = std::max(intervals[i].end, std::max(lhs, rhs));  // NOLINT
+      }
+      last_i = (last_i >> k & 1) ? last_i - x : last_i + x;
+      if (last_i < n) {
+        last = std::max(last, intervals[last_i].max_end);
+      }
+    }
+  }
+
+  // calls f for intervals of read id with begin < begin_below and
+  // end > end_above, in order of begin
+  template<typename F>
+  void Query(
+      std::uint32_t id,
+      std::uint64_t begin_below,
+      std::uint64_t end_above,
+      F f) const {
+    if (id >= num_reads() || offsets_[id] == offsets_[id + 1]) {
+      return;
+    }
+    const Interval* intervals = intervals_.data() + offsets_[id];
+    std::size_t n = offsets_[id + 1] - offsets_[id];
+
+    struct Node {
+      std::size_t x;
+      std::uint32_t k;
+      bool is_visited;
+    } stack[64];
+    std::uint32_t level = MaxLevel(n);
+    std::uint32_t size = 0;
+    stack[size++] = {(1ULL << level) - 1, level, false};
+    while (size) {
+      Node z = stack[--size];
+      if (z.k <= 3) {  // small subtrees are scanned
+        std::size_t i = z.x >> z.k << z.k;
+        std::size_t e = std::min<std::size_t>(n, i + (2ULL << z.k) - 1);
+        for (; i < e && intervals[i].begin < begin_below; ++i) {
+          if (intervals[i].end > end_above) {
+            f(intervals[i]);
+          }
+        }
+      } else if (!z.is_visited) {
+        std::size_t y = z.x - (1ULL << (z.k - 1));  // left child
+        stack[size++] = {z.x, z.k, true};
+        if (y >= n || intervals[y].max_end > end_above) {
+          stack[size++] = {y, z.k - 1, false};
+        }
+      } else if (z.x < n && intervals[z.x].begin < begin_below) {
+        if (intervals[z.x].end > end_above) {
+          f(intervals[z.x]);
+        }
+        stack[size++] = {z.x + (1ULL << (z.k - 1)), z.k - 1, false};
+      }
+    }
+  }
+
+  std::vector<std::uint64_t> offsets_;  // intervals of read i start here
+  std::vector<Interval> intervals_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_OVERLAP_INDEX_HPP_
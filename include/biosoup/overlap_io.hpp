@@ -0,0 +1,727 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_OVERLAP_IO_HPP_
+#define BIOSOUP_OVERLAP_IO_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "biosoup/cigar.hpp"
+#include "biosoup/detail/chunk_pipeline.hpp"
+#include "biosoup/detail/parallel.hpp"
+#include "biosoup/io.hpp"
+#include "biosoup/overlap_store.hpp"
+#include "biosoup/parser.hpp"
+
+namespace biosoup {
+
+namespace detail {
+
+using Field = std::pair<const char*, const char*>;
+
+// Splits a line at delimiter into at most max_fields fields, the last of
+// which holds the rest of the line. Returns the number of fields.
+inline std::size_t SplitLine(
+    const char* begin, const char* end,
+    char delimiter,
+    Field* fields, std::size_t max_fields) {
+  std::size_t n = 0;
+  while (n + 1 < max_fields) {
+    const char* e = static_cast<const char*>(
+        std::memchr(begin, delimiter, end - begin));
+    if (e == nullptr) {
+      break;
+    }
+    fields[n++] = Field(begin, e);
+    begin = e + 1;
+  }
+  fields[n++] = Field(begin, end);
+  return n;
+}
+
+inline std::uint32_t FieldToUint(const Field& field, const char* format) {
+  std::uint64_t x = 0;
+  const char* p = field.first;
+  for (; p < field.second && *p >= '0' && *p <= '9' && x <= UINT32_MAX; ++p) {
+    x = x * 10 + (*p - '0');
+  }
+  if (p == field.first || p != field.second || x > UINT32_MAX) {
+    throw std::invalid_argument(
+        "[biosoup::OverlapParser] error: invalid " + std::string(format) +
+        " field " + std::string(field.first, field.second));
+  }
+  return x;
+}
+
+inline void AppendUint(std::uint64_t x, std::string* dst) {
+  char buffer[20];
+  int n = 0;
+  do {
+    buffer[n++] = '0' + x % 10;
+    x /= 10;
+  } while (x);
+  while (n) {
+    dst->push_back(buffer[--n]);
+  }
+}
+
+// Formats [0, n) in blocks on num_threads threads with format(begin, end,
+// dst) and writes them in order.
+template<typename F>
+void WriteBlocks(
+    std::size_t n,
+    F format,
+    const WriteFunction& write,
+    std::uint32_t num_threads) {
+  const std::size_t kBlockSize = 1U << 14;
+  std::vector<std::string> blocks(2 * std::max(num_threads, 1U));
+  for (std::size_t i = 0; i < n; i += blocks.size() * kBlockSize) {
+    std::size_t num_blocks = std::min(
+        blocks.size(),
+        (n - i + kBlockSize - 1) / kBlockSize);
+    ParallelFor(num_blocks, num_threads, [&] (std::size_t j) -> void {
+      std::size_t begin = i + j * kBlockSize;
+      blocks[j].clear();
+      format(begin, std::min(n, begin + kBlockSize), &blocks[j]);
+    });
+    for (std::size_t j = 0; j < num_blocks; ++j) {
+      write(blocks[j].data(), blocks[j].size());
+    }
+  }
+}
+
+}  // namespace detail
+
+// Parses PAF or MHAP (detected from the first line, PAF is tab separated)
+// into OverlapStore batches, lines are parsed in parallel as in Parser.
+// PAF query and target names are mapped to lhs and rhs ids with id (which is
+// called from multiple threads) or read as decimal ids if it is empty; the
+// score is the number of residue matches, the CIGAR is taken from the cg:Z:
+// tag. MHAP ids are 1-based, the score is the number of shared minimizers.
+class OverlapParser {
+ public:
+  using IdFunction =
+      std::function<std::uint32_t(const char* name, std::uint32_t name_len)>;
+
+  explicit OverlapParser(
+      ReadFunction read,
+      IdFunction id = nullptr,
+      std::uint32_t num_threads = std::thread::hardware_concurrency(),
+      std::size_t chunk_size = 1U << 22,
+      std::size_t max_chunks = 0)  // 0 for 2 * num_threads + 2
+      : format_(kUnknown),
+        id_(std::move(id)),
+        pipeline_(
+            std::move(read),
+            [this] (const std::string& data, std::size_t begin, bool) -> std::size_t {  // NOLINT
+              return Split(data, begin);
+            },
+            [this] (const char* begin, const char* end, OverlapStore* dst) -> void {  // NOLINT
+              Convert(begin, end, dst);
+            },
+            num_threads,
+            chunk_size,
+            max_chunks) {}
+
+  OverlapParser(const OverlapParser&) = delete;
+  OverlapParser& operator=(const OverlapParser&) = delete;
+
+  OverlapParser(OverlapParser&&) = delete;
+  OverlapParser& operator=(OverlapParser&&) = delete;
+
+  ~OverlapParser() = default;
+
+  // returns whole chunks until at least bytes of input are consumed,
+  // empty once the input is exhausted
+  OverlapStore Parse(std::uint64_t bytes = -1) {
+    OverlapStore dst;
+    OverlapStore overlaps;
+    for (std::uint64_t num_bytes = 0, n; num_bytes < bytes; num_bytes += n) {
+      if (!pipeline_.Next(&overlaps, &n)) {
+        break;
+      }
+      if (dst.empty()) {
+        std::swap(dst, overlaps);
+      } else {
+        dst.Append(overlaps);
+      }
+    }
+    return dst;
+  }
+
+ private:
+  enum Format {
+    kUnknown,
+    kPaf,
+    kMhap
+  };
+
+  // position after the last complete line at or after begin, 0 if there is
+  // none
+  std::size_t Split(const std::string& data, std::size_t begin) {
+    if (format_ == kUnknown) {
+      const char* p = detail::SkipSpace(data.data(), data.data() + data.size());  // NOLINT
+      const char* e = static_cast<const char*>(
+          std::memchr(p, '\n', data.data() + data.size() - p));
+      if (e == nullptr) {
+        return 0;
+      }
+      format_ = std::memchr(p, '\t', e - p) ? kPaf : kMhap;
+    }
+    for (std::size_t i = data.size(); i > begin; --i) {
+      if (data[i - 1] == '\n') {
+        return i;
+      }
+    }
+    return 0;
+  }
+
+  void Convert(const char* begin, const char* end, OverlapStore* dst) const {
+    std::vector<std::uint32_t> cigar;
+    detail::Field fields[13];
+    while (begin < end) {
+      const char* e = static_cast<const char*>(
+          std::memchr(begin, '\n', end - begin));
+      const char* line_end = detail::RightStrip(begin, e);
+      begin = detail::SkipSpace(begin, line_end);
+      if (begin == line_end) {
+        begin = e + 1;
+        continue;
+      }
+      if (format_ == kPaf) {
+        std::size_t num_fields =
+            detail::SplitLine(begin, line_end, '\t', fields, 13);
+        if (num_fields < 12) {
+          throw std::invalid_argument(
+              "[biosoup::OverlapParser] error: invalid PAF line " +
+              std::string(begin, line_end));
+        }
+        cigar.clear();
+        for (const char* p = num_fields == 13 ? fields[12].first : line_end;
+            p < line_end;) {
+          const char* tag_end = static_cast<const char*>(
+              std::memchr(p, '\t', line_end - p));
+          tag_end = tag_end ? tag_end : line_end;
+          if (tag_end - p > 5 && std::memcmp(p, "cg:Z:", 5) == 0) {
+            EncodeCigar(p + 5, tag_end - p - 5, &cigar);
+            break;
+          }
+          p = tag_end + 1;
+        }
+        dst->Append(
+            Id(fields[0]),
+            detail::FieldToUint(fields[2], "PAF"),
+            detail::FieldToUint(fields[3], "PAF"),
+            Id(fields[5]),
+            detail::FieldToUint(fields[7], "PAF"),
+            detail::FieldToUint(fields[8], "PAF"),
+            detail::FieldToUint(fields[9], "PAF"),
+            *fields[4].first == '+',
+            cigar.data(), cigar.size());
+      } else {
+        if (detail::SplitLine(begin, line_end, ' ', fields, 13) != 12) {
+          throw std::invalid_argument(
+              "[biosoup::OverlapParser] error: invalid MHAP line " +
+              std::string(begin, line_end));
+        }
+        std::uint32_t lhs_id = detail::FieldToUint(fields[0], "MHAP");
+        std::uint32_t rhs_id = detail::FieldToUint(fields[1], "MHAP");
+        if (lhs_id == 0 || rhs_id == 0) {
+          throw std::invalid_argument(
+              "[biosoup::OverlapParser] error: MHAP ids are 1-based");
+        }
+        dst->Append(
+            lhs_id - 1,
+            detail::FieldToUint(fields[5], "MHAP"),
+            detail::FieldToUint(fields[6], "MHAP"),
+            rhs_id - 1,
+            detail::FieldToUint(fields[9], "MHAP"),
+            detail::FieldToUint(fields[10], "MHAP"),
+            detail::FieldToUint(fields[3], "MHAP"),
+            detail::FieldToUint(fields[4], "MHAP") ==
+                detail::FieldToUint(fields[8], "MHAP"));
+      }
+      begin = e + 1;
+    }
+  }
+
+  std::uint32_t Id(const detail::Field& name) const {
+    return id_ ?
+        id_(name.first, name.second - name.first) :
+        detail::FieldToUint(name, "PAF");
+  }
+
+  Format format_;  // set by the reader before the first chunk is converted
+  IdFunction id_;
+  detail::ChunkPipeline<OverlapStore> pipeline_;  // last, its threads use the rest  // NOLINT
+};
+
+// Writes overlaps as PAF, formatted in parallel. Names and lengths of
+// sequences are given by name(id) (std::string or const char*) and
+// length(id). The alignment block length is taken from the CIGAR if there is
+// one (which is written as a cg:Z: tag), otherwise it is the longer span.
+template<typename N, typename L>
+void WritePaf(
+    const OverlapStore& overlaps,
+    N name,
+    L length,
+    const WriteFunction& write,
+    std::uint32_t num_threads = std::thread::hardware_concurrency()) {
+  detail::WriteBlocks(
+      overlaps.size(),
+      [&] (std::size_t begin, std::size_t end, std::string* dst) -> void {
+        for (std::size_t i = begin; i < end; ++i) {
+          const std::uint32_t* cigar = overlaps.cigar(i);
+          std::uint32_t cigar_len = overlaps.cigar_len(i);
+          std::uint64_t block_len = 0;
+          for (std::uint32_t j = 0; j < cigar_len; ++j) {
+            if ((0x187U >> CigarOp(cigar[j])) & 1) {  // M, I, D, =, X
+              block_len += CigarLength(cigar[j]);
+            }
+          }
+          if (cigar_len == 0) {
+            block_len = std::max(
+                overlaps.lhs_end(i) - overlaps.lhs_begin(i),
+                overlaps.rhs_end(i) - overlaps.rhs_begin(i));
+          }
+
+          dst->append(name(overlaps.lhs_id(i)));
+          dst->push_back('\t');
+          detail::AppendUint(length(overlaps.lhs_id(i)), dst);
+          dst->push_back('\t');
+          detail::AppendUint(overlaps.lhs_begin(i), dst);
+          dst->push_back('\t');
+          detail::AppendUint(overlaps.lhs_end(i), dst);
+          dst->push_back('\t');
+          dst->push_back(overlaps.strand(i) ? '+' : '-');
+          dst->push_back('\t');
+          dst->append(name(overlaps.rhs_id(i)));
+          dst->push_back('\t');
+          detail::AppendUint(length(overlaps.rhs_id(i)), dst);
+          dst->push_back('\t');
+          detail::AppendUint(overlaps.rhs_begin(i), dst);
+          dst->push_back('\t');
+          detail::AppendUint(overlaps.rhs_end(i), dst);
+          dst->push_back('\t');
+          detail::AppendUint(overlaps.score(i), dst);
+          dst->push_back('\t');
+          detail::AppendUint(block_len, dst);
+          dst->append("\t255");
+          if (cigar_len) {
+            dst->append("\tcg:Z:");
+            for (std::uint32_t j = 0; j < cigar_len; ++j) {
+              detail::AppendUint(CigarLength(cigar[j]), dst);
+              dst->push_back(CigarOperations()[std::min<std::uint32_t>(CigarOp(cigar[j]), 8)]);  // NOLINT
+            }
+          }
+          dst->push_back('\n');
+        }
+      },
+      write,
+      num_threads);
+}
+
+// Writes overlaps as MHAP with 1-based ids. The Jaccard estimate is not
+// stored, its field is written as 0, and the lhs is always forward.
+template<typename L>
+void WriteMhap(
+    const OverlapStore& overlaps,
+    L length,
+    const WriteFunction& write,
+    std::uint32_t num_threads = std::thread::hardware_concurrency()) {
+  detail::WriteBlocks(
+      overlaps.size(),
+      [&] (std::size_t begin, std::size_t end, std::string* dst) -> void {
+        for (std::size_t i = begin; i < end; ++i) {
+          detail::AppendUint(overlaps.lhs_id(i) + 1ULL, dst);
+          dst->push_back(' ');
+          detail::AppendUint(overlaps.rhs_id(i) + 1ULL, dst);
+          dst->append(" 0 ");
+          detail::AppendUint(overlaps.score(i), dst);
+          dst->append(" 0 ");
+          detail::AppendUint(overlaps.lhs_begin(i), dst);
+          dst->push_back(' ');
+          detail::AppendUint(overlaps.lhs_end(i), dst);
+          dst->push_back(' ');
+          detail::AppendUint(length(overlaps.lhs_id(i)), dst);
+          dst->append(overlaps.strand(i) ? " 0 " : " 1 ");
+          detail::AppendUint(overlaps.rhs_begin(i), dst);
+          dst->push_back(' ');
+          detail::AppendUint(overlaps.rhs_end(i), dst);
+          dst->push_back(' ');
+          detail::AppendUint(length(overlaps.rhs_id(i)), dst);
+          dst->push_back('\n');
+        }
+      },
+      write,
+      num_threads);
+}
+
+// External memory sort of overlaps by (lhs_id, lhs_begin) or (rhs_id,
+// rhs_begin), stable with respect to the order of Add calls. Overlaps are
+// buffered until about half of memory_limit is used, after which the buffer
+// is split into num_threads parts which are sorted in parallel and spilled
+// to binary run files in tmp_dir. Next merges the runs (or the sorted parts
+// if nothing was spilled) and returns sorted batches. At most kMaxFanIn runs
+// are read at once, more are first merged in passes over groups of
+// consecutive runs, and the blocks read from runs share half of
+// memory_limit.
+//
+// Runs start with the magic "BSORUN01" and hold overlaps as 8 native 32-bit
+// words (lhs id, begin, end, rhs id, begin, end, score with the strand in the
+// top bit, CIGAR length) followed by the binary CIGAR.
+class OverlapSorter {
+ public:
+  enum Key {
+    kLhs,
+    kRhs
+  };
+
+  enum : std::uint32_t {
+    kMaxFanIn = 64
+  };
+
+  explicit OverlapSorter(
+      Key key = kLhs,
+      std::uint64_t memory_limit = 1ULL << 32,
+      const std::string& tmp_dir = ".",
+      std::uint32_t num_threads = std::thread::hardware_concurrency())
+      : key_(key),
+        memory_limit_(memory_limit),
+        tmp_dir_(tmp_dir),
+        num_threads_(std::max(num_threads, 1U)),
+        prefix_(),
+        buffer_(),
+        num_run_files_(0),
+        runs_(),
+        sources_(),
+        heap_(),
+        is_merging_(false) {
+    prefix_ = detail::TemporaryPrefix(tmp_dir_, "overlaps");
+  }
+
+  OverlapSorter(const OverlapSorter&) = delete;
+  OverlapSorter& operator=(const OverlapSorter&) = delete;
+
+  OverlapSorter(OverlapSorter&&) = delete;
+  OverlapSorter& operator=(OverlapSorter&&) = delete;
+
+  ~OverlapSorter() {
+    sources_.clear();
+    for (const auto& it : runs_) {
+      std::remove(it.c_str());
+    }
+  }
+
+  std::size_t num_runs() const {
+    return runs_.size();
+  }
+
+  void Add(const OverlapStore& overlaps) {
+    if (is_merging_) {
+      throw std::logic_error(
+          "[biosoup::OverlapSorter::Add] error: merge already started");
+    }
+    buffer_.Append(overlaps);
+    if (buffer_.memory_usage() >= memory_limit_ / 2) {
+      Spill();
+    }
+  }
+
+  // returns up to num_overlaps next overlaps, empty once all are returned
+  OverlapStore Next(std::size_t num_overlaps = 1U << 20) {
+    if (!is_merging_) {
+      Merge();
+    }
+    OverlapStore dst;
+    while (dst.size() < num_overlaps && !heap_.empty()) {
+      std::size_t i = Pop(&heap_);
+      dst.Append(sources_[i].block, sources_[i].pos, sources_[i].pos + 1);
+      Push(&sources_, i, &heap_);
+    }
+    return dst;
+  }
+
+ private:
+  using Head = std::pair<std::uint64_t, std::size_t>;  // key, source
+
+  // overlaps per read block, with memory per overlap estimated at 64 bytes
+  // in the block and 32 bytes in the read buffer
+  static std::size_t BlockSize(std::uint64_t memory_limit, std::size_t n) {
+    return std::max<std::uint64_t>(1U << 10, memory_limit / (2 * 96 * n));
+  }
+
+  // sorted part of the buffer, or a run read in blocks
+  struct Source {
+    Source(Key key, OverlapStore part)
+        : sort_key(key),
+          block(std::move(part)),
+          pos(0),
+          read(),
+          block_size(0),
+          data_size(0),
+          data(),
+          data_pos(0) {}
+
+    Source(Key key, ReadFunction run, std::size_t run_block_size)
+        : sort_key(key),
+          block(),
+          pos(0),
+          read(std::move(run)),
+          block_size(run_block_size),
+          data_size(run_block_size * 8 * sizeof(std::uint32_t)),
+          data(),
+          data_pos(0) {
+      char magic[8];
+      if (!ReadBytes(magic, 8) || std::memcmp(magic, "BSORUN01", 8) != 0) {
+        throw std::runtime_error(
+            "[biosoup::OverlapSorter] error: invalid run file");
+      }
+      Fill();
+    }
+
+    std::uint64_t key() const {
+      return sort_key == kLhs ?
+          static_cast<std::uint64_t>(block.lhs_id(pos)) << 32 | block.lhs_begin(pos) :  // NOLINT
+          static_cast<std::uint64_t>(block.rhs_id(pos)) << 32 | block.rhs_begin(pos);  // NOLINT
+    }
+
+    bool empty() const {
+      return pos == block.size();
+    }
+
+    bool Advance() {
+      if (++pos == block.size() && read) {
+        Fill();
+      }
+      return !empty();
+    }
+
+    void Fill() {
+      block.Clear();
+      pos = 0;
+      std::uint32_t words[8];
+      std::vector<std::uint32_t> cigar;
+      while (block.size() < block_size && ReadBytes(words, sizeof(words))) {
+        cigar.resize(words[7]);
+        if (!ReadBytes(cigar.data(), cigar.size() * sizeof(std::uint32_t)) &&
+            !cigar.empty()) {
+          throw std::runtime_error(
+              "[biosoup::OverlapSorter] error: truncated run file");
+        }
+        block.Append(
+            words[0], words[1], words[2],
+            words[3], words[4], words[5],
+            words[6] & 0x7FFFFFFF,
+            words[6] >> 31,
+            cigar.data(), cigar.size());
+      }
+    }
+
+    // false at the end of the run
+    bool ReadBytes(void* dst, std::size_t len) {
+      char* p = static_cast<char*>(dst);
+      while (len) {
+        if (data_pos == data.size()) {
+          data.resize(data_size);
+          data.resize(read(&data[0], data.size()));
+          data_pos = 0;
+          if (data.empty()) {
+            if (p != dst) {
+              throw std::runtime_error(
+                  "[biosoup::OverlapSorter] error: truncated run file");
+            }
+            return false;
+          }
+        }
+        std::size_t n = std::min(len, data.size() - data_pos);
+        std::memcpy(p, data.data() + data_pos, n);
+        data_pos += n;
+        p += n;
+        len -= n;
+      }
+      return true;
+    }
+
+    Key sort_key;
+    OverlapStore block;
+    std::size_t pos;
+    ReadFunction read;
+    std::size_t block_size;
+    std::size_t data_size;  // of reads from the run
+    std::string data;
+    std::size_t data_pos;
+  };
+
+  std::vector<OverlapStore> SortParts() {
+    std::size_t num_parts = std::min<std::size_t>(
+        num_threads_,
+        (buffer_.size() + (1U << 16) - 1) >> 16);
+    std::vector<OverlapStore> parts(num_parts);
+    detail::ParallelFor(num_parts, num_threads_, [&] (std::size_t i) -> void {
+      parts[i].Append(
+          buffer_,
+          buffer_.size() * i / num_parts,
+          buffer_.size() * (i + 1) / num_parts);
+      if (key_ == kLhs) {
+        parts[i].SortByLhs();
+      } else {
+        parts[i].SortByRhs();
+      }
+    });
+    buffer_.Clear();
+    return parts;
+  }
+
+  // index of the source with the smallest key, its overlap has to be taken
+  // before it is pushed back
+  static std::size_t Pop(std::vector<Head>* heap) {
+    std::pop_heap(heap->begin(), heap->end(), std::greater<Head>());
+    std::size_t dst = heap->back().second;
+    heap->pop_back();
+    return dst;
+  }
+
+  static void Push(
+      std::vector<Source>* sources, std::size_t i,
+      std::vector<Head>* heap) {
+    if ((*sources)[i].Advance()) {
+      heap->emplace_back((*sources)[i].key(), i);
+      std::push_heap(heap->begin(), heap->end(), std::greater<Head>());
+    }
+  }
+
+  static std::vector<Head> Heap(const std::vector<Source>& sources) {
+    std::vector<Head> dst;
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+      if (!sources[i].empty()) {
+        dst.emplace_back(sources[i].key(), i);
+      }
+    }
+    std::make_heap(dst.begin(), dst.end(), std::greater<Head>());
+    return dst;
+  }
+
+  static void AppendRecord(
+      const OverlapStore& overlaps, std::size_t i,
+      std::string* dst) {
+    std::uint32_t words[8] = {
+        overlaps.lhs_id(i), overlaps.lhs_begin(i), overlaps.lhs_end(i),
+        overlaps.rhs_id(i), overlaps.rhs_begin(i), overlaps.rhs_end(i),
+        overlaps.score(i) | static_cast<std::uint32_t>(overlaps.strand(i)) << 31,  // NOLINT
+        overlaps.cigar_len(i)};
+    dst->append(reinterpret_cast<const char*>(words), sizeof(words));
+    dst->append(
+        reinterpret_cast<const char*>(overlaps.cigar(i)),
+        overlaps.cigar_len(i) * sizeof(std::uint32_t));
+  }
+
+  std::string NextRunPath() {
+    return prefix_ + std::to_string(num_run_files_++) + ".bin";
+  }
+
+  void Spill() {
+    std::vector<OverlapStore> parts = SortParts();
+    std::size_t first = runs_.size();
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+      runs_.emplace_back(NextRunPath());
+    }
+    detail::ParallelFor(parts.size(), num_threads_, [&] (std::size_t i) -> void {  // NOLINT
+      FileWriter file{runs_[first + i]};
+      const OverlapStore& part = parts[i];
+      std::string data("BSORUN01");
+      for (std::size_t j = 0; j < part.size(); ++j) {
+        AppendRecord(part, j, &data);
+        if (data.size() >= (1U << 20)) {
+          file.Write(data.data(), data.size());
+          data.clear();
+        }
+      }
+      file.Write(data.data(), data.size());
+      file.Close();
+    });
+  }
+
+  // merges runs [first, last) into one, which keeps their order on ties
+  std::string MergeRuns(std::size_t first, std::size_t last) {
+    std::size_t block_size = BlockSize(memory_limit_, last - first + 1);
+    std::vector<Source> sources;
+    sources.reserve(last - first);
+    for (std::size_t i = first; i < last; ++i) {
+      sources.emplace_back(key_, ReadFile(runs_[i]), block_size);
+    }
+    std::vector<Head> heap = Heap(sources);
+
+    std::string dst = NextRunPath();
+    FileWriter file{dst};
+    std::string data("BSORUN01");
+    while (!heap.empty()) {
+      std::size_t i = Pop(&heap);
+      AppendRecord(sources[i].block, sources[i].pos, &data);
+      Push(&sources, i, &heap);
+      if (data.size() >= block_size * 8 * sizeof(std::uint32_t)) {
+        file.Write(data.data(), data.size());
+        data.clear();
+      }
+    }
+    file.Write(data.data(), data.size());
+    file.Close();
+
+    sources.clear();
+    for (std::size_t i = first; i < last; ++i) {
+      std::remove(runs_[i].c_str());
+    }
+    return dst;
+  }
+
+  void Merge() {
+    is_merging_ = true;
+    if (runs_.empty()) {
+      for (auto& it : SortParts()) {
+        sources_.emplace_back(key_, std::move(it));
+      }
+    } else {
+      if (!buffer_.empty()) {
+        Spill();
+      }
+      while (runs_.size() > kMaxFanIn) {  // merged runs are appended
+        std::size_t num_runs = runs_.size();
+        for (std::size_t i = 0; i < num_runs; i += kMaxFanIn) {
+          std::size_t last = std::min<std::size_t>(num_runs, i + kMaxFanIn);
+          runs_.emplace_back(last - i > 1 ? MergeRuns(i, last) : runs_[i]);
+        }
+        runs_.erase(runs_.begin(), runs_.begin() + num_runs);
+      }
+      std::size_t block_size = BlockSize(memory_limit_, runs_.size());
+      sources_.reserve(runs_.size());
+      for (const auto& it : runs_) {
+        sources_.emplace_back(key_, ReadFile(it), block_size);
+      }
+    }
+    heap_ = Heap(sources_);
+  }
+
+  Key key_;
+  std::uint64_t memory_limit_;
+  std::string tmp_dir_;
+  std::uint32_t num_threads_;
+  std::string prefix_;  // of run files
+  OverlapStore buffer_;
+  std::size_t num_run_files_;  // numbers run file names
+  std::vector<std::string> runs_;
+  std::vector<Source> sources_;  // in input order
+  std::vector<Head> heap_;  // min-heap, ties are broken by input order
+  bool is_merging_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_OVERLAP_IO_HPP_
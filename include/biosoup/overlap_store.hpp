@@ -0,0 +1,322 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_OVERLAP_STORE_HPP_
+#define BIOSOUP_OVERLAP_STORE_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "biosoup/cigar.hpp"
+#include "biosoup/overlap.hpp"
+
+namespace biosoup {
+
+namespace detail {
+
+// Stable LSD radix sort of a permutation by 64-bit keys, 16 bits per pass.
+// Passes over digits which are equal for all keys are skipped.
+template<typename F>
+void RadixSort(std::vector<std::uint32_t>* permutation, F key) {
+  std::vector<std::uint32_t> tmp(permutation->size());
+  std::vector<std::uint64_t> counts(1U << 16);
+  for (std::uint32_t shift = 0; shift < 64; shift += 16) {
+    std::fill(counts.begin(), counts.end(), 0);
+    for (auto it : *permutation) {
+      ++counts[(key(it) >> shift) & 0xFFFF];
+    }
+    if (std::count(counts.begin(), counts.end(), 0) + 1 ==
+        static_cast<std::int64_t>(counts.size())) {
+      continue;
+    }
+    std::uint64_t sum = 0;
+    for (auto& it : counts) {
+      std::swap(sum, it);
+      sum += it;
+    }
+    for (auto it : *permutation) {
+      tmp[counts[(key(it) >> shift) & 0xFFFF]++] = it;
+    }
+    permutation->swap(tmp);
+  }
+}
+
+}  // namespace detail
+
+// Overlaps in structure-of-arrays form (36 bytes each) with the strand kept
+// in the top bit of the score and binary CIGARs in one shared buffer,
+// addressed by n + 1 offsets.
+class OverlapStore {
+ public:
+  OverlapStore()
+      : lhs_ids_(),
+        lhs_begins_(),
+        lhs_ends_(),
+        rhs_ids_(),
+        rhs_begins_(),
+        rhs_ends_(),
+        scores_(),
+        cigar_offsets_(1, 0),
+        cigars_() {}
+
+  OverlapStore(const OverlapStore&) = default;
+  OverlapStore& operator=(const OverlapStore&) = default;
+
+  OverlapStore(OverlapStore&&) = default;
+  OverlapStore& operator=(OverlapStore&&) = default;
+
+  ~OverlapStore() = default;
+
+  std::size_t size() const {
+    return lhs_ids_.size();
+  }
+
+  bool empty() const {
+    return lhs_ids_.empty();
+  }
+
+  std::uint64_t memory_usage() const {  // bytes held by the store
+    return (lhs_ids_.capacity() + lhs_begins_.capacity() +
+        lhs_ends_.capacity() + rhs_ids_.capacity() + rhs_begins_.capacity() +
+        rhs_ends_.capacity() + scores_.capacity() + cigars_.capacity()) *
+            sizeof(std::uint32_t) +
+        cigar_offsets_.capacity() * sizeof(std::uint64_t);
+  }
+
+  void Reserve(std::size_t num_overlaps) {
+    lhs_ids_.reserve(num_overlaps);
+    lhs_begins_.reserve(num_overlaps);
+    lhs_ends_.reserve(num_overlaps);
+    rhs_ids_.reserve(num_overlaps);
+    rhs_begins_.reserve(num_overlaps);
+    rhs_ends_.reserve(num_overlaps);
+    scores_.reserve(num_overlaps);
+    cigar_offsets_.reserve(num_overlaps + 1);
+  }
+
+  void Clear() {
+    *this = OverlapStore();
+  }
+
+  std::size_t Append(
+      std::uint32_t lhs_id, std::uint32_t lhs_begin, std::uint32_t lhs_end,
+      std::uint32_t rhs_id, std::uint32_t rhs_begin, std::uint32_t rhs_end,
+      std::uint32_t score,
+      bool strand = true,
+      const std::uint32_t* cigar = nullptr, std::uint32_t cigar_len = 0) {
+    if (score & kStrandMask) {
+      throw std::invalid_argument(
+          "[biosoup::OverlapStore::Append] error: score exceeds 31 bits");
+    }
+    lhs_ids_.emplace_back(lhs_id);
+    lhs_begins_.emplace_back(lhs_begin);
+    lhs_ends_.emplace_back(lhs_end);
+    rhs_ids_.emplace_back(rhs_id);
+    rhs_begins_.emplace_back(rhs_begin);
+    rhs_ends_.emplace_back(rhs_end);
+    scores_.emplace_back(score | static_cast<std::uint32_t>(strand) << 31);
+    cigars_.insert(cigars_.end(), cigar, cigar + cigar_len);
+    cigar_offsets_.emplace_back(cigars_.size());
+    return size() - 1;
+  }
+
+  std::size_t Append(const Overlap& overlap) {
+    std::vector<std::uint32_t> cigar;
+    EncodeCigar(overlap.alignment.c_str(), overlap.alignment.size(), &cigar);
+    return Append(
+        overlap.lhs_id, overlap.lhs_begin, overlap.lhs_end,
+        overlap.rhs_id, overlap.rhs_begin, overlap.rhs_end,
+        overlap.score,
+        overlap.strand,
+        cigar.data(), cigar.size());
+  }
+
+  // appends overlaps [begin, end) of other
+  void Append(const OverlapStore& other, std::size_t begin, std::size_t end) {
+    auto append = [&] (
+        std::vector<std::uint32_t>* dst,
+        const std::vector<std::uint32_t>& src) -> void {
+      dst->insert(dst->end(), src.begin() + begin, src.begin() + end);
+    };
+    append(&lhs_ids_, other.lhs_ids_);
+    append(&lhs_begins_, other.lhs_begins_);
+    append(&lhs_ends_, other.lhs_ends_);
+    append(&rhs_ids_, other.rhs_ids_);
+    append(&rhs_begins_, other.rhs_begins_);
+    append(&rhs_ends_, other.rhs_ends_);
+    append(&scores_, other.scores_);
+    std::uint64_t offset = cigars_.size() - other.cigar_offsets_[begin];
+    cigars_.insert(
+        cigars_.end(),
+        other.cigars_.begin() + other.cigar_offsets_[begin],
+        other.cigars_.begin() + other.cigar_offsets_[end]);
+    for (std::size_t i = begin; i < end; ++i) {
+      cigar_offsets_.emplace_back(other.cigar_offsets_[i + 1] + offset);
+    }
+  }
+
+  void Append(const OverlapStore& other) {
+    Append(other, 0, other.size());
+  }
+
+  std::uint32_t lhs_id(std::size_t i) const {
+    return lhs_ids_[i];
+  }
+
+  std::uint32_t lhs_begin(std::size_t i) const {
+    return lhs_begins_[i];
+  }
+
+  std::uint32_t lhs_end(std::size_t i) const {
+    return lhs_ends_[i];
+  }
+
+  std::uint32_t rhs_id(std::size_t i) const {
+    return rhs_ids_[i];
+  }
+
+  std::uint32_t rhs_begin(std::size_t i) const {
+    return rhs_begins_[i];
+  }
+
+  std::uint32_t rhs_end(std::size_t i) const {
+    return rhs_ends_[i];
+  }
+
+  std::uint32_t score(std::size_t i) const {
+    return scores_[i] & ~kStrandMask;
+  }
+
+  bool strand(std::size_t i) const {
+    return scores_[i] & kStrandMask;
+  }
+
+  const std::uint32_t* cigar(std::size_t i) const {
+    return cigars_.data() + cigar_offsets_[i];
+  }
+
+  std::uint32_t cigar_len(std::size_t i) const {
+    return cigar_offsets_[i + 1] - cigar_offsets_[i];
+  }
+
+  Overlap operator[](std::size_t i) const {
+    return Overlap(
+        lhs_ids_[i], lhs_begins_[i], lhs_ends_[i],
+        rhs_ids_[i], rhs_begins_[i], rhs_ends_[i],
+        score(i),
+        DecodeCigar(cigar(i), cigar_len(i)),
+        strand(i));
+  }
+
+  // stable, by id and begin
+  void SortByLhs() {
+    Sort(lhs_ids_, lhs_begins_);
+  }
+
+  void SortByRhs() {
+    Sort(rhs_ids_, rhs_begins_);
+  }
+
+  // keeps overlaps for which keep(i) is true, preserving their order
+  template<typename F>
+  void Filter(F keep) {
+    std::vector<std::uint32_t> permutation;
+    for (std::uint32_t i = 0; i < size(); ++i) {
+      if (keep(i)) {
+        permutation.emplace_back(i);
+      }
+    }
+    if (permutation.size() != size()) {
+      Permute(permutation);
+    }
+  }
+
+  // [begin, end) of overlaps with the given id, the store has to be sorted
+  std::pair<std::size_t, std::size_t> LhsRange(std::uint32_t lhs_id) const {
+    auto range = std::equal_range(lhs_ids_.begin(), lhs_ids_.end(), lhs_id);
+    return std::make_pair(
+        range.first - lhs_ids_.begin(),
+        range.second - lhs_ids_.begin());
+  }
+
+  std::pair<std::size_t, std::size_t> RhsRange(std::uint32_t rhs_id) const {
+    auto range = std::equal_range(rhs_ids_.begin(), rhs_ids_.end(), rhs_id);
+    return std::make_pair(
+        range.first - rhs_ids_.begin(),
+        range.second - rhs_ids_.begin());
+  }
+
+ private:
+  enum : std::uint32_t {
+    kStrandMask = 1U << 31
+  };
+
+  void Sort(
+      const std::vector<std::uint32_t>& ids,
+      const std::vector<std::uint32_t>& begins) {
+    if (size() > UINT32_MAX) {
+      throw std::length_error(
+          "[biosoup::OverlapStore::Sort] error: too many overlaps");
+    }
+    std::vector<std::uint32_t> permutation(size());
+    for (std::uint32_t i = 0; i < size(); ++i) {
+      permutation[i] = i;
+    }
+    detail::RadixSort(&permutation, [&] (std::uint32_t i) -> std::uint64_t {
+      return static_cast<std::uint64_t>(ids[i]) << 32 | begins[i];
+    });
+    Permute(permutation);
+  }
+
+  // i-th overlap is replaced with the permutation[i]-th one
+  void Permute(const std::vector<std::uint32_t>& permutation) {
+    auto gather = [&] (std::vector<std::uint32_t>* column) -> void {
+      std::vector<std::uint32_t> dst(permutation.size());
+      for (std::size_t i = 0; i < permutation.size(); ++i) {
+        dst[i] = (*column)[permutation[i]];
+      }
+      column->swap(dst);
+    };
+    gather(&lhs_ids_);
+    gather(&lhs_begins_);
+    gather(&lhs_ends_);
+    gather(&rhs_ids_);
+    gather(&rhs_begins_);
+    gather(&rhs_ends_);
+    gather(&scores_);
+
+    std::vector<std::uint64_t> cigar_offsets(1, 0);
+    cigar_offsets.reserve(permutation.size() + 1);
+    std::vector<std::uint32_t> cigars;
+    if (!cigars_.empty()) {
+      for (auto it : permutation) {
+        cigars.insert(
+            cigars.end(),
+            cigars_.begin() + cigar_offsets_[it],
+            cigars_.begin() + cigar_offsets_[it + 1]);
+        cigar_offsets.emplace_back(cigars.size());
+      }
+    } else {
+      cigar_offsets.resize(permutation.size() + 1, 0);
+    }
+    cigar_offsets_.swap(cigar_offsets);
+    cigars_.swap(cigars);
+  }
+
+  std::vector<std::uint32_t> lhs_ids_;
+  std::vector<std::uint32_t> lhs_begins_;
+  std::vector<std::uint32_t> lhs_ends_;
+  std::vector<std::uint32_t> rhs_ids_;
+  std::vector<std::uint32_t> rhs_begins_;
+  std::vector<std::uint32_t> rhs_ends_;
+  std::vector<std::uint32_t> scores_;  // strand in the top bit
+  std::vector<std::uint64_t> cigar_offsets_;
+  std::vector<std::uint32_t> cigars_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_OVERLAP_STORE_HPP_
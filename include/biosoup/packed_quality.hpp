@@ -0,0 +1,195 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_PACKED_QUALITY_HPP_
+#define BIOSOUP_PACKED_QUALITY_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace biosoup {
+
+// Lossy mapping of Phred scores, [lower_bounds[i], lower_bounds[i + 1]) is
+// replaced with values[i], negative scores are kept as is
+class QualityBinning {
+ public:
+  QualityBinning(
+      const std::vector<std::int8_t>& lower_bounds,
+      const std::vector<std::int8_t>& values)
+      : table_() {
+    if (lower_bounds.empty() ||
+        lower_bounds.size() != values.size() ||
+        lower_bounds.front() != 0 ||
+        !std::is_sorted(lower_bounds.begin(), lower_bounds.end())) {
+      throw std::invalid_argument(
+          "[biosoup::QualityBinning::QualityBinning] error: invalid bins");
+    }
+    for (std::int32_t i = -128; i < 0; ++i) {
+      table_[static_cast<std::uint8_t>(i)] = i;
+    }
+    for (std::int32_t i = 0, j = 0; i < 128; ++i) {
+      while (j + 1 < static_cast<std::int32_t>(lower_bounds.size()) &&
+             lower_bounds[j + 1] <= i) {
+        ++j;
+      }
+      table_[i] = values[j];
+    }
+  }
+
+  QualityBinning(const QualityBinning&) = default;
+  QualityBinning& operator=(const QualityBinning&) = default;
+
+  QualityBinning(QualityBinning&&) = default;
+  QualityBinning& operator=(QualityBinning&&) = default;
+
+  ~QualityBinning() = default;
+
+  // 8 levels as in Illumina's RTA, fits 3 bits
+  static QualityBinning Illumina() {
+    return QualityBinning(
+        {0, 2, 10, 20, 25, 30, 35, 40},
+        {0, 6, 15, 22, 27, 33, 37, 40});
+  }
+
+  std::int8_t operator()(std::int8_t score) const {
+    return table_[static_cast<std::uint8_t>(score)];
+  }
+
+ private:
+  std::int8_t table_[256];
+};
+
+// Quality scores stored as indices into the alphabet of distinct scores,
+// packed with the minimal number of bits (lossless unless binned). Scores are
+// decoded lazily, one at a time or in ranges.
+class PackedQuality {
+ public:
+  PackedQuality()
+      : alphabet_(),
+        width_(0),
+        mask_(0),
+        len_(0),
+        data_() {}
+
+  PackedQuality(const std::int8_t* quality, std::uint32_t quality_len)
+      : PackedQuality() {
+    Pack(quality, quality_len, [] (std::int8_t score) { return score; });
+  }
+
+  PackedQuality(
+      const std::int8_t* quality, std::uint32_t quality_len,
+      const QualityBinning& binning)
+      : PackedQuality() {
+    Pack(quality, quality_len, binning);
+  }
+
+  PackedQuality(const PackedQuality&) = default;
+  PackedQuality& operator=(const PackedQuality&) = default;
+
+  PackedQuality(PackedQuality&&) = default;
+  PackedQuality& operator=(PackedQuality&&) = default;
+
+  ~PackedQuality() = default;
+
+  std::uint32_t size() const {
+    return len_;
+  }
+
+  bool empty() const {
+    return len_ == 0;
+  }
+
+  std::uint32_t width() const {  // bits per score
+    return width_;
+  }
+
+  std::uint64_t memory_usage() const {
+    return sizeof(*this) +
+        alphabet_.capacity() +
+        data_.capacity() * sizeof(std::uint64_t);
+  }
+
+  std::int8_t operator[](std::uint32_t i) const {
+    return alphabet_[Index(i)];
+  }
+
+  // writes scores [i, i + len) as Phred + 33 characters, reversed if needed
+  void Inflate(
+      std::uint32_t i, std::uint32_t len,
+      bool is_reverse,
+      char* dst) const {
+    char lut[256];
+    for (std::uint32_t j = 0; j < alphabet_.size(); ++j) {
+      lut[j] = alphabet_[j] + '!';
+    }
+    if (is_reverse) {
+      dst += len;
+      for (std::uint32_t j = 0; j < len; ++j) {
+        *--dst = lut[Index(i + j)];
+      }
+    } else {
+      for (std::uint32_t j = 0; j < len; ++j) {
+        *dst++ = lut[Index(i + j)];
+      }
+    }
+  }
+
+ private:
+  // packs map(quality[i]), map is applied on the fly to avoid a copy
+  template<typename F>
+  void Pack(const std::int8_t* quality, std::uint32_t quality_len, F map) {
+    if (quality_len == 0) {
+      return;
+    }
+    std::uint8_t index[256] = {0};
+    bool is_present[256] = {false};
+    for (std::uint32_t i = 0; i < quality_len; ++i) {
+      is_present[static_cast<std::uint8_t>(map(quality[i]))] = true;
+    }
+    for (std::int32_t i = -128; i < 128; ++i) {
+      if (is_present[static_cast<std::uint8_t>(i)]) {
+        index[static_cast<std::uint8_t>(i)] = alphabet_.size();
+        alphabet_.emplace_back(i);
+      }
+    }
+    while ((1U << width_) < alphabet_.size()) {
+      ++width_;
+    }
+    mask_ = (1ULL << width_) - 1;
+    len_ = quality_len;
+    if (width_ == 0) {
+      return;
+    }
+    data_.resize((static_cast<std::uint64_t>(len_) * width_ + 63) >> 6, 0);
+    for (std::uint64_t i = 0, bit = 0; i < len_; ++i, bit += width_) {
+      std::uint64_t c = index[static_cast<std::uint8_t>(map(quality[i]))];
+      data_[bit >> 6] |= c << (bit & 63);
+      if ((bit & 63) + width_ > 64) {
+        data_[(bit >> 6) + 1] |= c >> (64 - (bit & 63));
+      }
+    }
+  }
+
+  std::uint64_t Index(std::uint32_t i) const {
+    if (width_ == 0) {
+      return 0;
+    }
+    std::uint64_t bit = static_cast<std::uint64_t>(i) * width_;
+    std::uint64_t c = data_[bit >> 6] >> (bit & 63);
+    if ((bit & 63) + width_ > 64) {
+      c |= data_[(bit >> 6) + 1] << (64 - (bit & 63));
+    }
+    return c & mask_;
+  }
+
+  std::vector<std::int8_t> alphabet_;  // sorted distinct scores
+  std::uint32_t width_;
+  std::uint64_t mask_;
+  std::uint32_t len_;
+  std::vector<std::uint64_t> data_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_PACKED_QUALITY_HPP_
@@ -0,0 +1,336 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_PARSER_HPP_
+#define BIOSOUP_PARSER_HPP_
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "biosoup/detail/chunk_pipeline.hpp"
+#include "biosoup/io.hpp"
+#include "biosoup/object_id.hpp"
+
+namespace biosoup {
+
+namespace detail {
+
+inline const char* SkipSpace(const char* begin, const char* end) {
+  while (begin < end && std::isspace(static_cast<unsigned char>(*begin))) {
+    ++begin;
+  }
+  return begin;
+}
+
+// end of line without trailing whitespace
+inline const char* RightStrip(const char* begin, const char* end) {
+  while (end > begin && std::isspace(static_cast<unsigned char>(end[-1]))) {
+    --end;
+  }
+  return end;
+}
+
+// Moves begin past the next record and stores its fields (without line
+// breaks) unless they are nullptr. Returns false if there are no records left
+// or the last one is incomplete (lines have to end with '\n').
+inline bool NextFastaRecord(
+    const char** begin, const char* end,
+    std::string* name,
+    std::string* data) {
+  const char* p = SkipSpace(*begin, end);
+  if (p == end) {
+    *begin = end;
+    return false;
+  }
+  if (*p != '>') {
+    throw std::invalid_argument(
+        "[biosoup::Parser] error: invalid FASTA record");
+  }
+  const char* e = static_cast<const char*>(std::memchr(p, '\n', end - p));
+  if (e == nullptr) {
+    return false;
+  }
+  if (name) {
+    name->assign(p + 1, RightStrip(p + 1, e));
+  }
+  if (data) {
+    data->clear();
+  }
+  for (p = e + 1; p < end && *p != '>'; p = e + 1) {
+    e = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (e == nullptr) {
+      return false;
+    }
+    if (data) {
+      data->append(p, RightStrip(p, e));
+    }
+  }
+  *begin = p;
+  return true;
+}
+
+inline bool NextFastqRecord(
+    const char** begin, const char* end,
+    std::string* name,
+    std::string* data,
+    std::string* quality) {
+  const char* p = SkipSpace(*begin, end);
+  if (p == end) {
+    *begin = end;
+    return false;
+  }
+  if (*p != '@') {
+    throw std::invalid_argument(
+        "[biosoup::Parser] error: invalid FASTQ record");
+  }
+  const char* e = static_cast<const char*>(std::memchr(p, '\n', end - p));
+  if (e == nullptr) {
+    return false;
+  }
+  if (name) {
+    name->assign(p + 1, RightStrip(p + 1, e));
+  }
+  if (data) {
+    data->clear();
+  }
+  if (quality) {
+    quality->clear();
+  }
+  std::size_t data_len = 0;
+  for (p = e + 1; p < end && *p != '+'; p = e + 1) {
+    e = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (e == nullptr) {
+      return false;
+    }
+    data_len += RightStrip(p, e) - p;
+    if (data) {
+      data->append(p, RightStrip(p, e));
+    }
+  }
+  if (p == end ||
+      (e = static_cast<const char*>(std::memchr(p, '\n', end - p))) == nullptr) {  // NOLINT
+    return false;
+  }
+  std::size_t quality_len = 0;
+  for (p = e + 1; quality_len < data_len; p = e + 1) {
+    if (p == end ||
+        (e = static_cast<const char*>(std::memchr(p, '\n', end - p))) == nullptr) {  // NOLINT
+      return false;
+    }
+    quality_len += RightStrip(p, e) - p;
+    if (quality) {
+      quality->append(p, RightStrip(p, e));
+    }
+  }
+  if (quality_len != data_len) {
+    throw std::invalid_argument(
+        "[biosoup::Parser] error: unequal quality and sequence length");
+  }
+  *begin = p;
+  return true;
+}
+
+// Progress of the search for the end of a FASTQ record in a buffer that
+// keeps growing, so that each line is looked at once.
+struct FastqScan {
+  std::size_t line;  // start of the first line not looked at
+  std::uint32_t phase;  // name, sequence or quality lines
+  std::size_t data_len;
+  std::size_t quality_len;
+};
+
+// Moves scan->line past the lines in [data + scan->line, end) that belong to
+// the record being scanned. Returns true once the record is complete, with
+// scan->line as its end. Mirrors the checks of NextFastqRecord.
+inline bool ScanFastqRecord(const char* data, const char* end, FastqScan* scan) {  // NOLINT
+  const char* p = data + scan->line;
+  const char* e = nullptr;
+  if (scan->phase == 0) {
+    p = SkipSpace(p, end);
+    if (p == end) {
+      return false;
+    }
+    if (*p != '@') {
+      throw std::invalid_argument(
+          "[biosoup::Parser] error: invalid FASTQ record");
+    }
+    if ((e = static_cast<const char*>(std::memchr(p, '\n', end - p))) == nullptr) {  // NOLINT
+      return false;
+    }
+    scan->line = e + 1 - data;
+    scan->phase = 1;
+    p = e + 1;
+  }
+  if (scan->phase == 1) {
+    for (; p < end && *p != '+'; p = e + 1) {
+      if ((e = static_cast<const char*>(std::memchr(p, '\n', end - p))) == nullptr) {  // NOLINT
+        return false;
+      }
+      scan->data_len += RightStrip(p, e) - p;
+      scan->line = e + 1 - data;
+    }
+    if (p == end ||
+        (e = static_cast<const char*>(std::memchr(p, '\n', end - p))) == nullptr) {  // NOLINT
+      return false;
+    }
+    scan->line = e + 1 - data;
+    scan->phase = 2;
+    p = e + 1;
+  }
+  for (; scan->quality_len < scan->data_len; p = e + 1) {
+    if (p == end ||
+        (e = static_cast<const char*>(std::memchr(p, '\n', end - p))) == nullptr) {  // NOLINT
+      return false;
+    }
+    scan->quality_len += RightStrip(p, e) - p;
+    scan->line = e + 1 - data;
+  }
+  if (scan->quality_len != scan->data_len) {
+    throw std::invalid_argument(
+        "[biosoup::Parser] error: unequal quality and sequence length");
+  }
+  return true;
+}
+
+}  // namespace detail
+
+// Parses FASTA/FASTQ (detected from the first record) into Sequence or
+// NucleicAcid objects. A reader thread splits the input into chunks of whole
+// records, which are parsed on a pool of worker threads and handed out in
+// input order. At most max_chunks chunks are held in memory at a time.
+// Each handed out chunk reserves a block of ids from T::num_objects, so
+// objects get consecutive ids in input order without the workers contending
+// on the shared counter.
+template<typename T>
+class Parser {
+ public:
+  explicit Parser(
+      ReadFunction read,
+      std::uint32_t num_threads = std::thread::hardware_concurrency(),
+      std::size_t chunk_size = 1U << 22,
+      std::size_t max_chunks = 0)  // 0 for 2 * num_threads + 2
+      : format_(kUnknown),
+        scan_(),
+        pipeline_(
+            std::move(read),
+            [this] (const std::string& data, std::size_t begin, bool) -> std::size_t {  // NOLINT
+              return Split(data, begin);
+            },
+            [this] (const char* begin, const char* end, Records* dst) -> void {  // NOLINT
+              Convert(begin, end, dst);
+            },
+            num_threads,
+            chunk_size,
+            max_chunks) {}
+
+  Parser(const Parser&) = delete;
+  Parser& operator=(const Parser&) = delete;
+
+  Parser(Parser&&) = delete;
+  Parser& operator=(Parser&&) = delete;
+
+  ~Parser() = default;
+
+  // returns whole chunks until at least bytes of input are consumed,
+  // empty once the input is exhausted
+  std::vector<std::unique_ptr<T>> Parse(std::uint64_t bytes = -1) {
+    std::vector<std::unique_ptr<T>> dst;
+    Records records;
+    for (std::uint64_t num_bytes = 0, n; num_bytes < bytes; num_bytes += n) {
+      if (!pipeline_.Next(&records, &n)) {
+        break;
+      }
+      ObjectId id = ReserveIds<T>(records.size());
+      for (auto& it : records) {  // constructed out of order
+        it->id = id++;
+        dst.emplace_back(std::move(it));
+      }
+    }
+    return dst;
+  }
+
+ private:
+  using Records = std::vector<std::unique_ptr<T>>;
+
+  enum Format {
+    kUnknown,
+    kFasta,
+    kFastq
+  };
+
+  // position after the last complete record, 0 if there is none; records
+  // ending before begin were looked for by the previous call
+  std::size_t Split(const std::string& data, std::size_t begin) {
+    if (format_ == kUnknown) {
+      const char* p = detail::SkipSpace(data.data(), data.data() + data.size());  // NOLINT
+      if (p == data.data() + data.size()) {
+        return 0;
+      }
+      if (*p == '>') {
+        format_ = kFasta;
+      } else if (*p == '@') {
+        format_ = kFastq;
+      } else {
+        throw std::invalid_argument(
+            "[biosoup::Parser] error: unknown format");
+      }
+    }
+    if (format_ == kFasta) {
+      for (std::size_t i = data.size(); i > std::max<std::size_t>(begin, 1); --i) {
+        if (data[i - 1] == '>' && data[i - 2] == '\n') {
+          return i - 1;
+        }
+      }
+      return 0;
+    }
+    if (begin == 0) {  // a new chunk
+      scan_ = detail::FastqScan();
+    }
+    std::size_t dst = 0;
+    while (detail::ScanFastqRecord(data.data(), data.data() + data.size(), &scan_)) {  // NOLINT
+      dst = scan_.line;
+      scan_ = detail::FastqScan();
+      scan_.line = dst;
+    }
+    return dst;
+  }
+
+  void Convert(const char* begin, const char* end, Records* dst) const {
+    IdScope<T> ids(0, -1);  // placeholders, replaced in Parse
+    std::string name, data, quality;
+    const char* p = begin;
+    if (format_ == kFasta) {
+      while (detail::NextFastaRecord(&p, end, &name, &data)) {
+        dst->emplace_back(new T(
+            name.c_str(), name.size(),
+            data.c_str(), data.size()));
+      }
+    } else {
+      while (detail::NextFastqRecord(&p, end, &name, &data, &quality)) {
+        dst->emplace_back(new T(
+            name.c_str(), name.size(),
+            data.c_str(), data.size(),
+            quality.c_str(), quality.size()));
+      }
+    }
+    if (p != end) {
+      throw std::invalid_argument(
+          "[biosoup::Parser] error: truncated record");
+    }
+  }
+
+  Format format_;  // set by the reader before the first chunk is converted
+  detail::FastqScan scan_;  // used by the reader only
+  detail::ChunkPipeline<Records> pipeline_;  // last, its threads use the rest
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_PARSER_HPP_
@@ -0,0 +1,344 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_PROFILER_HPP_
+#define BIOSOUP_PROFILER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+// BIOSOUP_PROFILE_SCOPE expands to nothing if BIOSOUP_DISABLE_PROFILER is
+// defined, so profiling can be compiled out entirely
+#if defined(BIOSOUP_DISABLE_PROFILER)
+#define BIOSOUP_PROFILE_SCOPE(profiler, name)
+#else
+#define BIOSOUP_PROFILE_SCOPE_CONCAT(lhs, rhs) lhs##rhs
+#define BIOSOUP_PROFILE_SCOPE_NAME(line) \
+  BIOSOUP_PROFILE_SCOPE_CONCAT(biosoup_profile_scope_, line)
+#define BIOSOUP_PROFILE_SCOPE(profiler, name) \
+  biosoup::ProfilerScope BIOSOUP_PROFILE_SCOPE_NAME(__LINE__)(profiler, name)
+#endif
+
+namespace biosoup {
+
+// statistics of a region over all threads, times are in seconds
+struct ProfilerRegion {
+  std::string path;  // names of enclosing regions and its own, joined by '/'
+  std::uint64_t count;
+  double total;
+  double min;
+  double p50;
+  double p90;
+  double p99;
+  double max;
+};
+
+// Records nested named regions (see ProfilerScope) into per-thread buffers,
+// which are appended to by their threads only, so recording never locks
+// once a thread has registered. Timestamps are taken from steady_clock or,
+// if use_tsc is set on x86-64, from the time stamp counter which is
+// calibrated against steady_clock when the records are read. Buffers are
+// not locked against their threads, so Clear, Summary and ChromeTrace may
+// only be called while no regions are being recorded (scopes may be open,
+// but no thread may begin or end one meanwhile).
+class Profiler {
+ public:
+  explicit Profiler(bool use_tsc = false)
+      : is_enabled_(true),
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+        use_tsc_(use_tsc),
+#else
+        use_tsc_(false),
+#endif
+        id_(NextId()),
+        first_tick_(Now()),
+        first_time_(SteadyNow()),
+        mutex_(),
+        buffers_() {
+    static_cast<void>(use_tsc);
+  }
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  Profiler(Profiler&&) = delete;
+  Profiler& operator=(Profiler&&) = delete;
+
+  ~Profiler() = default;
+
+  bool is_enabled() const {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  void set_is_enabled(bool is_enabled) {
+    is_enabled_.store(is_enabled, std::memory_order_relaxed);
+  }
+
+  // drops closed regions, regions still open are kept (without their closed
+  // children) so that their scopes can end, see above for when to call it
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& it : buffers_) {
+      it->size = it->stack.empty() ? 0 : it->stack.back() + 1;
+      for (std::size_t i = 0, j = 0; i < it->size; ++i) {
+        if (it->stack[j] == i) {  // open events are in increasing order
+          ++j;
+          continue;
+        }
+        (*it)[i].begin = -1;  // end < begin, skipped like open events
+        (*it)[i].end = 0;
+      }
+    }
+  }
+
+  // regions sorted by path, durations of regions still open are ignored
+  std::vector<ProfilerRegion> Summary() const {
+    std::map<std::string, std::vector<double>> durations;
+    double scale = NanosecondsPerTick();
+    Visit([&] (const std::string& path, const Event& event) -> void {
+      durations[path].emplace_back((event.end - event.begin) * scale * 1e-9);
+    });
+
+    std::vector<ProfilerRegion> dst;
+    for (auto& it : durations) {
+      std::vector<double>& d = it.second;
+      std::sort(d.begin(), d.end());
+      auto percentile = [&] (double p) -> double {  // nearest rank
+        std::size_t rank = std::ceil(p * d.size());
+        return d[std::max<std::size_t>(rank, 1) - 1];
+      };
+      ProfilerRegion region;
+      region.path = it.first;
+      region.count = d.size();
+      region.total = 0;
+      for (auto jt : d) {
+        region.total += jt;
+      }
+      region.min = d.front();
+      region.p50 = percentile(0.5);
+      region.p90 = percentile(0.9);
+      region.p99 = percentile(0.99);
+      region.max = d.back();
+      dst.emplace_back(region);
+    }
+    return dst;
+  }
+
+  // Chrome trace event JSON with complete events in microseconds and
+  // registered threads numbered from 0, viewable in chrome://tracing or
+  // Perfetto
+  std::string ChromeTrace() const {
+    double scale = NanosecondsPerTick();
+    std::string dst = "{\"traceEvents\":[";
+    bool is_first = true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < buffers_.size(); ++i) {
+      const Buffer& b = *buffers_[i];
+      for (std::size_t j = 0; j < b.size; ++j) {
+        const Event& it = b[j];
+        if (it.end < it.begin) {
+          continue;
+        }
+        char buffer[128];
+        std::snprintf(buffer, sizeof(buffer),
+            "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u}",
+            (it.begin - first_tick_) * scale * 1e-3,
+            (it.end - it.begin) * scale * 1e-3,
+            static_cast<std::uint32_t>(i));
+        dst += is_first ? "\n{\"name\":\"" : ",\n{\"name\":\"";
+        for (const char* c = it.name; *c; ++c) {
+          if (*c == '"' || *c == '\\') {
+            dst += '\\';
+          }
+          if (static_cast<unsigned char>(*c) >= 0x20) {
+            dst += *c;
+          }
+        }
+        dst += buffer;
+        is_first = false;
+      }
+    }
+    dst += "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return dst;
+  }
+
+ private:
+  friend class ProfilerScope;
+
+  struct Event {
+    const char* name;
+    std::uint64_t begin;
+    std::uint64_t end;  // 0 while open
+    std::uint32_t parent;  // index in the same buffer, -1 for top level
+  };
+
+  // events are kept in blocks which are never moved
+  struct Buffer {
+    explicit Buffer(std::thread::id thread)
+        : thread(thread),
+          blocks(),
+          size(0),
+          stack() {}
+
+    enum : std::uint32_t {
+      kBlockSize = 1U << 12
+    };
+
+    Event& operator[](std::size_t i) {
+      return blocks[i / kBlockSize][i % kBlockSize];
+    }
+
+    const Event& operator[](std::size_t i) const {
+      return blocks[i / kBlockSize][i % kBlockSize];
+    }
+
+    Event* Push() {
+      if (size == blocks.size() * kBlockSize) {
+        blocks.emplace_back(new Event[kBlockSize]);
+      }
+      return &(*this)[size++];
+    }
+
+    std::thread::id thread;
+    std::vector<std::unique_ptr<Event[]>> blocks;
+    std::size_t size;
+    std::vector<std::uint32_t> stack;  // open events
+  };
+
+  static std::uint64_t NextId() {
+    static std::atomic<std::uint64_t> num_profilers{0};
+    return ++num_profilers;
+  }
+
+  static std::uint64_t SteadyNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  std::uint64_t Now() const {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    if (use_tsc_) {
+      return __builtin_ia32_rdtsc();
+    }
+#endif
+    return SteadyNow();
+  }
+
+  // the time stamp counter is calibrated over at least 10 ms
+  double NanosecondsPerTick() const {
+    if (!use_tsc_) {
+      return 1;
+    }
+    std::uint64_t time;
+    while ((time = SteadyNow()) < first_time_ + 10000000) {
+      std::this_thread::yield();
+    }
+    return (time - first_time_) / static_cast<double>(Now() - first_tick_);
+  }
+
+  // buffer of the calling thread, registered on first use
+  Buffer* ThreadBuffer() {
+    thread_local std::uint64_t cached_id = 0;
+    thread_local Buffer* cached_buffer = nullptr;
+    if (cached_id != id_) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::thread::id thread = std::this_thread::get_id();
+      cached_buffer = nullptr;
+      for (const auto& it : buffers_) {
+        if (it->thread == thread) {
+          cached_buffer = it.get();
+        }
+      }
+      if (cached_buffer == nullptr) {
+        buffers_.emplace_back(new Buffer(thread));
+        cached_buffer = buffers_.back().get();
+      }
+      cached_id = id_;
+    }
+    return cached_buffer;
+  }
+
+  Event* Begin(const char* name, Buffer** buffer) {
+    *buffer = ThreadBuffer();
+    std::uint32_t parent = (*buffer)->stack.empty() ? -1 : (*buffer)->stack.back();  // NOLINT
+    (*buffer)->stack.emplace_back((*buffer)->size);
+    Event* event = (*buffer)->Push();
+    event->name = name;
+    event->end = 0;
+    event->parent = parent;
+    event->begin = Now();
+    return event;
+  }
+
+  void End(Buffer* buffer, Event* event) {
+    event->end = Now();
+    buffer->stack.pop_back();
+  }
+
+  // calls f(path, event) for closed events
+  template<typename F>
+  void Visit(F f) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& it : buffers_) {
+      std::vector<std::string> paths(it->size);
+      for (std::size_t i = 0; i < it->size; ++i) {
+        const Event& event = (*it)[i];
+        paths[i] = event.parent == static_cast<std::uint32_t>(-1) ?
+            event.name :
+            paths[event.parent] + "/" + event.name;
+        if (event.end >= event.begin) {
+          f(paths[i], event);
+        }
+      }
+    }
+  }
+
+  std::atomic<bool> is_enabled_;
+  bool use_tsc_;
+  std::uint64_t id_;  // unique per process, identifies cached buffers
+  std::uint64_t first_tick_;
+  std::uint64_t first_time_;  // of steady_clock in ns, for calibration
+  mutable std::mutex mutex_;  // guards registration of buffers
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
+// Records the region from its construction to its destruction under name,
+// which has to outlive the profiler (e.g. a string literal). Nothing is
+// recorded if the profiler is nullptr or disabled.
+class ProfilerScope {
+ public:
+  ProfilerScope(Profiler* profiler, const char* name)
+      : profiler_(profiler && profiler->is_enabled() ? profiler : nullptr),
+        buffer_(nullptr),
+        event_(profiler_ ? profiler_->Begin(name, &buffer_) : nullptr) {}
+
+  ProfilerScope(const ProfilerScope&) = delete;
+  ProfilerScope& operator=(const ProfilerScope&) = delete;
+
+  ProfilerScope(ProfilerScope&&) = delete;
+  ProfilerScope& operator=(ProfilerScope&&) = delete;
+
+  ~ProfilerScope() {
+    if (event_) {
+      profiler_->End(buffer_, event_);
+    }
+  }
+
+ private:
+  Profiler* profiler_;
+  Profiler::Buffer* buffer_;
+  Profiler::Event* event_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_PROFILER_HPP_
@@ -5,10 +5,12 @@
 
 #include <algorithm>
 #include <atomic>
-#include <cctype>
 #include <cstdint>
 #include <string>
 
+#include "biosoup/detail/complement.hpp"
+#include "biosoup/object_id.hpp"
+
 namespace biosoup {
 
 struct Sequence {
@@ -21,7 +23,7 @@ struct Sequence {
   Sequence(
       const char* name, std::uint32_t name_len,
       const char* data, std::uint32_t data_len)
-      : id(num_objects++),
+      : id(NextId<Sequence>()),
         name(name, name_len),
         data(data, data_len),
         quality() {}
@@ -39,7 +41,7 @@ struct Sequence {
       const char* name, std::uint32_t name_len,
       const char* data, std::uint32_t data_len,
       const char* quality, std::uint32_t quality_len)
-      : id(num_objects++),
+      : id(NextId<Sequence>()),
         name(name, name_len),
         data(data, data_len),
         quality(quality, quality_len) {}
@@ -53,32 +55,17 @@ struct Sequence {
   ~Sequence() = default;
 
   void ReverseAndComplement() {  // (optional) Watson-Crick base pairing
-    for (auto& it : data) {
-      switch (static_cast<char>(std::toupper(static_cast<unsigned char>(it)))) {
-        case 'A': it = 'T'; break;
-        case 'C': it = 'G'; break;
-        case 'G': it = 'C'; break;
-        case 'T': case 'U': it = 'A'; break;
-        case 'R': it = 'Y'; break;  // A || G
-        case 'Y': it = 'R'; break;  // C || T (U)
-        case 'K': it = 'M'; break;  // G || T (U)
-        case 'M': it = 'K'; break;  // A || C
-        case 'S': break;  // C || G
-        case 'W': break;  // A || T (U)
-        case 'B': it = 'V'; break;  // !A
-        case 'D': it = 'H'; break;  // !C
-        case 'H': it = 'D'; break;  // !G
-        case 'V': it = 'B'; break;  // !T (!U)
-        default: break;  // N || -
-      }
+    if (quality.size() == data.size()) {  // in a single pass
+      detail::ReverseAndComplement(&data[0], &quality[0], data.size());
+    } else {
+      detail::ReverseAndComplement(&data[0], nullptr, data.size());
+      std::reverse(quality.begin(), quality.end());
     }
-    std::reverse(data.begin(), data.end());
-    std::reverse(quality.begin(), quality.end());
   }
 
-  static std::atomic<std::uint32_t> num_objects;
+  static std::atomic<ObjectId> num_objects;
 
-  std::uint32_t id;  // (optional) initialize num_objects to 0
+  ObjectId id;  // (optional) initialize num_objects to 0
   std::string name;
   std::string data;
   std::string quality;  // (optional) Phred quality scores
@@ -0,0 +1,587 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_STRING_GRAPH_HPP_
+#define BIOSOUP_STRING_GRAPH_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "biosoup/detail/parallel.hpp"
+#include "biosoup/overlap.hpp"
+
+namespace biosoup {
+
+// Bidirected string graph of reads, kept in compressed sparse row format.
+// Read id is represented by node 2 * id (forward strand) and node 2 * id + 1
+// (reverse complement), and a suffix-prefix (dovetail) overlap between two
+// reads gives an edge v -> w together with its twin w ^ 1 -> v ^ 1. Edge
+// length is the number of bases of v preceding w. Since every edge has a
+// twin, in-edges of a node are out-edges of its complement and no reverse
+// adjacency is stored. Edges of each node are sorted by length.
+//
+// Contained reads are dropped on construction, while transitive reduction
+// (Myers 2005) and tip and bubble removal process all nodes in parallel and
+// compact the graph after each pass.
+class StringGraph {
+ public:
+  struct Edge {
+    std::uint32_t head;
+    std::uint32_t length;
+  };
+
+  StringGraph()
+      : status_(),
+        offsets_(1, 0),
+        edges_() {}
+
+  // len(id) gives read lengths, overlaps with overhangs longer than tolerance
+  // in total are internal matches and are ignored (as are self overlaps)
+  template<typename L>
+  StringGraph(
+      const std::vector<Overlap>& overlaps,
+      L len,
+      std::uint32_t tolerance = 0,
+      std::uint32_t num_threads = std::thread::hardware_concurrency())
+      : StringGraph() {
+    Build(overlaps, len, tolerance, num_threads);
+  }
+
+  StringGraph(const StringGraph&) = default;
+  StringGraph& operator=(const StringGraph&) = default;
+
+  StringGraph(StringGraph&&) = default;
+  StringGraph& operator=(StringGraph&&) = default;
+
+  ~StringGraph() = default;
+
+  std::uint32_t num_reads() const {  // largest id + 1
+    return status_.size();
+  }
+
+  std::uint32_t num_nodes() const {
+    return offsets_.size() - 1;
+  }
+
+  std::uint64_t num_edges() const {
+    return edges_.size();
+  }
+
+  bool is_contained(std::uint32_t id) const {
+    return id < num_reads() && status_[id] == kContained;
+  }
+
+  bool is_removed(std::uint32_t id) const {  // as a tip or within a bubble
+    return id < num_reads() && status_[id] == kRemoved;
+  }
+
+  std::uint32_t out_degree(std::uint32_t v) const {
+    return v < num_nodes() ? offsets_[v + 1] - offsets_[v] : 0;
+  }
+
+  std::uint32_t in_degree(std::uint32_t v) const {
+    return out_degree(v ^ 1);
+  }
+
+  // out_degree(v) edges
+  const Edge* out_edges(std::uint32_t v) const {
+    return edges_.data() + offsets_[std::min(v, num_nodes())];
+  }
+
+  // removes edges v -> x implied by paths v -> w -> x (up to fuzz bases
+  // longer), returns the number of removed edges
+  std::uint64_t RemoveTransitiveEdges(
+      std::uint32_t fuzz = 0,
+      std::uint32_t num_threads = std::thread::hardware_concurrency()) {
+    std::vector<std::uint8_t> is_transitive(num_edges(), 0);
+    detail::ParallelFor(
+        (num_nodes() + kBlockSize - 1) / kBlockSize,
+        num_threads,
+        [&] (std::size_t block) -> void {
+          std::vector<std::pair<std::uint32_t, std::uint32_t>> heads;
+          std::vector<std::uint8_t> marks;
+          std::uint32_t last = std::min<std::uint64_t>(
+              num_nodes(), (block + 1) * kBlockSize);
+          for (std::uint32_t v = block * kBlockSize; v < last; ++v) {
+            MarkTransitive(v, fuzz, &heads, &marks, &is_transitive[offsets_[v]]);  // NOLINT
+          }
+        });
+    // an edge goes along with its twin
+    return Compact(
+        [&] (std::uint32_t v, std::uint64_t i) -> bool {
+          if (is_transitive[i]) {
+            return false;
+          }
+          std::uint32_t w = edges_[i].head ^ 1;
+          for (std::uint64_t j = offsets_[w]; j < offsets_[w + 1]; ++j) {
+            if (edges_[j].head == (v ^ 1)) {
+              return !is_transitive[j];
+            }
+          }
+          return true;
+        },
+        num_threads);
+  }
+
+  // removes unbranched paths of up to max_len reads which start at a node
+  // without in-edges and join the graph, in passes until none are left,
+  // returns the number of removed reads
+  std::uint32_t RemoveTips(
+      std::uint32_t max_len = 4,
+      std::uint32_t num_threads = std::thread::hardware_concurrency()) {
+    std::uint32_t dst = 0;
+    for (std::uint32_t n = 1; n;) {
+      dst += n = RemoveReads(
+          [&] (std::uint32_t v, std::vector<std::uint32_t>* ids) -> void {
+            FindTip(v, max_len, ids);
+          },
+          num_threads);
+    }
+    return dst;
+  }
+
+  // removes reads of all but one unbranched path (the one with most reads)
+  // of up to max_len reads between two nodes, in passes until none are left,
+  // returns the number of removed reads
+  std::uint32_t PopBubbles(
+      std::uint32_t max_len = 8,
+      std::uint32_t num_threads = std::thread::hardware_concurrency()) {
+    std::uint32_t dst = 0;
+    for (std::uint32_t n = 1; n;) {
+      dst += n = RemoveReads(
+          [&] (std::uint32_t v, std::vector<std::uint32_t>* ids) -> void {
+            FindBubble(v, max_len, ids);
+          },
+          num_threads);
+    }
+    return dst;
+  }
+
+ private:
+  enum : std::uint32_t {
+    kBlockSize = 1U << 10,  // nodes processed per task
+    kOverlapBlockSize = 1U << 16,  // overlaps processed per task
+    kNumBuckets = 256  // of consecutive nodes, filled in parallel
+  };
+
+  enum : std::uint8_t {  // of reads
+    kActive,
+    kContained,
+    kRemoved
+  };
+
+  enum : std::uint8_t {  // of overlaps
+    kInternal,
+    kLhsContained,
+    kRhsContained,
+    kDovetail
+  };
+
+  struct Arc {
+    std::uint32_t tail;
+    Edge edge;
+  };
+
+  bool is_active(std::uint32_t v) const {
+    return status_[v >> 1] == kActive;
+  }
+
+  // stores the edge and its twin given by a dovetail overlap to arcs
+  static std::uint8_t Classify(
+      const Overlap& o,
+      std::uint32_t lhs_len, std::uint32_t rhs_len,
+      std::uint32_t tolerance,
+      Arc* arcs) {
+    if (o.lhs_id == o.rhs_id) {
+      return kInternal;
+    }
+    if (o.lhs_begin > o.lhs_end || o.lhs_end > lhs_len ||
+        o.rhs_begin > o.rhs_end || o.rhs_end > rhs_len) {
+      throw std::invalid_argument(
+          "[biosoup::StringGraph::StringGraph] error: "
+          "overlap exceeds read length");
+    }
+    // bases before and after the overlap, on rhs in the orientation of lhs
+    std::uint32_t lhs_begin = o.lhs_begin, lhs_end = lhs_len - o.lhs_end;
+    std::uint32_t rhs_begin = o.strand ? o.rhs_begin : rhs_len - o.rhs_end;
+    std::uint32_t rhs_end = o.strand ? rhs_len - o.rhs_end : o.rhs_begin;
+    if (static_cast<std::uint64_t>(std::min(lhs_begin, rhs_begin)) +
+        std::min(lhs_end, rhs_end) > tolerance) {
+      return kInternal;
+    }
+    if (lhs_begin == rhs_begin && lhs_end == rhs_end) {
+      return o.lhs_id > o.rhs_id ? kLhsContained : kRhsContained;
+    }
+    if (lhs_begin <= rhs_begin && lhs_end <= rhs_end) {
+      return kLhsContained;
+    }
+    if (lhs_begin >= rhs_begin && lhs_end >= rhs_end) {
+      return kRhsContained;
+    }
+    std::uint32_t l = o.lhs_id << 1, r = o.rhs_id << 1 | !o.strand;
+    if (lhs_begin > rhs_begin) {
+      arcs[0] = Arc{l, Edge{r, lhs_begin - rhs_begin}};
+      arcs[1] = Arc{r ^ 1, Edge{l ^ 1, rhs_end - lhs_end}};
+    } else {
+      arcs[0] = Arc{r, Edge{l, rhs_begin - lhs_begin}};
+      arcs[1] = Arc{l ^ 1, Edge{r ^ 1, lhs_end - rhs_end}};
+    }
+    return kDovetail;
+  }
+
+  template<typename L>
+  void Build(
+      const std::vector<Overlap>& overlaps,
+      L len,
+      std::uint32_t tolerance,
+      std::uint32_t num_threads) {
+    std::size_t num_blocks =
+        (overlaps.size() + kOverlapBlockSize - 1) / kOverlapBlockSize;
+    auto classify = [&] (std::size_t i, Arc* arcs) -> std::uint8_t {
+      const Overlap& o = overlaps[i];
+      return Classify(o, len(o.lhs_id), len(o.rhs_id), tolerance, arcs);
+    };
+    auto for_each_block = [&] (std::function<void(std::size_t, std::size_t, std::size_t)> f) -> void {  // NOLINT
+      detail::ParallelFor(num_blocks, num_threads, [&] (std::size_t block) -> void {  // NOLINT
+        f(block,
+          block * kOverlapBlockSize,
+          std::min<std::size_t>((block + 1) * kOverlapBlockSize, overlaps.size()));  // NOLINT
+      });
+    };
+
+    // edges are recomputed from dovetail overlaps instead of being kept, as
+    // most of them usually involve contained reads
+    std::vector<std::uint8_t> types(overlaps.size());
+    std::vector<std::uint64_t> max_ids(num_blocks, 0);
+    std::vector<std::vector<std::uint32_t>> contained(num_blocks);
+    for_each_block([&] (std::size_t block, std::size_t first, std::size_t last) -> void {  // NOLINT
+      std::uint64_t max_id = 0;
+      Arc pair[2] = {};
+      for (std::size_t i = first; i < last; ++i) {
+        const Overlap& o = overlaps[i];
+        max_id = std::max<std::uint64_t>(
+            max_id, std::max(o.lhs_id + 1ULL, o.rhs_id + 1ULL));
+        types[i] = classify(i, pair);
+        if (types[i] == kLhsContained) {
+          contained[block].emplace_back(o.lhs_id);
+        } else if (types[i] == kRhsContained) {
+          contained[block].emplace_back(o.rhs_id);
+        }
+      }
+      max_ids[block] = max_id;
+    });
+    std::uint64_t max_id = 0;
+    for (const auto& it : max_ids) {
+      max_id = std::max(max_id, it);
+    }
+    if (max_id >= (1U << 31)) {  // two nodes per read
+      throw std::length_error(
+          "[biosoup::StringGraph::StringGraph] error: too many reads");
+    }
+    std::uint32_t num_reads = max_id;
+    status_.assign(num_reads, kActive);
+    for (const auto& it : contained) {
+      for (const auto& jt : it) {
+        status_[jt] = kContained;
+      }
+    }
+    std::vector<std::vector<std::uint32_t>>().swap(contained);
+
+    // edges are scattered into buckets of consecutive nodes by each block
+    // (at positions given by prefix sums of per-block counts), and each
+    // bucket is then sorted into place on its own
+    std::uint32_t num_nodes = num_reads * 2, shift = 0;
+    while (num_nodes && ((num_nodes - 1ULL) >> shift) >= kNumBuckets) {
+      ++shift;
+    }
+    auto is_edge = [&] (std::size_t i) -> bool {
+      return types[i] == kDovetail &&
+          status_[overlaps[i].lhs_id] == kActive &&
+          status_[overlaps[i].rhs_id] == kActive;
+    };
+    std::vector<std::uint64_t> positions(num_blocks * kNumBuckets, 0);
+    for_each_block([&] (std::size_t block, std::size_t first, std::size_t last) -> void {  // NOLINT
+      std::uint64_t* counts = &positions[block * kNumBuckets];
+      Arc pair[2] = {};
+      for (std::size_t i = first; i < last; ++i) {
+        if (is_edge(i)) {
+          classify(i, pair);
+          ++counts[pair[0].tail >> shift];
+          ++counts[pair[1].tail >> shift];
+        }
+      }
+    });
+    std::vector<std::uint64_t> buckets(kNumBuckets + 1, 0);
+    for (std::uint32_t j = 0; j < kNumBuckets; ++j) {
+      buckets[j + 1] = buckets[j];
+      for (std::size_t block = 0; block < num_blocks; ++block) {
+        std::uint64_t n = positions[block * kNumBuckets + j];
+        positions[block * kNumBuckets + j] = buckets[j + 1];
+        buckets[j + 1] += n;
+      }
+    }
+    std::vector<Arc> arcs(buckets.back());
+    for_each_block([&] (std::size_t block, std::size_t first, std::size_t last) -> void {  // NOLINT
+      std::uint64_t* next = &positions[block * kNumBuckets];
+      Arc pair[2] = {};
+      for (std::size_t i = first; i < last; ++i) {
+        if (is_edge(i)) {
+          classify(i, pair);
+          arcs[next[pair[0].tail >> shift]++] = pair[0];
+          arcs[next[pair[1].tail >> shift]++] = pair[1];
+        }
+      }
+    });
+    std::vector<std::uint64_t>().swap(positions);
+    std::vector<std::uint8_t>().swap(types);
+
+    offsets_.assign(num_nodes + 1ULL, 0);
+    edges_.resize(arcs.size());
+    detail::ParallelFor(kNumBuckets, num_threads, [&] (std::size_t j) -> void {
+      std::uint64_t first = std::min<std::uint64_t>(j << shift, num_nodes);
+      std::uint64_t last = std::min<std::uint64_t>((j + 1) << shift, num_nodes);  // NOLINT
+      if (first == last) {
+        return;
+      }
+      for (std::uint64_t k = buckets[j]; k < buckets[j + 1]; ++k) {
+        ++offsets_[arcs[k].tail + 1];
+      }
+      offsets_[first + 1] += buckets[j];
+      for (std::uint64_t v = first + 1; v < last; ++v) {
+        offsets_[v + 1] += offsets_[v];
+      }
+      // offsets_[first] is written by j - 1, buckets[j] holds the same value
+      std::vector<std::uint64_t> next(1, buckets[j]);
+      next.insert(next.end(), offsets_.begin() + first + 1, offsets_.begin() + last);  // NOLINT
+      for (std::uint64_t k = buckets[j]; k < buckets[j + 1]; ++k) {
+        edges_[next[arcs[k].tail - first]++] = arcs[k].edge;
+      }
+      for (std::uint64_t v = first; v < last; ++v) {
+        std::uint64_t begin = v == first ? buckets[j] : offsets_[v];
+        std::sort(edges_.begin() + begin, edges_.begin() + offsets_[v + 1],
+            [] (const Edge& lhs, const Edge& rhs) -> bool {
+              return lhs.head < rhs.head ||
+                  (lhs.head == rhs.head && lhs.length < rhs.length);
+            });
+      }
+    });
+    std::vector<Arc>().swap(arcs);
+
+    // overlaps reported more than once keep the shortest edge
+    Compact(
+        [&] (std::uint32_t v, std::uint64_t i) -> bool {
+          return i == offsets_[v] || edges_[i - 1].head != edges_[i].head;
+        },
+        num_threads);
+  }
+
+  // keeps edges i of nodes v for which keep(v, i), sorted by length
+  template<typename F>
+  std::uint64_t Compact(F keep, std::uint32_t num_threads) {
+    std::size_t num_blocks = (num_nodes() + kBlockSize - 1) / kBlockSize;
+    std::vector<std::uint64_t> offsets(offsets_.size(), 0);
+    detail::ParallelFor(num_blocks, num_threads, [&] (std::size_t block) -> void {  // NOLINT
+      std::uint32_t last = std::min<std::uint64_t>(
+          num_nodes(), (block + 1) * kBlockSize);
+      for (std::uint32_t v = block * kBlockSize; v < last; ++v) {
+        for (std::uint64_t i = offsets_[v]; i < offsets_[v + 1]; ++i) {
+          offsets[v + 1] += keep(v, i);
+        }
+      }
+    });
+    for (std::size_t i = 1; i < offsets.size(); ++i) {
+      offsets[i] += offsets[i - 1];
+    }
+    std::vector<Edge> edges(offsets.back());
+    detail::ParallelFor(num_blocks, num_threads, [&] (std::size_t block) -> void {  // NOLINT
+      std::uint32_t last = std::min<std::uint64_t>(
+          num_nodes(), (block + 1) * kBlockSize);
+      for (std::uint32_t v = block * kBlockSize; v < last; ++v) {
+        std::uint64_t j = offsets[v];
+        for (std::uint64_t i = offsets_[v]; i < offsets_[v + 1]; ++i) {
+          if (keep(v, i)) {
+            edges[j++] = edges_[i];
+          }
+        }
+        std::sort(edges.begin() + offsets[v], edges.begin() + j,
+            [] (const Edge& lhs, const Edge& rhs) -> bool {
+              return lhs.length < rhs.length ||
+                  (lhs.length == rhs.length && lhs.head < rhs.head);
+            });
+      }
+    });
+    std::uint64_t dst = edges_.size() - edges.size();
+    offsets_.swap(offsets);
+    edges_.swap(edges);
+    return dst;
+  }
+
+  // marks edges of node v which are implied by others (Myers 2005), heads
+  // and marks are reusable buffers
+  void MarkTransitive(
+      std::uint32_t v,
+      std::uint32_t fuzz,
+      std::vector<std::pair<std::uint32_t, std::uint32_t>>* heads,
+      std::vector<std::uint8_t>* marks,
+      std::uint8_t* is_transitive) const {
+    enum : std::uint8_t { kInPlay = 1, kEliminated = 2 };
+    std::uint32_t n = out_degree(v);
+    if (n < 2) {
+      return;
+    }
+    const Edge* edges = out_edges(v);
+    heads->clear();
+    for (std::uint32_t i = 0; i < n; ++i) {
+      heads->emplace_back(edges[i].head, i);
+    }
+    std::sort(heads->begin(), heads->end());
+    marks->assign(n, kInPlay);
+    auto mark = [&] (std::uint32_t x) -> void {
+      auto it = std::lower_bound(
+          heads->begin(), heads->end(), std::make_pair(x, 0U));
+      if (it != heads->end() && it->first == x &&
+          (*marks)[it->second] == kInPlay) {
+        (*marks)[it->second] = kEliminated;
+      }
+    };
+
+    std::uint64_t longest = static_cast<std::uint64_t>(edges[n - 1].length) + fuzz;  // NOLINT
+    for (std::uint32_t i = 0; i < n; ++i) {
+      if ((*marks)[i] != kInPlay) {
+        continue;
+      }
+      std::uint32_t w = edges[i].head;
+      const Edge* next = out_edges(w);
+      for (std::uint32_t j = 0; j < out_degree(w); ++j) {
+        if (static_cast<std::uint64_t>(edges[i].length) + next[j].length > longest) {  // NOLINT
+          break;
+        }
+        mark(next[j].head);
+      }
+    }
+    for (std::uint32_t i = 0; i < n; ++i) {
+      std::uint32_t w = edges[i].head;
+      const Edge* next = out_edges(w);
+      for (std::uint32_t j = 0; j < out_degree(w); ++j) {
+        if (j > 0 && next[j].length >= fuzz) {
+          break;
+        }
+        mark(next[j].head);
+      }
+    }
+    for (std::uint32_t i = 0; i < n; ++i) {
+      is_transitive[i] = (*marks)[i] == kEliminated;
+    }
+  }
+
+  // appends reads of the tip starting at node v
+  void FindTip(
+      std::uint32_t v,
+      std::uint32_t max_len,
+      std::vector<std::uint32_t>* dst) const {
+    if (in_degree(v) != 0 || !is_active(v)) {
+      return;
+    }
+    std::vector<std::uint32_t> path{v >> 1};
+    for (std::uint32_t w = v; out_degree(w) == 1;) {
+      w = out_edges(w)->head;
+      if (in_degree(w) > 1) {
+        dst->insert(dst->end(), path.begin(), path.end());
+        return;
+      }
+      if (path.size() == max_len ||
+          std::find(path.begin(), path.end(), w >> 1) != path.end()) {
+        return;
+      }
+      path.emplace_back(w >> 1);
+    }
+  }
+
+  // appends reads of the bubble starting at node v, except for those on the
+  // path with most reads (with the smallest read id on ties)
+  void FindBubble(
+      std::uint32_t v,
+      std::uint32_t max_len,
+      std::vector<std::uint32_t>* dst) const {
+    if (out_degree(v) < 2 || !is_active(v)) {
+      return;
+    }
+    struct Path {
+      std::uint32_t end;
+      std::vector<std::uint32_t> reads;
+      std::uint32_t min_read;
+    };
+    std::vector<Path> paths;
+    for (std::uint32_t i = 0; i < out_degree(v); ++i) {
+      Path p{out_edges(v)[i].head, {}, UINT32_MAX};
+      while (in_degree(p.end) == 1 && out_degree(p.end) == 1 &&
+             p.reads.size() < max_len) {
+        p.reads.emplace_back(p.end >> 1);
+        p.min_read = std::min(p.min_read, p.end >> 1);
+        p.end = out_edges(p.end)->head;
+      }
+      if (in_degree(p.end) < 2 || (p.end >> 1) == (v >> 1) ||
+          std::find(p.reads.begin(), p.reads.end(), v >> 1) != p.reads.end() ||  // NOLINT
+          std::find(p.reads.begin(), p.reads.end(), p.end >> 1) != p.reads.end()) {  // NOLINT
+        continue;
+      }
+      paths.emplace_back(std::move(p));
+    }
+    std::sort(paths.begin(), paths.end(),
+        [] (const Path& lhs, const Path& rhs) -> bool {
+          return lhs.end < rhs.end ||
+              (lhs.end == rhs.end && (lhs.reads.size() > rhs.reads.size() ||
+              (lhs.reads.size() == rhs.reads.size() &&
+                  lhs.min_read < rhs.min_read)));
+        });
+    for (std::size_t i = 1; i < paths.size(); ++i) {
+      if (paths[i].end == paths[i - 1].end) {
+        dst->insert(dst->end(), paths[i].reads.begin(), paths[i].reads.end());
+      }
+    }
+  }
+
+  // removes reads found by f(v, dst) over all nodes, along with their edges,
+  // returns the number of removed reads
+  template<typename F>
+  std::uint32_t RemoveReads(F f, std::uint32_t num_threads) {
+    std::size_t num_blocks = (num_nodes() + kBlockSize - 1) / kBlockSize;
+    std::vector<std::vector<std::uint32_t>> ids(num_blocks);
+    detail::ParallelFor(num_blocks, num_threads, [&] (std::size_t block) -> void {  // NOLINT
+      std::uint32_t last = std::min<std::uint64_t>(
+          num_nodes(), (block + 1) * kBlockSize);
+      for (std::uint32_t v = block * kBlockSize; v < last; ++v) {
+        f(v, &ids[block]);
+      }
+    });
+    std::uint32_t dst = 0;
+    for (const auto& it : ids) {
+      for (const auto& jt : it) {
+        if (status_[jt] == kActive) {
+          status_[jt] = kRemoved;
+          ++dst;
+        }
+      }
+    }
+    if (dst) {
+      Compact(
+          [&] (std::uint32_t v, std::uint64_t i) -> bool {
+            return is_active(v) && is_active(edges_[i].head);
+          },
+          num_threads);
+    }
+    return dst;
+  }
+
+  std::vector<std::uint8_t> status_;  // of reads
+  std::vector<std::uint64_t> offsets_;  // of edges of nodes
+  std::vector<Edge> edges_;
+};
+
+}  // namespace biosoup
+
+#endif  // BIOSOUP_STRING_GRAPH_HPP_
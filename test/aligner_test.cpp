@@ -0,0 +1,206 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/aligner.hpp"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "test_utils.hpp"
+
+namespace biosoup {
+namespace test {
+
+class BiosoupAlignerTest: public ::testing::Test {
+ public:
+  // copy of data with substitutions, insertions and deletions at rate
+  static std::string Mutate(
+      const std::string& data,
+      double rate,
+      std::mt19937* generator) {
+    std::string dst;
+    std::uniform_real_distribution<double> distribution(0, 1);
+    for (const auto& it : data) {
+      double x = distribution(*generator);
+      if (x < rate / 3) {
+        dst += "ACGT"[(*generator)() & 3];
+      } else if (x < rate * 2 / 3) {
+        dst += it;
+        dst += "ACGT"[(*generator)() & 3];
+      } else if (x >= rate) {
+        dst += it;
+      }
+    }
+    return dst;
+  }
+
+  static std::uint32_t EditDistance(const std::string& lhs, const std::string& rhs) {  // NOLINT
+    std::vector<std::uint32_t> column(lhs.size() + 1);
+    for (std::uint32_t i = 0; i <= lhs.size(); ++i) {
+      column[i] = i;
+    }
+    for (std::uint32_t j = 1; j <= rhs.size(); ++j) {
+      std::uint32_t diagonal = column[0];
+      column[0] = j;
+      for (std::uint32_t i = 1; i <= lhs.size(); ++i) {
+        std::uint32_t score = std::min(
+            diagonal + (lhs[i - 1] != rhs[j - 1]),
+            std::min(column[i], column[i - 1]) + 1);
+        diagonal = column[i];
+        column[i] = score;
+      }
+    }
+    return column.back();
+  }
+
+  // checks that cigar turns lhs into rhs, returns the number of edits
+  static std::uint32_t Apply(
+      const std::vector<std::uint32_t>& cigar,
+      const std::string& lhs,
+      const std::string& rhs) {
+    std::uint32_t i = 0, j = 0, dst = 0;
+    for (const auto& it : cigar) {
+      for (std::uint32_t k = 0; k < CigarLength(it); ++k) {
+        switch (CigarOp(it)) {
+          case kCigarEqual: EXPECT_EQ(lhs[i++], rhs[j++]); break;
+          case kCigarMismatch: EXPECT_NE(lhs[i++], rhs[j++]); ++dst; break;
+          case kCigarInsertion: ++i; ++dst; break;
+          case kCigarDeletion: ++j; ++dst; break;
+          default: ADD_FAILURE(); break;
+        }
+      }
+    }
+    EXPECT_EQ(lhs.size(), i);
+    EXPECT_EQ(rhs.size(), j);
+    return dst;
+  }
+};
+
+TEST_F(BiosoupAlignerTest, Align) {
+  std::mt19937 generator(42);
+  Aligner aligner{UINT32_MAX};
+  for (std::uint32_t t = 0; t < 100; ++t) {
+    std::string data = RandomData(generator() % 500, &generator);
+    std::string other = Mutate(data, 0.15, &generator);
+    NucleicAcid lhs{"lhs", data}, rhs{"rhs", other};
+    NucleicAcidView l = NucleicAcidView(lhs), r = NucleicAcidView(rhs);
+    if (t & 1) {  // in both orientations
+      l.ReverseAndComplement();
+      data = l.InflateData();
+    }
+    if (t & 2) {
+      l = l.Slice(t % 7, data.size() - t % 13);
+      data = l.InflateData();
+    }
+
+    std::uint32_t expected = EditDistance(data, other);
+    EXPECT_EQ(expected, aligner.EditDistance(l, r));
+    std::vector<std::uint32_t> cigar;
+    EXPECT_EQ(expected, aligner.Align(l, r, &cigar));
+    EXPECT_EQ(expected, Apply(cigar, data, other));
+  }
+
+  std::vector<std::uint32_t> cigar;
+  NucleicAcid lhs{"lhs", "ACGTTACG"}, rhs{"rhs", "ACTTACCG"};
+  EXPECT_EQ(2U, aligner.Align(NucleicAcidView(lhs), NucleicAcidView(rhs), &cigar));  // NOLINT
+  EXPECT_EQ("2=1I3=1D2=", DecodeCigar(cigar));
+  EXPECT_EQ(8U, aligner.Align(NucleicAcidView(lhs), NucleicAcidView(), &cigar));  // NOLINT
+  EXPECT_EQ("2=1I3=1D2=8I", DecodeCigar(cigar));
+}
+
+TEST_F(BiosoupAlignerTest, Band) {
+  std::mt19937 generator(7);
+  std::string data = RandomData(5000, &generator);
+  std::string other = Mutate(data, 0.1, &generator);
+  NucleicAcid lhs{"lhs", data}, rhs{"rhs", other};
+  std::uint32_t expected = EditDistance(data, other);
+
+  for (std::uint32_t band : {0U, 16U, 64U, 200U, 1000U}) {
+    Aligner aligner{band};
+    std::vector<std::uint32_t> cigar;
+    std::uint32_t distance = aligner.Align(
+        NucleicAcidView(lhs), NucleicAcidView(rhs), &cigar);
+    EXPECT_LE(expected, distance);
+    EXPECT_EQ(distance, Apply(cigar, data, other));
+    if (band >= 200) {
+      EXPECT_EQ(expected, distance);
+    }
+  }
+}
+
+TEST_F(BiosoupAlignerTest, Overlaps) {
+  std::mt19937 generator(42);
+  std::string genome = RandomData(50000, &generator);
+  std::vector<std::unique_ptr<NucleicAcid>> sequences;
+  std::vector<Overlap> overlaps;
+  for (std::uint32_t i = 0; i < 40; ++i) {
+    std::uint32_t begin = generator() % 40000;
+    std::uint32_t len = 2000 + generator() % 8000;
+    std::string data = Mutate(genome.substr(begin, len), 0.05, &generator);
+    sequences.emplace_back(new NucleicAcid("read", data));
+    if (i & 1) {
+      sequences.back()->ReverseAndComplement();
+    }
+    overlaps.emplace_back(
+        i, generator() % 500, data.size() - generator() % 500,
+        (i + 1) % 40, 100, 1500,
+        0,
+        (i & 2) == 0);
+  }
+
+  Aligner aligner{};
+  for (std::uint32_t i = 0; i < 4; ++i) {
+    Overlap o = overlaps[i];
+    const NucleicAcid& lhs = *sequences[o.lhs_id];
+    const NucleicAcid& rhs = *sequences[o.rhs_id];
+    std::string l = lhs.InflateData(o.lhs_begin, o.lhs_end - o.lhs_begin);
+    std::string r = rhs.InflateData(o.rhs_begin, o.rhs_end - o.rhs_begin);
+    if (!o.strand) {
+      NucleicAcid tmp{"tmp", l};
+      tmp.ReverseAndComplement();
+      l = tmp.InflateData();
+    }
+    std::uint32_t distance = aligner.Align(
+        NucleicAcidView(lhs), NucleicAcidView(rhs), &o);
+    Cigar cigar{o};
+    EXPECT_EQ(distance, Apply(cigar.words(), l, r));
+    EXPECT_EQ(cigar.num_matches(), o.score);
+    EXPECT_EQ(o.lhs_end - o.lhs_begin, cigar.lhs_len());
+  }
+
+  std::vector<Overlap> expected = overlaps;
+  for (auto& it : expected) {
+    aligner.Align(
+        NucleicAcidView(*sequences[it.lhs_id]),
+        NucleicAcidView(*sequences[it.rhs_id]),
+        &it);
+  }
+  aligner.Align(
+      [&] (std::uint32_t id) -> NucleicAcidView {
+        return NucleicAcidView(*sequences[id]);
+      },
+      &overlaps,
+      4);
+  for (std::uint32_t i = 0; i < overlaps.size(); ++i) {
+    EXPECT_EQ(expected[i].alignment, overlaps[i].alignment);
+    EXPECT_EQ(expected[i].score, overlaps[i].score);
+  }
+}
+
+TEST_F(BiosoupAlignerTest, Error) {
+  NucleicAcid lhs{"lhs", "ACGT"}, rhs{"rhs", "ACGT"};
+  Overlap o{0, 0, 5, 1, 0, 4, 0};
+  try {
+    Aligner{}.Align(NucleicAcidView(lhs), NucleicAcidView(rhs), &o);
+  } catch (std::invalid_argument& exception) {
+    EXPECT_STREQ(
+        exception.what(),
+        "[biosoup::Aligner::Align] error: overlap exceeds sequence length");
+  }
+}
+
+}  // namespace test
+}  // namespace biosoup
@@ -0,0 +1,194 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/chainer.hpp"
+
+#include <random>
+
+#include "gtest/gtest.h"
+
+namespace biosoup {
+namespace test {
+
+class BiosoupChainerTest: public ::testing::Test {
+ public:
+  // anchors of a k-mer every step bases of an overlap of length len starting
+  // at lhs_begin and rhs_begin, with positions shifted by up to noise bases
+  static void Diagonal(
+      std::uint32_t lhs_begin,
+      std::uint32_t rhs_begin,
+      std::uint32_t len,
+      std::uint32_t step,
+      std::uint32_t noise,
+      bool strand,
+      std::mt19937* generator,
+      std::vector<Anchor>* dst) {
+    for (std::uint32_t i = 0; i + 15 <= len; i += step) {
+      std::uint32_t j = i ? i - (*generator)() % (noise + 1) : i;
+      dst->push_back(Anchor{
+          lhs_begin + i,
+          strand ? rhs_begin + j : rhs_begin + len - 15 - j,
+          strand});
+    }
+  }
+};
+
+TEST_F(BiosoupChainerTest, Kernel) {
+  std::mt19937 generator(42);
+  std::vector<std::int32_t> q(2000), t(2000), f(2000);
+  for (std::uint32_t i = 0; i < q.size(); ++i) {
+    q[i] = generator() % 20000;
+    t[i] = i * 10 + generator() % 10;
+    f[i] = generator() % 200;
+  }
+  detail::ChainParameters p{15, 500, 100, 38};
+  for (std::int32_t i = 0; i < static_cast<std::int32_t>(q.size()); ++i) {
+    std::int32_t first = std::max(0, i - 1 - static_cast<std::int32_t>(generator() % 100));  // NOLINT
+    std::int32_t score = 0, expected = 0;
+    std::int32_t j = detail::BestPredecessor(
+        q.data(), t.data(), f.data(), first, i, p, &score);
+    EXPECT_EQ(
+        detail::BestPredecessorScalar(
+            q.data(), t.data(), f.data(), first, i, p, &expected),
+        j);
+    if (j != -1) {
+      EXPECT_EQ(expected, score);
+    }
+  }
+}
+
+TEST_F(BiosoupChainerTest, Chain) {
+  std::mt19937 generator(42);
+  std::vector<Anchor> anchors;
+  Diagonal(1000, 0, 4000, 40, 5, true, &generator, &anchors);
+  Diagonal(300, 2000, 2000, 40, 5, false, &generator, &anchors);
+  for (std::uint32_t i = 0; i < 200; ++i) {  // spurious, off the diagonals
+    anchors.push_back(Anchor{
+        static_cast<std::uint32_t>(generator() % 8000),
+        static_cast<std::uint32_t>(10000 + generator() % 8000),
+        (generator() & 1) == 1});
+  }
+  std::shuffle(anchors.begin(), anchors.end(), generator);
+
+  Chainer c{15, 3, 200};
+  std::vector<Overlap> overlaps;
+  EXPECT_EQ(2U, c.Chain(3, 7, anchors, &overlaps));
+  ASSERT_EQ(2U, overlaps.size());
+
+  EXPECT_EQ(3U, overlaps[0].lhs_id);
+  EXPECT_EQ(1000U, overlaps[0].lhs_begin);
+  EXPECT_EQ(4975U, overlaps[0].lhs_end);
+  EXPECT_EQ(7U, overlaps[0].rhs_id);
+  EXPECT_EQ(0U, overlaps[0].rhs_begin);
+  EXPECT_GE(3975U, overlaps[0].rhs_end);
+  EXPECT_LE(3970U, overlaps[0].rhs_end);
+  EXPECT_TRUE(overlaps[0].strand);
+  EXPECT_LT(1000U, overlaps[0].score);
+  EXPECT_GE(100U * 15, overlaps[0].score);
+
+  EXPECT_EQ(300U, overlaps[1].lhs_begin);
+  EXPECT_EQ(2275U, overlaps[1].lhs_end);
+  EXPECT_GE(2030U, overlaps[1].rhs_begin);
+  EXPECT_LE(2025U, overlaps[1].rhs_begin);
+  EXPECT_EQ(4000U, overlaps[1].rhs_end);
+  EXPECT_FALSE(overlaps[1].strand);
+  EXPECT_GT(overlaps[0].score, overlaps[1].score);
+
+  std::vector<Overlap> strict;
+  Chainer{15, 60}.Chain(3, 7, anchors, &strict);
+  ASSERT_EQ(1U, strict.size());
+  EXPECT_TRUE(strict[0].strand);
+}
+
+TEST_F(BiosoupChainerTest, Hits) {
+  std::mt19937 generator(7);
+  std::vector<Anchor> lhs, rhs;
+  Diagonal(0, 500, 3000, 30, 3, true, &generator, &lhs);
+  Diagonal(100, 0, 2000, 30, 3, false, &generator, &rhs);
+  std::vector<MinimizerHit> hits;
+  for (const auto& it : lhs) {
+    hits.push_back(MinimizerHit{5, it.rhs_position, it.lhs_position, it.strand});  // NOLINT
+  }
+  for (const auto& it : rhs) {
+    hits.push_back(MinimizerHit{2, it.rhs_position, it.lhs_position, it.strand});  // NOLINT
+  }
+  std::shuffle(hits.begin(), hits.end(), generator);
+
+  Chainer c{15};
+  std::vector<Overlap> overlaps, expected;
+  EXPECT_EQ(2U, c.Chain(9, hits, &overlaps));
+  c.Chain(9, 2, rhs, &expected);
+  c.Chain(9, 5, lhs, &expected);
+  ASSERT_EQ(expected.size(), overlaps.size());
+  for (std::uint32_t i = 0; i < overlaps.size(); ++i) {
+    EXPECT_EQ(9U, overlaps[i].lhs_id);
+    EXPECT_EQ(expected[i].rhs_id, overlaps[i].rhs_id);
+    EXPECT_EQ(expected[i].lhs_begin, overlaps[i].lhs_begin);
+    EXPECT_EQ(expected[i].rhs_end, overlaps[i].rhs_end);
+    EXPECT_EQ(expected[i].score, overlaps[i].score);
+  }
+}
+
+TEST_F(BiosoupChainerTest, Batches) {
+  std::mt19937 generator(42);
+  std::vector<AnchorBatch> batches(500);
+  for (std::uint32_t i = 0; i < batches.size(); ++i) {
+    batches[i].lhs_id = i;
+    batches[i].rhs_id = i + 1;
+    Diagonal(
+        generator() % 1000, generator() % 1000, 500 + generator() % 5000,
+        20 + generator() % 40, 5, (generator() & 1) == 1,
+        &generator, &batches[i].anchors);
+    for (std::uint32_t j = generator() % 100; j > 0; --j) {
+      batches[i].anchors.push_back(Anchor{
+          static_cast<std::uint32_t>(generator() % 6000),
+          static_cast<std::uint32_t>(generator() % 6000),
+          (generator() & 1) == 1});
+    }
+  }
+
+  Chainer c{15};
+  std::vector<Overlap> expected;
+  for (const auto& it : batches) {
+    c.Chain(it.lhs_id, it.rhs_id, it.anchors, &expected);
+  }
+  auto overlaps = c.Chain(batches, 4);
+  ASSERT_EQ(expected.size(), overlaps.size());
+  EXPECT_LE(batches.size(), overlaps.size());
+  for (std::uint32_t i = 0; i < overlaps.size(); ++i) {
+    EXPECT_EQ(expected[i].lhs_id, overlaps[i].lhs_id);
+    EXPECT_EQ(expected[i].lhs_begin, overlaps[i].lhs_begin);
+    EXPECT_EQ(expected[i].lhs_end, overlaps[i].lhs_end);
+    EXPECT_EQ(expected[i].rhs_begin, overlaps[i].rhs_begin);
+    EXPECT_EQ(expected[i].rhs_end, overlaps[i].rhs_end);
+    EXPECT_EQ(expected[i].score, overlaps[i].score);
+    EXPECT_EQ(expected[i].strand, overlaps[i].strand);
+  }
+}
+
+TEST_F(BiosoupChainerTest, Error) {
+  try {
+    Chainer c{33};
+  } catch (std::invalid_argument& exception) {
+    EXPECT_STREQ(
+        exception.what(),
+        "[biosoup::Chainer::Chainer] error: k is not in [1, 32]");
+  }
+  try {
+    Chainer c{15, 3, 40, 5000, 500, 0};
+  } catch (std::invalid_argument& exception) {
+    EXPECT_STREQ(
+        exception.what(),
+        "[biosoup::Chainer::Chainer] error: lookback is not in [1, 2^31)");
+  }
+  try {
+    std::vector<Overlap> overlaps;
+    Chainer{15}.Chain(0, 1, {Anchor{1U << 31, 0, true}}, &overlaps);
+  } catch (std::invalid_argument& exception) {
+    EXPECT_STREQ(
+        exception.what(),
+        "[biosoup::Chainer::Chain] error: position is too large");
+  }
+}
+
+}  // namespace test
+}  // namespace biosoup
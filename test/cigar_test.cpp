@@ -0,0 +1,79 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/cigar.hpp"
+
+#include "gtest/gtest.h"
+
+namespace biosoup {
+namespace test {
+
+TEST(BiosoupCigarTest, Encode) {
+  auto c = EncodeCigar("10M2I3D1=4X100S5H");
+  ASSERT_EQ(7U, c.size());
+  EXPECT_EQ(CigarWord(10, kCigarMatch), c[0]);
+  EXPECT_EQ(2U, CigarLength(c[1]));
+  EXPECT_EQ(kCigarInsertion, CigarOp(c[1]));
+  EXPECT_EQ(kCigarHardClip, CigarOp(c[6]));
+  EXPECT_EQ("10M2I3D1=4X100S5H", DecodeCigar(c));
+  EXPECT_TRUE(EncodeCigar("").empty());
+  EXPECT_THROW(EncodeCigar("10M5"), std::invalid_argument);
+  EXPECT_THROW(EncodeCigar("M"), std::invalid_argument);
+  EXPECT_THROW(EncodeCigar("10Q"), std::invalid_argument);
+}
+
+TEST(BiosoupCigarTest, Statistics) {
+  Cigar c{"5S10M2I3D4=1X2H"};
+  EXPECT_EQ(7U, c.size());
+  EXPECT_EQ(22U, c.lhs_len());
+  EXPECT_EQ(18U, c.rhs_len());
+  EXPECT_EQ(14U, c.num_matches());
+  EXPECT_EQ(1U, c.num_mismatches());
+  EXPECT_EQ(2U, c.num_insertions());
+  EXPECT_EQ(3U, c.num_deletions());
+  EXPECT_EQ(6U, c.EditDistance());
+  EXPECT_DOUBLE_EQ(0.7, c.Identity());
+  EXPECT_EQ("5S10M2I3D4=1X2H", c.ToString());
+
+  Overlap o{0, 0, 3, 1, 0, 3, 3, std::string("3=")};
+  EXPECT_DOUBLE_EQ(1, Cigar(o).Identity());
+  EXPECT_DOUBLE_EQ(0, Cigar().Identity());
+}
+
+TEST(BiosoupCigarTest, Projection) {
+  Cigar c{"5S10M2I3D4=1X"};
+  EXPECT_EQ(0U, c.LhsToRhs(0));  // clipped
+  EXPECT_EQ(0U, c.LhsToRhs(5));
+  EXPECT_EQ(9U, c.LhsToRhs(14));
+  EXPECT_EQ(10U, c.LhsToRhs(15));  // inserted
+  EXPECT_EQ(13U, c.LhsToRhs(17));
+  EXPECT_EQ(17U, c.LhsToRhs(21));
+  EXPECT_EQ(18U, c.LhsToRhs(22));
+
+  EXPECT_EQ(14U, c.RhsToLhs(9));
+  EXPECT_EQ(17U, c.RhsToLhs(10));  // deleted
+  EXPECT_EQ(17U, c.RhsToLhs(12));
+  EXPECT_EQ(17U, c.RhsToLhs(13));
+  EXPECT_EQ(21U, c.RhsToLhs(17));
+  EXPECT_EQ(22U, c.RhsToLhs(100));
+
+  // compared to a linear scan
+  for (std::uint32_t i = 0; i < c.lhs_len(); ++i) {
+    std::uint32_t l = 0, r = 0, e = 0;
+    for (auto it : c.words()) {
+      std::uint32_t len = CigarLength(it);
+      bool is_l = CigarOp(it) != kCigarDeletion;
+      bool is_r = CigarOp(it) != kCigarInsertion &&
+          CigarOp(it) != kCigarSoftClip;
+      if (is_l && i < l + len) {
+        e = r + (is_r ? i - l : 0);
+        break;
+      }
+      l += is_l ? len : 0;
+      r += is_r ? len : 0;
+    }
+    EXPECT_EQ(e, c.LhsToRhs(i));
+  }
+}
+
+}  // namespace test
+}  // namespace biosoup
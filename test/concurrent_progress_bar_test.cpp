@@ -0,0 +1,57 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/concurrent_progress_bar.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace biosoup {
+namespace test {
+
+TEST(BiosoupConcurrentProgressBarTest, Add) {
+  std::ostringstream os;
+  ConcurrentProgressBar pb{40000, 8, &os};
+  std::vector<std::thread> threads;
+  for (std::uint32_t i = 0; i < 4; ++i) {
+    threads.emplace_back([&] () -> void {
+      for (std::uint32_t j = 0; j < 5000; ++j) {
+        ++pb;
+        pb.Add(1);
+      }
+    });
+  }
+  for (auto& it : threads) {
+    it.join();
+  }
+  EXPECT_EQ(40000U, pb.event_counter());
+  EXPECT_EQ(0U, pb.ToString().find("[========] 100% 40000/40000 | "));
+  EXPECT_NE(std::string::npos, pb.ToString().find("ETA 00:00:00"));
+  EXPECT_TRUE(os.str().empty());
+}
+
+TEST(BiosoupConcurrentProgressBarTest, Render) {
+  std::ostringstream os;
+  ConcurrentProgressBar pb{8, 4, &os, "stage", 1};
+  EXPECT_EQ(0U, pb.ToString().find("stage [>   ] 0% 0/8 | 0 events/s | ETA --:--:--"));  // NOLINT
+  pb.Add(4);
+  EXPECT_EQ(0U, pb.ToString().find("stage [==> ] 50% 4/8"));
+
+  EXPECT_TRUE(pb.Render());
+  EXPECT_FALSE(pb.Render());
+  EXPECT_TRUE(pb.Render(true));
+  std::string s = os.str();
+  EXPECT_EQ(2, std::count(s.begin(), s.end(), '\r'));
+
+  pb.Start();
+  pb.Add(4);
+  pb.Stop();
+  s = os.str();
+  EXPECT_EQ('\n', s.back());
+  EXPECT_NE(std::string::npos, s.find("\rstage [====] 100% 8/8"));
+}
+
+}  // namespace test
+}  // namespace biosoup
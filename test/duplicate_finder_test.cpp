@@ -0,0 +1,117 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/duplicate_finder.hpp"
+
+#include <algorithm>
+#include <map>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "test_utils.hpp"
+
+namespace biosoup {
+namespace test {
+
+class BiosoupDuplicateFinderTest: public ::testing::Test {
+ public:
+  void SetUp() override {
+    std::mt19937 generator(42);
+    std::vector<std::string> data;
+    for (std::uint32_t i = 0; i < 3000; ++i) {
+      if (i % 3 == 2) {  // copy of an earlier read
+        data.emplace_back(data[generator() % data.size()]);
+      } else {
+        data.emplace_back(RandomData(100 + generator() % 400, &generator));
+      }
+      s.emplace_back(new NucleicAcid("read", data.back()));
+      if (generator() & 1) {
+        s.back()->ReverseAndComplement();
+      }
+    }
+  }
+
+  std::vector<std::vector<ObjectId>> FindByHand(bool is_canonical) const {
+    std::map<std::string, std::vector<ObjectId>> groups;
+    for (const auto& it : s) {
+      std::string data = it->InflateData();
+      if (is_canonical) {
+        NucleicAcid r = *it;
+        r.ReverseAndComplement();
+        data = std::min(data, r.InflateData());
+      }
+      groups[data].emplace_back(it->id);
+    }
+    std::vector<std::vector<ObjectId>> dst;
+    for (const auto& it : groups) {
+      if (it.second.size() > 1) {
+        dst.emplace_back(it.second);
+      }
+    }
+    std::sort(dst.begin(), dst.end());
+    return dst;
+  }
+
+  std::vector<std::unique_ptr<NucleicAcid>> s;
+};
+
+TEST_F(BiosoupDuplicateFinderTest, Find) {
+  for (bool is_canonical : {true, false}) {
+    DuplicateFinder d{is_canonical, 1ULL << 32, ::testing::TempDir(), 4};
+    d.Add(s);
+    EXPECT_EQ(s.size(), d.num_sequences());
+    EXPECT_EQ(0U, d.num_spills());
+    auto groups = d.Find();
+    EXPECT_EQ(FindByHand(is_canonical), groups);
+    EXPECT_FALSE(groups.empty());
+    EXPECT_EQ(0U, d.memory_usage());
+  }
+}
+
+TEST_F(BiosoupDuplicateFinderTest, Spill) {
+  DuplicateFinder d{true, 1U << 12, ::testing::TempDir(), 3};
+  for (std::size_t i = 0; i < s.size(); i += 500) {
+    std::vector<std::unique_ptr<NucleicAcid>> batch;
+    for (std::size_t j = i; j < std::min(i + 500, s.size()); ++j) {
+      batch.emplace_back(new NucleicAcid(*s[j]));
+    }
+    d.Add(batch);
+    EXPECT_GE(1U << 12, d.memory_usage());
+  }
+  EXPECT_EQ(6U, d.num_spills());
+  EXPECT_EQ(FindByHand(true), d.Find());
+}
+
+TEST_F(BiosoupDuplicateFinderTest, Ambiguous) {
+  std::vector<std::unique_ptr<NucleicAcid>> ambiguous;
+  for (const char* it : {"ACGTNACGTA", "ACGTAACGTA", "ACGTNACGTA"}) {
+    ambiguous.emplace_back(new NucleicAcid("read", 4, it, 10, true));
+  }
+  DuplicateFinder d{};
+  d.Add(ambiguous);
+  std::vector<std::vector<ObjectId>> groups{{ambiguous[0]->id, ambiguous[2]->id}};  // NOLINT
+  EXPECT_EQ(groups, d.Find());
+}
+
+TEST_F(BiosoupDuplicateFinderTest, Error) {
+  DuplicateFinder d{};
+  d.Add(s);
+  d.Find();
+  try {
+    d.Add(s);
+  } catch (std::logic_error& exception) {
+    EXPECT_STREQ(
+        exception.what(),
+        "[biosoup::DuplicateFinder::Add] error: duplicates already found");
+  }
+  try {
+    d.Find();
+  } catch (std::logic_error& exception) {
+    EXPECT_STREQ(
+        exception.what(),
+        "[biosoup::DuplicateFinder::Find] error: duplicates already found");
+  }
+}
+
+}  // namespace test
+}  // namespace biosoup
@@ -0,0 +1,119 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/fingerprint.hpp"
+
+#include <random>
+#include <set>
+
+#include "gtest/gtest.h"
+
+#include "test_utils.hpp"
+
+namespace biosoup {
+namespace test {
+
+TEST(BiosoupFingerprintTest, Compute) {
+  std::mt19937 generator(42);
+  std::set<Fingerprint> fingerprints;
+  for (std::uint32_t len : {0, 1, 31, 32, 33, 64, 65, 2047, 2048, 2049, 5000}) {  // NOLINT
+    std::string data = RandomData(len, &generator);
+    NucleicAcid n{"fp", data};
+    NucleicAcid r{"fp", ReverseComplement(data)};
+    NucleicAcid c{"fp", data};
+    c.ReverseAndComplement();
+
+    Fingerprint f = ComputeFingerprint(n);
+    EXPECT_EQ(f, ComputeFingerprint(NucleicAcid{"fp", data}));
+    EXPECT_EQ(ComputeFingerprint(r), ComputeFingerprint(c));
+    if (len > 0) {
+      EXPECT_NE(f, ComputeFingerprint(r));
+    }
+    EXPECT_TRUE(fingerprints.emplace(f).second);
+
+    Fingerprint g = ComputeCanonicalFingerprint(n);
+    EXPECT_EQ(g, ComputeCanonicalFingerprint(r));
+    EXPECT_EQ(g, ComputeCanonicalFingerprint(c));
+    EXPECT_TRUE(g == f || g == ComputeFingerprint(r));
+
+    if (len > 2) {  // views into the middle of the sequence
+      NucleicAcid m{"fp", data.substr(1, len - 2)};
+      NucleicAcidView v = NucleicAcidView{n}.Slice(1, len - 2);
+      EXPECT_EQ(ComputeFingerprint(m), ComputeFingerprint(v));
+      v.ReverseAndComplement();
+      EXPECT_EQ(ComputeCanonicalFingerprint(m), ComputeCanonicalFingerprint(v));  // NOLINT
+    }
+  }
+
+  // equal prefixes of different lengths, including bases past the tail
+  std::string data(100, 'A');
+  EXPECT_NE(
+      ComputeFingerprint(NucleicAcid{"fp", data}),
+      ComputeFingerprint(NucleicAcid{"fp", data + "A"}));
+  NucleicAcid n{"fp", data + "C"};
+  EXPECT_EQ(
+      ComputeFingerprint(NucleicAcid{"fp", data}),
+      ComputeFingerprint(NucleicAcidView{n}.Slice(0, 100)));
+}
+
+TEST(BiosoupFingerprintTest, Single) {
+  std::mt19937 generator(7);
+  std::string data = RandomData(1000, &generator);
+  std::set<Fingerprint> fingerprints;
+  for (std::uint32_t i = 0; i < 1000; ++i) {  // every substitution differs
+    std::string s = data;
+    s[i] = s[i] == 'A' ? 'C' : 'A';
+    EXPECT_TRUE(fingerprints.emplace(ComputeFingerprint(NucleicAcid{"fp", s})).second);  // NOLINT
+  }
+}
+
+TEST(BiosoupFingerprintTest, Ambiguous) {
+  auto create = [] (const std::string& data) -> NucleicAcid {
+    return NucleicAcid{"fp", 2, data.c_str(), static_cast<std::uint32_t>(data.size()), true};  // NOLINT
+  };
+  EXPECT_NE(
+      ComputeFingerprint(create("ACGTN")),
+      ComputeFingerprint(create("ACGTA")));
+  EXPECT_NE(
+      ComputeCanonicalFingerprint(create("ACGTN")),
+      ComputeCanonicalFingerprint(create("ACGTA")));
+  EXPECT_NE(
+      ComputeFingerprint(create("ACNTA")),
+      ComputeFingerprint(create("ACGNA")));
+  EXPECT_NE(
+      ComputeFingerprint(create("ACNNA")),
+      ComputeFingerprint(create("ACNRA")));
+  EXPECT_EQ(
+      ComputeFingerprint(create("ACGTA")),
+      ComputeFingerprint(NucleicAcid{"fp", "ACGTN"}));  // without runs
+  EXPECT_EQ(
+      ComputeFingerprint(create("ACGtn")),
+      ComputeFingerprint(create("ACGTN")));  // case is not hashed
+
+  std::mt19937 generator(42);
+  std::string data = RandomData(5000, &generator);
+  data.replace(10, 5, "NNNNN");
+  data.replace(500, 2, "RY");
+  data.replace(2040, 20, std::string(20, 'N'));  // across packed chunks
+  NucleicAcid n = create(data);
+  NucleicAcid r = create("TT" + data.substr(2));
+  EXPECT_NE(ComputeFingerprint(n), ComputeFingerprint(r));
+  n.ReverseAndComplement();
+  EXPECT_EQ(ComputeFingerprint(create(n.InflateData())), ComputeFingerprint(n));  // NOLINT
+  NucleicAcid c = create(n.InflateData());
+  c.ReverseAndComplement();
+  EXPECT_EQ(ComputeFingerprint(c), ComputeFingerprint(create(data)));
+  EXPECT_EQ(ComputeCanonicalFingerprint(n), ComputeCanonicalFingerprint(create(data)));  // NOLINT
+
+  // equal packed bases in both orientations, only the runs differ
+  NucleicAcid p = create("ACNT");
+  NucleicAcid q = create("ANGT");
+  EXPECT_EQ(ComputeCanonicalFingerprint(p), ComputeCanonicalFingerprint(q));
+  p.ReverseAndComplement();
+  EXPECT_EQ(ComputeCanonicalFingerprint(p), ComputeCanonicalFingerprint(q));
+  EXPECT_NE(
+      ComputeCanonicalFingerprint(create("ACNT")),
+      ComputeCanonicalFingerprint(create("ACGT")));
+}
+
+}  // namespace test
+}  // namespace biosoup
@@ -0,0 +1,138 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/hpc_nucleic_acid.hpp"
+
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "test_utils.hpp"
+
+namespace biosoup {
+namespace test {
+
+class BiosoupHpcNucleicAcidTest: public ::testing::Test {
+ public:
+  // runs of geometric length, with a few long ones
+  static std::string RandomRuns(std::uint32_t len, std::mt19937* generator) {
+    std::string dst;
+    while (dst.size() < len) {
+      char c = "ACGT"[(*generator)() & 3];
+      if (!dst.empty() && c == dst.back()) {
+        continue;
+      }
+      std::uint32_t n = 1;
+      if ((*generator)() % 100 == 0) {
+        n = 64 + (*generator)() % 1200;
+      } else {
+        while ((*generator)() % 3 == 0) {
+          ++n;
+        }
+      }
+      dst.append(n, c);
+    }
+    dst.resize(len);
+    return dst;
+  }
+
+  // collapsed bases and raw positions of the starts of their runs
+  static void CompressByHand(
+      const std::string& data,
+      std::string* bases,
+      std::vector<std::uint32_t>* positions) {
+    for (std::uint32_t i = 0; i < data.size(); ++i) {
+      if (i == 0 || data[i] != data[i - 1]) {
+        bases->push_back(data[i]);
+        positions->push_back(i);
+      }
+    }
+    positions->push_back(data.size());
+  }
+
+  static void Check(const HpcNucleicAcid& h, const std::string& data) {
+    std::string bases;
+    std::vector<std::uint32_t> positions;
+    CompressByHand(data, &bases, &positions);
+
+    ASSERT_EQ(data.size(), h.raw_len);
+    ASSERT_EQ(bases.size(), h.inflated_len);
+    EXPECT_EQ(bases, h.InflateData());
+    EXPECT_EQ(data, h.InflateRawData());
+    for (std::uint32_t i = 0; i <= bases.size(); ++i) {
+      ASSERT_EQ(positions[i], h.RawPosition(i)) << i;
+    }
+    for (std::uint32_t i = 0, j = 0; i <= data.size(); ++i) {
+      if (j < bases.size() && positions[j + 1] == i) {
+        ++j;
+      }
+      ASSERT_EQ(j, h.HpcPosition(i)) << i;
+    }
+    if (bases.size() > 10) {
+      EXPECT_EQ(bases.substr(3, 7), h.InflateData(3, 7));
+      EXPECT_EQ(
+          data.substr(positions[3], positions[10] - positions[3]),
+          h.InflateRawData(3, 7));
+      EXPECT_EQ(positions[6] - positions[5], h.RunLength(5));
+    }
+  }
+};
+
+TEST_F(BiosoupHpcNucleicAcidTest, Compress) {
+  std::mt19937 generator(42);
+  for (std::uint32_t len : {0, 1, 31, 32, 33, 64, 1000, 1024, 1025, 20000}) {
+    std::string data = RandomRuns(len, &generator);
+
+    HpcNucleicAcid h{"hpc", data};
+    EXPECT_EQ("hpc", h.name);
+    Check(h, data);
+    h.ReverseAndComplement();
+    Check(h, ReverseComplement(data));
+
+    NucleicAcid n{"hpc", data};
+    n.ReverseAndComplement();
+    HpcNucleicAcid m{n};
+    EXPECT_EQ(n.id, m.id);
+    Check(m, ReverseComplement(data));
+    m.ReverseAndComplement();
+    Check(m, data);
+    EXPECT_EQ(h.deflated_data, m.deflated_data);
+  }
+
+  std::string data(5000, 'G');  // one run
+  Check(HpcNucleicAcid{"hpc", data}, data);
+}
+
+TEST_F(BiosoupHpcNucleicAcidTest, Lift) {
+  HpcNucleicAcid lhs{"lhs", "AACCCGTTTT"};  // ACGT
+  HpcNucleicAcid rhs{"rhs", "GGGAAACCCCT"};  // GACT
+  Overlap o = LiftOverlap(
+      Overlap(0, 1, 4, 1, 0, 3, 3, std::string("3M")),
+      lhs, rhs);
+  EXPECT_EQ(2U, o.lhs_begin);
+  EXPECT_EQ(10U, o.lhs_end);
+  EXPECT_EQ(0U, o.rhs_begin);
+  EXPECT_EQ(10U, o.rhs_end);
+  EXPECT_EQ(3U, o.score);
+  EXPECT_TRUE(o.alignment.empty());
+
+  rhs.ReverseAndComplement();  // coordinates stay on the forward strand
+  o = LiftOverlap(Overlap(0, 0, 2, 1, 1, 4, 2, false), lhs, rhs);
+  EXPECT_EQ(0U, o.lhs_begin);
+  EXPECT_EQ(5U, o.lhs_end);
+  EXPECT_EQ(3U, o.rhs_begin);
+  EXPECT_EQ(11U, o.rhs_end);
+  EXPECT_FALSE(o.strand);
+}
+
+TEST_F(BiosoupHpcNucleicAcidTest, Error) {
+  try {
+    HpcNucleicAcid h{"hpc", "ACGT!"};
+  } catch (std::invalid_argument& exception) {
+    EXPECT_STREQ(
+        exception.what(),
+        "[biosoup::HpcNucleicAcid::HpcNucleicAcid] error: not a nucleotide");
+  }
+}
+
+}  // namespace test
+}  // namespace biosoup
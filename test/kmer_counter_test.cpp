@@ -0,0 +1,129 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/kmer_counter.hpp"
+
+#include <map>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "test_utils.hpp"
+
+namespace biosoup {
+namespace test {
+
+class BiosoupKmerCounterTest: public ::testing::Test {
+ public:
+  void SetUp() override {
+    std::mt19937 generator(42);
+    s = RandomReads(RandomData(20000, &generator), 200, &generator);  // 10x
+  }
+
+  std::map<std::uint64_t, std::uint64_t> CountByHand(std::uint32_t k) const {
+    std::map<std::uint64_t, std::uint64_t> dst;
+    for (const auto& it : s) {
+      std::vector<Kmer> kmers;
+      detail::CanonicalKmersByCode(*it, k, &kmers);
+      for (const auto& jt : kmers) {
+        ++dst[jt.value];
+      }
+    }
+    return dst;
+  }
+
+  static std::vector<KmerCount> Concatenate(const KmerCounter& c) {
+    std::vector<KmerCount> dst;
+    for (std::uint32_t i = 0; i < KmerCounter::kNumPartitions; ++i) {
+      dst.insert(dst.end(), c.kmers(i).begin(), c.kmers(i).end());
+    }
+    return dst;
+  }
+
+  std::vector<std::unique_ptr<NucleicAcid>> s;
+};
+
+TEST_F(BiosoupKmerCounterTest, Count) {
+  for (std::uint32_t k : {3, 15, 32}) {
+    auto e = CountByHand(k);
+    KmerCounter c{k, 1ULL << 32, ::testing::TempDir(), 4};
+    c.Add(s);
+    c.Count(3);
+    EXPECT_EQ(0U, c.num_runs());
+
+    std::vector<std::uint64_t> histogram;
+    std::uint64_t num_kmers = 0, num_frequent = 0;
+    for (const auto& it : e) {
+      if (histogram.size() <= it.second) {
+        histogram.resize(it.second + 1, 0);
+      }
+      ++histogram[it.second];
+      num_kmers += it.second;
+      num_frequent += it.second >= 3;
+      EXPECT_EQ(it.second >= 3 ? it.second : 0, c.Find(it.first));
+    }
+    EXPECT_EQ(num_kmers, c.num_kmers());
+    EXPECT_EQ(num_frequent, c.num_counted_kmers());
+    EXPECT_EQ(histogram, c.histogram());
+    std::vector<KmerCount> kmers = Concatenate(c);
+    EXPECT_EQ(num_frequent, kmers.size());
+    for (std::size_t i = 1; i < kmers.size(); ++i) {
+      EXPECT_LT(
+          HashKmer(kmers[i - 1].kmer, KmerMask(k)),
+          HashKmer(kmers[i].kmer, KmerMask(k)));
+    }
+  }
+}
+
+TEST_F(BiosoupKmerCounterTest, Spill) {
+  KmerCounter e{21, 1ULL << 32, ::testing::TempDir(), 1};
+  e.Add(s);
+  e.Add(s);
+  e.Count();
+
+  KmerCounter c{21, 1U << 18, ::testing::TempDir(), 4};  // initial tables
+  c.Add(s);
+  c.Add(s);
+  EXPECT_LT(0U, c.num_runs());
+  c.Count();
+  EXPECT_EQ(0U, c.num_runs());
+  EXPECT_EQ(e.histogram(), c.histogram());
+  std::vector<KmerCount> e_kmers = Concatenate(e), kmers = Concatenate(c);
+  ASSERT_EQ(e_kmers.size(), kmers.size());
+  for (std::size_t i = 0; i < e_kmers.size(); ++i) {
+    EXPECT_EQ(e_kmers[i].kmer, kmers[i].kmer);
+    EXPECT_EQ(e_kmers[i].count, kmers[i].count);
+    if (i % 101 == 0) {
+      EXPECT_EQ(e_kmers[i].count, c.Find(e_kmers[i].kmer));
+    }
+  }
+
+  std::string histogram;
+  c.WriteHistogram([&] (const char* data, std::size_t len) -> void {
+    histogram.append(data, len);
+  });
+  std::string e_histogram;
+  for (std::size_t i = 1; i < e.histogram().size(); ++i) {
+    if (e.histogram()[i]) {
+      e_histogram += std::to_string(i) + " " + std::to_string(e.histogram()[i]) + "\n";  // NOLINT
+    }
+  }
+  EXPECT_EQ(e_histogram, histogram);
+}
+
+TEST_F(BiosoupKmerCounterTest, Error) {
+  try {
+    KmerCounter c{33};
+  } catch (std::invalid_argument& exception) {
+    EXPECT_STREQ(
+        exception.what(),
+        "[biosoup::KmerCounter::KmerCounter] error: k is not in [1, 32]");
+  }
+  KmerCounter c{15, 1ULL << 32, ::testing::TempDir()};
+  EXPECT_TRUE(c.kmers(0).empty());
+  c.Count();
+  EXPECT_THROW(c.Add(s), std::logic_error);
+  EXPECT_THROW(c.Count(), std::logic_error);
+}
+
+}  // namespace test
+}  // namespace biosoup
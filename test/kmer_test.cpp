@@ -0,0 +1,165 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/kmer.hpp"
+
+#include <random>
+#include <set>
+
+#include "gtest/gtest.h"
+
+#include "test_utils.hpp"
+
+namespace biosoup {
+namespace test {
+
+std::vector<Kmer> Extract(const NucleicAcid& n, std::uint32_t k) {
+  std::vector<Kmer> dst;
+  Kmer batch[7];  // odd size to cross block boundaries
+  KmerIterator it{n, k};
+  for (std::size_t m; (m = it.Next(batch, 7)) > 0;) {
+    dst.insert(dst.end(), batch, batch + m);
+  }
+  std::sort(dst.begin(), dst.end(), [] (const Kmer& lhs, const Kmer& rhs) {
+    return lhs.position < rhs.position;
+  });
+  return dst;
+}
+
+TEST(BiosoupKmerTest, Iterator) {
+  std::mt19937 generator(42);
+  for (std::uint32_t len : {0, 1, 31, 32, 33, 64, 100, 1001}) {
+    NucleicAcid n{"Iterator", RandomData(len, &generator)};
+    for (std::uint32_t k : {1, 5, 15, 16, 31, 32}) {
+      for (int r = 0; r < 2; ++r, n.ReverseAndComplement()) {
+        std::vector<Kmer> e;
+        detail::CanonicalKmersByCode(n, k, &e);
+        auto d = Extract(n, k);
+        ASSERT_EQ(e.size(), d.size());
+        for (std::uint32_t i = 0; i < d.size(); ++i) {
+          EXPECT_EQ(e[i].value, d[i].value);
+          EXPECT_EQ(e[i].position, d[i].position);
+          EXPECT_EQ(e[i].strand, d[i].strand);
+        }
+      }
+    }
+  }
+  NucleicAcid n{"Iterator", "ACGT"};
+  EXPECT_THROW(KmerIterator(n, 0), std::invalid_argument);
+  EXPECT_THROW(KmerIterator(n, 33), std::invalid_argument);
+  EXPECT_THROW(KmerIterator(n, 64), std::invalid_argument);
+  std::vector<Kmer> kmers;
+  EXPECT_THROW(Minimize(n, 33, 5, &kmers), std::invalid_argument);
+}
+
+TEST(BiosoupKmerTest, Ambiguous) {
+  std::mt19937 generator(42);
+  std::string data = RandomData(1000, &generator);
+  data.replace(0, 3, "NNN");
+  data.replace(100, 1, "N");
+  data.replace(200, 20, std::string(20, 'N'));
+  data.replace(220, 2, "RY");
+  data.replace(230, 1, "n");
+  data.replace(990, 10, std::string(10, 'N'));
+  NucleicAcid n{"Ambiguous", 9, data.c_str(), static_cast<std::uint32_t>(data.size()), true};  // NOLINT
+  for (std::uint32_t k : {1, 5, 15, 32}) {
+    for (int r = 0; r < 2; ++r, n.ReverseAndComplement()) {
+      std::vector<Kmer> kmers, e;
+      detail::CanonicalKmersByCode(n, k, &kmers);
+      for (const auto& it : kmers) {
+        bool is_ambiguous = false;
+        for (std::uint32_t i = 0; i < k; ++i) {
+          is_ambiguous |= n.IsAmbiguous(it.position + i);
+        }
+        if (!is_ambiguous) {
+          e.emplace_back(it);
+        }
+      }
+      auto d = Extract(n, k);
+      ASSERT_EQ(e.size(), d.size());
+      for (std::uint32_t i = 0; i < d.size(); ++i) {
+        EXPECT_EQ(e[i].value, d[i].value);
+        EXPECT_EQ(e[i].position, d[i].position);
+        EXPECT_EQ(e[i].strand, d[i].strand);
+      }
+
+      std::uint32_t w = 10;  // windows do not span ambiguous runs
+      std::set<std::uint32_t> m;
+      for (std::uint32_t i = 0, j = 0; i < e.size(); i = j) {
+        for (j = i + 1; j < e.size() && e[j].position == e[j - 1].position + 1; ++j) {}  // NOLINT
+        for (std::uint32_t b = i; b == i || b + w <= j; ++b) {
+          std::uint32_t x = b;
+          for (std::uint32_t l = b; l < std::min(b + w, j); ++l) {
+            std::uint64_t lhs = HashKmer(e[l].value, KmerMask(k));
+            std::uint64_t rhs = HashKmer(e[x].value, KmerMask(k));
+            if (lhs < rhs || (r && lhs == rhs)) {  // ties in traversal order
+              x = l;
+            }
+          }
+          m.emplace(e[x].position);
+        }
+      }
+      std::vector<Kmer> p;
+      Minimize(n, k, w, &p);
+      std::set<std::uint32_t> q;
+      for (const auto& it : p) {
+        q.emplace(it.position);
+      }
+      EXPECT_EQ(m, q);
+    }
+  }
+}
+
+TEST(BiosoupKmerTest, Canonical) {
+  NucleicAcid n{"Canonical", "TTTCA"};
+  Kmer batch[3];
+  KmerIterator it{n, 3};
+  ASSERT_EQ(3U, it.Next(batch, 3));
+  EXPECT_EQ(0U, batch[0].value);  // TTT -> AAA
+  EXPECT_FALSE(batch[0].strand);
+  EXPECT_EQ(52U, batch[2].value);  // TCA < TGA
+  EXPECT_TRUE(batch[2].strand);
+  EXPECT_EQ(0U, it.Next(batch, 3));
+}
+
+TEST(BiosoupKmerTest, Minimize) {
+  std::mt19937 generator(42);
+  NucleicAcid n{"Minimize", RandomData(2000, &generator)};
+  std::uint32_t k = 15, w = 10;
+  for (int r = 0; r < 2; ++r, n.ReverseAndComplement()) {
+    std::vector<Kmer> kmers;
+    detail::CanonicalKmersByCode(n, k, &kmers);
+
+    std::set<std::uint32_t> e;
+    for (std::uint32_t i = 0; i + w <= kmers.size(); ++i) {
+      std::uint32_t j = i;
+      for (std::uint32_t l = i; l < i + w; ++l) {
+        if (HashKmer(kmers[l].value, KmerMask(k)) <
+            HashKmer(kmers[j].value, KmerMask(k))) {
+          j = l;
+        }
+      }
+      e.emplace(kmers[j].position);
+    }
+
+    std::vector<Kmer> d;
+    Minimize(n, k, w, &d);
+    EXPECT_TRUE(std::is_sorted(d.begin(), d.end(),
+        [] (const Kmer& lhs, const Kmer& rhs) {
+          return lhs.position < rhs.position;
+        }));
+    std::set<std::uint32_t> p;
+    for (const auto& it : d) {
+      p.emplace(it.position);
+      EXPECT_EQ(HashKmer(kmers[it.position].value, KmerMask(k)), it.value);
+    }
+    EXPECT_EQ(e, p);
+  }
+
+  NucleicAcid s{"Minimize", "ACGTTA"};
+  std::vector<Kmer> d;
+  Minimize(s, 5, 10, &d);
+  EXPECT_EQ(1U, d.size());
+}
+
+}  // namespace test
+}  // namespace biosoup
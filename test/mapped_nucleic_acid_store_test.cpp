@@ -0,0 +1,118 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/mapped_nucleic_acid_store.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+#include "gtest/gtest.h"
+
+namespace biosoup {
+namespace test {
+
+TEST(BiosoupMappedNucleicAcidStoreTest, RoundTrip) {
+  NucleicAcidStore s{};
+  s.Append("a", "ACGTACGTACGTACGTACGTACGTACGTACGTACG", "0123456789012345678901234567890123X");  // NOLINT
+  s.Append("bb", "");
+  s.Append("ccc", "TTGCATTGCATTGCATTGCATTGCATTGCATTGCATTGCATTGCATTGCATTGCATTGCATTGCA");  // NOLINT
+  s.ReverseAndComplement(2);
+
+  std::string path = ::testing::TempDir() + "biosoup_mapped_test.bin";
+  MappedNucleicAcidStore::Write(path, s);
+  {
+    MappedNucleicAcidStore m{path};
+    EXPECT_EQ(s.size(), m.size());
+    for (std::size_t i = 0; i < s.size(); ++i) {
+      EXPECT_EQ(s[i].id, m[i].id);
+      EXPECT_EQ(s[i].Name(), m[i].Name());
+      EXPECT_EQ(s[i].InflateData(), m[i].InflateData());
+      EXPECT_EQ(s[i].InflateQuality(), m[i].InflateQuality());
+      EXPECT_EQ(s[i].is_reverse_complement, m[i].is_reverse_complement);
+    }
+  }
+
+  std::vector<std::unique_ptr<NucleicAcid>> v;
+  v.emplace_back(new NucleicAcid("d", "GATTACA", "!!!!!!5"));
+  v.emplace_back(new NucleicAcid("e", "CAT"));
+  MappedNucleicAcidStore::Write(path, v);
+  {
+    MappedNucleicAcidStore m{path};
+    EXPECT_EQ(2, m.size());
+    EXPECT_EQ(v[0]->id, m[0].id);
+    EXPECT_EQ("GATTACA", m[0].InflateData());
+    EXPECT_EQ("!!!!!!5", m[0].InflateQuality());
+    EXPECT_EQ("e", m[1].Name());
+    EXPECT_EQ("CAT", m[1].InflateData());
+    EXPECT_EQ("", m[1].InflateQuality());
+  }
+  std::remove(path.c_str());
+}
+
+TEST(BiosoupMappedNucleicAcidStoreTest, Error) {
+  std::string path = ::testing::TempDir() + "biosoup_mapped_test.bin";
+  {
+    std::ofstream os(path);
+    os << ">not a biosoup file\nACGT\n";
+  }
+  try {
+    MappedNucleicAcidStore m{path};
+  } catch (std::invalid_argument& exception) {
+    EXPECT_EQ(
+        std::string(exception.what()).find(
+            "[biosoup::MappedNucleicAcidStore::MappedNucleicAcidStore] error:"),  // NOLINT
+        0);
+  }
+  std::remove(path.c_str());
+  EXPECT_THROW(MappedNucleicAcidStore{path}, std::runtime_error);
+}
+
+TEST(BiosoupMappedNucleicAcidStoreTest, Corrupted) {
+  NucleicAcidStore s{};
+  s.Append("a", "ACGTACGTACGTACGTACGTACGTACGTACGTACG", "0123456789012345678901234567890123X");  // NOLINT
+  s.Append("bb", "TTGCA");
+
+  std::string path = ::testing::TempDir() + "biosoup_mapped_test.bin";
+  auto patch = [&] (std::uint64_t position, std::uint64_t value) -> void {
+    MappedNucleicAcidStore::Write(path, s);
+    std::fstream fs(path, std::ios::in | std::ios::out | std::ios::binary);
+    fs.seekp(position);
+    fs.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+  auto read = [&] (std::uint64_t position) -> std::uint64_t {
+    std::uint64_t value = 0;
+    std::ifstream is(path, std::ios::binary);
+    is.seekg(position);
+    is.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+  };
+  auto expect_error = [&] (const std::string& what) -> void {
+    try {
+      MappedNucleicAcidStore m{path};
+      ADD_FAILURE() << "expected " << what;
+    } catch (std::invalid_argument& exception) {
+      EXPECT_NE(std::string(exception.what()).find(what), std::string::npos);
+    }
+  };
+
+  // header: magic, byte order, version, number of sections, reserved,
+  // number of sequences and section offsets
+  patch(8, 0x0000000204030201ULL);
+  expect_error("byte order");
+
+  MappedNucleicAcidStore::Write(path, s);
+  std::uint64_t data_offsets = read(32 + 5 * 8);
+  patch(data_offsets + 2 * 8, 1ULL << 40);  // past the blocks
+  expect_error("corrupted offsets");
+
+  patch(data_offsets + 8, 1);  // first sequence needs two blocks
+  expect_error("corrupted lengths");
+
+  std::uint64_t lens = read(32 + 1 * 8);
+  patch(lens, 1000 | (5ULL << 32));
+  expect_error("corrupted lengths");
+
+  std::remove(path.c_str());
+}
+
+}  // namespace test
+}  // namespace biosoup
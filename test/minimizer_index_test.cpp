@@ -0,0 +1,245 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/minimizer_index.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <tuple>
+
+#include "gtest/gtest.h"
+
+#include "test_utils.hpp"
+
+namespace biosoup {
+namespace test {
+
+class BiosoupMinimizerIndexTest: public ::testing::Test {
+ public:
+  void SetUp() override {
+    std::mt19937 generator(42);
+    s = RandomReads(RandomData(20000, &generator), 100, &generator);
+    s.emplace_back(new NucleicAcid("repeat", std::string(2000, 'A')));
+    s.back()->id = 100;
+  }
+
+  using Locations = std::vector<std::tuple<std::uint32_t, std::uint32_t, bool>>;  // NOLINT
+
+  std::map<std::uint64_t, Locations> IndexByHand(
+      std::uint32_t k,
+      std::uint32_t w) const {
+    std::map<std::uint64_t, Locations> dst;
+    for (const auto& it : s) {
+      std::vector<Kmer> minimizers;
+      Minimize(*it, k, w, &minimizers);
+      for (const auto& jt : minimizers) {
+        dst[jt.value].emplace_back(it->id, jt.position, jt.strand);
+      }
+    }
+    for (auto& it : dst) {
+      std::sort(it.second.begin(), it.second.end());
+    }
+    return dst;
+  }
+
+  static Locations Find(const MinimizerIndex& index, std::uint64_t value) {
+    Locations dst;
+    auto range = index.Find(value);
+    for (auto it = range.first; it != range.second; ++it) {
+      dst.emplace_back(it->id, it->position(), it->strand());
+    }
+    return dst;
+  }
+
+  std::vector<std::unique_ptr<NucleicAcid>> s;
+};
+
+TEST_F(BiosoupMinimizerIndexTest, Find) {
+  for (std::uint32_t k : {3, 15, 32}) {
+    auto e = IndexByHand(k, 5);
+    MinimizerIndex m{s, k, 5, 0, 4};
+    EXPECT_EQ(k, m.k());
+    EXPECT_EQ(5U, m.w());
+    EXPECT_EQ(e.size(), m.num_minimizers());
+    EXPECT_EQ(0U, m.num_masked());
+
+    std::uint64_t num_locations = 0;
+    for (const auto& it : e) {
+      EXPECT_EQ(it.second, Find(m, it.first));
+      num_locations += it.second.size();
+      if (it.first < KmerMask(k)) {
+        EXPECT_EQ(e.count(it.first + 1) > 0, !Find(m, it.first + 1).empty());
+      }
+    }
+    EXPECT_EQ(num_locations, m.num_locations());
+  }
+}
+
+TEST_F(BiosoupMinimizerIndexTest, Mask) {
+  auto e = IndexByHand(15, 5);
+  MinimizerIndex m{s, 15, 5, 0.001, 1};
+  EXPECT_EQ(e.size(), m.num_minimizers() + m.num_masked());
+  EXPECT_LT(0U, m.num_masked());
+  EXPECT_GE(static_cast<std::uint64_t>(e.size() * 0.001), m.num_masked());
+
+  std::uint64_t num_masked = 0;
+  for (const auto& it : e) {
+    if (it.second.size() > m.threshold()) {
+      EXPECT_TRUE(Find(m, it.first).empty());
+      ++num_masked;
+    } else {
+      EXPECT_EQ(it.second, Find(m, it.first));
+    }
+  }
+  EXPECT_EQ(num_masked, m.num_masked());
+
+  // the poly-A minimizer is masked
+  std::vector<Kmer> minimizers;
+  Minimize(*s.back(), 15, 5, &minimizers);
+  EXPECT_TRUE(Find(m, minimizers.front().value).empty());
+}
+
+TEST_F(BiosoupMinimizerIndexTest, Query) {
+  MinimizerIndex m{s, 15, 5, 0, 2};
+  auto q = s[10]->InflateData(100, 300);
+  NucleicAcid query{"query", q};
+
+  std::vector<MinimizerHit> hits;
+  std::size_t num_queried = m.Query(query, &hits);
+  EXPECT_EQ(num_queried, hits.size());
+
+  std::vector<Kmer> minimizers;
+  Minimize(query, 15, 5, &minimizers);
+  std::size_t num_hits = 0, num_self_hits = 0;
+  for (const auto& it : minimizers) {
+    for (const auto& jt : Find(m, it.value)) {
+      ASSERT_LT(num_hits, hits.size());
+      EXPECT_EQ(std::get<0>(jt), hits[num_hits].id);
+      EXPECT_EQ(std::get<1>(jt), hits[num_hits].position);
+      EXPECT_EQ(it.position, hits[num_hits].query_position);
+      EXPECT_EQ(it.strand == std::get<2>(jt), hits[num_hits].strand);
+      if (hits[num_hits].id == 10) {
+        EXPECT_EQ(it.position + 100, hits[num_hits].position);
+        EXPECT_TRUE(hits[num_hits].strand);
+        ++num_self_hits;
+      }
+      ++num_hits;
+    }
+  }
+  EXPECT_EQ(num_hits, hits.size());
+  EXPECT_EQ(minimizers.size(), num_self_hits);
+
+  MinimizerIndex d{};
+  EXPECT_EQ(0U, d.Query(query, &hits));
+  EXPECT_TRUE(d.Find(0).first == d.Find(0).second);
+}
+
+TEST_F(BiosoupMinimizerIndexTest, Write) {
+  std::string path = ::testing::TempDir() + "biosoup_minimizer_index_test.bin";  // NOLINT
+  auto e = IndexByHand(15, 5);
+
+  MinimizerIndex m{s, 15, 5, 0.001, 2};
+  m.Write(path);
+  {
+    MinimizerIndex r{path};
+    EXPECT_EQ(15U, r.k());
+    EXPECT_EQ(5U, r.w());
+    EXPECT_EQ(m.num_minimizers(), r.num_minimizers());
+    EXPECT_EQ(m.num_locations(), r.num_locations());
+    EXPECT_EQ(m.num_masked(), r.num_masked());
+    EXPECT_EQ(m.threshold(), r.threshold());
+    EXPECT_EQ(m.memory_usage(), r.memory_usage());
+    for (const auto& it : e) {
+      EXPECT_EQ(Find(m, it.first), Find(r, it.first));
+    }
+
+    MinimizerIndex t = std::move(r);
+    EXPECT_EQ(Find(m, e.begin()->first), Find(t, e.begin()->first));
+  }
+
+  MinimizerIndex{}.Write(path);
+  {
+    MinimizerIndex r{path};
+    EXPECT_EQ(0U, r.num_minimizers());
+    EXPECT_TRUE(r.Find(0).first == r.Find(0).second);
+  }
+  std::remove(path.c_str());
+}
+
+TEST_F(BiosoupMinimizerIndexTest, Error) {
+  try {
+    MinimizerIndex m{s, 33, 5};
+  } catch (std::invalid_argument& exception) {
+    EXPECT_STREQ(
+        exception.what(),
+        "[biosoup::MinimizerIndex::MinimizerIndex] error: k is not in [1, 32]");  // NOLINT
+  }
+  EXPECT_THROW(MinimizerIndex(s, 15, 0), std::invalid_argument);
+  EXPECT_THROW(MinimizerIndex(s, 15, 5, 1), std::invalid_argument);
+
+  std::string path = ::testing::TempDir() + "biosoup_minimizer_index_test.bin";  // NOLINT
+  {
+    std::ofstream os(path);
+    os << ">not a biosoup file\nACGT\n";
+  }
+  try {
+    MinimizerIndex m{path};
+  } catch (std::invalid_argument& exception) {
+    EXPECT_EQ(
+        std::string(exception.what()).find(
+            "[biosoup::MinimizerIndex::MinimizerIndex] error:"),
+        0);
+  }
+  std::remove(path.c_str());
+  EXPECT_THROW(MinimizerIndex{path}, std::runtime_error);
+}
+
+TEST_F(BiosoupMinimizerIndexTest, Corrupted) {
+  std::string path = ::testing::TempDir() + "biosoup_minimizer_index_test.bin";  // NOLINT
+  MinimizerIndex m{s, 15, 5};
+  auto patch = [&] (std::uint64_t position, std::uint64_t value) -> void {
+    m.Write(path);
+    std::fstream fs(path, std::ios::in | std::ios::out | std::ios::binary);
+    fs.seekp(position);
+    fs.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+  auto read = [&] (std::uint64_t position) -> std::uint64_t {
+    std::uint64_t value = 0;
+    std::ifstream is(path, std::ios::binary);
+    is.seekg(position);
+    is.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+  };
+  auto expect_error = [&] (const std::string& what) -> void {
+    try {
+      MinimizerIndex r{path};
+      ADD_FAILURE() << "expected " << what;
+    } catch (std::invalid_argument& exception) {
+      EXPECT_NE(std::string(exception.what()).find(what), std::string::npos);
+    }
+  };
+
+  // header: magic, byte order, version, number of sections, reserved, k, w,
+  // bucket bits, threshold, number of masked minimizers, minimizers and
+  // locations, and section offsets
+  patch(8, 0x0000000204030201ULL);  // written on a host of the other order
+  expect_error("unsupported version");
+
+  m.Write(path);
+  std::uint64_t buckets = read(72);
+  std::uint64_t minimizers = read(80);
+  patch(buckets + 8, 1ULL << 40);  // past the minimizers
+  expect_error("corrupted offsets");
+
+  patch(buckets + 8, m.num_minimizers());  // followed by smaller offsets
+  expect_error("corrupted offsets");
+
+  patch(minimizers + 8, 1ULL << 40);  // past the locations
+  expect_error("corrupted offsets");
+
+  std::remove(path.c_str());
+}
+
+}  // namespace test
+}  // namespace biosoup
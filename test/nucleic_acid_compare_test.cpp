@@ -0,0 +1,129 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/nucleic_acid_compare.hpp"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "test_utils.hpp"
+
+namespace biosoup {
+namespace test {
+
+class BiosoupNucleicAcidCompareTest: public ::testing::Test {
+ public:
+  void SetUp() override {
+    std::mt19937 generator(42);
+    data = RandomData(5000, &generator);
+    other = data;
+    for (std::uint32_t i = 0; i < 100; ++i) {
+      other[generator() % other.size()] = "ACGT"[generator() & 3];
+    }
+    lhs.reset(new NucleicAcid("lhs", data));
+    rhs.reset(new NucleicAcid("rhs", other));
+  }
+
+  std::string data;
+  std::string other;
+  std::unique_ptr<NucleicAcid> lhs;
+  std::unique_ptr<NucleicAcid> rhs;
+};
+
+TEST_F(BiosoupNucleicAcidCompareTest, Views) {
+  std::mt19937 generator(7);
+  for (std::uint32_t t = 0; t < 500; ++t) {
+    std::uint32_t len = generator() % 3000;
+    NucleicAcidView l = NucleicAcidView(*lhs).Slice(generator() % 2000, len);
+    NucleicAcidView r = NucleicAcidView(t & 1 ? *rhs : *lhs).Slice(
+        generator() % 2000, generator() % 3000);
+    if (t & 2) {
+      l.ReverseAndComplement();
+    }
+    if (t & 4) {
+      r.ReverseAndComplement();
+    }
+    std::string a = l.InflateData(), b = r.InflateData();  // by hand
+    std::uint32_t n = std::min(a.size(), b.size());
+
+    std::uint32_t hamming = 0, prefix = n, suffix = n, gc = 0;
+    for (std::uint32_t i = 0; i < n; ++i) {
+      hamming += a[i] != b[i];
+    }
+    for (std::uint32_t i = 0; i < n; ++i) {
+      if (a[i] != b[i]) {
+        prefix = i;
+        break;
+      }
+    }
+    for (std::uint32_t i = 0; i < n; ++i) {
+      if (a[a.size() - i - 1] != b[b.size() - i - 1]) {
+        suffix = i;
+        break;
+      }
+    }
+    for (auto it : a) {
+      gc += it == 'C' || it == 'G';
+    }
+    EXPECT_EQ(hamming, HammingDistance(l, r));
+    EXPECT_EQ(prefix, CommonPrefixLength(l, r));
+    EXPECT_EQ(suffix, CommonSuffixLength(l, r));
+    EXPECT_EQ(a == b, Equal(l, r));
+    EXPECT_EQ(gc, GcCount(l));
+  }
+}
+
+TEST_F(BiosoupNucleicAcidCompareTest, Equal) {
+  NucleicAcidView l{*lhs}, r{*rhs};
+  EXPECT_TRUE(Equal(l, l));
+  EXPECT_FALSE(Equal(l, r));
+  EXPECT_FALSE(Equal(l, l.Slice(0, 4999)));
+  EXPECT_EQ(4999U, CommonPrefixLength(l, l.Slice(0, 4999)));
+  EXPECT_EQ(0U, HammingDistance(l.Slice(100), r.Slice(0, 0)));
+
+  // same bases at different offsets and in different orientations
+  NucleicAcid c{"c", data.substr(13, 777)};
+  c.ReverseAndComplement();
+  NucleicAcidView s = l.Slice(13, 777);
+  s.ReverseAndComplement();
+  EXPECT_TRUE(Equal(NucleicAcidView(c), s));
+  EXPECT_EQ(0U, HammingDistance(NucleicAcidView(c), s));
+
+  NucleicAcid g{"g", "ACGTTTGGCCAA"};
+  EXPECT_EQ(6U, GcCount(NucleicAcidView(g)));
+  EXPECT_EQ(2U, GcCount(NucleicAcidView(g).Slice(2, 5)));
+}
+
+TEST_F(BiosoupNucleicAcidCompareTest, Kernels) {
+  using Compare = std::uint32_t (*)(const std::uint64_t*, const std::uint64_t*, std::uint32_t);  // NOLINT
+  using Count = std::uint32_t (*)(const std::uint64_t*, std::uint32_t);
+  std::vector<Compare> hamming{detail::HammingDistanceScalar};
+  std::vector<Compare> mismatch{detail::MismatchScalar};
+  std::vector<Count> gc{detail::GcCountScalar};
+#if defined(BIOSOUP_X86_DISPATCH)
+  if (detail::simd_level() >= detail::SimdLevel::kSse42) {
+    hamming.emplace_back(detail::HammingDistanceSse42);
+    mismatch.emplace_back(detail::MismatchSse42);
+    gc.emplace_back(detail::GcCountSse42);
+  }
+  if (detail::simd_level() >= detail::SimdLevel::kAvx2) {
+    hamming.emplace_back(detail::HammingDistanceAvx2);
+    mismatch.emplace_back(detail::MismatchAvx2);
+    gc.emplace_back(detail::GcCountAvx2);
+  }
+#endif
+  const std::uint64_t* l = lhs->deflated_data.data();
+  const std::uint64_t* r = rhs->deflated_data.data();
+  for (std::uint32_t len : {0, 1, 31, 32, 33, 127, 128, 129, 1000, 5000}) {
+    for (std::uint32_t i = 1; i < hamming.size(); ++i) {
+      EXPECT_EQ(hamming[0](l, r, len), hamming[i](l, r, len));
+      EXPECT_EQ(mismatch[0](l, r, len), mismatch[i](l, r, len));
+      EXPECT_EQ(mismatch[0](l, l, len), mismatch[i](l, l, len));
+      EXPECT_EQ(gc[0](l, len), gc[i](l, len));
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace biosoup
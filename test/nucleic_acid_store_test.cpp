@@ -0,0 +1,105 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/nucleic_acid_store.hpp"
+
+#include "gtest/gtest.h"
+
+namespace biosoup {
+namespace test {
+
+TEST(BiosoupNucleicAcidStoreTest, Append) {
+  NucleicAcidStore s{};
+  EXPECT_TRUE(s.empty());
+  EXPECT_EQ(0, s.Append("a", "ACGTACGTACGTACGTACGTACGTACGTACGTACG", "0123456789012345678901234567890123X"));  // NOLINT
+  EXPECT_EQ(1, s.Append("bb", ""));
+  EXPECT_EQ(2, s.Append("ccc", "TTGCA"));
+  EXPECT_EQ(3, s.size());
+
+  EXPECT_EQ("a", s[0].Name());
+  EXPECT_EQ("ACGTACGTACGTACGTACGTACGTACGTACGTACG", s[0].InflateData());
+  EXPECT_EQ("0123456789012345678901234567890123X", s[0].InflateQuality());
+  EXPECT_EQ(2, s[0].Code(34));
+  EXPECT_EQ('X' - '!', s[0].Score(34));
+
+  EXPECT_EQ("bb", s[1].Name());
+  EXPECT_EQ("", s[1].InflateData());
+  EXPECT_EQ("", s[1].InflateQuality());
+
+  EXPECT_EQ("ccc", s[2].Name());
+  EXPECT_EQ("GCA", s[2].InflateData(2));
+  EXPECT_EQ("", s[2].InflateQuality());
+  EXPECT_EQ(s[0].id + 2, s[2].id);
+
+  try {
+    s.Append("d", "ACGTE");
+  } catch (std::invalid_argument& exception) {
+    EXPECT_STREQ(
+        exception.what(),
+        "[biosoup::NucleicAcidStore::Append] error: not a nucleotide");
+  }
+  try {
+    s.Append("e", "ACGT", "012");
+  } catch (std::invalid_argument& exception) {
+    EXPECT_STREQ(
+        exception.what(),
+        "[biosoup::NucleicAcidStore::Append] error: "
+        "quality length differs from data length");
+  }
+  EXPECT_EQ(3, s.size());
+  EXPECT_EQ(3, s.num_blocks());
+  EXPECT_EQ("TTGCA", s[2].InflateData());
+}
+
+TEST(BiosoupNucleicAcidStoreTest, EmptyName) {
+  NucleicAcidStore s{};
+  EXPECT_EQ(0, s.Append("", "ACGT"));
+  EXPECT_EQ(1, s.Append("b", "TGCA"));
+  EXPECT_EQ("", s[0].Name());
+  EXPECT_EQ("ACGT", s[0].InflateData());
+  EXPECT_EQ("b", s[1].Name());
+}
+
+TEST(BiosoupNucleicAcidStoreTest, EmptyData) {
+  NucleicAcidStore s{};
+  EXPECT_EQ(0, s.Append("a", ""));
+  EXPECT_EQ(1, s.Append("b", "TGCA"));
+  EXPECT_EQ("a", s[0].Name());
+  EXPECT_EQ("", s[0].InflateData());
+  EXPECT_EQ("TGCA", s[1].InflateData());
+}
+
+TEST(BiosoupNucleicAcidStoreTest, NucleicAcid) {
+  NucleicAcid n{"test", "ACGTACTGAGCTAGTCATCGATGCCAGTCATGCGATCG", "0123456789012345678901234567890123456Z"};  // NOLINT
+  n.ReverseAndComplement();
+
+  NucleicAcidStore s{};
+  s.Reserve(2);
+  s.Append(n);
+  s.Append(n.name, n.InflateData(), n.InflateQuality());
+  EXPECT_EQ(n.id, s[0].id);
+  EXPECT_EQ(n.InflateData(), s[0].InflateData());
+  EXPECT_EQ(n.InflateQuality(), s[0].InflateQuality());
+  EXPECT_EQ(n.InflateData(), s[1].InflateData());
+  EXPECT_EQ(n.InflateQuality(), s[1].InflateQuality());
+
+  auto v = s[0];
+  v.ReverseAndComplement();
+  s.ReverseAndComplement(1);
+  EXPECT_EQ(v.InflateData(), s[1].InflateData());
+  EXPECT_EQ(v.InflateQuality(5, 7), s[1].InflateQuality(5, 7));
+  EXPECT_EQ(v.Code(3), s[1].Code(3));
+  EXPECT_EQ(v.Score(3), s[1].Score(3));
+
+  NucleicAcid c = s.ToNucleicAcid(0);
+  EXPECT_EQ(n.id, c.id);
+  EXPECT_EQ(n.name, c.name);
+  EXPECT_EQ(n.deflated_data, c.deflated_data);
+  EXPECT_EQ(n.quality, c.quality);
+  EXPECT_EQ(n.is_reverse_complement, c.is_reverse_complement);
+
+  s.Clear();
+  EXPECT_TRUE(s.empty());
+}
+
+}  // namespace test
+}  // namespace biosoup
@@ -3,10 +3,11 @@
 #include "biosoup/nucleic_acid.hpp"
 
 #include <iostream>
+#include <random>
 
 #include "gtest/gtest.h"
 
-std::atomic<std::uint32_t> biosoup::NucleicAcid::num_objects{0};
+std::atomic<biosoup::ObjectId> biosoup::NucleicAcid::num_objects{0};
 
 namespace biosoup {
 namespace test {
@@ -37,6 +38,163 @@ TEST(BiosoupNucleicAcidTest, Inflate) {
   EXPECT_EQ("CCAAAA", s.InflateData(69));
 }
 
+TEST(BiosoupNucleicAcidTest, Deflate) {
+  std::vector<bool (*)(const char*, std::uint32_t, std::uint64_t*)> kernels{
+      detail::DeflateScalar};
+#if defined(BIOSOUP_X86_DISPATCH)
+  if (detail::simd_level() >= detail::SimdLevel::kSse42) {
+    kernels.emplace_back(detail::DeflateSse42);
+  }
+  if (detail::simd_level() >= detail::SimdLevel::kAvx2) {
+    kernels.emplace_back(detail::DeflateAvx2);
+  }
+#endif
+  for (std::uint32_t c = 0; c < 256; ++c) {
+    std::string data(75, 'A');
+    data[c % 75] = static_cast<char>(c);
+    data[40 + c % 35] = static_cast<char>(c);
+    for (const auto& it : kernels) {
+      std::vector<std::uint64_t> dst(3);
+      EXPECT_EQ(kNucleotideCoder[c] != 255, it(data.c_str(), 75, dst.data()));
+      if (kNucleotideCoder[c] != 255) {
+        EXPECT_EQ(kNucleotideCoder[c], (dst[c % 75 >> 5] >> (c % 75 % 32 * 2)) & 3);  // NOLINT
+        EXPECT_EQ(kNucleotideCoder[c], dst[(40 + c % 35) >> 5] >> ((40 + c % 35) % 32 * 2) & 3);  // NOLINT
+      }
+    }
+  }
+
+  std::mt19937 generator(42);
+  std::string alphabet = "ACGTURYKMSWBDHVN-acgturykmswbdhvn";
+  std::string data(1021, 'A');
+  for (auto& it : data) {
+    it = alphabet[generator() % alphabet.size()];
+  }
+  std::vector<std::uint64_t> expected(32);
+  EXPECT_TRUE(detail::DeflateScalar(data.c_str(), data.size(), expected.data()));  // NOLINT
+  for (const auto& it : kernels) {
+    for (std::uint32_t len : {0U, 1U, 31U, 32U, 33U, 64U, 500U, 1021U}) {
+      std::vector<std::uint64_t> dst(32, 0);
+      EXPECT_TRUE(it(data.c_str(), len, dst.data()));
+      for (std::uint32_t i = 0; i < (len + 31) / 32; ++i) {
+        EXPECT_EQ(i == len / 32 && len % 32 ? expected[i] & ((1ULL << (len % 32 * 2)) - 1) : expected[i], dst[i]);  // NOLINT
+      }
+    }
+  }
+}
+
+TEST(BiosoupNucleicAcidTest, InflateKernels) {
+  std::vector<void (*)(const std::uint64_t*, std::uint32_t, std::uint32_t, bool, char*)> kernels{  // NOLINT
+      detail::InflateScalar};
+#if defined(BIOSOUP_X86_DISPATCH)
+  if (detail::simd_level() >= detail::SimdLevel::kSse42) {
+    kernels.emplace_back(detail::InflateSse42);
+  }
+  if (detail::simd_level() >= detail::SimdLevel::kAvx2) {
+    kernels.emplace_back(detail::InflateAvx2);
+  }
+#endif
+  std::mt19937 generator(42);
+  std::string data(1021, 'A');
+  for (auto& it : data) {
+    it = kNucleotideDecoder[generator() % 4];
+  }
+  NucleicAcid s{"test", data};
+  NucleicAcid c{s};
+  c.ReverseAndComplement();
+  for (const auto& it : kernels) {
+    for (std::uint32_t i = 0; i < 64; ++i) {
+      std::uint32_t begin = generator() % data.size();
+      std::uint32_t len = generator() % (data.size() - begin + 1);
+      std::string dst(len, ' ');
+      it(s.deflated_data.data(), begin, len, false, &dst[0]);
+      EXPECT_EQ(data.substr(begin, len), dst);
+      it(s.deflated_data.data(), data.size() - begin - len, len, true, &dst[0]);  // NOLINT
+      for (std::uint32_t j = 0; j < len; ++j) {
+        EXPECT_EQ(kNucleotideDecoder[c.Code(begin + j)], dst[j]);
+      }
+    }
+  }
+}
+
+TEST(BiosoupNucleicAcidTest, Ambiguous) {
+  std::string data = "NNNNACGTRYKMacgtnnnnNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNACGT-SWBDHVU";  // NOLINT
+  NucleicAcid s{"test", 4, data.c_str(), static_cast<std::uint32_t>(data.size()), true};  // NOLINT
+  EXPECT_EQ(13, s.ambiguous_runs().size());
+  EXPECT_EQ(1, s.lower_case_runs().size());
+  EXPECT_EQ(data.substr(0, 68) + "T", s.InflateData());  // U is packed as T
+  EXPECT_EQ("RYKMacgtnnnnNN", s.InflateData(8, 14));
+  EXPECT_EQ("-SWB", s.InflateData(61, 4));
+  EXPECT_TRUE(s.IsAmbiguous(0));
+  EXPECT_FALSE(s.IsAmbiguous(4));
+  EXPECT_TRUE(s.IsAmbiguous(56));
+  EXPECT_FALSE(s.IsAmbiguous(57));
+  EXPECT_FALSE(s.IsAmbiguous(60));
+  EXPECT_TRUE(s.IsAmbiguous(61));
+  EXPECT_FALSE(s.IsAmbiguous(12));
+  EXPECT_TRUE(s.IsAmbiguous(16));
+  EXPECT_EQ(0, s.Code(0));
+  EXPECT_EQ(1, s.Code(13));
+
+  s.ReverseAndComplement();
+  EXPECT_EQ("ABDHVWS-ACGTNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNnnnnacgtKMRYACGTNNNN", s.InflateData());  // NOLINT
+  EXPECT_EQ("S-AC", s.InflateData(6, 4));
+  EXPECT_FALSE(s.IsAmbiguous(0));
+  EXPECT_TRUE(s.IsAmbiguous(1));
+  EXPECT_FALSE(s.IsAmbiguous(8));
+  EXPECT_TRUE(s.IsAmbiguous(67));
+  EXPECT_EQ("nnacgtKM", s.InflateData(51, 8));
+
+  NucleicAcid c{"test", data};
+  EXPECT_TRUE(c.ambiguous_runs().empty());
+  EXPECT_EQ(nullptr, c.extras);
+  EXPECT_FALSE(c.IsAmbiguous(0));
+  EXPECT_EQ('A', c.InflateData()[0]);
+
+  NucleicAcid r{"rna", 3, "ACGUUUacgu", 10, true};
+  EXPECT_TRUE(r.ambiguous_runs().empty());
+  EXPECT_EQ(1, r.lower_case_runs().size());
+  EXPECT_EQ("ACGTTTacgt", r.InflateData());
+}
+
+TEST(BiosoupNucleicAcidTest, SoftMasked) {
+  std::mt19937 generator(42);
+  std::string data(10000, 'A');
+  for (auto& it : data) {
+    it = "ACGT"[generator() & 3];
+  }
+  for (std::uint32_t i = 1000; i < 9000; ++i) {
+    data[i] |= 0x20;
+  }
+  data[5000] = 'n';
+  NucleicAcid s{"test", 4, data.c_str(), static_cast<std::uint32_t>(data.size()), true};  // NOLINT
+  EXPECT_EQ(1, s.ambiguous_runs().size());
+  EXPECT_EQ(1, s.lower_case_runs().size());
+  EXPECT_EQ(1000, s.lower_case_runs().front().begin);
+  EXPECT_EQ(8000, s.lower_case_runs().front().len);
+  EXPECT_EQ(1, s.ambiguous_runs().capacity());
+  EXPECT_EQ(1, s.lower_case_runs().capacity());
+  EXPECT_FALSE(s.IsAmbiguous(999));
+  EXPECT_FALSE(s.IsAmbiguous(1000));
+  EXPECT_FALSE(s.IsAmbiguous(4999));
+  EXPECT_TRUE(s.IsAmbiguous(5000));
+  EXPECT_EQ(data, s.InflateData());
+  EXPECT_EQ(data.substr(990, 20), s.InflateData(990, 20));
+
+  s.ReverseAndComplement();
+  std::string rc(data.rbegin(), data.rend());
+  for (auto& it : rc) {
+    bool is_lower = it >= 'a';
+    it = detail::Complement()[it];
+    if (is_lower) {
+      it |= 0x20;
+    }
+  }
+  EXPECT_EQ(rc, s.InflateData());
+  EXPECT_EQ(rc.substr(8990, 20), s.InflateData(8990, 20));
+  EXPECT_EQ('n', s.InflateData(4999, 1)[0]);
+  EXPECT_TRUE(s.IsAmbiguous(4999));
+}
+
 TEST(BiosoupNucleicAcidTest, Quality) {
   NucleicAcid s{
       "test",
@@ -49,6 +207,35 @@ TEST(BiosoupNucleicAcidTest, Quality) {
   EXPECT_EQ("_`ab", s.InflateQuality(62, 4));
 }
 
+TEST(BiosoupNucleicAcidTest, CompressQuality) {
+  NucleicAcid s{
+      "test",
+      "ACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTAC",  // NOLINT
+      "!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~"};  // NOLINT
+  EXPECT_EQ(nullptr, s.extras);
+  NucleicAcid c{s};
+  c.CompressQuality();
+  EXPECT_TRUE(c.quality.empty());
+  EXPECT_EQ(7, c.packed_quality().width());
+  NucleicAcid d{c};
+  EXPECT_NE(c.extras, d.extras);
+  EXPECT_EQ(s.InflateQuality(), d.InflateQuality());
+  EXPECT_EQ(42, c.Score(42));
+  EXPECT_EQ(s.InflateQuality(), c.InflateQuality());
+  EXPECT_EQ("_`ab", c.InflateQuality(62, 4));
+  s.ReverseAndComplement();
+  c.ReverseAndComplement();
+  EXPECT_EQ(s.Score(17), c.Score(17));
+  EXPECT_EQ(s.InflateQuality(), c.InflateQuality());
+  EXPECT_EQ(s.InflateQuality(5, 9), c.InflateQuality(5, 9));
+
+  c = s;
+  c.CompressQuality(QualityBinning::Illumina());
+  EXPECT_EQ(3, c.packed_quality().width());
+  EXPECT_EQ(15, c.Score(93 - 10));
+  EXPECT_EQ(40, c.Score(0));
+}
+
 TEST(BiosoupNucleicAcidTest, ReverseAndComplement) {
   NucleicAcid s{
       "test",
@@ -63,5 +250,79 @@ TEST(BiosoupNucleicAcidTest, ReverseAndComplement) {
   EXPECT_EQ(c.InflateQuality(), s.InflateQuality());
 }
 
+TEST(BiosoupNucleicAcidTest, InflateBuffer) {
+  std::string data = "ACGTNNACGTACGTACGTACGTACGTACGTACGTACGTAC";
+  std::string quality = "0123456789012345678901234567890123456789";
+  NucleicAcid s{"test", 4, data.c_str(), 40, quality.c_str(), 40, true};
+  std::string buffer(16, 'x');
+  EXPECT_EQ(8U, s.InflateData(2, 8, &buffer[0]));
+  EXPECT_EQ("GTNNACGTxxxxxxxx", buffer);
+  EXPECT_EQ(4U, s.InflateData(36, 8, &buffer[0]));
+  EXPECT_EQ("GTACACGTxxxxxxxx", buffer);
+  EXPECT_EQ(0U, s.InflateData(40, 8, &buffer[0]));
+  EXPECT_EQ(3U, s.InflateQuality(7, 3, &buffer[0]));
+  EXPECT_EQ("789CACGTxxxxxxxx", buffer);
+
+  std::string dst;
+  dst.reserve(64);
+  const char* storage = dst.data();
+  s.InflateData(0, 10, &dst);
+  EXPECT_EQ("ACGTNNACGT", dst);
+  s.InflateQuality(35, 10, &dst);
+  EXPECT_EQ("56789", dst);
+  EXPECT_EQ(storage, dst.data());
+
+  s.ReverseAndComplement();
+  s.InflateData(30, 6, &dst);
+  EXPECT_EQ(s.InflateData().substr(30, 6), dst);
+  EXPECT_EQ("ACGTNN", dst);
+  EXPECT_EQ(2U, s.InflateQuality(38, 2, &buffer[0]));
+  EXPECT_EQ("10", buffer.substr(0, 2));
+
+  NucleicAcid c{"test", "ACGT"};
+  c.InflateQuality(0, 4, &dst);
+  EXPECT_TRUE(dst.empty());
+  EXPECT_FALSE(c.has_quality());
+  EXPECT_EQ(0U, c.InflateQuality(0, 4, &buffer[0]));
+}
+
+TEST(BiosoupNucleicAcidTest, InflateBatch) {
+  NucleicAcid a{"a", "ACGTACGTACGTACGTACGTACGTACGTACGTACGTACGT", "0123456789012345678901234567890123456789"};  // NOLINT
+  NucleicAcid b{"b", "TTTTGGGGCCCC"};
+  b.ReverseAndComplement();
+
+  std::vector<InflateRequest> requests;
+  for (std::uint32_t i = 0; i < 1000; ++i) {
+    requests.push_back(InflateRequest{i & 1 ? &b : &a, (i * 7) % 45, i % 13});
+  }
+
+  for (std::uint32_t num_threads : {1, 4}) {
+    std::string dst;
+    std::vector<std::uint64_t> offsets;
+    InflateDataBatch(requests, &dst, &offsets, num_threads);
+    ASSERT_EQ(requests.size() + 1, offsets.size());
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+      const InflateRequest& it = requests[i];
+      EXPECT_EQ(
+          it.nucleic_acid->InflateData(it.begin, it.len),
+          dst.substr(offsets[i], offsets[i + 1] - offsets[i]));
+    }
+    InflateQualityBatch(requests, &dst, &offsets, num_threads);
+    ASSERT_EQ(requests.size() + 1, offsets.size());
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+      const InflateRequest& it = requests[i];
+      EXPECT_EQ(
+          it.nucleic_acid->InflateQuality(it.begin, it.len),
+          dst.substr(offsets[i], offsets[i + 1] - offsets[i]));
+    }
+  }
+
+  std::string dst = "x";
+  std::vector<std::uint64_t> offsets;
+  InflateDataBatch({}, &dst, &offsets);
+  EXPECT_TRUE(dst.empty());
+  EXPECT_EQ(1U, offsets.size());
+}
+
 }  // namespace test
 }  // namespace biosoup
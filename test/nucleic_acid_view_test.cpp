@@ -0,0 +1,215 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/nucleic_acid_view.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <random>
+
+#include "biosoup/fingerprint.hpp"
+#include "biosoup/kmer.hpp"
+#include "biosoup/mapped_nucleic_acid_store.hpp"
+#include "gtest/gtest.h"
+
+#include "test_utils.hpp"
+
+namespace biosoup {
+namespace test {
+
+class BiosoupNucleicAcidViewTest: public ::testing::Test {
+ public:
+  void SetUp() override {
+    std::mt19937 generator(42);
+    data.resize(333);
+    quality.resize(333);
+    for (std::uint32_t i = 0; i < data.size(); ++i) {
+      data[i] = "ACGT"[generator() & 3];
+      quality[i] = '!' + generator() % 40;
+    }
+    n.reset(new NucleicAcid("view", data, quality));
+  }
+
+  std::string data;
+  std::string quality;
+  std::unique_ptr<NucleicAcid> n;
+};
+
+TEST_F(BiosoupNucleicAcidViewTest, NucleicAcid) {
+  NucleicAcidView v{*n};
+  EXPECT_EQ(n->id, v.id);
+  EXPECT_EQ("view", v.Name());
+  EXPECT_EQ(data, v.InflateData());
+  EXPECT_EQ(quality, v.InflateQuality());
+  EXPECT_EQ(n->Code(100), v.Code(100));
+  EXPECT_EQ(n->Score(100), v.Score(100));
+
+  n->ReverseAndComplement();
+  v = NucleicAcidView(*n);
+  EXPECT_EQ(n->InflateData(), v.InflateData());
+  EXPECT_EQ(n->InflateQuality(), v.InflateQuality());
+
+  n->CompressQuality();
+  v = NucleicAcidView(*n);
+  EXPECT_EQ(nullptr, v.quality);
+  EXPECT_TRUE(v.has_quality());
+  EXPECT_EQ(n->Score(7), v.Score(7));
+  EXPECT_EQ(n->InflateQuality(), v.InflateQuality());
+  EXPECT_EQ(n->InflateQuality(40, 80), v.InflateQuality(40, 80));
+
+  NucleicAcid e{"empty", "ACGT"};
+  EXPECT_FALSE(NucleicAcidView(e).has_quality());
+  EXPECT_EQ("", NucleicAcidView(e).InflateQuality());
+}
+
+TEST_F(BiosoupNucleicAcidViewTest, Slice) {
+  NucleicAcidView v{*n};
+  NucleicAcidView s = v.Slice(37, 200);
+  EXPECT_EQ(37U, s.begin);
+  EXPECT_EQ(200U, s.inflated_len);
+  EXPECT_EQ(data.substr(37, 200), s.InflateData());
+  EXPECT_EQ(quality.substr(37, 200), s.InflateQuality());
+  EXPECT_EQ(data.substr(40, 7), s.InflateData(3, 7));
+  EXPECT_EQ(n->Code(99), s.Code(62));
+  EXPECT_EQ(n->Score(99), s.Score(62));
+
+  NucleicAcidView t = s.Slice(100);  // nested
+  EXPECT_EQ(data.substr(137, 100), t.InflateData());
+  EXPECT_EQ(data.substr(0, 0), v.Slice(333).InflateData());
+  EXPECT_EQ(data.substr(330), v.Slice(330, 100).InflateData());
+
+  s.ReverseAndComplement();
+  EXPECT_EQ(ReverseComplement(data.substr(37, 200)), s.InflateData());
+  std::string q = quality.substr(37, 200);
+  std::reverse(q.begin(), q.end());
+  EXPECT_EQ(q, s.InflateQuality());
+
+  t = s.Slice(10, 50);  // [177, 227) of the forward strand
+  EXPECT_EQ(177U, t.begin);
+  EXPECT_TRUE(t.is_reverse_complement);
+  EXPECT_EQ(ReverseComplement(data.substr(177, 50)), t.InflateData());
+  EXPECT_EQ(q.substr(10, 50), t.InflateQuality());
+  t.ReverseAndComplement();
+  EXPECT_EQ(data.substr(177, 50), t.InflateData());
+  EXPECT_EQ(data.substr(180, 20), t.Slice(3, 20).InflateData());
+
+  n->CompressQuality();
+  t = NucleicAcidView(*n).Slice(64, 65);
+  EXPECT_EQ(quality.substr(64, 65), t.InflateQuality());
+  t.ReverseAndComplement();
+  EXPECT_EQ(n->Score(64), t.Score(64));
+}
+
+TEST_F(BiosoupNucleicAcidViewTest, Buffer) {
+  NucleicAcidView v = NucleicAcidView(*n).Slice(5, 100);
+  std::string buffer(128, 'x');
+  EXPECT_EQ(10U, v.InflateData(90, 64, &buffer[0]));
+  EXPECT_EQ(data.substr(95, 10), buffer.substr(0, 10));
+  EXPECT_EQ('x', buffer[10]);
+  EXPECT_EQ(0U, v.InflateData(100, 1, &buffer[0]));
+  EXPECT_EQ(7U, v.InflateQuality(1, 7, &buffer[0]));
+  EXPECT_EQ(quality.substr(6, 7), buffer.substr(0, 7));
+}
+
+TEST_F(BiosoupNucleicAcidViewTest, Kmers) {
+  NucleicAcidView v = NucleicAcidView(*n).Slice(45, 150);
+  NucleicAcid c{"copy", data.substr(45, 150)};
+  for (int r = 0; r < 2; ++r, v.ReverseAndComplement(), c.ReverseAndComplement()) {  // NOLINT
+    std::vector<Kmer> e, d;
+    Minimize(c, 15, 5, &e);
+    Minimize(v, 15, 5, &d);
+    ASSERT_EQ(e.size(), d.size());
+    for (std::uint32_t i = 0; i < e.size(); ++i) {
+      EXPECT_EQ(e[i].value, d[i].value);
+      EXPECT_EQ(e[i].position, d[i].position);
+      EXPECT_EQ(e[i].strand, d[i].strand);
+    }
+  }
+}
+
+TEST_F(BiosoupNucleicAcidViewTest, Write) {
+  std::vector<NucleicAcidView> views{
+      NucleicAcidView(*n).Slice(13, 97),
+      NucleicAcidView(*n).Slice(64, 64),
+      NucleicAcidView(*n).Slice(300)};
+  views[1].ReverseAndComplement();
+
+  std::string path = ::testing::TempDir() + "biosoup_view_test.bin";
+  MappedNucleicAcidStore::Write(path, views.size(),
+      [&] (std::size_t i) -> NucleicAcidView {
+        return views[i];
+      });
+  {
+    MappedNucleicAcidStore m{path};
+    ASSERT_EQ(views.size(), m.size());
+    for (std::size_t i = 0; i < m.size(); ++i) {
+      EXPECT_EQ(0U, m[i].begin);
+      EXPECT_EQ(views[i].InflateData(), m[i].InflateData());
+      EXPECT_EQ(views[i].InflateQuality(), m[i].InflateQuality());
+    }
+  }
+  std::remove(path.c_str());
+}
+
+TEST_F(BiosoupNucleicAcidViewTest, Ambiguous) {
+  data.replace(10, 5, "NNNNN");
+  data.replace(60, 2, "RY");
+  std::transform(data.begin() + 100, data.begin() + 180, data.begin() + 100, ::tolower);  // NOLINT
+  data.replace(150, 3, "nnn");
+  NucleicAcid a{"view", 4, data.c_str(), static_cast<std::uint32_t>(data.size()), true};  // NOLINT
+
+  NucleicAcidStore s{};
+  s.Append(a);
+  s.Append(*n);
+  EXPECT_EQ(data, s[0].InflateData());
+  EXPECT_EQ(0, s[1].num_ambiguous_runs);
+  EXPECT_EQ(data, s.ToNucleicAcid(0).InflateData());
+  EXPECT_EQ(ComputeFingerprint(a), ComputeFingerprint(s[0]));
+  EXPECT_EQ(
+      ComputeCanonicalFingerprint(a),
+      ComputeCanonicalFingerprint(s[0]));
+
+  std::vector<NucleicAcidView> views{
+      s[0].Slice(12, 140),
+      s[0].Slice(12, 140),
+      s[0].Slice(170)};
+  views[1].ReverseAndComplement();
+  EXPECT_EQ(data.substr(12, 140), views[0].InflateData());
+  EXPECT_EQ(a.InflateData(0, 100), NucleicAcidView(a).InflateData(0, 100));
+  a.ReverseAndComplement();
+  EXPECT_EQ(
+      a.InflateData(data.size() - 152, 140),
+      views[1].InflateData());
+
+  NucleicAcid c{"copy", 4, data.c_str() + 12, 140, true};
+  for (int r = 0; r < 2; ++r, views[0].ReverseAndComplement(), c.ReverseAndComplement()) {  // NOLINT
+    std::vector<Kmer> e, d;
+    Minimize(c, 5, 3, &e);
+    Minimize(views[0], 5, 3, &d);
+    ASSERT_EQ(e.size(), d.size());
+    for (std::uint32_t i = 0; i < e.size(); ++i) {
+      EXPECT_EQ(e[i].value, d[i].value);
+      EXPECT_EQ(e[i].position, d[i].position);
+    }
+  }
+  EXPECT_EQ(ComputeFingerprint(c), ComputeFingerprint(views[0]));
+
+  std::string path = ::testing::TempDir() + "biosoup_view_test.bin";
+  MappedNucleicAcidStore::Write(path, views.size(),
+      [&] (std::size_t i) -> NucleicAcidView {
+        return views[i];
+      });
+  {
+    MappedNucleicAcidStore m{path};
+    ASSERT_EQ(views.size(), m.size());
+    for (std::size_t i = 0; i < m.size(); ++i) {
+      EXPECT_EQ(views[i].InflateData(), m[i].InflateData());
+    }
+    EXPECT_EQ(4, m[0].num_ambiguous_runs);  // N, R, Y and n clipped
+    EXPECT_EQ(0, m[2].num_ambiguous_runs);
+  }
+  std::remove(path.c_str());
+}
+
+}  // namespace test
+}  // namespace biosoup
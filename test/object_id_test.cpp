@@ -0,0 +1,85 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/object_id.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "biosoup/sequence.hpp"
+#include "gtest/gtest.h"
+
+namespace biosoup {
+namespace test {
+
+struct Object {
+  Object()
+      : id(NextId<Object>()) {}
+
+  static std::atomic<ObjectId> num_objects;
+
+  ObjectId id;
+};
+
+std::atomic<ObjectId> Object::num_objects{0};
+
+TEST(BiosoupObjectIdTest, Scope) {
+  EXPECT_EQ(0U, Object().id);
+  {
+    IdScope<Object> s{3};
+    EXPECT_EQ(1U, s.next());
+    EXPECT_EQ(4U, s.end());
+    EXPECT_EQ(4U, Object::num_objects);
+    EXPECT_EQ(1U, Object().id);
+    {
+      IdScope<Object> t{100, 101};
+      EXPECT_EQ(100U, Object().id);
+      EXPECT_EQ(4U, Object().id);  // exhausted, from the counter
+    }
+    EXPECT_EQ(2U, Object().id);
+    EXPECT_EQ(3U, Object().id);
+    EXPECT_EQ(5U, Object().id);
+  }
+  EXPECT_EQ(6U, Object().id);
+
+  std::vector<std::vector<ObjectId>> ids(4);
+  std::vector<std::thread> threads;
+  for (std::uint32_t i = 0; i < ids.size(); ++i) {
+    threads.emplace_back([&ids, i] () -> void {
+      for (std::uint32_t j = 0; j < 10; ++j) {
+        IdScope<Object> s{100};
+        for (std::uint32_t k = 0; k < 100; ++k) {
+          ids[i].emplace_back(Object().id);
+        }
+      }
+    });
+  }
+  for (auto& it : threads) {
+    it.join();
+  }
+  std::vector<ObjectId> all;
+  for (const auto& it : ids) {
+    for (std::uint32_t j = 0; j < it.size(); j += 100) {
+      EXPECT_EQ(it[j] + 99, it[j + 99]);  // blocks are consecutive
+    }
+    all.insert(all.end(), it.begin(), it.end());
+  }
+  std::sort(all.begin(), all.end());
+  for (std::uint32_t i = 0; i < all.size(); ++i) {
+    EXPECT_EQ(7 + i, all[i]);  // dense
+  }
+}
+
+TEST(BiosoupObjectIdTest, Sequence) {
+  {
+    IdScope<Sequence> s{10, 12};
+    EXPECT_EQ(10U, Sequence("a", "ACGT").id);
+    EXPECT_EQ(11U, Sequence("b", "ACGT", "!!!!").id);
+  }
+  EXPECT_EQ(0U, Sequence("c", "ACGT").id);
+  Sequence::num_objects = 0;
+}
+
+}  // namespace test
+}  // namespace biosoup
@@ -0,0 +1,149 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/overlap_index.hpp"
+
+#include <algorithm>
+#include <random>
+
+#include "gtest/gtest.h"
+
+namespace biosoup {
+namespace test {
+
+TEST(BiosoupOverlapIndexTest, Queries) {
+  std::mt19937 generator(7);
+  std::vector<Overlap> overlaps;
+  for (std::uint32_t i = 0; i < 3000; ++i) {
+    std::uint32_t lhs_begin = generator() % 1000, rhs_begin = generator() % 1000;  // NOLINT
+    overlaps.emplace_back(
+        generator() % 20, lhs_begin, lhs_begin + 1 + generator() % 300,
+        generator() % 25, rhs_begin, rhs_begin + 1 + generator() % 300,
+        i);
+  }
+  overlaps.emplace_back(3, 0, 1300, 30, 5, 1305, 0);
+
+  OverlapStore s{};
+  for (const auto& it : overlaps) {
+    s.Append(it);
+  }
+  OverlapIndex a{overlaps, 3};
+  OverlapIndex b{s, 1};
+  EXPECT_EQ(31U, a.num_reads());
+  EXPECT_EQ(0U, a.num_intervals(29));
+
+  // intervals of read id which pass f
+  auto brute = [&] (std::uint32_t id, std::function<bool(std::uint32_t, std::uint32_t)> f)  // NOLINT
+      -> std::vector<std::uint32_t> {
+    std::vector<std::uint32_t> dst;
+    for (std::uint32_t i = 0; i < overlaps.size(); ++i) {
+      const Overlap& o = overlaps[i];
+      if ((o.lhs_id == id && f(o.lhs_begin, o.lhs_end)) ||
+          (o.rhs_id == id && f(o.rhs_begin, o.rhs_end))) {
+        dst.emplace_back(i);
+      }
+    }
+    return dst;
+  };
+
+  for (std::uint32_t id = 0; id < 32; ++id) {
+    for (std::uint32_t j = 0; j < 20; ++j) {
+      std::uint32_t begin = generator() % 1400;
+      std::uint32_t end = begin + generator() % 200;
+
+      std::vector<std::uint32_t> found;
+      a.Find(id, begin, end, &found);
+      std::sort(found.begin(), found.end());
+      found.erase(std::unique(found.begin(), found.end()), found.end());
+      EXPECT_EQ(brute(id, [&] (std::uint32_t b, std::uint32_t e) -> bool {
+        return begin < end && b < end && begin < e;
+      }), found);
+
+      std::vector<std::uint32_t> other;
+      b.Find(id, begin, end, &other);
+      std::sort(other.begin(), other.end());
+      other.erase(std::unique(other.begin(), other.end()), other.end());
+      EXPECT_EQ(found, other);
+
+      found.clear();
+      a.FindContaining(id, begin, end, &found);
+      std::sort(found.begin(), found.end());
+      found.erase(std::unique(found.begin(), found.end()), found.end());
+      EXPECT_EQ(brute(id, [&] (std::uint32_t b, std::uint32_t e) -> bool {
+        return b <= begin && end <= e;
+      }), found);
+
+      std::vector<std::uint32_t> coverage = a.Coverage(id, begin, end);
+      ASSERT_EQ(end - begin, coverage.size());
+      for (std::uint32_t k = begin; k < end; k += 7) {
+        std::uint32_t depth = 0;
+        for (const auto& o : overlaps) {
+          depth += o.lhs_id == id && o.lhs_begin <= k && k < o.lhs_end;
+          depth += o.rhs_id == id && o.rhs_begin <= k && k < o.rhs_end;
+        }
+        EXPECT_EQ(depth, coverage[k - begin]);
+      }
+    }
+  }
+
+  EXPECT_TRUE(a.IsContained(3, 1300));
+  EXPECT_FALSE(a.IsContained(30, 1310));
+  EXPECT_TRUE(a.IsContained(30, 1310, 5));
+  EXPECT_FALSE(a.IsContained(29, 10));
+  auto contained = b.ContainedReads(
+      [] (std::uint32_t id) -> std::uint32_t { return id == 30 ? 1310 : 1300; },  // NOLINT
+      5,
+      2);
+  EXPECT_EQ(std::vector<std::uint32_t>({3, 30}), contained);
+}
+
+TEST(BiosoupOverlapIndexTest, ManyReads) {
+  std::mt19937 generator(11);
+  std::vector<Overlap> overlaps;
+  for (std::uint32_t i = 0; i < 150000; ++i) {  // spans several blocks
+    std::uint32_t lhs_begin = generator() % 1000, rhs_begin = generator() % 1000;  // NOLINT
+    overlaps.emplace_back(
+        generator() % 5000, lhs_begin, lhs_begin + 1 + generator() % 300,
+        generator() % 5000, rhs_begin, rhs_begin + 1 + generator() % 300,
+        i);
+  }
+  OverlapIndex a{overlaps, 4};
+
+  std::vector<std::uint32_t> num_intervals(5000, 0);
+  std::vector<std::vector<std::uint32_t>> found(5000);
+  for (std::uint32_t i = 0; i < overlaps.size(); ++i) {
+    const Overlap& o = overlaps[i];
+    ++num_intervals[o.lhs_id];
+    ++num_intervals[o.rhs_id];
+    if (o.lhs_begin < 500 && o.lhs_end > 400) {
+      found[o.lhs_id].emplace_back(i);
+    }
+    if (o.rhs_begin < 500 && o.rhs_end > 400) {
+      found[o.rhs_id].emplace_back(i);
+    }
+  }
+  EXPECT_EQ(5000U, a.num_reads());
+  for (std::uint32_t id = 0; id < 5000; ++id) {
+    EXPECT_EQ(num_intervals[id], a.num_intervals(id));
+    if (id % 97 == 0) {
+      std::vector<std::uint32_t> dst;
+      a.Find(id, 400, 500, &dst);
+      std::sort(dst.begin(), dst.end());
+      EXPECT_EQ(found[id], dst);
+    }
+  }
+}
+
+TEST(BiosoupOverlapIndexTest, Error) {
+  std::vector<Overlap> overlaps{Overlap(UINT32_MAX, 0, 100, 0, 0, 100, 100)};
+  try {
+    OverlapIndex a{overlaps, 2};
+    ADD_FAILURE() << "expected std::length_error";
+  } catch (std::length_error& exception) {
+    EXPECT_STREQ(
+        exception.what(),
+        "[biosoup::OverlapIndex::OverlapIndex] error: too many reads");
+  }
+}
+
+}  // namespace test
+}  // namespace biosoup
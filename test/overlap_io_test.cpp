@@ -0,0 +1,164 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/overlap_io.hpp"
+
+#include <cstdio>
+#include <unordered_map>
+
+#include "gtest/gtest.h"
+
+namespace biosoup {
+namespace test {
+
+// hands out text in pieces of at most len bytes
+ReadFunction ReadText(const std::string& text, std::size_t len) {
+  std::shared_ptr<std::size_t> i(new std::size_t(0));
+  return [=] (char* dst, std::size_t n) -> std::size_t {
+    n = std::min(std::min(n, len), text.size() - *i);
+    std::copy(text.begin() + *i, text.begin() + *i + n, dst);
+    *i += n;
+    return n;
+  };
+}
+
+OverlapStore Overlaps(std::uint32_t num_overlaps) {
+  OverlapStore dst{};
+  for (std::uint32_t i = 0; i < num_overlaps; ++i) {
+    std::vector<std::uint32_t> cigar;
+    if (i % 3 == 0) {
+      cigar = EncodeCigar("5S" + std::to_string(i % 7 + 1) + "M1I2D3=");
+    }
+    dst.Append(
+        (i * 7919) % 50, (i * 104729) % 1000, (i * 104729) % 1000 + 100,
+        (i * 31) % 40, i % 100, i % 100 + 90,
+        i,
+        i % 2,
+        cigar.data(), cigar.size());
+  }
+  return dst;
+}
+
+void ExpectEqual(const OverlapStore& a, const OverlapStore& b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    Overlap x = a[i], y = b[i];
+    EXPECT_EQ(x.lhs_id, y.lhs_id);
+    EXPECT_EQ(x.lhs_begin, y.lhs_begin);
+    EXPECT_EQ(x.lhs_end, y.lhs_end);
+    EXPECT_EQ(x.rhs_id, y.rhs_id);
+    EXPECT_EQ(x.rhs_begin, y.rhs_begin);
+    EXPECT_EQ(x.rhs_end, y.rhs_end);
+    EXPECT_EQ(x.score, y.score);
+    EXPECT_EQ(x.strand, y.strand);
+    EXPECT_EQ(x.alignment, y.alignment);
+  }
+}
+
+TEST(BiosoupOverlapIoTest, Paf) {
+  OverlapStore s = Overlaps(1000);
+  std::string text;
+  WritePaf(
+      s,
+      [] (std::uint32_t id) -> std::string { return "read" + std::to_string(id); },  // NOLINT
+      [] (std::uint32_t id) -> std::uint32_t { return 2000 + id; },
+      [&] (const char* data, std::size_t len) -> void { text.append(data, len); },  // NOLINT
+      3);
+  EXPECT_EQ(
+      "read0\t2000\t0\t100\t-\tread0\t2000\t0\t90\t0\t7\t255\tcg:Z:5S1M1I2D3=\n",  // NOLINT
+      text.substr(0, text.find('\n') + 1));
+
+  std::unordered_map<std::string, std::uint32_t> ids;
+  for (std::uint32_t i = 0; i < 50; ++i) {
+    ids["read" + std::to_string(i)] = i;
+  }
+  for (std::size_t chunk_size : {1, 100, 1 << 22}) {
+    OverlapParser p{
+        ReadText(text, 77),
+        [&] (const char* name, std::uint32_t name_len) -> std::uint32_t {
+          return ids.at(std::string(name, name_len));
+        },
+        3,
+        chunk_size};
+    OverlapStore t = p.Parse(1);
+    EXPECT_EQ(chunk_size == 1 << 22, t.size() == 1000U);
+    t.Append(p.Parse());
+    EXPECT_TRUE(p.Parse().empty());
+    ExpectEqual(s, t);
+  }
+
+  OverlapParser n{ReadText("0\t9\t1\t5\t+\t7\t9\t2\t6\t3\t4\t60\tNM:i:1\n", 5), nullptr, 1};  // NOLINT
+  OverlapStore t = n.Parse();
+  ASSERT_EQ(1U, t.size());
+  EXPECT_EQ(7U, t.rhs_id(0));
+  EXPECT_EQ(3U, t.score(0));
+  EXPECT_EQ(0U, t.cigar_len(0));
+}
+
+TEST(BiosoupOverlapIoTest, Mhap) {
+  OverlapStore s{};
+  s.Append(0, 1, 10, 2, 3, 12, 5, true);
+  s.Append(4, 0, 7, 1, 2, 9, 3, false);
+  std::string text;
+  WriteMhap(
+      s,
+      [] (std::uint32_t) -> std::uint32_t { return 20; },
+      [&] (const char* data, std::size_t len) -> void { text.append(data, len); },  // NOLINT
+      2);
+  EXPECT_EQ(
+      "1 3 0 5 0 1 10 20 0 3 12 20\n"
+      "5 2 0 3 0 0 7 20 1 2 9 20\n",
+      text);
+
+  OverlapParser p{ReadText("\n" + text + "\n", 3), nullptr, 2, 8};
+  ExpectEqual(s, p.Parse());
+}
+
+TEST(BiosoupOverlapIoTest, Error) {
+  OverlapParser e{ReadText("", 1), nullptr, 1};
+  EXPECT_TRUE(e.Parse().empty());
+
+  OverlapParser f{ReadText("0\t9\t1\t5\t+\t7\t9\t2\t6\t3\t4\n", 1), nullptr, 1};
+  EXPECT_THROW(f.Parse(), std::invalid_argument);
+
+  OverlapParser n{ReadText("0\t9\t1\t5\t+\t7\t9\t2\t-6\t3\t4\t0\n", 1), nullptr, 1};  // NOLINT
+  EXPECT_THROW(n.Parse(), std::invalid_argument);
+
+  OverlapParser m{ReadText("0 1 0 5 0 1 10 20 0 3 12 20\n", 1), nullptr, 1};
+  EXPECT_THROW(m.Parse(), std::invalid_argument);
+}
+
+TEST(BiosoupOverlapIoTest, Sort) {
+  OverlapStore s = Overlaps(5000);
+  for (auto key : {OverlapSorter::kLhs, OverlapSorter::kRhs}) {
+    OverlapStore expected = s;
+    if (key == OverlapSorter::kLhs) {
+      expected.SortByLhs();
+    } else {
+      expected.SortByRhs();
+    }
+    for (std::uint64_t memory_limit : {1ULL << 30, 1ULL << 16, 1ULL << 8}) {
+      OverlapSorter sorter{key, memory_limit, ".", 3};
+      std::size_t batch_size = memory_limit > (1U << 8) ? 700 : 30;
+      for (std::size_t i = 0; i < s.size(); i += batch_size) {
+        OverlapStore batch{};
+        batch.Append(s, i, std::min<std::size_t>(s.size(), i + batch_size));
+        sorter.Add(batch);
+      }
+      EXPECT_EQ(memory_limit < s.memory_usage(), sorter.num_runs() > 0);
+      if (memory_limit == (1U << 8)) {  // merged in passes
+        EXPECT_LT(OverlapSorter::kMaxFanIn, sorter.num_runs());
+      }
+
+      OverlapStore sorted{};
+      for (OverlapStore batch; !(batch = sorter.Next(999)).empty();) {
+        EXPECT_LE(batch.size(), 999U);
+        sorted.Append(batch);
+      }
+      ExpectEqual(expected, sorted);
+      EXPECT_THROW(sorter.Add(s), std::logic_error);
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace biosoup
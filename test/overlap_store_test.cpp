@@ -0,0 +1,91 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/overlap_store.hpp"
+
+#include "gtest/gtest.h"
+
+namespace biosoup {
+namespace test {
+
+TEST(BiosoupOverlapStoreTest, Conversion) {
+  OverlapStore s{};
+  EXPECT_TRUE(s.empty());
+  s.Append(Overlap(0, 10, 20, 1, 0, 10, 10, std::string("10M"), false));
+  s.Append(Overlap(2, 1, 5, 3, 4, 8, 4));
+  s.Append(1, 2, 3, 4, 5, 6, 7);
+  EXPECT_EQ(3U, s.size());
+  EXPECT_FALSE(s.strand(0));
+  EXPECT_TRUE(s.strand(1));
+  EXPECT_EQ(10U, s.score(0));
+  EXPECT_EQ(1U, s.cigar_len(0));
+  EXPECT_EQ(0U, s.cigar_len(1));
+
+  Overlap o = s[0];
+  EXPECT_EQ(0U, o.lhs_id);
+  EXPECT_EQ(20U, o.lhs_end);
+  EXPECT_EQ(1U, o.rhs_id);
+  EXPECT_EQ(10U, o.rhs_end);
+  EXPECT_FALSE(o.strand);
+  EXPECT_EQ("10M", o.alignment);
+  EXPECT_EQ("", s[2].alignment);
+
+  EXPECT_THROW(s.Append(0, 0, 0, 0, 0, 0, 1U << 31), std::invalid_argument);
+}
+
+TEST(BiosoupOverlapStoreTest, Concatenation) {
+  OverlapStore s{};
+  s.Append(Overlap(0, 1, 2, 3, 4, 5, 6, std::string("2M1I"), false));
+  s.Append(Overlap(1, 1, 2, 3, 4, 5, 6));
+  s.Append(Overlap(2, 1, 2, 3, 4, 5, 6, std::string("3="), true));
+
+  OverlapStore t{};
+  t.Append(Overlap(3, 0, 0, 0, 0, 0, 0, std::string("1X"), true));
+  t.Append(s, 1, 3);
+  t.Append(s);
+  ASSERT_EQ(6U, t.size());
+  EXPECT_EQ("1X", t[0].alignment);
+  EXPECT_EQ(1U, t.lhs_id(1));
+  EXPECT_EQ("", t[1].alignment);
+  EXPECT_EQ("3=", t[2].alignment);
+  EXPECT_EQ("2M1I", t[3].alignment);
+  EXPECT_FALSE(t.strand(3));
+  EXPECT_EQ("3=", t[5].alignment);
+}
+
+TEST(BiosoupOverlapStoreTest, SortAndFilter) {
+  OverlapStore s{};
+  for (std::uint32_t i = 0; i < 1000; ++i) {
+    s.Append(Overlap(
+        (i * 7919) % 100, (i * 104729) % 100000, 0,
+        i, 0, 0,
+        i,
+        std::to_string(i) + "M"));
+  }
+  s.SortByLhs();
+  for (std::uint32_t i = 1; i < s.size(); ++i) {
+    EXPECT_TRUE(s.lhs_id(i - 1) < s.lhs_id(i) ||
+        (s.lhs_id(i - 1) == s.lhs_id(i) &&
+         s.lhs_begin(i - 1) <= s.lhs_begin(i)));
+  }
+  for (std::uint32_t i = 0; i < s.size(); ++i) {
+    EXPECT_EQ(std::to_string(s.rhs_id(i)) + "M", s[i].alignment);
+  }
+  auto r = s.LhsRange(42);
+  EXPECT_EQ(10U, r.second - r.first);
+  for (auto i = r.first; i < r.second; ++i) {
+    EXPECT_EQ(42U, s.lhs_id(i));
+  }
+
+  s.Filter([&] (std::uint32_t i) -> bool { return s.score(i) % 2 == 0; });
+  EXPECT_EQ(500U, s.size());
+  s.SortByRhs();
+  for (std::uint32_t i = 0; i < s.size(); ++i) {
+    EXPECT_EQ(2 * i, s.rhs_id(i));
+    EXPECT_EQ(std::to_string(2 * i) + "M", s[i].alignment);
+  }
+  s.Clear();
+  EXPECT_TRUE(s.empty());
+}
+
+}  // namespace test
+}  // namespace biosoup
@@ -0,0 +1,88 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/packed_quality.hpp"
+
+#include <random>
+
+#include "gtest/gtest.h"
+
+namespace biosoup {
+namespace test {
+
+TEST(BiosoupPackedQualityTest, Lossless) {
+  std::mt19937 generator(42);
+  for (std::uint32_t num_values : {1, 2, 3, 8, 17, 50, 94}) {
+    std::vector<std::int8_t> quality(1001);
+    for (auto& it : quality) {
+      it = generator() % num_values;
+    }
+    PackedQuality p{quality.data(), static_cast<std::uint32_t>(quality.size())};  // NOLINT
+    EXPECT_EQ(quality.size(), p.size());
+    for (std::uint32_t i = 0; i < quality.size(); ++i) {
+      EXPECT_EQ(quality[i], p[i]);
+    }
+    std::string dst(100, ' ');
+    p.Inflate(900, 100, false, &dst[0]);
+    for (std::uint32_t i = 0; i < 100; ++i) {
+      EXPECT_EQ(quality[900 + i] + '!', dst[i]);
+    }
+    p.Inflate(900, 100, true, &dst[0]);
+    for (std::uint32_t i = 0; i < 100; ++i) {
+      EXPECT_EQ(quality[999 - i] + '!', dst[i]);
+    }
+  }
+  EXPECT_TRUE(PackedQuality().empty());
+}
+
+TEST(BiosoupPackedQualityTest, NegativeScores) {
+  std::vector<std::int8_t> quality;
+  for (std::int32_t i = -128; i < 128; ++i) {
+    quality.emplace_back(i);
+  }
+  quality.emplace_back(-1);
+  quality.emplace_back(-33);
+  PackedQuality p{quality.data(), static_cast<std::uint32_t>(quality.size())};  // NOLINT
+  EXPECT_EQ(8, p.width());
+  for (std::uint32_t i = 0; i < quality.size(); ++i) {
+    EXPECT_EQ(quality[i], p[i]);
+  }
+
+  QualityBinning b = QualityBinning::Illumina();
+  EXPECT_EQ(-1, b(-1));
+  EXPECT_EQ(-128, b(-128));
+  EXPECT_EQ(40, b(127));
+  PackedQuality c{
+      quality.data(), static_cast<std::uint32_t>(quality.size()), b};
+  EXPECT_EQ(-1, c[256]);
+  EXPECT_EQ(-33, c[257]);
+  EXPECT_EQ(0, c[128]);
+}
+
+TEST(BiosoupPackedQualityTest, Lossy) {
+  std::vector<std::int8_t> quality;
+  for (std::int8_t i = 0; i < 94; ++i) {
+    quality.emplace_back(i);
+  }
+  PackedQuality p{quality.data(), 94, QualityBinning::Illumina()};
+  EXPECT_EQ(3, p.width());
+  EXPECT_EQ(0, p[1]);
+  EXPECT_EQ(6, p[2]);
+  EXPECT_EQ(6, p[9]);
+  EXPECT_EQ(15, p[10]);
+  EXPECT_EQ(22, p[24]);
+  EXPECT_EQ(27, p[25]);
+  EXPECT_EQ(33, p[34]);
+  EXPECT_EQ(37, p[35]);
+  EXPECT_EQ(40, p[93]);
+
+  QualityBinning b{{0, 20}, {10, 30}};
+  PackedQuality c{quality.data(), 94, b};
+  EXPECT_EQ(1, c.width());
+  EXPECT_EQ(10, c[19]);
+  EXPECT_EQ(30, c[20]);
+
+  EXPECT_THROW(QualityBinning({1, 20}, {10, 30}), std::invalid_argument);
+}
+
+}  // namespace test
+}  // namespace biosoup
@@ -0,0 +1,152 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/parser.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+#include "biosoup/nucleic_acid.hpp"
+#include "biosoup/sequence.hpp"
+#include "gtest/gtest.h"
+
+namespace biosoup {
+namespace test {
+
+// hands out data in pieces of at most len bytes
+ReadFunction ReadString(const std::string& data, std::size_t len) {
+  std::shared_ptr<std::size_t> i(new std::size_t(0));
+  return [=] (char* dst, std::size_t n) -> std::size_t {
+    n = std::min(std::min(n, len), data.size() - *i);
+    std::copy(data.begin() + *i, data.begin() + *i + n, dst);
+    *i += n;
+    return n;
+  };
+}
+
+std::string Fasta(std::uint32_t num_records) {
+  std::string dst;
+  for (std::uint32_t i = 0; i < num_records; ++i) {
+    dst += ">" + std::to_string(i) + " description\r\n";
+    for (std::uint32_t j = 0; j < i % 5; ++j) {
+      dst += "ACGTTGCA\n";
+    }
+    dst += "ACG\n\n";
+  }
+  return dst;
+}
+
+std::string Fastq(std::uint32_t num_records) {
+  std::string dst;
+  for (std::uint32_t i = 0; i < num_records; ++i) {
+    dst += "@" + std::to_string(i) + "\n";
+    dst += std::string(i % 3 + 1, 'A') + "\nCG\n+\n";
+    dst += i % 2 ? std::string(i % 3 + 3, '@') + "\n" :
+        "@\n" + std::string(i % 3 + 2, '+') + "\n";
+  }
+  return dst;
+}
+
+class BiosoupParserTest: public ::testing::Test {
+ public:
+  void TearDown() override {  // ids are expected to start from 0 elsewhere
+    Sequence::num_objects = 0;
+    NucleicAcid::num_objects = 0;
+  }
+};
+
+TEST_F(BiosoupParserTest, Fasta) {
+  for (std::size_t chunk_size : {1, 7, 100, 1 << 22}) {
+    std::uint32_t id = Sequence::num_objects;
+    Parser<Sequence> p{ReadString(Fasta(1000), 13), 3, chunk_size, 3};
+    std::vector<std::unique_ptr<Sequence>> s;
+    for (auto b = p.Parse(500); !b.empty(); b = p.Parse(500)) {
+      for (auto& it : b) {
+        s.emplace_back(std::move(it));
+      }
+    }
+    ASSERT_EQ(1000U, s.size());
+    EXPECT_EQ(id + 1000, Sequence::num_objects);
+    for (std::uint32_t i = 0; i < s.size(); ++i) {
+      EXPECT_EQ(id + i, s[i]->id);
+      EXPECT_EQ(std::to_string(i) + " description", s[i]->name);
+      EXPECT_EQ(i % 5 * 8 + 3, s[i]->data.size());
+      EXPECT_EQ("ACG", s[i]->data.substr(s[i]->data.size() - 3));
+      EXPECT_TRUE(s[i]->quality.empty());
+    }
+    EXPECT_TRUE(p.Parse().empty());
+  }
+}
+
+TEST_F(BiosoupParserTest, Fastq) {
+  for (std::size_t chunk_size : {1, 10, 1 << 22}) {
+    Parser<NucleicAcid> p{ReadString(Fastq(1000), 1 << 20), 2, chunk_size};
+    auto s = p.Parse();
+    ASSERT_EQ(1000U, s.size());
+    for (std::uint32_t i = 0; i < s.size(); ++i) {
+      EXPECT_EQ(std::to_string(i), s[i]->name);
+      EXPECT_EQ(std::string(i % 3 + 1, 'A') + "CG", s[i]->InflateData());
+      EXPECT_EQ(i % 2 ? std::string(i % 3 + 3, '@') :
+          "@" + std::string(i % 3 + 2, '+'), s[i]->InflateQuality());
+      if (i) {
+        EXPECT_EQ(s[i - 1]->id + 1, s[i]->id);
+      }
+    }
+  }
+}
+
+TEST_F(BiosoupParserTest, File) {
+  std::string path = "biosoup_parser_test.fasta";
+  {
+    std::string data = Fasta(10).substr(0, Fasta(10).size() - 2);
+    FileWriter file{path};
+    file.Write(data.c_str(), 7);
+    file.Write(data.c_str() + 7, data.size() - 7);
+    file.Close();
+    file.Close();  // no-op
+  }
+  Parser<Sequence> p{ReadFile(path), 1};
+  auto s = p.Parse();
+  ASSERT_EQ(10U, s.size());
+  EXPECT_EQ("ACG", s.back()->data.substr(s.back()->data.size() - 3));
+  std::remove(path.c_str());
+
+  EXPECT_THROW(ReadFile(path), std::runtime_error);
+}
+
+#if defined(BIOSOUP_USE_ZLIB)
+
+TEST_F(BiosoupParserTest, Gzip) {
+  std::string path = "biosoup_parser_test.fastq.gz";
+  std::string data = Fastq(100);
+  gzFile f = gzopen(path.c_str(), "wb");
+  gzwrite(f, data.c_str(), data.size());
+  gzclose(f);
+
+  Parser<Sequence> p{ReadGzipFile(path), 2, 64};
+  auto s = p.Parse();
+  ASSERT_EQ(100U, s.size());
+  EXPECT_EQ("99", s.back()->name);
+  std::remove(path.c_str());
+}
+
+#endif
+
+TEST_F(BiosoupParserTest, Error) {
+  Parser<Sequence> e{ReadString("", 1), 1};
+  EXPECT_TRUE(e.Parse().empty());
+
+  Parser<Sequence> u{ReadString("ACGT\n", 1), 1};
+  EXPECT_THROW(u.Parse(), std::invalid_argument);
+
+  Parser<Sequence> q{ReadString("@0\nAC\n+\n!!!\n", 1), 1};
+  EXPECT_THROW(q.Parse(), std::invalid_argument);
+
+  Parser<Sequence> t{ReadString("@0\nAC\n+\n", 1), 1};
+  EXPECT_THROW(t.Parse(), std::invalid_argument);
+
+  Parser<NucleicAcid> n{ReadString(">0\nACGT\n>1\nAC!T", 1), 2};
+  EXPECT_THROW(n.Parse(), std::invalid_argument);
+}
+
+}  // namespace test
+}  // namespace biosoup
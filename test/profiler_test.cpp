@@ -0,0 +1,111 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/profiler.hpp"
+
+#include "gtest/gtest.h"
+
+namespace biosoup {
+namespace test {
+
+void Work(Profiler* profiler, std::uint32_t n) {
+  BIOSOUP_PROFILE_SCOPE(profiler, "work");
+  for (std::uint32_t i = 0; i < n; ++i) {
+    BIOSOUP_PROFILE_SCOPE(profiler, "step");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+TEST(BiosoupProfilerTest, Summary) {
+  for (bool use_tsc : {false, true}) {
+    Profiler p{use_tsc};
+    std::vector<std::thread> threads;
+    for (std::uint32_t i = 0; i < 3; ++i) {
+      threads.emplace_back(Work, &p, 4);
+    }
+    for (auto& it : threads) {
+      it.join();
+    }
+    {
+      ProfilerScope s{&p, "main"};
+      Work(&p, 1);
+    }
+    ProfilerScope open{&p, "open"};
+
+    auto s = p.Summary();
+    ASSERT_EQ(5U, s.size());
+    EXPECT_EQ("main", s[0].path);
+    EXPECT_EQ("main/work", s[1].path);
+    EXPECT_EQ("main/work/step", s[2].path);
+    EXPECT_EQ("work", s[3].path);
+    EXPECT_EQ("work/step", s[4].path);
+    EXPECT_EQ(1U, s[2].count);
+    EXPECT_EQ(3U, s[3].count);
+    EXPECT_EQ(12U, s[4].count);
+    EXPECT_LE(s[4].min, s[4].p50);
+    EXPECT_LE(s[4].p50, s[4].p99);
+    EXPECT_LE(s[4].p99, s[4].max);
+    EXPECT_GE(s[4].min, 0.0009);
+    EXPECT_LT(s[4].min, 0.5);
+    EXPECT_GE(s[4].total, 12 * s[4].min);
+    EXPECT_GE(s[3].total, s[4].total);
+    EXPECT_GE(s[0].total, s[1].total);
+  }
+}
+
+TEST(BiosoupProfilerTest, ChromeTrace) {
+  Profiler p{};
+  {
+    ProfilerScope s{&p, "a \"quoted\" name"};
+  }
+  std::thread([&] () -> void { Work(&p, 1); }).join();
+  std::string t = p.ChromeTrace();
+  EXPECT_EQ(0U, t.find("{\"traceEvents\":[\n{\"name\":\"a \\\"quoted\\\" name\",\"ph\":\"X\",\"ts\":"));  // NOLINT
+  EXPECT_NE(std::string::npos, t.find("{\"name\":\"step\",\"ph\":\"X\""));
+  EXPECT_NE(std::string::npos, t.find("\"tid\":1}"));
+
+  p.Clear();
+  EXPECT_TRUE(p.Summary().empty());
+}
+
+TEST(BiosoupProfilerTest, ClearOpen) {
+  Profiler p{};
+  Work(&p, 2);
+  {
+    ProfilerScope outer{&p, "outer"};
+    Work(&p, 1);
+    {
+      ProfilerScope inner{&p, "inner"};
+      Work(&p, 1);
+      p.Clear();
+      EXPECT_TRUE(p.Summary().empty());
+      Work(&p, 1);
+    }
+  }
+  Work(&p, 1);
+
+  auto s = p.Summary();
+  ASSERT_EQ(6U, s.size());
+  EXPECT_EQ("outer", s[0].path);
+  EXPECT_EQ("outer/inner", s[1].path);
+  EXPECT_EQ("outer/inner/work", s[2].path);
+  EXPECT_EQ(1U, s[2].count);
+  EXPECT_EQ("outer/inner/work/step", s[3].path);
+  EXPECT_EQ("work", s[4].path);
+  EXPECT_EQ(1U, s[4].count);
+  EXPECT_EQ("work/step", s[5].path);
+  EXPECT_EQ(1U, s[5].count);
+}
+
+TEST(BiosoupProfilerTest, Disabled) {
+  Profiler p{};
+  p.set_is_enabled(false);
+  Work(&p, 1);
+  Work(nullptr, 1);
+  EXPECT_TRUE(p.Summary().empty());
+  p.set_is_enabled(true);
+  Work(&p, 1);
+  EXPECT_EQ(2U, p.Summary().size());
+}
+
+}  // namespace test
+}  // namespace biosoup
@@ -2,9 +2,13 @@
 
 #include "biosoup/sequence.hpp"
 
+#include <cctype>
+#include <random>
+#include <vector>
+
 #include "gtest/gtest.h"
 
-std::atomic<std::uint32_t> biosoup::Sequence::num_objects{0};
+std::atomic<biosoup::ObjectId> biosoup::Sequence::num_objects{0};
 
 namespace biosoup {
 namespace test {
@@ -17,5 +21,64 @@ TEST(BiosoupSequenceTest, ReverseAndComplement) {
   EXPECT_EQ("?>=<;:9876543210", s.quality);
 }
 
+// switch based implementation preceding the table driven one
+void ReverseAndComplementBySwitch(std::string* data, std::string* quality) {
+  for (auto& it : *data) {
+    switch (static_cast<char>(std::toupper(static_cast<unsigned char>(it)))) {
+      case 'A': it = 'T'; break;
+      case 'C': it = 'G'; break;
+      case 'G': it = 'C'; break;
+      case 'T': case 'U': it = 'A'; break;
+      case 'R': it = 'Y'; break;
+      case 'Y': it = 'R'; break;
+      case 'K': it = 'M'; break;
+      case 'M': it = 'K'; break;
+      case 'B': it = 'V'; break;
+      case 'D': it = 'H'; break;
+      case 'H': it = 'D'; break;
+      case 'V': it = 'B'; break;
+      default: break;
+    }
+  }
+  std::reverse(data->begin(), data->end());
+  std::reverse(quality->begin(), quality->end());
+}
+
+TEST(BiosoupSequenceTest, ReverseAndComplementKernels) {
+  std::vector<void (*)(char*, char*, std::size_t)> kernels{
+      detail::ReverseAndComplementScalar};
+#if defined(BIOSOUP_X86_DISPATCH)
+  if (detail::simd_level() >= detail::SimdLevel::kSse42) {
+    kernels.emplace_back(detail::ReverseAndComplementSse42);
+  }
+  if (detail::simd_level() >= detail::SimdLevel::kAvx2) {
+    kernels.emplace_back(detail::ReverseAndComplementAvx2);
+  }
+#endif
+  std::mt19937 generator(42);
+  for (const auto& it : kernels) {
+    for (std::uint32_t len = 0; len < 300; ++len) {
+      std::string data(len, 0), quality(len, 0);
+      for (std::uint32_t i = 0; i < len; ++i) {
+        data[i] = len < 256 ? i : generator();  // all characters
+        quality[i] = generator();
+      }
+      std::string e = data, q = quality;
+      ReverseAndComplementBySwitch(&e, &q);
+      it(&data[0], &quality[0], len);
+      EXPECT_EQ(e, data);
+      EXPECT_EQ(q, quality);
+      it(&data[0], nullptr, len);
+      ReverseAndComplementBySwitch(&e, &quality);
+      EXPECT_EQ(e, data);
+    }
+  }
+
+  Sequence s{"Test", "ACGT", "!!"};
+  s.ReverseAndComplement();
+  EXPECT_EQ("ACGT", s.data);
+  EXPECT_EQ("!!", s.quality);
+}
+
 }  // namespace test
 }  // namespace biosoup
@@ -0,0 +1,229 @@
+// Copyright (c) 2020 Robert Vaser
+
+#include "biosoup/string_graph.hpp"
+
+#include <algorithm>
+#include <random>
+
+#include "gtest/gtest.h"
+
+namespace biosoup {
+namespace test {
+
+class BiosoupStringGraphTest: public ::testing::Test {
+ public:
+  struct Read {
+    std::uint32_t begin;
+    std::uint32_t len;
+    bool is_reverse;
+  };
+
+  // overlaps between all pairs of reads sharing at least min_len bases of a
+  // genome, with coordinates on forward strands of reads
+  static std::vector<Overlap> Layout(
+      const std::vector<Read>& reads,
+      std::uint32_t min_len) {
+    auto coordinate = [] (const Read& r, std::uint32_t i) -> std::uint32_t {
+      return r.is_reverse ? r.len - i : i;
+    };
+    std::vector<Overlap> dst;
+    for (std::uint32_t i = 0; i < reads.size(); ++i) {
+      for (std::uint32_t j = 0; j < reads.size(); ++j) {
+        const Read& x = reads[i];
+        const Read& y = reads[j];
+        if (i == j || x.begin > y.begin || (x.begin == y.begin && i > j)) {
+          continue;
+        }
+        std::uint32_t end = std::min(x.begin + x.len, y.begin + y.len);
+        if (end < y.begin + min_len) {
+          continue;
+        }
+        std::uint32_t xb = coordinate(x, y.begin - x.begin);
+        std::uint32_t xe = coordinate(x, end - x.begin);
+        std::uint32_t yb = coordinate(y, 0);
+        std::uint32_t ye = coordinate(y, end - y.begin);
+        dst.emplace_back(
+            i, std::min(xb, xe), std::max(xb, xe),
+            j, std::min(yb, ye), std::max(yb, ye),
+            end - y.begin,
+            x.is_reverse == y.is_reverse);
+      }
+    }
+    return dst;
+  }
+};
+
+TEST_F(BiosoupStringGraphTest, Build) {
+  // 0 -> 1 on the same strand, 0 -> 2 on the opposite, 3 within 0
+  std::vector<Overlap> overlaps{
+    Overlap(0, 60, 100, 1, 0, 40, 40),
+    Overlap(0, 70, 100, 2, 20, 50, 30, false),
+    Overlap(0, 10, 40, 3, 0, 30, 30),
+    Overlap(1, 0, 10, 0, 90, 100, 10)};  // reported twice
+  std::vector<std::uint32_t> lens{100, 100, 50, 30};
+  StringGraph g{overlaps, [&] (std::uint32_t i) { return lens[i]; }, 0, 2};
+
+  EXPECT_EQ(4U, g.num_reads());
+  EXPECT_EQ(8U, g.num_nodes());
+  EXPECT_EQ(4U, g.num_edges());
+  EXPECT_TRUE(g.is_contained(3));
+  EXPECT_FALSE(g.is_contained(0));
+
+  ASSERT_EQ(2U, g.out_degree(0));
+  EXPECT_EQ(2U, g.out_edges(0)[0].head);
+  EXPECT_EQ(60U, g.out_edges(0)[0].length);
+  EXPECT_EQ(5U, g.out_edges(0)[1].head);
+  EXPECT_EQ(70U, g.out_edges(0)[1].length);
+  EXPECT_EQ(2U, g.in_degree(1));
+  ASSERT_EQ(1U, g.out_degree(3));
+  EXPECT_EQ(1U, g.out_edges(3)->head);
+  EXPECT_EQ(60U, g.out_edges(3)->length);
+  ASSERT_EQ(1U, g.out_degree(4));
+  EXPECT_EQ(1U, g.out_edges(4)->head);
+  EXPECT_EQ(20U, g.out_edges(4)->length);
+  EXPECT_EQ(0U, g.out_degree(6));
+  EXPECT_EQ(0U, g.out_degree(7));
+}
+
+TEST_F(BiosoupStringGraphTest, Reduce) {
+  std::mt19937 generator(42);
+  std::vector<Read> reads;
+  for (std::uint32_t i = 0; i < 600; ++i) {
+    std::uint32_t begin = generator() % 100000;
+    std::uint32_t len = 2000 + generator() % 4000;
+    reads.emplace_back(Read{begin, len, (generator() & 1) == 1});
+  }
+  reads.emplace_back(reads[7]);  // duplicate
+  auto overlaps = Layout(reads, 1000);
+
+  StringGraph g{
+      overlaps,
+      [&] (std::uint32_t i) -> std::uint32_t { return reads[i].len; },
+      0,
+      3};
+  ASSERT_EQ(reads.size(), g.num_reads());
+
+  std::vector<std::uint32_t> order;
+  for (std::uint32_t i = 0; i < reads.size(); ++i) {
+    bool is_contained = false;
+    for (std::uint32_t j = 0; j < reads.size(); ++j) {
+      const Read& x = reads[i];
+      const Read& y = reads[j];
+      if (i != j &&
+          y.begin <= x.begin && x.begin + x.len <= y.begin + y.len &&
+          (y.begin != x.begin || y.len != x.len || j < i)) {
+        is_contained = true;
+      }
+    }
+    EXPECT_EQ(is_contained, g.is_contained(i)) << i;
+    if (!is_contained) {
+      order.emplace_back(i);
+    }
+  }
+  std::sort(order.begin(), order.end(),
+      [&] (std::uint32_t lhs, std::uint32_t rhs) -> bool {
+        return reads[lhs].begin < reads[rhs].begin;
+      });
+
+  std::uint64_t num_edges = g.num_edges();
+  std::uint64_t num_removed = g.RemoveTransitiveEdges(0, 3);
+  EXPECT_LT(0U, num_removed);
+  EXPECT_EQ(num_edges, g.num_edges() + num_removed);
+
+  // consecutive reads which overlap enough are all that is left
+  std::uint64_t num_expected = 0;
+  for (std::uint32_t i = 0; i + 1 < order.size(); ++i) {
+    const Read& x = reads[order[i]];
+    const Read& y = reads[order[i + 1]];
+    if (x.begin + x.len < y.begin + 1000) {
+      continue;
+    }
+    num_expected += 2;
+    std::uint32_t v = order[i] << 1 | x.is_reverse;
+    std::uint32_t w = order[i + 1] << 1 | y.is_reverse;
+    ASSERT_EQ(1U, g.out_degree(v)) << i;
+    EXPECT_EQ(w, g.out_edges(v)->head);
+    EXPECT_EQ(y.begin - x.begin, g.out_edges(v)->length);
+    ASSERT_EQ(1U, g.out_degree(w ^ 1));
+    EXPECT_EQ(v ^ 1, g.out_edges(w ^ 1)->head);
+  }
+  EXPECT_EQ(num_expected, g.num_edges());
+
+  StringGraph h{
+      overlaps,
+      [&] (std::uint32_t i) -> std::uint32_t { return reads[i].len; },
+      0,
+      1};
+  h.RemoveTransitiveEdges(0, 1);
+  ASSERT_EQ(g.num_nodes(), h.num_nodes());
+  for (std::uint32_t v = 0; v < g.num_nodes(); ++v) {
+    ASSERT_EQ(g.out_degree(v), h.out_degree(v));
+    for (std::uint32_t i = 0; i < g.out_degree(v); ++i) {
+      EXPECT_EQ(g.out_edges(v)[i].head, h.out_edges(v)[i].head);
+    }
+  }
+}
+
+TEST_F(BiosoupStringGraphTest, Simplify) {
+  // path 0 -> 1 -> ... -> 9, tip 10 -> 5 and 12 -> 11 -> 3, bubble
+  // 6 -> 13 -> 8 next to 6 -> 7 -> 8
+  std::vector<Overlap> overlaps;
+  auto join = [&] (std::uint32_t lhs, std::uint32_t rhs) -> void {
+    overlaps.emplace_back(lhs, 50, 100, rhs, 0, 50, 50);
+  };
+  for (std::uint32_t i = 0; i < 9; ++i) {
+    join(i, i + 1);
+  }
+  join(10, 5);
+  join(12, 11);
+  join(11, 3);
+  join(6, 13);
+  join(13, 8);
+  StringGraph g{overlaps, [] (std::uint32_t) { return 100U; }, 0, 2};
+  EXPECT_EQ(0U, g.RemoveTransitiveEdges());
+
+  EXPECT_EQ(0U, g.PopBubbles(0));
+  EXPECT_EQ(1U, g.PopBubbles());
+  EXPECT_TRUE(g.is_removed(13) != g.is_removed(7));
+  EXPECT_TRUE(g.is_removed(13));  // the path with the smaller read id stays
+
+  EXPECT_EQ(1U, g.RemoveTips(1));
+  EXPECT_TRUE(g.is_removed(10));
+  EXPECT_FALSE(g.is_removed(11));
+  EXPECT_EQ(2U, g.RemoveTips(2));
+  EXPECT_TRUE(g.is_removed(11));
+  EXPECT_TRUE(g.is_removed(12));
+  EXPECT_FALSE(g.is_removed(0));
+  for (std::uint32_t i = 0; i < 9; ++i) {
+    ASSERT_EQ(1U, g.out_degree(i << 1));
+    EXPECT_EQ((i + 1) << 1, g.out_edges(i << 1)->head);
+  }
+  EXPECT_EQ(18U, g.num_edges());
+}
+
+TEST_F(BiosoupStringGraphTest, Error) {
+  std::vector<Overlap> overlaps{Overlap(0, 60, 120, 1, 0, 60, 60)};
+  try {
+    StringGraph g{overlaps, [] (std::uint32_t) { return 100U; }};
+  } catch (std::invalid_argument& exception) {
+    EXPECT_STREQ(
+        exception.what(),
+        "[biosoup::StringGraph::StringGraph] error: "
+        "overlap exceeds read length");
+  }
+
+  for (std::uint32_t id : {UINT32_MAX, 1U << 31, (1U << 31) - 1}) {
+    overlaps = {Overlap(id, 0, 100, 0, 0, 100, 100)};
+    try {
+      StringGraph g{overlaps, [] (std::uint32_t) { return 100U; }};
+      ADD_FAILURE() << "expected std::length_error for " << id;
+    } catch (std::length_error& exception) {
+      EXPECT_STREQ(
+          exception.what(),
+          "[biosoup::StringGraph::StringGraph] error: too many reads");
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace biosoup
@@ -0,0 +1,57 @@
+// Copyright (c) 2020 Robert Vaser
+
+#ifndef BIOSOUP_TEST_UTILS_HPP_
+#define BIOSOUP_TEST_UTILS_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "biosoup/nucleic_acid.hpp"
+
+namespace biosoup {
+namespace test {
+
+inline std::string RandomData(std::uint32_t len, std::mt19937* generator) {
+  std::string dst(len, 'A');
+  for (auto& it : dst) {
+    it = "ACGT"[(*generator)() & 3];
+  }
+  return dst;
+}
+
+// substrings of 500 to 1499 bases with ids 0 to n - 1, every other reverse
+// complemented
+inline std::vector<std::unique_ptr<NucleicAcid>> RandomReads(
+    const std::string& genome,
+    std::uint32_t n,
+    std::mt19937* generator) {
+  std::vector<std::unique_ptr<NucleicAcid>> dst;
+  for (std::uint32_t i = 0; i < n; ++i) {
+    std::uint32_t len = 500 + (*generator)() % 1000;
+    std::uint32_t begin = (*generator)() % (genome.size() - len);
+    dst.emplace_back(new NucleicAcid("read", genome.substr(begin, len)));
+    dst.back()->id = i;
+    if (i & 1) {
+      dst.back()->ReverseAndComplement();
+    }
+  }
+  return dst;
+}
+
+// of ACGT strings
+inline std::string ReverseComplement(std::string str) {
+  std::reverse(str.begin(), str.end());
+  for (auto& it : str) {
+    it = it == 'A' ? 'T' : it == 'C' ? 'G' : it == 'G' ? 'C' : 'A';
+  }
+  return str;
+}
+
+}  // namespace test
+}  // namespace biosoup
+
+#endif  // BIOSOUP_TEST_UTILS_HPP_